@@ -0,0 +1,34 @@
+#include "bench.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const struct {
+  const char *name;
+  void (*run)(void);
+} bench_groups[] = {
+    {"host", bench_host},       {"indirect", bench_indirect},
+    {"wasi", bench_wasi},       {"bulk", bench_bulk},
+    {"simd", bench_simd},       {"threads", bench_threads},
+    {"sched", bench_sched},     {"async", bench_async},
+    {"sections", bench_sections}, {"check", bench_check},
+    {"parse", bench_parse},     {"alloc", bench_alloc},
+    {"regs", bench_regs},       {"calls", bench_calls},
+    {"startup", bench_startup}, {"print", bench_print},
+};
+
+// Runs all benchmarks or only the groups named on the command line. Build in
+// release mode to get meaningful numbers. Every result is one line with a
+// fixed width name so runs of different commits can be diffed.
+int main(int argc, char **argv) {
+  size_t group_count = sizeof(bench_groups) / sizeof(bench_groups[0]);
+  for (size_t i = 0; i < group_count; i++) {
+    bool selected = argc < 2;
+    for (int arg = 1; arg < argc; arg++) {
+      selected = selected || strcmp(argv[arg], bench_groups[i].name) == 0;
+    }
+    if (selected) {
+      bench_groups[i].run();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Monotonic time in nanoseconds.
+static inline uint64_t bench_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Prints one result line. `ops` is the number of operations that took `ns`.
+static inline void bench_report(const char *name, uint64_t ns, uint64_t ops) {
+  printf("%-40s %12.2f ns/op\n", name, (double)ns / (double)ops);
+}
+
+// Prints one result line for a benchmark that processed `bytes` in `ns`.
+static inline void bench_report_throughput(const char *name, uint64_t ns,
+                                           uint64_t bytes) {
+  printf("%-40s %12.2f MB/s\n", name, (double)bytes * 1000.0 / (double)ns);
+}
+
+// Prints one result line with the time per operation and the throughput for
+// benchmarks that process `bytes` of input in `ops` operations.
+static inline void bench_report_bytes(const char *name, uint64_t ns,
+                                      uint64_t ops, uint64_t bytes) {
+  printf("%-40s %12.2f ns/op %10.2f MB/s\n", name, (double)ns / (double)ops,
+         (double)bytes * 1000.0 / (double)ns);
+}
+
+// Prints one result line for a benchmark that completed `ops` in `ns`.
+static inline void bench_report_rate(const char *name, uint64_t ns,
+                                     uint64_t ops) {
+  printf("%-40s %12.0f ops/s\n", name, (double)ops * 1e9 / (double)ns);
+}
+
+// Prints one latency line, `ns` is the latency of a single operation.
+static inline void bench_report_latency(const char *name, uint64_t ns) {
+  printf("%-40s %12.2f us\n", name, (double)ns / 1000.0);
+}
+
+// Benchmark groups.
+void bench_host(void);
+void bench_indirect(void);
+void bench_wasi(void);
+void bench_bulk(void);
+void bench_simd(void);
+void bench_threads(void);
+void bench_sched(void);
+void bench_async(void);
+void bench_sections(void);
+void bench_check(void);
+void bench_parse(void);
+void bench_alloc(void);
+void bench_regs(void);
+void bench_calls(void);
+void bench_startup(void);
+void bench_print(void);
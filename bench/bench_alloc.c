@@ -0,0 +1,92 @@
+#include "bench.h"
+#include "wasm/wasm_common.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Allocation accounting with many threads allocating at once, as when modules
+// are loaded in parallel. Every thread allocates and frees small objects with
+// plain malloc, with malloc and one shared atomic counter, which is how
+// allocations used to be counted, and with `wasm_alloc_n`.
+
+#define bench_alloc_ops 2000000
+#define bench_alloc_threads_max 16
+#define bench_alloc_batch 16
+
+enum bench_alloc_kind {
+  bench_alloc_malloc,
+  bench_alloc_shared,
+  bench_alloc_wasm,
+};
+
+static _Atomic size_t bench_shared_count;
+
+static void *bench_alloc_worker(void *arg) {
+  enum bench_alloc_kind kind = *(enum bench_alloc_kind *)arg;
+  void *objects[bench_alloc_batch];
+  for (uint32_t i = 0; i < bench_alloc_ops / bench_alloc_batch; i++) {
+    for (int j = 0; j < bench_alloc_batch; j++) {
+      size_t size = 16 + (size_t)j * 8;
+      if (kind == bench_alloc_wasm) {
+        objects[j] = wasm_alloc_n(size);
+      } else {
+        objects[j] = malloc(size);
+        if (kind == bench_alloc_shared) {
+          bench_shared_count++;
+        }
+      }
+    }
+    for (int j = 0; j < bench_alloc_batch; j++) {
+      if (kind == bench_alloc_wasm) {
+        wasm_free(objects[j]);
+      } else {
+        free(objects[j]);
+        if (kind == bench_alloc_shared) {
+          bench_shared_count--;
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+static void bench_alloc_run(enum bench_alloc_kind kind, const char *name,
+                            uint32_t thread_count) {
+  pthread_t threads[bench_alloc_threads_max];
+  uint64_t start = bench_now_ns();
+  uint32_t started = 0;
+  for (; started < thread_count; started++) {
+    if (pthread_create(&threads[started], NULL, bench_alloc_worker, &kind)) {
+      break;
+    }
+  }
+  for (uint32_t i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "alloc+free %s %u threads", name, started);
+  bench_report_rate(label, ns, (uint64_t)bench_alloc_ops * 2 * started);
+}
+
+void bench_alloc(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = cpus < 1 ? 1 : (uint32_t)cpus;
+  if (max_threads > bench_alloc_threads_max) {
+    max_threads = bench_alloc_threads_max;
+  }
+
+  for (uint32_t threads = 1;; threads *= 2) {
+    if (threads > max_threads) {
+      threads = max_threads;
+    }
+    bench_alloc_run(bench_alloc_malloc, "malloc", threads);
+    bench_alloc_run(bench_alloc_shared, "shared counter", threads);
+    bench_alloc_run(bench_alloc_wasm, "wasm_alloc", threads);
+    if (threads == max_threads) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,190 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include "wasm/wasm_sched.h"
+#include <stdatomic.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// Guests that call the host import `io` in a loop. Depending on the imports it
+// does nothing, yields the task or waits for a request to a backend with a
+// fixed latency, emulated by a timer. Waiting blocks the worker thread or
+// suspends the task until the event loop sees the timer expire.
+//
+// (import "env" "io" (func $io (param i32) (result i32)))
+// (func $run (param $n i32)
+//   loop
+//     (drop (call $io (local.get $n)))
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end)
+static const unsigned char bench_async_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0A, 0x02, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x60, 0x01, 0x7F, 0x00, 0x02, 0x0A, 0x01, 0x03,
+    0x65, 0x6E, 0x76, 0x02, 0x69, 0x6F, 0x00, 0x00, 0x03, 0x02, 0x01, 0x01,
+    0x0A, 0x15, 0x01, 0x13, 0x00, 0x03, 0x40, 0x20, 0x00, 0x10, 0x00, 0x1A,
+    0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00, 0x0B, 0x0B};
+
+#define bench_func_run 1
+#define bench_switch_count 1000000
+#define bench_guest_count 256
+#define bench_request_count 10
+#define bench_request_latency_ns 100000
+
+static int32_t bench_io_nop(wasm_instance *instance, void *user, int32_t n) {
+  (void)instance;
+  (void)user;
+  return n;
+}
+
+static int32_t bench_io_yield(wasm_instance *instance, void *user,
+                              int32_t n) {
+  (void)user;
+  wasm_task_yield(instance);
+  return n;
+}
+
+// Sends a request and waits for the response.
+static int32_t bench_io_request(wasm_instance *instance, void *user,
+                                int32_t n) {
+  bool async = user != NULL;
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  struct itimerspec timeout = {{0, 0}, {0, bench_request_latency_ns}};
+  timerfd_settime(fd, 0, &timeout, NULL);
+
+  if (async) {
+    wasm_task_wait_fd(instance, fd, POLLIN);
+  }
+  uint64_t expirations;
+  int32_t result = read(fd, &expirations, sizeof(expirations)) > 0 ? n : -1;
+  close(fd);
+  return result;
+}
+
+static _Atomic int bench_trap_count;
+
+static void bench_run_done(enum wasm_trap trap, const wasm_value *result,
+                           void *user) {
+  (void)result;
+  (void)user;
+  if (trap) {
+    atomic_fetch_add(&bench_trap_count, 1);
+  }
+}
+
+// Runs `run` of every instance as a task and returns the wall time or 0 if one
+// of them trapped.
+static uint64_t bench_run_tasks(wasm_scheduler *scheduler,
+                                wasm_instance **instances, uint32_t count,
+                                int32_t iterations) {
+  wasm_value arg = {.i32 = iterations};
+  atomic_store(&bench_trap_count, 0);
+
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < count; i++) {
+    wasm_scheduler_spawn(scheduler, instances[i], bench_func_run, &arg,
+                         bench_run_done, NULL);
+  }
+  wasm_scheduler_wait(scheduler);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (atomic_load(&bench_trap_count) > 0) {
+    puts("bench_async: a guest trapped");
+    return 0;
+  }
+  return ns;
+}
+
+// Creates `count` instances whose `io` import is `native`.
+static wasm_module *bench_load(wasm_host_imports *imports, void (*native)(void),
+                               void *user, wasm_instance **instances,
+                               uint32_t count) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_async_module,
+                          sizeof(bench_async_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_init_host_imports(imports);
+  wasm_host_imports_add(imports, "env", "io", "(i)i", native, user);
+
+  bool ok = module != NULL;
+  for (uint32_t i = 0; i < count; i++) {
+    instances[i] = ok ? wasm_instantiate(module, imports) : NULL;
+    ok = instances[i] != NULL;
+  }
+  if (!ok) {
+    puts("bench_async: failed to instantiate module");
+  }
+  return module;
+}
+
+static void bench_unload(wasm_module *module, wasm_host_imports *imports,
+                         wasm_instance **instances, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    wasm_free_instance(instances[i]);
+  }
+  wasm_deinit_host_imports(imports);
+  wasm_free_module(module);
+}
+
+// A yield switches to the worker, requeues the task and switches back. The
+// host call without a yield is the baseline.
+static void bench_context_switch(void) {
+  wasm_host_imports imports;
+  wasm_instance *instance;
+  wasm_scheduler *scheduler = wasm_create_scheduler(1, INT64_MAX);
+
+  wasm_module *module = bench_load(&imports, (void (*)(void))bench_io_nop,
+                                   NULL, &instance, 1);
+  uint64_t ns = instance ? bench_run_tasks(scheduler, &instance, 1,
+                                           bench_switch_count)
+                         : 0;
+  if (ns) {
+    bench_report("host call in a task", ns, bench_switch_count);
+  }
+  bench_unload(module, &imports, &instance, 1);
+
+  module = bench_load(&imports, (void (*)(void))bench_io_yield, NULL,
+                      &instance, 1);
+  ns = instance ? bench_run_tasks(scheduler, &instance, 1, bench_switch_count)
+                : 0;
+  if (ns) {
+    bench_report("host call + task switch", ns, bench_switch_count);
+  }
+  bench_unload(module, &imports, &instance, 1);
+
+  wasm_free_scheduler(scheduler);
+}
+
+static void bench_requests(uint32_t worker_count, bool async) {
+  static wasm_instance *instances[bench_guest_count];
+  wasm_host_imports imports;
+  // Any non NULL user selects the async variant.
+  wasm_module *module =
+      bench_load(&imports, (void (*)(void))bench_io_request,
+                 async ? (void *)&imports : NULL, instances, bench_guest_count);
+
+  wasm_scheduler *scheduler = wasm_create_scheduler(worker_count, INT64_MAX);
+  uint64_t ns = instances[bench_guest_count - 1]
+                    ? bench_run_tasks(scheduler, instances, bench_guest_count,
+                                      bench_request_count)
+                    : 0;
+  wasm_free_scheduler(scheduler);
+
+  if (ns) {
+    char label[64];
+    snprintf(label, sizeof(label), "requests %s, %u workers",
+             async ? "suspended" : "blocking", worker_count);
+    bench_report_rate(label, ns, bench_guest_count * bench_request_count);
+  }
+  bench_unload(module, &imports, instances, bench_guest_count);
+}
+
+void bench_async(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t worker_count = cpus < 1 ? 1 : (uint32_t)cpus;
+
+  bench_context_switch();
+  bench_requests(worker_count, false);
+  bench_requests(worker_count, true);
+}
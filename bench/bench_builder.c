@@ -0,0 +1,191 @@
+#include "bench_builder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void bench_buf_init(bench_buf *buf) {
+  buf->data = NULL;
+  buf->size = 0;
+  buf->capacity = 0;
+}
+
+void bench_buf_deinit(bench_buf *buf) {
+  free(buf->data);
+  bench_buf_init(buf);
+}
+
+void bench_buf_clear(bench_buf *buf) { buf->size = 0; }
+
+void bench_emit_bytes(bench_buf *buf, const void *data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  if (buf->size + size > buf->capacity) {
+    size_t capacity = buf->capacity ? buf->capacity : 256;
+    while (capacity < buf->size + size) {
+      capacity *= 2;
+    }
+    buf->data = realloc(buf->data, capacity);
+    buf->capacity = capacity;
+  }
+
+  memcpy(buf->data + buf->size, data, size);
+  buf->size += size;
+}
+
+void bench_emit_byte(bench_buf *buf, unsigned char byte) {
+  bench_emit_bytes(buf, &byte, 1);
+}
+
+void bench_emit_u32(bench_buf *buf, uint32_t value) {
+  do {
+    unsigned char byte = value & 127;
+    value >>= 7;
+    bench_emit_byte(buf, byte | (value ? 128 : 0));
+  } while (value);
+}
+
+void bench_emit_u32_width(bench_buf *buf, uint32_t value, int width) {
+  if (width == 0) {
+    bench_emit_u32(buf, value);
+    return;
+  }
+  for (int i = 0; i < width; i++) {
+    unsigned char byte = value & 127;
+    value >>= 7;
+    bench_emit_byte(buf, byte | (i < width - 1 ? 128 : 0));
+  }
+}
+
+void bench_emit_s64(bench_buf *buf, int64_t value) {
+  for (;;) {
+    unsigned char byte = value & 127;
+    value >>= 7;
+    bool done = (value == 0 && (byte & 64) == 0) ||
+                (value == -1 && (byte & 64) != 0);
+    bench_emit_byte(buf, byte | (done ? 0 : 128));
+    if (done) {
+      return;
+    }
+  }
+}
+
+void bench_emit_s32(bench_buf *buf, int32_t value) {
+  bench_emit_s64(buf, value);
+}
+
+void bench_emit_name(bench_buf *buf, const char *name) {
+  size_t length = strlen(name);
+  bench_emit_u32(buf, (uint32_t)length);
+  bench_emit_bytes(buf, name, length);
+}
+
+void bench_emit_header(bench_buf *buf) {
+  bench_emit_bytes(buf, "\0asm\x01\0\0\0", 8);
+}
+
+void bench_emit_section(bench_buf *buf, unsigned char id, bench_buf *content) {
+  bench_emit_byte(buf, id);
+  bench_emit_u32(buf, (uint32_t)content->size);
+  bench_emit_bytes(buf, content->data, content->size);
+  bench_buf_clear(content);
+}
+
+static uint32_t bench_next_random(uint32_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void bench_emit_section_width(bench_buf *buf, unsigned char id,
+                                     bench_buf *content, int width) {
+  bench_emit_byte(buf, id);
+  bench_emit_u32_width(buf, (uint32_t)content->size, width);
+  bench_emit_bytes(buf, content->data, content->size);
+  bench_buf_clear(content);
+}
+
+// Export names start with a unique number and are padded with letters or
+// with 2 and 3 byte sequences ("\u00e9" and "\u20ac").
+static void bench_emit_export_name(bench_buf *buf,
+                                   const bench_module_config *config,
+                                   uint32_t index) {
+  char name[32];
+  size_t length = (size_t)snprintf(name, sizeof(name), "e%u_", index);
+  size_t padded = config->name_length > length ? config->name_length : length;
+
+  bench_emit_u32_width(buf, (uint32_t)padded, config->leb_width);
+  bench_emit_bytes(buf, name, length);
+  while (length < padded) {
+    if (config->multibyte_names && padded - length >= 3) {
+      bench_emit_bytes(buf, length % 2 ? "\xE2\x82\xAC" : "\xC3\xA9",
+                       length % 2 ? 3 : 2);
+      length += length % 2 ? 3 : 2;
+    } else {
+      bench_emit_byte(buf, (unsigned char)('a' + length % 26));
+      length++;
+    }
+  }
+}
+
+void bench_build_module(bench_buf *buf, const bench_module_config *config) {
+  static const unsigned char valtypes[4] = {0x7F, 0x7E, 0x7D, 0x7C};
+  int width = config->leb_width;
+  uint32_t random = config->seed ? config->seed : 1;
+  uint32_t type_count = config->type_count ? config->type_count : 1;
+  bench_buf section, body;
+  bench_buf_init(&section);
+  bench_buf_init(&body);
+
+  bench_emit_header(buf);
+
+  bench_emit_u32_width(&section, type_count, width);
+  for (uint32_t i = 0; i < type_count; i++) {
+    // The parameters vary with `i` so there are many different types.
+    uint32_t param_count = i % 5;
+    bench_emit_byte(&section, 0x60);
+    bench_emit_u32_width(&section, param_count, width);
+    for (uint32_t j = 0, bits = i / 5; j < param_count; j++, bits /= 4) {
+      bench_emit_byte(&section, valtypes[bits % 4]);
+    }
+    bench_emit_u32_width(&section, 1, width);
+    bench_emit_byte(&section, 0x7F);
+  }
+  bench_emit_section_width(buf, 1, &section, width);
+
+  bench_emit_u32_width(&section, config->func_count, width);
+  for (uint32_t i = 0; i < config->func_count; i++) {
+    bench_emit_u32_width(&section, i % type_count, width);
+  }
+  bench_emit_section_width(buf, 3, &section, width);
+
+  uint32_t export_count = config->func_count > 0 ? config->export_count : 0;
+  bench_emit_u32_width(&section, export_count, width);
+  for (uint32_t i = 0; i < export_count; i++) {
+    bench_emit_export_name(&section, config, i);
+    bench_emit_byte(&section, 0);
+    bench_emit_u32_width(&section, i % config->func_count, width);
+  }
+  bench_emit_section_width(buf, 7, &section, width);
+
+  bench_emit_u32_width(&section, config->func_count, width);
+  for (uint32_t i = 0; i < config->func_count; i++) {
+    bench_emit_u32_width(&body, 0, width); // no locals
+    while (body.size < config->body_size) {
+      // i32.const with a random value, drop
+      bench_emit_byte(&body, 0x41);
+      bench_emit_s32(&body, (int32_t)bench_next_random(&random));
+      bench_emit_byte(&body, 0x1A);
+    }
+    bench_emit_bytes(&body, "\x41\x00\x0B", 3);
+    bench_emit_u32_width(&section, (uint32_t)body.size, width);
+    bench_emit_bytes(&section, body.data, body.size);
+    bench_buf_clear(&body);
+  }
+  bench_emit_section_width(buf, 10, &section, width);
+
+  bench_buf_deinit(&section);
+  bench_buf_deinit(&body);
+}
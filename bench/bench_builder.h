@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A growable byte buffer to assemble wasm modules in memory.
+typedef struct {
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+} bench_buf;
+
+void bench_buf_init(bench_buf *buf);
+void bench_buf_deinit(bench_buf *buf);
+void bench_buf_clear(bench_buf *buf);
+
+void bench_emit_byte(bench_buf *buf, unsigned char byte);
+void bench_emit_bytes(bench_buf *buf, const void *data, size_t size);
+void bench_emit_u32(bench_buf *buf, uint32_t value);
+// Emits `value` with exactly `width` bytes (1 to 5) by padding it with
+// continuation bytes. `width` 0 emits the shortest encoding. `value` has to fit.
+void bench_emit_u32_width(bench_buf *buf, uint32_t value, int width);
+void bench_emit_s32(bench_buf *buf, int32_t value);
+void bench_emit_s64(bench_buf *buf, int64_t value);
+// Length prefixed string.
+void bench_emit_name(bench_buf *buf, const char *name);
+
+// Writes the magic number and version.
+void bench_emit_header(bench_buf *buf);
+// Writes a section with the contents of `content` and clears `content`.
+void bench_emit_section(bench_buf *buf, unsigned char id, bench_buf *content);
+
+// Knobs of the synthetic module generator. The same config always generates
+// the same bytes.
+typedef struct {
+  uint32_t type_count;
+  uint32_t func_count;
+  uint32_t export_count;
+  // Approximate size in bytes of the instructions of each function body.
+  uint32_t body_size;
+  // Width of every u32 leb in the module including section sizes, 0 for the
+  // shortest encoding.
+  int leb_width;
+  // Export names are padded to this length. Multibyte names use 2 and 3 byte
+  // UTF-8 sequences.
+  uint32_t name_length;
+  bool multibyte_names;
+  uint32_t seed;
+} bench_module_config;
+
+// Writes a valid module: types with up to 4 parameters that all return an
+// i32, functions that cycle through the types and whose bodies are constants
+// that are dropped, and exports of the functions.
+void bench_build_module(bench_buf *buf, const bench_module_config *config);
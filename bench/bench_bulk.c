@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+
+// Bulk memory instructions compared with the byte loops that MVP toolchains
+// emit for memcpy/memset. Every function repeats one copy or fill of `size`
+// bytes `n` times. The destination is the second page.
+//
+// (memory 2)
+// (func $copy_bulk (param $n i32) (param $size i32)
+//   loop
+//     (memory.copy (i32.const 65536) (i32.const 0) (local.get $size))
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end)
+// (func $copy_loop (param $n i32) (param $size i32) (local $i i32)
+//   loop
+//     (local.set $i (i32.const 0))
+//     loop
+//       (i32.store8 offset=65536 (local.get $i)
+//                                (i32.load8_u (local.get $i)))
+//       (br_if 0 (i32.lt_u (local.tee $i (i32.add (local.get $i)
+//                                                 (i32.const 1)))
+//                          (local.get $size)))
+//     end
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end)
+// $fill_bulk and $fill_loop store 0x55 instead of loading.
+static const unsigned char bench_bulk_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x02, 0x7F, 0x7F, 0x00, 0x03, 0x05, 0x04, 0x00, 0x00, 0x00, 0x00, 0x05,
+    0x03, 0x01, 0x00, 0x02, 0x0A, 0x95, 0x01, 0x04, 0x1A, 0x00, 0x03, 0x40,
+    0x41, 0x80, 0x80, 0x04, 0x41, 0x00, 0x20, 0x01, 0xFC, 0x0A, 0x00, 0x00,
+    0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00, 0x0B, 0x0B, 0x2F,
+    0x01, 0x01, 0x7F, 0x03, 0x40, 0x41, 0x00, 0x21, 0x02, 0x03, 0x40, 0x20,
+    0x02, 0x20, 0x02, 0x2D, 0x00, 0x00, 0x3A, 0x00, 0x80, 0x80, 0x04, 0x20,
+    0x02, 0x41, 0x01, 0x6A, 0x22, 0x02, 0x20, 0x01, 0x49, 0x0D, 0x00, 0x0B,
+    0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00, 0x0B, 0x0B, 0x1A,
+    0x00, 0x03, 0x40, 0x41, 0x80, 0x80, 0x04, 0x41, 0xD5, 0x00, 0x20, 0x01,
+    0xFC, 0x0B, 0x00, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00,
+    0x0B, 0x0B, 0x2D, 0x01, 0x01, 0x7F, 0x03, 0x40, 0x41, 0x00, 0x21, 0x02,
+    0x03, 0x40, 0x20, 0x02, 0x41, 0xD5, 0x00, 0x3A, 0x00, 0x80, 0x80, 0x04,
+    0x20, 0x02, 0x41, 0x01, 0x6A, 0x22, 0x02, 0x20, 0x01, 0x49, 0x0D, 0x00,
+    0x0B, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00, 0x0B, 0x0B};
+
+enum {
+  bench_func_copy_bulk,
+  bench_func_copy_loop,
+  bench_func_fill_bulk,
+  bench_func_fill_loop,
+};
+
+// Bytes that are processed by one measurement. The loops are much slower so
+// they process less.
+#define bench_bulk_bytes (256u * 1024 * 1024)
+#define bench_loop_bytes (16u * 1024 * 1024)
+
+static void bench_run_bulk(wasm_instance *instance, const char *name,
+                           uint32_t funcidx, uint32_t size,
+                           uint32_t total_bytes) {
+  uint32_t count = total_bytes / size;
+  wasm_value args[2] = {{.i32 = (int32_t)count}, {.i32 = (int32_t)size}};
+
+  uint64_t start = bench_now_ns();
+  enum wasm_trap trap = wasm_invoke(instance, funcidx, args, NULL);
+  uint64_t ns = bench_now_ns() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s %u B", name, size);
+  if (trap) {
+    printf("%s failed: %s\n", label, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report_throughput(label, ns, (uint64_t)count * size);
+}
+
+void bench_bulk(void) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_bulk_module,
+                          sizeof(bench_bulk_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  if (instance == NULL) {
+    puts("bench_bulk: failed to instantiate module");
+  } else {
+    static const uint32_t sizes[] = {16, 256, 4096, 65536};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      bench_run_bulk(instance, "memory.copy", bench_func_copy_bulk, sizes[i],
+                     bench_bulk_bytes);
+      bench_run_bulk(instance, "byte copy loop", bench_func_copy_loop,
+                     sizes[i], bench_loop_bytes);
+      bench_run_bulk(instance, "memory.fill", bench_func_fill_bulk, sizes[i],
+                     bench_bulk_bytes);
+      bench_run_bulk(instance, "byte fill loop", bench_func_fill_loop,
+                     sizes[i], bench_loop_bytes);
+    }
+  }
+
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
@@ -0,0 +1,170 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+
+// Call heavy recursion: the throughput of calls and returns between wasm
+// functions and how deep the recursion can get before it traps.
+
+#define bench_fib_n 27
+#define bench_ack_m 3
+#define bench_ack_n 8
+
+enum {
+  bench_func_fib,
+  bench_func_ack_call,
+  bench_func_ack_tail,
+  bench_func_depth,
+  bench_calls_func_count,
+};
+
+static const struct {
+  // 0: (i32) -> i32, 1: (i32 i32) -> i32
+  unsigned char typeidx;
+  // Declared locals and instructions.
+  const char *body;
+  size_t size;
+} bench_calls_funcs[] = {
+#define BENCH_CALLS_FUNC(typeidx, body) {typeidx, body, sizeof(body) - 1}
+    // n < 2 ? n : fib(n - 1) + fib(n - 2)
+    BENCH_CALLS_FUNC(0, "\x00"
+                        "\x20\x00\x41\x02\x48\x04\x7F\x20\x00\x05"
+                        "\x20\x00\x41\x01\x6B\x10\x00"
+                        "\x20\x00\x41\x02\x6B\x10\x00\x6A\x0B\x0B"),
+    // m == 0 ? n + 1 : n == 0 ? ack(m - 1, 1) : ack(m - 1, ack(m, n - 1))
+    BENCH_CALLS_FUNC(1, "\x00"
+                        "\x20\x00\x45\x04\x40\x20\x01\x41\x01\x6A\x0F\x0B"
+                        "\x20\x01\x45\x04\x40\x20\x00\x41\x01\x6B\x41\x01"
+                        "\x10\x01\x0F\x0B"
+                        "\x20\x00\x41\x01\x6B\x20\x00\x20\x01\x41\x01\x6B"
+                        "\x10\x01\x10\x01\x0B"),
+    // The same with `return_call` for the calls in tail position.
+    BENCH_CALLS_FUNC(1, "\x00"
+                        "\x20\x00\x45\x04\x40\x20\x01\x41\x01\x6A\x0F\x0B"
+                        "\x20\x01\x45\x04\x40\x20\x00\x41\x01\x6B\x41\x01"
+                        "\x12\x02\x0B"
+                        "\x20\x00\x41\x01\x6B\x20\x00\x20\x01\x41\x01\x6B"
+                        "\x10\x02\x12\x02\x0B"),
+    // n == 0 ? 0 : depth(n - 1) + 1
+    BENCH_CALLS_FUNC(0, "\x00"
+                        "\x20\x00\x45\x04\x40\x41\x00\x0F\x0B"
+                        "\x20\x00\x41\x01\x6B\x10\x03\x41\x01\x6A\x0B"),
+#undef BENCH_CALLS_FUNC
+};
+
+static void bench_build_calls_module(bench_buf *out) {
+  bench_buf section;
+  bench_buf_init(&section);
+
+  bench_emit_header(out);
+
+  bench_emit_bytes(&section, "\x02\x60\x01\x7F\x01\x7F\x60\x02\x7F\x7F\x01\x7F",
+                   12);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, bench_calls_func_count);
+  for (uint32_t i = 0; i < bench_calls_func_count; i++) {
+    bench_emit_byte(&section, bench_calls_funcs[i].typeidx);
+  }
+  bench_emit_section(out, 3, &section);
+
+  bench_emit_u32(&section, bench_calls_func_count);
+  for (uint32_t i = 0; i < bench_calls_func_count; i++) {
+    bench_emit_u32(&section, (uint32_t)bench_calls_funcs[i].size);
+    bench_emit_bytes(&section, bench_calls_funcs[i].body,
+                     bench_calls_funcs[i].size);
+  }
+  bench_emit_section(out, 10, &section);
+
+  bench_buf_deinit(&section);
+}
+
+// Number of calls the kernels make, counted the slow way.
+static uint64_t bench_fib_calls(uint32_t n) {
+  return n < 2 ? 1 : 1 + bench_fib_calls(n - 1) + bench_fib_calls(n - 2);
+}
+
+static uint32_t bench_ack(uint32_t m, uint32_t n, uint64_t *calls) {
+  ++*calls;
+  if (m == 0) {
+    return n + 1;
+  }
+  if (n == 0) {
+    return bench_ack(m - 1, 1, calls);
+  }
+  return bench_ack(m - 1, bench_ack(m, n - 1, calls), calls);
+}
+
+static void bench_run_calls(wasm_instance *instance, const char *name,
+                            uint32_t funcidx, const wasm_value *args,
+                            int32_t expected, uint64_t calls) {
+  wasm_value result;
+  uint64_t start = bench_now_ns();
+  enum wasm_trap trap = wasm_invoke(instance, funcidx, args, &result);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (trap || result.i32 != expected) {
+    printf("%s failed: %s\n", name, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report(name, ns, calls);
+}
+
+// Finds the deepest recursion of `depth` that doesn't trap.
+static uint32_t bench_max_depth(wasm_instance *instance, uint32_t limit) {
+  uint32_t low = 0, high = limit;
+  while (low < high) {
+    uint32_t mid = low + (high - low + 1) / 2;
+    wasm_value arg = {.i32 = (int32_t)mid};
+    wasm_value result;
+    if (wasm_invoke(instance, bench_func_depth, &arg, &result) ==
+        wasm_trap_none) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+void bench_calls(void) {
+  bench_buf module_bytes;
+  bench_buf_init(&module_bytes);
+  bench_build_calls_module(&module_bytes);
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, module_bytes.data, module_bytes.size);
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  if (instance == NULL) {
+    puts("bench_calls: failed to instantiate module");
+  } else {
+    wasm_value args[2] = {{.i32 = bench_fib_n}};
+    uint64_t calls = bench_fib_calls(bench_fib_n);
+    bench_run_calls(instance, "fib (per call)", bench_func_fib, args, 196418,
+                    calls);
+
+    args[0].i32 = bench_ack_m;
+    args[1].i32 = bench_ack_n;
+    calls = 0;
+    int32_t expected = (int32_t)bench_ack(bench_ack_m, bench_ack_n, &calls);
+    bench_run_calls(instance, "ackermann (per call)", bench_func_ack_call,
+                    args, expected, calls);
+    bench_run_calls(instance, "ackermann return_call (per call)",
+                    bench_func_ack_tail, args, expected, calls);
+
+    uint32_t depth = bench_max_depth(instance, instance->max_call_depth);
+    printf("%-40s %12u calls\n", "max depth (default limit)", depth);
+    // Without the limit the value stack is the bound.
+    uint32_t limit = 10000000;
+    if (wasm_instance_set_max_call_depth(instance, limit)) {
+      depth = bench_max_depth(instance, limit);
+      printf("%-40s %12u calls\n", "max depth (value stack)", depth);
+    }
+  }
+
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+  bench_buf_deinit(&module_bytes);
+}
@@ -0,0 +1,144 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm_check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Batch validation as done by `wasm --check` over a generated corpus of
+// modules of different sizes, with an increasing number of threads.
+
+#define bench_corpus_size 400
+#define bench_check_threads_max 16
+
+// A module with `func_count` functions that each add 1 to their parameter a
+// few times and an export for every function.
+static void bench_build_corpus_module(bench_buf *out, uint32_t func_count) {
+  bench_buf section, body;
+  bench_buf_init(&section);
+  bench_buf_init(&body);
+
+  bench_emit_header(out);
+
+  // type 0: (i32) -> i32
+  bench_emit_bytes(&section, "\x01\x60\x01\x7F\x01\x7F", 6);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, func_count);
+  for (uint32_t i = 0; i < func_count; i++) {
+    bench_emit_byte(&section, 0);
+  }
+  bench_emit_section(out, 3, &section);
+
+  bench_emit_u32(&section, func_count);
+  for (uint32_t i = 0; i < func_count; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "f%u", i);
+    bench_emit_name(&section, name);
+    bench_emit_byte(&section, 0);
+    bench_emit_u32(&section, i);
+  }
+  bench_emit_section(out, 7, &section);
+
+  bench_emit_u32(&section, func_count);
+  for (uint32_t i = 0; i < func_count; i++) {
+    bench_emit_byte(&body, 0);
+    bench_emit_bytes(&body, "\x20\x00", 2);
+    for (uint32_t j = 0; j < 8 + i % 32; j++) {
+      bench_emit_bytes(&body, "\x41\x01\x6A", 3);
+    }
+    bench_emit_byte(&body, 0x0B);
+    bench_emit_u32(&section, (uint32_t)body.size);
+    bench_emit_bytes(&section, body.data, body.size);
+    bench_buf_clear(&body);
+  }
+  bench_emit_section(out, 10, &section);
+
+  bench_buf_deinit(&section);
+  bench_buf_deinit(&body);
+}
+
+// Writes the corpus into a new temporary directory. Returns false on failure.
+static bool bench_write_corpus(char *dir, char **paths) {
+  if (mkdtemp(dir) == NULL) {
+    perror("mkdtemp");
+    return false;
+  }
+
+  bench_buf module;
+  bench_buf_init(&module);
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < bench_corpus_size; i++) {
+    size_t length = strlen(dir) + 32;
+    paths[i] = malloc(length);
+    snprintf(paths[i], length, "%s/m%u.wasm", dir, i);
+
+    bench_buf_clear(&module);
+    bench_build_corpus_module(&module, 50 + (i * 37) % 400);
+    FILE *file = fopen(paths[i], "wb");
+    ok = file != NULL &&
+         fwrite(module.data, 1, module.size, file) == module.size;
+    if (file) {
+      fclose(file);
+    }
+  }
+  bench_buf_deinit(&module);
+  return ok;
+}
+
+static void bench_remove_corpus(const char *dir, char **paths) {
+  for (uint32_t i = 0; i < bench_corpus_size && paths[i]; i++) {
+    unlink(paths[i]);
+    free(paths[i]);
+  }
+  rmdir(dir);
+}
+
+void bench_check(void) {
+  char dir[] = "/tmp/wasm_bench_corpusXXXXXX";
+  char *paths[bench_corpus_size] = {NULL};
+  static wasm_check_result results[bench_corpus_size];
+
+  if (!bench_write_corpus(dir, paths)) {
+    puts("bench_check: failed to write the corpus");
+    bench_remove_corpus(dir, paths);
+    return;
+  }
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = cpus < 1 ? 1 : (uint32_t)cpus;
+  if (max_threads > bench_check_threads_max) {
+    max_threads = bench_check_threads_max;
+  }
+  uint64_t single_ns = 0;
+  for (uint32_t threads = 1;; threads *= 2) {
+    if (threads > max_threads) {
+      threads = max_threads;
+    }
+    uint64_t start = bench_now_ns();
+    wasm_check_modules((const char **)paths, bench_corpus_size, threads, 0,
+                       results);
+    uint64_t ns = bench_now_ns() - start;
+
+    for (uint32_t i = 0; i < bench_corpus_size; i++) {
+      if (!results[i].ok) {
+        printf("bench_check: %s failed\n", results[i].path);
+        bench_remove_corpus(dir, paths);
+        return;
+      }
+    }
+
+    if (threads == 1) {
+      single_ns = ns;
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "check corpus %u threads (%.2fx)", threads,
+             (double)single_ns / (double)ns);
+    bench_report_rate(label, ns, bench_corpus_size);
+    if (threads == max_threads) {
+      break;
+    }
+  }
+
+  bench_remove_corpus(dir, paths);
+}
@@ -0,0 +1,177 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+
+// Cost of calls from wasm into the host. Every run function loops `n` times
+// and passes an accumulator through the callee:
+//
+//   (func $run (param $n i32) (result i32) (local $acc i32)
+//     loop
+//       local.get $acc
+//       call $callee
+//       local.set $acc
+//       local.get $n
+//       i32.const 1
+//       i32.sub
+//       local.tee $n
+//       br_if 0
+//     end
+//     local.get $acc)
+
+#define bench_host_iterations 20000000
+
+enum {
+  bench_func_inc_typed,
+  bench_func_inc_raw,
+  bench_func_inc_guest,
+  bench_func_run_typed,
+  bench_func_run_raw,
+  bench_func_run_guest,
+  bench_func_run_inline,
+  bench_func_count,
+};
+
+static int32_t bench_inc_typed(wasm_instance *instance, void *user,
+                               int32_t value) {
+  (void)instance;
+  (void)user;
+  return value + 1;
+}
+
+static enum wasm_trap bench_inc_raw(const wasm_host_func *func,
+                                    wasm_instance *instance,
+                                    wasm_value *args) {
+  (void)func;
+  (void)instance;
+  args[0].i32++;
+  return wasm_trap_none;
+}
+
+static void bench_emit_run(bench_buf *code, bench_buf *body, int callee) {
+  bench_emit_bytes(body, "\x01\x01\x7F", 3); // local $acc i32
+  bench_emit_bytes(body, "\x03\x40\x20\x01", 4);
+  if (callee >= 0) {
+    bench_emit_byte(body, 0x10);
+    bench_emit_u32(body, (uint32_t)callee);
+  } else {
+    bench_emit_bytes(body, "\x41\x01\x6A", 3); // i32.const 1, i32.add
+  }
+  bench_emit_bytes(body,
+                   "\x21\x01\x20\x00\x41\x01\x6B\x22\x00\x0D\x00\x0B\x20\x01"
+                   "\x0B",
+                   15);
+  bench_emit_u32(code, (uint32_t)body->size);
+  bench_emit_bytes(code, body->data, body->size);
+  bench_buf_clear(body);
+}
+
+static void bench_build_host_module(bench_buf *out) {
+  bench_buf section, body;
+  bench_buf_init(&section);
+  bench_buf_init(&body);
+
+  bench_emit_header(out);
+
+  // type 0: (i32) -> i32
+  bench_emit_bytes(&section, "\x01\x60\x01\x7F\x01\x7F", 6);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, 2);
+  bench_emit_name(&section, "env");
+  bench_emit_name(&section, "inc_typed");
+  bench_emit_bytes(&section, "\x00\x00", 2);
+  bench_emit_name(&section, "env");
+  bench_emit_name(&section, "inc_raw");
+  bench_emit_bytes(&section, "\x00\x00", 2);
+  bench_emit_section(out, 2, &section);
+
+  uint32_t defined = bench_func_count - bench_func_inc_guest;
+  bench_emit_u32(&section, defined);
+  for (uint32_t i = 0; i < defined; i++) {
+    bench_emit_byte(&section, 0);
+  }
+  bench_emit_section(out, 3, &section);
+
+  const char *names[] = {"run_typed", "run_raw", "run_guest", "run_inline"};
+  bench_emit_u32(&section, 4);
+  for (uint32_t i = 0; i < 4; i++) {
+    bench_emit_name(&section, names[i]);
+    bench_emit_byte(&section, 0);
+    bench_emit_u32(&section, bench_func_run_typed + i);
+  }
+  bench_emit_section(out, 7, &section);
+
+  bench_emit_u32(&section, defined);
+  // inc_guest: local.get 0, i32.const 1, i32.add
+  bench_emit_bytes(&section, "\x07\x00\x20\x00\x41\x01\x6A\x0B", 8);
+  bench_emit_run(&section, &body, bench_func_inc_typed);
+  bench_emit_run(&section, &body, bench_func_inc_raw);
+  bench_emit_run(&section, &body, bench_func_inc_guest);
+  bench_emit_run(&section, &body, -1);
+  bench_emit_section(out, 10, &section);
+
+  bench_buf_deinit(&section);
+  bench_buf_deinit(&body);
+}
+
+static void bench_run(wasm_instance *instance, const char *name,
+                      uint32_t funcidx) {
+  wasm_value arg = {.i32 = bench_host_iterations};
+  wasm_value result;
+
+  uint64_t start = bench_now_ns();
+  enum wasm_trap trap = wasm_invoke(instance, funcidx, &arg, &result);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (trap || result.i32 != bench_host_iterations) {
+    printf("%s failed: %s\n", name, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report(name, ns, bench_host_iterations);
+}
+
+// Prevents the native baseline from being inlined.
+static int32_t (*volatile bench_native_inc)(wasm_instance *, void *,
+                                            int32_t) = &bench_inc_typed;
+
+void bench_host(void) {
+  bench_buf module_bytes;
+  bench_buf_init(&module_bytes);
+  bench_build_host_module(&module_bytes);
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, module_bytes.data, module_bytes.size);
+  wasm_module *module = wasm_load_module(&reader);
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_host_imports_add(&imports, "env", "inc_typed", "(i)i", &bench_inc_typed,
+                        NULL);
+  wasm_host_imports_add_raw(&imports, "env", "inc_raw", "(i)i", &bench_inc_raw,
+                            NULL);
+
+  wasm_instance *instance = module ? wasm_instantiate(module, &imports) : NULL;
+  if (instance == NULL) {
+    puts("bench_host: failed to instantiate module");
+  } else {
+    bench_run(instance, "host call (typed trampoline)", bench_func_run_typed);
+    bench_run(instance, "host call (raw)", bench_func_run_raw);
+    bench_run(instance, "guest call", bench_func_run_guest);
+    bench_run(instance, "loop without call", bench_func_run_inline);
+
+    int32_t acc = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < bench_host_iterations; i++) {
+      acc = bench_native_inc(NULL, NULL, acc);
+    }
+    bench_report("native indirect call", bench_now_ns() - start,
+                 bench_host_iterations);
+  }
+
+  wasm_free_instance(instance);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+  bench_buf_deinit(&module_bytes);
+}
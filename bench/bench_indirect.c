@@ -0,0 +1,128 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+
+// Virtual dispatch as emitted for C++ vtables: the target is loaded from the
+// table with `call_indirect` and checked against the expected signature. The
+// run functions loop `n` times and pass an accumulator through the callee.
+
+#define bench_indirect_iterations 20000000
+#define bench_indirect_methods 8
+
+enum {
+  bench_run_direct = bench_indirect_methods,
+  bench_run_monomorphic,
+  bench_run_polymorphic_2,
+  bench_run_polymorphic_8,
+  bench_indirect_func_count,
+};
+
+// `call` is the instruction sequence that consumes the accumulator and
+// produces the new one.
+static void bench_emit_loop(bench_buf *code, bench_buf *body, const void *call,
+                            size_t call_size) {
+  bench_emit_bytes(body, "\x01\x01\x7F", 3); // local $acc i32
+  bench_emit_bytes(body, "\x03\x40\x20\x01", 4);
+  bench_emit_bytes(body, call, call_size);
+  bench_emit_bytes(body,
+                   "\x21\x01\x20\x00\x41\x01\x6B\x22\x00\x0D\x00\x0B\x20\x01"
+                   "\x0B",
+                   15);
+  bench_emit_u32(code, (uint32_t)body->size);
+  bench_emit_bytes(code, body->data, body->size);
+  bench_buf_clear(body);
+}
+
+static void bench_build_indirect_module(bench_buf *out) {
+  bench_buf section, body;
+  bench_buf_init(&section);
+  bench_buf_init(&body);
+
+  bench_emit_header(out);
+
+  // type 0: (i32) -> i32. Type 1 is the same signature and must share the
+  // canonical id.
+  bench_emit_bytes(&section, "\x02\x60\x01\x7F\x01\x7F\x60\x01\x7F\x01\x7F",
+                   11);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, bench_indirect_func_count);
+  for (uint32_t i = 0; i < bench_indirect_func_count; i++) {
+    bench_emit_byte(&section, i < bench_indirect_methods ? 1 : 0);
+  }
+  bench_emit_section(out, 3, &section);
+
+  // table with all methods
+  bench_emit_bytes(&section, "\x01\x70\x00", 3);
+  bench_emit_u32(&section, bench_indirect_methods);
+  bench_emit_section(out, 4, &section);
+
+  bench_emit_bytes(&section, "\x01\x00\x41\x00\x0B", 5);
+  bench_emit_u32(&section, bench_indirect_methods);
+  for (uint32_t i = 0; i < bench_indirect_methods; i++) {
+    bench_emit_u32(&section, i);
+  }
+  bench_emit_section(out, 9, &section);
+
+  bench_emit_u32(&section, bench_indirect_func_count);
+  for (uint32_t i = 0; i < bench_indirect_methods; i++) {
+    // local.get 0, i32.const 1, i32.add
+    bench_emit_bytes(&section, "\x07\x00\x20\x00\x41\x01\x6A\x0B", 8);
+  }
+  // call 0
+  bench_emit_loop(&section, &body, "\x10\x00", 2);
+  // i32.const 0, call_indirect 0
+  bench_emit_loop(&section, &body, "\x41\x00\x11\x00\x00", 5);
+  // local.get $n, i32.const 1, i32.and, call_indirect 0
+  bench_emit_loop(&section, &body, "\x20\x00\x41\x01\x71\x11\x00\x00", 8);
+  // local.get $n, i32.const 7, i32.and, call_indirect 0
+  bench_emit_loop(&section, &body, "\x20\x00\x41\x07\x71\x11\x00\x00", 8);
+  bench_emit_section(out, 10, &section);
+
+  bench_buf_deinit(&section);
+  bench_buf_deinit(&body);
+}
+
+static void bench_run_indirect(wasm_instance *instance, const char *name,
+                               uint32_t funcidx) {
+  wasm_value arg = {.i32 = bench_indirect_iterations};
+  wasm_value result;
+
+  uint64_t start = bench_now_ns();
+  enum wasm_trap trap = wasm_invoke(instance, funcidx, &arg, &result);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (trap || result.i32 != bench_indirect_iterations) {
+    printf("%s failed: %s\n", name, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report(name, ns, bench_indirect_iterations);
+}
+
+void bench_indirect(void) {
+  bench_buf module_bytes;
+  bench_buf_init(&module_bytes);
+  bench_build_indirect_module(&module_bytes);
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, module_bytes.data, module_bytes.size);
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  if (instance == NULL) {
+    puts("bench_indirect: failed to instantiate module");
+  } else {
+    bench_run_indirect(instance, "direct call", bench_run_direct);
+    bench_run_indirect(instance, "call_indirect (1 target)",
+                       bench_run_monomorphic);
+    bench_run_indirect(instance, "call_indirect (2 targets)",
+                       bench_run_polymorphic_2);
+    bench_run_indirect(instance, "call_indirect (8 targets)",
+                       bench_run_polymorphic_8);
+  }
+
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+  bench_buf_deinit(&module_bytes);
+}
@@ -0,0 +1,261 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_perf.h"
+#include "wasm/wasm_reader.h"
+#include "wasm/wasm_simd.h"
+#include "wasm/wasm_utf8.h"
+#include <string.h>
+
+// The loader on synthetic modules: header and section parsing of whole
+// modules, leb decoding, UTF-8 validation of names at every SIMD level and
+// freeing the module. Loading with perf stats shows what the per section and
+// per function samples cost.
+// Every result is reported per operation and per input byte.
+
+// Keeps results alive.
+static volatile uint32_t bench_sink;
+
+// About this many bytes are parsed per measurement.
+#define bench_parse_bytes (64u * 1024 * 1024)
+
+typedef struct {
+  const char *name;
+  bench_module_config config;
+} bench_parse_case;
+
+static const bench_parse_case bench_parse_cases[] = {
+    {"small", {4, 16, 4, 32, 0, 8, false, 1}},
+    {"medium", {64, 2000, 200, 64, 0, 16, false, 2}},
+    {"large", {512, 50000, 5000, 128, 0, 16, false, 3}},
+    {"many types", {20000, 20000, 0, 8, 0, 8, false, 4}},
+    {"many exports", {16, 20000, 20000, 8, 0, 32, false, 5}},
+    {"utf-8 exports", {16, 20000, 20000, 8, 0, 32, true, 6}},
+    {"5 byte lebs", {64, 2000, 200, 64, 5, 16, false, 2}},
+};
+
+static uint32_t bench_repeat_for(size_t size) {
+  uint32_t repeat = (uint32_t)(bench_parse_bytes / size);
+  return repeat ? repeat : 1;
+}
+
+// Heap held by a loaded module per function. Malloc adds its own header to
+// every block so the allocations are reported as well.
+static void bench_parse_memory(const bench_parse_case *test, bench_buf *buf) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, buf->data, buf->size);
+  size_t blocks = wasm_alloc_count();
+  wasm_reset_thread_allocs();
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_thread_allocs allocs = wasm_get_thread_allocs();
+  blocks = wasm_alloc_count() - blocks;
+  wasm_free_module(module);
+  if (module == NULL || allocs.count == 0) {
+    return;
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "memory %s", test->name);
+  double funcs = test->config.func_count ? test->config.func_count : 1;
+  printf("%-40s %12.1f B/func %9.2f allocs/func\n", label,
+         (double)allocs.bytes / funcs, (double)blocks / funcs);
+}
+
+static void bench_parse_module(const bench_parse_case *test) {
+  bench_buf buf;
+  bench_buf_init(&buf);
+  bench_build_module(&buf, &test->config);
+  uint32_t repeat = bench_repeat_for(buf.size);
+
+  uint64_t load_ns = 0;
+  uint64_t free_ns = 0;
+  for (uint32_t i = 0; i < repeat; i++) {
+    wasm_reader reader;
+    wasm_init_memory_reader(&reader, buf.data, buf.size);
+    uint64_t start = bench_now_ns();
+    wasm_module *module = wasm_load_module(&reader);
+    uint64_t loaded = bench_now_ns();
+    wasm_free_module(module);
+    free_ns += bench_now_ns() - loaded;
+    load_ns += loaded - start;
+
+    if (module == NULL) {
+      printf("bench_parse: %s failed to load\n", test->name);
+      bench_buf_deinit(&buf);
+      return;
+    }
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "load %s", test->name);
+  bench_report_bytes(label, load_ns, repeat, (uint64_t)buf.size * repeat);
+  snprintf(label, sizeof(label), "free %s", test->name);
+  bench_report_bytes(label, free_ns, repeat, (uint64_t)buf.size * repeat);
+  bench_parse_memory(test, &buf);
+  bench_buf_deinit(&buf);
+}
+
+// Loads the module while the thread records perf stats.
+static void bench_parse_perf_stats(const bench_parse_case *test) {
+  bench_buf buf;
+  bench_buf_init(&buf);
+  bench_build_module(&buf, &test->config);
+  uint32_t repeat = bench_repeat_for(buf.size);
+
+  wasm_perf_stats stats;
+  wasm_init_perf_stats(&stats);
+  wasm_set_perf_stats(&stats);
+  bool ok = true;
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; ok && i < repeat; i++) {
+    wasm_reader reader;
+    wasm_init_memory_reader(&reader, buf.data, buf.size);
+    stats.funcs.end = stats.funcs.start;
+    wasm_module *module = wasm_load_module(&reader);
+    ok = module != NULL;
+    wasm_free_module(module);
+  }
+  uint64_t ns = bench_now_ns() - start;
+  wasm_set_perf_stats(NULL);
+
+  if (!ok) {
+    printf("bench_parse: %s failed to load\n", test->name);
+  } else {
+    char label[64];
+    snprintf(label, sizeof(label), "load %s (perf stats%s)", test->name,
+             stats.events ? "" : ", clock only");
+    bench_report_bytes(label, ns, repeat, (uint64_t)buf.size * repeat);
+  }
+  wasm_deinit_perf_stats(&stats);
+  bench_buf_deinit(&buf);
+}
+
+// Decodes a buffer of u32 lebs that all have `width` bytes.
+static void bench_parse_lebs(int width) {
+  bench_buf buf;
+  bench_buf_init(&buf);
+  uint32_t count = bench_parse_bytes / 4 / (uint32_t)width;
+  uint32_t max = width >= 5 ? UINT32_MAX : (1u << (7 * width)) - 1;
+  uint32_t random = 7;
+  for (uint32_t i = 0; i < count; i++) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    bench_emit_u32_width(&buf, random & max, width);
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, buf.data, buf.size);
+  uint32_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t value;
+    wasm_read_leb_u32_2(&reader, &value);
+    sum += value;
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  char label[64];
+  bench_sink = sum;
+  snprintf(label, sizeof(label), "leb u32 %d bytes", width);
+  bench_report_bytes(label, ns, count, buf.size);
+  bench_buf_deinit(&buf);
+}
+
+// Reads strings of `length` bytes. Multibyte strings mix 2 and 3 byte
+// sequences.
+static void bench_parse_names(uint32_t length, bool multibyte) {
+  bench_buf buf;
+  bench_buf_init(&buf);
+  uint32_t count = bench_parse_bytes / 4 / length;
+  for (uint32_t i = 0; i < count; i++) {
+    bench_emit_u32(&buf, length);
+    for (uint32_t j = 0; j < length;) {
+      if (multibyte && length - j >= 3) {
+        bool wide = (i + j) % 2 == 1;
+        bench_emit_bytes(&buf, wide ? "\xE2\x82\xAC" : "\xC3\xA9",
+                         wide ? 3 : 2);
+        j += wide ? 3 : 2;
+      } else {
+        bench_emit_byte(&buf, (unsigned char)('a' + (i + j) % 26));
+        j++;
+      }
+    }
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, buf.data, buf.size);
+  bool ok = true;
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; ok && i < count; i++) {
+    char *str;
+    ok = wasm_read_string(&reader, &str);
+    if (ok) {
+      wasm_free(str);
+    }
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  if (!ok) {
+    puts("bench_parse: invalid name");
+  } else {
+    char label[64];
+    snprintf(label, sizeof(label), "names %u bytes %s", length,
+             multibyte ? "utf-8" : "ascii");
+    bench_report_bytes(label, ns, count, buf.size);
+  }
+  bench_buf_deinit(&buf);
+}
+
+// Validates a 64 KiB name section worth of text at every SIMD level.
+static void bench_parse_utf8(bool multibyte) {
+  enum { size = 64 * 1024 };
+  static char text[size];
+  for (size_t i = 0; i < size;) {
+    if (multibyte && size - i >= 3 && i % 5 == 0) {
+      memcpy(text + i, "\xE2\x82\xAC", 3);
+      i += 3;
+    } else {
+      text[i] = (char)('a' + i % 26);
+      i++;
+    }
+  }
+
+  enum wasm_simd_level best = wasm_simd_detect_level();
+  uint32_t repeat = bench_repeat_for(size);
+  for (enum wasm_simd_level level = wasm_simd_scalar; level <= best;
+       level++) {
+    wasm_simd_set_level(level);
+    uint32_t valid = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < repeat; i++) {
+      valid += wasm_validate_utf8(text, size);
+    }
+    uint64_t ns = bench_now_ns() - start;
+    bench_sink = valid;
+
+    char label[64];
+    snprintf(label, sizeof(label), "utf-8 %s %s",
+             multibyte ? "mixed" : "ascii", wasm_simd_level_to_str(level));
+    bench_report_bytes(label, ns, repeat, (uint64_t)size * repeat);
+  }
+  wasm_simd_set_level(best);
+}
+
+void bench_parse(void) {
+  for (size_t i = 0;
+       i < sizeof(bench_parse_cases) / sizeof(bench_parse_cases[0]); i++) {
+    bench_parse_module(&bench_parse_cases[i]);
+  }
+  // Includes the free, compare with load plus free of the same module.
+  bench_parse_perf_stats(&bench_parse_cases[1]);
+  for (int width = 1; width <= 5; width += 2) {
+    bench_parse_lebs(width);
+  }
+  bench_parse_names(8, false);
+  bench_parse_names(64, false);
+  bench_parse_names(64, true);
+  bench_parse_utf8(false);
+  bench_parse_utf8(true);
+}
@@ -0,0 +1,80 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_print.h"
+#include "wasm/wasm_reader.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+// The text printer on a large synthetic module: into memory, and to
+// /dev/null through the write buffer on one and on all threads. Reported as
+// text bytes per second.
+
+#define bench_print_threads_max 16
+
+static void bench_print_run(const char *name, const wasm_module *module,
+                            int fd, uint32_t thread_count) {
+  // The first run only warms up the buffers and the page cache.
+  uint64_t ns = 0, bytes = 0;
+  for (int i = 0; i < 4; i++) {
+    wasm_text_out out;
+    wasm_init_text_out(&out, fd);
+    uint64_t start = bench_now_ns();
+    bool ok = wasm_print_wat(&out, module, thread_count);
+    ok = wasm_flush_text_out(&out) && ok;
+    uint64_t end = bench_now_ns();
+    if (!ok) {
+      fprintf(stderr, "%s: failed to print\n", name);
+    }
+    if (i > 0) {
+      ns += end - start;
+      bytes += fd >= 0 ? out.written : out.size;
+    }
+    wasm_deinit_text_out(&out);
+  }
+  bench_report_throughput(name, ns, bytes);
+}
+
+void bench_print(void) {
+  bench_module_config config = {
+      .type_count = 512,
+      .func_count = 50000,
+      .export_count = 5000,
+      .body_size = 128,
+      .name_length = 16,
+      .seed = 3,
+  };
+  bench_buf buf;
+  bench_buf_init(&buf);
+  bench_build_module(&buf, &config);
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, buf.data, buf.size);
+  wasm_module *module = wasm_load_module(&reader);
+  int fd = open("/dev/null", O_WRONLY);
+  if (module == NULL || fd < 0) {
+    fprintf(stderr, "print: setup failed\n");
+    goto end;
+  }
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = cpus < 1 ? 1 : (uint32_t)cpus;
+  if (max_threads > bench_print_threads_max) {
+    max_threads = bench_print_threads_max;
+  }
+
+  bench_print_run("print wat (memory)", module, -1, 1);
+  bench_print_run("print wat (/dev/null, 1 thread)", module, fd, 1);
+  if (max_threads > 1) {
+    char label[64];
+    snprintf(label, sizeof(label), "print wat (/dev/null, %u threads)",
+             max_threads);
+    bench_print_run(label, module, fd, max_threads);
+  }
+
+end:
+  if (fd >= 0) {
+    close(fd);
+  }
+  wasm_free_module(module);
+  bench_buf_deinit(&buf);
+}
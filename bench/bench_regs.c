@@ -0,0 +1,141 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_exec.h"
+
+// Loops that are dominated by local and constant traffic, run once compiled
+// to plain stack code and once lowered to register forms. Every kernel takes
+// the iteration count and counts it down to zero.
+
+#define bench_regs_iterations 20000000
+
+static const struct {
+  const char *name;
+  // Declared locals and instructions without the final `end`.
+  const char *body;
+  size_t size;
+} bench_regs_kernels[] = {
+#define BENCH_REGS_KERNEL(name, body) {name, body, sizeof(body) - 1}
+    // acc += n
+    BENCH_REGS_KERNEL("sum loop",
+                      "\x01\x01\x7F"
+                      "\x03\x40\x20\x01\x20\x00\x6A\x21\x01"
+                      "\x20\x00\x41\x01\x6B\x22\x00\x0D\x00\x0B\x20\x01"),
+    // t = a + b, a = b, b = t
+    BENCH_REGS_KERNEL("fib loop",
+                      "\x01\x03\x7F"
+                      "\x41\x01\x21\x02"
+                      "\x03\x40\x20\x01\x20\x02\x6A\x21\x03"
+                      "\x20\x02\x21\x01\x20\x03\x21\x02"
+                      "\x20\x00\x41\x01\x6B\x22\x00\x0D\x00\x0B\x20\x01"),
+    // acc += i32.load((n << 2) & 1020)
+    BENCH_REGS_KERNEL("load loop",
+                      "\x01\x01\x7F"
+                      "\x03\x40\x20\x01\x20\x00\x41\x02\x74"
+                      "\x41\xFC\x07\x71\x28\x02\x00\x6A\x21\x01"
+                      "\x20\x00\x41\x01\x6B\x22\x00\x0D\x00\x0B\x20\x01"),
+#undef BENCH_REGS_KERNEL
+};
+
+#define bench_regs_kernel_count                                                \
+  (sizeof(bench_regs_kernels) / sizeof(bench_regs_kernels[0]))
+
+static void bench_build_regs_module(bench_buf *out) {
+  bench_buf section;
+  bench_buf_init(&section);
+
+  bench_emit_header(out);
+
+  // (i32) -> i32
+  bench_emit_bytes(&section, "\x01\x60\x01\x7F\x01\x7F", 6);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, bench_regs_kernel_count);
+  for (size_t i = 0; i < bench_regs_kernel_count; i++) {
+    bench_emit_byte(&section, 0);
+  }
+  bench_emit_section(out, 3, &section);
+
+  // One page.
+  bench_emit_bytes(&section, "\x01\x00\x01", 3);
+  bench_emit_section(out, 5, &section);
+
+  bench_emit_u32(&section, bench_regs_kernel_count);
+  for (size_t i = 0; i < bench_regs_kernel_count; i++) {
+    bench_emit_u32(&section, (uint32_t)bench_regs_kernels[i].size + 1);
+    bench_emit_bytes(&section, bench_regs_kernels[i].body,
+                     bench_regs_kernels[i].size);
+    bench_emit_byte(&section, 0x0B);
+  }
+  bench_emit_section(out, 10, &section);
+
+  bench_buf_deinit(&section);
+}
+
+static wasm_instance *bench_regs_instantiate(wasm_module **module,
+                                             const bench_buf *bytes,
+                                             bool register_ir) {
+  wasm_set_register_ir(register_ir);
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bytes->data, bytes->size);
+  *module = wasm_load_module(&reader);
+  wasm_instance *instance = *module ? wasm_instantiate(*module, NULL) : NULL;
+  wasm_set_register_ir(true);
+  return instance;
+}
+
+static void bench_run_regs(wasm_instance *instance, uint32_t funcidx,
+                           const char *form) {
+  char name[64];
+  snprintf(name, sizeof(name), "%s (%s)", bench_regs_kernels[funcidx].name,
+           form);
+
+  wasm_value arg = {.i32 = bench_regs_iterations};
+  wasm_value result;
+#ifdef WASM_DISPATCH_COUNTING
+  uint64_t dispatches = instance->dispatch_count;
+#endif
+
+  uint64_t start = bench_now_ns();
+  enum wasm_trap trap = wasm_invoke(instance, funcidx, &arg, &result);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (trap) {
+    printf("%s failed: %s\n", name, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report(name, ns, bench_regs_iterations);
+#ifdef WASM_DISPATCH_COUNTING
+  printf("%-40s %12.2f dispatches/op\n", name,
+         (double)(instance->dispatch_count - dispatches) /
+             bench_regs_iterations);
+#endif
+}
+
+void bench_regs(void) {
+  bench_buf module_bytes;
+  bench_buf_init(&module_bytes);
+  bench_build_regs_module(&module_bytes);
+
+  wasm_module *stack_module, *register_module;
+  wasm_instance *stack =
+      bench_regs_instantiate(&stack_module, &module_bytes, false);
+  wasm_instance *registers =
+      bench_regs_instantiate(&register_module, &module_bytes, true);
+
+  if (stack == NULL || registers == NULL) {
+    puts("bench_regs: failed to instantiate module");
+  } else {
+    for (uint32_t i = 0; i < bench_regs_kernel_count; i++) {
+      bench_run_regs(stack, i, "stack");
+      bench_run_regs(registers, i, "register");
+    }
+  }
+
+  wasm_free_instance(stack);
+  wasm_free_instance(registers);
+  wasm_free_module(stack_module);
+  wasm_free_module(register_module);
+  bench_buf_deinit(&module_bytes);
+}
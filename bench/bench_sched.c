@@ -0,0 +1,150 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_sched.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+// Many instances multiplexed on the worker pool of the scheduler. Every
+// instance of the emscripten fixture runs one call of its exports as a task.
+// Optionally one long running loop per worker competes with them, which shows
+// the tail latency with and without preemption at the fuel checkpoints.
+//
+// (func $spin (param $n i32) (result i32)
+//   loop
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end
+//   (local.get $n))
+static const unsigned char bench_spin_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x0A, 0x12, 0x01, 0x10,
+    0x00, 0x03, 0x40, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00,
+    0x0B, 0x20, 0x00, 0x0B};
+
+#define bench_instance_count 10000
+#define bench_spin_iterations 10000000
+#define bench_slice 10000
+
+typedef struct {
+  uint64_t start;
+  uint64_t end;
+  enum wasm_trap trap;
+} bench_task;
+
+static void bench_task_done(enum wasm_trap trap, const wasm_value *result,
+                            void *user) {
+  (void)result;
+  bench_task *task = user;
+  task->end = bench_now_ns();
+  task->trap = trap;
+}
+
+static int bench_compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Spawns one task per fixture instance and reports the throughput and the
+// latency percentiles from spawning to completion.
+static void bench_run_sched(const char *name, uint32_t worker_count,
+                            int64_t slice, wasm_instance **instances,
+                            uint32_t *funcs, wasm_instance **spinners) {
+  static bench_task tasks[bench_instance_count];
+  static uint64_t latencies[bench_instance_count];
+  wasm_scheduler *scheduler = wasm_create_scheduler(worker_count, slice);
+  if (scheduler == NULL) {
+    return;
+  }
+
+  wasm_value spin_arg = {.i32 = bench_spin_iterations};
+  for (uint32_t i = 0; spinners && i < worker_count; i++) {
+    wasm_scheduler_spawn(scheduler, spinners[i], 0, &spin_arg, NULL, NULL);
+  }
+
+  // a(argc, argv) and b(size) of the fixture.
+  wasm_value args[2] = {{.i32 = 5}, {.i32 = 0}};
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < bench_instance_count; i++) {
+    tasks[i].start = bench_now_ns();
+    tasks[i].trap = wasm_trap_none;
+    wasm_scheduler_spawn(scheduler, instances[i], funcs[i % 2], args,
+                         bench_task_done, &tasks[i]);
+  }
+  wasm_scheduler_wait(scheduler);
+  uint64_t ns = bench_now_ns() - start;
+  wasm_free_scheduler(scheduler);
+
+  for (uint32_t i = 0; i < bench_instance_count; i++) {
+    if (tasks[i].trap) {
+      printf("%s failed: %s\n", name, wasm_trap_to_str(tasks[i].trap));
+      return;
+    }
+    latencies[i] = tasks[i].end - tasks[i].start;
+  }
+  qsort(latencies, bench_instance_count, sizeof(uint64_t), bench_compare_u64);
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s tasks", name);
+  bench_report(label, ns, bench_instance_count);
+  snprintf(label, sizeof(label), "%s p50", name);
+  bench_report_latency(label, latencies[bench_instance_count / 2]);
+  snprintf(label, sizeof(label), "%s p99", name);
+  bench_report_latency(label, latencies[bench_instance_count * 99 / 100]);
+}
+
+void bench_sched(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t worker_count = cpus < 1 ? 1 : (uint32_t)cpus;
+
+  wasm_module *module =
+      wasm_load_module_from_file("../tests/files/emscripten_1/a.out.wasm");
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_spin_module,
+                          sizeof(bench_spin_module));
+  wasm_module *spin_module = wasm_load_module(&reader);
+
+  wasm_export *a = module ? wasm_module_find_export(module, "a",
+                                                    wasm_export_func)
+                          : NULL;
+  wasm_export *b = module ? wasm_module_find_export(module, "b",
+                                                    wasm_export_func)
+                          : NULL;
+
+  static wasm_instance *instances[bench_instance_count];
+  wasm_instance **spinners = wasm_alloc_array(wasm_instance *, worker_count);
+  bool ok = a != NULL && b != NULL && spin_module != NULL;
+  uint32_t instance_count = 0;
+  for (; ok && instance_count < bench_instance_count; instance_count++) {
+    instances[instance_count] = wasm_instantiate(module, NULL);
+    ok = instances[instance_count] != NULL;
+  }
+  uint32_t spinner_count = 0;
+  for (; ok && spinner_count < worker_count; spinner_count++) {
+    spinners[spinner_count] = wasm_instantiate(spin_module, NULL);
+    ok = spinners[spinner_count] != NULL;
+  }
+
+  if (!ok) {
+    puts("bench_sched: failed to instantiate the emscripten fixture (run "
+         "from the build directory)");
+  } else {
+    uint32_t funcs[2] = {a->idx, b->idx};
+    bench_run_sched("10k instances", worker_count, bench_slice, instances,
+                    funcs, NULL);
+    bench_run_sched("10k instances + spin, preempted", worker_count,
+                    bench_slice, instances, funcs, spinners);
+    bench_run_sched("10k instances + spin, no preemption", worker_count,
+                    INT64_MAX, instances, funcs, spinners);
+  }
+
+  for (uint32_t i = 0; i < instance_count; i++) {
+    wasm_free_instance(instances[i]);
+  }
+  for (uint32_t i = 0; i < spinner_count; i++) {
+    wasm_free_instance(spinners[i]);
+  }
+  wasm_free(spinners);
+  wasm_free_module(spin_module);
+  wasm_free_module(module);
+}
@@ -0,0 +1,136 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm.h"
+#include <stdio.h>
+
+// Inspecting the exports of a large module, as a deploy pipeline does for
+// every module it ships. A full load decodes and copies every function body
+// and data segment, the section directory skips them by their length prefix
+// and only the export section is decoded.
+
+#define bench_section_funcs 20000
+#define bench_section_exports 200
+#define bench_section_data (1024 * 1024)
+#define bench_section_repeat 20
+
+static void bench_build_large_module(bench_buf *out) {
+  bench_buf section, body;
+  bench_buf_init(&section);
+  bench_buf_init(&body);
+
+  bench_emit_header(out);
+
+  // type 0: (i32) -> i32
+  bench_emit_bytes(&section, "\x01\x60\x01\x7F\x01\x7F", 6);
+  bench_emit_section(out, 1, &section);
+
+  bench_emit_u32(&section, bench_section_funcs);
+  for (uint32_t i = 0; i < bench_section_funcs; i++) {
+    bench_emit_byte(&section, 0);
+  }
+  bench_emit_section(out, 3, &section);
+
+  // memory 17 pages
+  bench_emit_bytes(&section, "\x01\x00\x11", 3);
+  bench_emit_section(out, 5, &section);
+
+  bench_emit_u32(&section, bench_section_exports);
+  for (uint32_t i = 0; i < bench_section_exports; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "f%u", i);
+    bench_emit_name(&section, name);
+    bench_emit_byte(&section, 0);
+    bench_emit_u32(&section, i * (bench_section_funcs / bench_section_exports));
+  }
+  bench_emit_section(out, 7, &section);
+
+  // Every body adds 1 to its parameter 40 times.
+  bench_emit_u32(&section, bench_section_funcs);
+  for (uint32_t i = 0; i < bench_section_funcs; i++) {
+    bench_emit_byte(&body, 0);
+    bench_emit_bytes(&body, "\x20\x00", 2);
+    for (int j = 0; j < 40; j++) {
+      bench_emit_bytes(&body, "\x41\x01\x6A", 3);
+    }
+    bench_emit_byte(&body, 0x0B);
+    bench_emit_u32(&section, (uint32_t)body.size);
+    bench_emit_bytes(&section, body.data, body.size);
+    bench_buf_clear(&body);
+  }
+  bench_emit_section(out, 10, &section);
+
+  // One active segment at address 0.
+  bench_emit_bytes(&section, "\x01\x00\x41\x00\x0B", 5);
+  bench_emit_u32(&section, bench_section_data);
+  for (uint32_t i = 0; i < bench_section_data; i++) {
+    bench_emit_byte(&section, (unsigned char)i);
+  }
+  bench_emit_section(out, 11, &section);
+
+  bench_emit_name(&section, "producers");
+  bench_emit_bytes(&section, "\x00", 1);
+  bench_emit_section(out, 0, &section);
+
+  bench_buf_deinit(&section);
+  bench_buf_deinit(&body);
+}
+
+void bench_sections(void) {
+  bench_buf module_data;
+  bench_buf_init(&module_data);
+  bench_build_large_module(&module_data);
+
+  uint64_t start = bench_now_ns();
+  size_t export_count = 0;
+  for (int i = 0; i < bench_section_repeat; i++) {
+    wasm_reader reader;
+    wasm_init_memory_reader(&reader, module_data.data, module_data.size);
+    wasm_module *module = wasm_load_module(&reader);
+    export_count += module ? wasm_vec_size(&module->exports) : 0;
+    wasm_free_module(module);
+  }
+  uint64_t ns = bench_now_ns() - start;
+  if (export_count != bench_section_exports * bench_section_repeat) {
+    puts("bench_sections: failed to load module");
+  } else {
+    bench_report("exports via full load", ns, bench_section_repeat);
+  }
+
+  start = bench_now_ns();
+  export_count = 0;
+  for (int i = 0; i < bench_section_repeat; i++) {
+    wasm_section_directory directory;
+    wasm_module *module =
+        wasm_read_section_directory(&directory, module_data.data,
+                                    module_data.size)
+            ? wasm_decode_sections(&directory, wasm_section_bit(7))
+            : NULL;
+    export_count += module ? wasm_vec_size(&module->exports) : 0;
+    wasm_free_module(module);
+    wasm_deinit_section_directory(&directory);
+  }
+  ns = bench_now_ns() - start;
+  if (export_count != bench_section_exports * bench_section_repeat) {
+    puts("bench_sections: failed to decode exports");
+  } else {
+    bench_report("exports via section directory", ns, bench_section_repeat);
+  }
+
+  start = bench_now_ns();
+  size_t found = 0;
+  for (int i = 0; i < bench_section_repeat; i++) {
+    wasm_section_directory directory;
+    found += wasm_read_section_directory(&directory, module_data.data,
+                                         module_data.size) &&
+             wasm_section_directory_find(&directory, 0, "producers");
+    wasm_deinit_section_directory(&directory);
+  }
+  ns = bench_now_ns() - start;
+  if (found != bench_section_repeat) {
+    puts("bench_sections: failed to find custom section");
+  } else {
+    bench_report("custom section via directory", ns, bench_section_repeat);
+  }
+
+  bench_buf_deinit(&module_data);
+}
@@ -0,0 +1,216 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_simd.h"
+
+// Small kernels written once with scalar and once with SIMD instructions. The
+// SIMD versions also run with the scalar fallback of the interpreter to show
+// what the host instructions gain. Every function takes the number of bytes.
+//
+// (memory 2)
+// (func $dot_scalar (param $n i32) (result i32) (local $i i32) (local $acc i32)
+//   loop
+//     (local.set $acc (i32.add (local.get $acc)
+//       (i32.mul (i32.load16_s (local.get $i))
+//                (i32.load16_s offset=16384 (local.get $i)))))
+//     (br_if 0 (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 2)))
+//                        (local.get $n)))
+//   end
+//   (local.get $acc))
+// (func $dot_simd (param $n i32) (result i32) (local $i i32) (local $acc v128)
+//   loop
+//     (local.set $acc (i32x4.add (local.get $acc)
+//       (i32x4.dot_i16x8_s (v128.load (local.get $i))
+//                          (v128.load offset=16384 (local.get $i)))))
+//     (br_if 0 (i32.lt_u (local.tee $i (i32.add (local.get $i) (i32.const 16)))
+//                        (local.get $n)))
+//   end
+//   ;; sum of the 4 lanes of $acc
+// )
+// (func $histogram_scalar (param $n i32) (result i32)
+//   (local $i i32) (local i32) (local $p i32)
+//   loop
+//     (local.set $p (i32.shl (i32.load8_u (local.get $i)) (i32.const 2)))
+//     (i32.store offset=65536 (local.get $p)
+//       (i32.add (i32.load offset=65536 (local.get $p)) (i32.const 1)))
+//     ;; $i += 1, br_if 0 while $i < $n
+//   end
+//   (i32.load offset=65536 (i32.const 0)))
+// (func $histogram_simd (param $n i32) (result i32)
+//   (local $i i32) (local $v v128) (local $p i32)
+//   loop
+//     (local.set $v (v128.load (local.get $i)))
+//     ;; for each lane k: the same update with
+//     ;; (i32.shl (i8x16.extract_lane_u k (local.get $v)) (i32.const 2))
+//     ;; $i += 16, br_if 0 while $i < $n
+//   end
+//   (i32.load offset=65536 (i32.const 0)))
+// (func $memchr_scalar (param $n i32) (result i32) (local $i i32)
+//   block
+//     loop
+//       (br_if 1 (i32.eq (i32.load8_u (local.get $i)) (i32.const 255)))
+//       ;; $i += 1, br_if 0 while $i < $n
+//     end
+//     (return (i32.const -1))
+//   end
+//   (local.get $i))
+// (func $memchr_simd (param $n i32) (result i32)
+//   (local $i i32) (local $needle v128) (local $mask i32)
+//   (local.set $needle (i8x16.splat (i32.const 255)))
+//   block
+//     loop
+//       (br_if 1 (local.tee $mask (i8x16.bitmask
+//         (i8x16.eq (v128.load (local.get $i)) (local.get $needle)))))
+//       ;; $i += 16, br_if 0 while $i < $n
+//     end
+//     (return (i32.const -1))
+//   end
+//   (i32.add (local.get $i) (i32.ctz (local.get $mask))))
+static const unsigned char bench_simd_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x03, 0x07, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x05, 0x03, 0x01, 0x00, 0x02, 0x0A, 0xE2, 0x05, 0x06, 0x27, 0x01,
+    0x02, 0x7F, 0x03, 0x40, 0x20, 0x02, 0x20, 0x01, 0x2E, 0x01, 0x00, 0x20,
+    0x01, 0x2E, 0x01, 0x80, 0x80, 0x01, 0x6C, 0x6A, 0x21, 0x02, 0x20, 0x01,
+    0x41, 0x02, 0x6A, 0x22, 0x01, 0x20, 0x00, 0x49, 0x0D, 0x00, 0x0B, 0x20,
+    0x02, 0x0B, 0x44, 0x02, 0x01, 0x7F, 0x01, 0x7B, 0x03, 0x40, 0x20, 0x02,
+    0x20, 0x01, 0xFD, 0x00, 0x04, 0x00, 0x20, 0x01, 0xFD, 0x00, 0x04, 0x80,
+    0x80, 0x01, 0xFD, 0xBA, 0x01, 0xFD, 0xAE, 0x01, 0x21, 0x02, 0x20, 0x01,
+    0x41, 0x10, 0x6A, 0x22, 0x01, 0x20, 0x00, 0x49, 0x0D, 0x00, 0x0B, 0x20,
+    0x02, 0xFD, 0x1B, 0x00, 0x20, 0x02, 0xFD, 0x1B, 0x01, 0x6A, 0x20, 0x02,
+    0xFD, 0x1B, 0x02, 0x6A, 0x20, 0x02, 0xFD, 0x1B, 0x03, 0x6A, 0x0B, 0x39,
+    0x03, 0x01, 0x7F, 0x01, 0x7F, 0x01, 0x7F, 0x03, 0x40, 0x20, 0x01, 0x2D,
+    0x00, 0x00, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28,
+    0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04,
+    0x20, 0x01, 0x41, 0x01, 0x6A, 0x22, 0x01, 0x20, 0x00, 0x49, 0x0D, 0x00,
+    0x0B, 0x41, 0x00, 0x28, 0x02, 0x80, 0x80, 0x04, 0x0B, 0xD6, 0x03, 0x03,
+    0x01, 0x7F, 0x01, 0x7B, 0x01, 0x7F, 0x03, 0x40, 0x20, 0x01, 0xFD, 0x00,
+    0x04, 0x00, 0x21, 0x02, 0x20, 0x02, 0xFD, 0x16, 0x00, 0x41, 0x02, 0x74,
+    0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41,
+    0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x01,
+    0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80,
+    0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02,
+    0xFD, 0x16, 0x02, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03,
+    0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80,
+    0x04, 0x20, 0x02, 0xFD, 0x16, 0x03, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20,
+    0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36,
+    0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x04, 0x41, 0x02, 0x74,
+    0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41,
+    0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x05,
+    0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80,
+    0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02,
+    0xFD, 0x16, 0x06, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03,
+    0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80,
+    0x04, 0x20, 0x02, 0xFD, 0x16, 0x07, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20,
+    0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36,
+    0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x08, 0x41, 0x02, 0x74,
+    0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41,
+    0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x09,
+    0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80,
+    0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02,
+    0xFD, 0x16, 0x0A, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03,
+    0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80,
+    0x04, 0x20, 0x02, 0xFD, 0x16, 0x0B, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20,
+    0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36,
+    0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x0C, 0x41, 0x02, 0x74,
+    0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41,
+    0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02, 0xFD, 0x16, 0x0D,
+    0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03, 0x28, 0x02, 0x80,
+    0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80, 0x04, 0x20, 0x02,
+    0xFD, 0x16, 0x0E, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20, 0x03, 0x20, 0x03,
+    0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36, 0x02, 0x80, 0x80,
+    0x04, 0x20, 0x02, 0xFD, 0x16, 0x0F, 0x41, 0x02, 0x74, 0x21, 0x03, 0x20,
+    0x03, 0x20, 0x03, 0x28, 0x02, 0x80, 0x80, 0x04, 0x41, 0x01, 0x6A, 0x36,
+    0x02, 0x80, 0x80, 0x04, 0x20, 0x01, 0x41, 0x10, 0x6A, 0x22, 0x01, 0x20,
+    0x00, 0x49, 0x0D, 0x00, 0x0B, 0x41, 0x00, 0x28, 0x02, 0x80, 0x80, 0x04,
+    0x0B, 0x26, 0x01, 0x01, 0x7F, 0x02, 0x40, 0x03, 0x40, 0x20, 0x01, 0x2D,
+    0x00, 0x00, 0x41, 0xFF, 0x01, 0x46, 0x0D, 0x01, 0x20, 0x01, 0x41, 0x01,
+    0x6A, 0x22, 0x01, 0x20, 0x00, 0x49, 0x0D, 0x00, 0x0B, 0x41, 0x7F, 0x0F,
+    0x0B, 0x20, 0x01, 0x0B, 0x3A, 0x03, 0x01, 0x7F, 0x01, 0x7B, 0x01, 0x7F,
+    0x41, 0xFF, 0x01, 0xFD, 0x0F, 0x21, 0x02, 0x02, 0x40, 0x03, 0x40, 0x20,
+    0x01, 0xFD, 0x00, 0x04, 0x00, 0x20, 0x02, 0xFD, 0x23, 0xFD, 0x64, 0x22,
+    0x03, 0x0D, 0x01, 0x20, 0x01, 0x41, 0x10, 0x6A, 0x22, 0x01, 0x20, 0x00,
+    0x49, 0x0D, 0x00, 0x0B, 0x41, 0x7F, 0x0F, 0x0B, 0x20, 0x01, 0x20, 0x03,
+    0x68, 0x6A, 0x0B};
+
+enum {
+  bench_func_dot_scalar,
+  bench_func_dot_simd,
+  bench_func_histogram_scalar,
+  bench_func_histogram_simd,
+  bench_func_memchr_scalar,
+  bench_func_memchr_simd,
+};
+
+// Bytes that are processed by one call and by one measurement.
+#define bench_simd_size (32u * 1024)
+#define bench_simd_bytes (64u * 1024 * 1024)
+
+static void bench_run_simd(wasm_instance *instance, const char *name,
+                           uint32_t funcidx, uint32_t size) {
+  uint32_t count = bench_simd_bytes / size;
+  wasm_value arg = {.i32 = (int32_t)size};
+  wasm_value result;
+  enum wasm_trap trap = wasm_trap_none;
+
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < count && !trap; i++) {
+    trap = wasm_invoke(instance, funcidx, &arg, &result);
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  if (trap) {
+    printf("%s failed: %s\n", name, wasm_trap_to_str(trap));
+    return;
+  }
+  bench_report_throughput(name, ns, (uint64_t)count * size);
+}
+
+// Runs a kernel as scalar wasm, as SIMD wasm with the best level and as SIMD
+// wasm with the scalar fallback.
+static void bench_run_kernel(wasm_instance *instance, const char *name,
+                             uint32_t scalar_func, uint32_t size) {
+  enum wasm_simd_level best = wasm_simd_detect_level();
+  char label[64];
+
+  snprintf(label, sizeof(label), "%s scalar wasm", name);
+  bench_run_simd(instance, label, scalar_func, size);
+
+  snprintf(label, sizeof(label), "%s simd wasm (%s)", name,
+           wasm_simd_level_to_str(best));
+  bench_run_simd(instance, label, scalar_func + 1, size);
+
+  wasm_simd_set_level(wasm_simd_scalar);
+  snprintf(label, sizeof(label), "%s simd wasm (scalar)", name);
+  bench_run_simd(instance, label, scalar_func + 1, size);
+  wasm_simd_set_level(best);
+}
+
+void bench_simd(void) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_simd_module,
+                          sizeof(bench_simd_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  if (instance == NULL) {
+    puts("bench_simd: failed to instantiate module");
+  } else {
+    // The input never contains the byte searched by memchr except at the end.
+    for (uint32_t i = 0; i < bench_simd_size; i++) {
+      instance->memory[i] = (unsigned char)(i * 7 % 255);
+    }
+    instance->memory[bench_simd_size - 1] = 255;
+
+    // The dot product reads 16 KiB from each of its two vectors.
+    bench_run_kernel(instance, "dot i16", bench_func_dot_scalar,
+                     bench_simd_size / 2);
+    bench_run_kernel(instance, "histogram", bench_func_histogram_scalar,
+                     bench_simd_size);
+    bench_run_kernel(instance, "memchr", bench_func_memchr_scalar,
+                     bench_simd_size);
+  }
+
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
@@ -0,0 +1,182 @@
+#include "bench.h"
+#include "bench_builder.h"
+#include "wasm/wasm_check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Startup of a host that loads a directory of plugins: the modules share most
+// of their function types and export names. Compares loading them one after
+// another with `wasm_load_modules` on one and on all threads. Every run is
+// done in a fresh process so the resident memory of the loaded modules can be
+// compared.
+
+#define bench_startup_corpus_size 400
+#define bench_startup_threads_max 16
+
+typedef struct {
+  uint64_t ns;
+  // Growth of the resident set while loading.
+  long rss_kb;
+  uint32_t loaded;
+  size_t interned_bytes;
+} bench_load_result;
+
+// Writes the corpus into a new temporary directory. Returns false on failure.
+static bool bench_write_load_corpus(char *dir, char **paths) {
+  if (mkdtemp(dir) == NULL) {
+    perror("mkdtemp");
+    return false;
+  }
+
+  bench_buf module;
+  bench_buf_init(&module);
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < bench_startup_corpus_size; i++) {
+    size_t length = strlen(dir) + 32;
+    paths[i] = malloc(length);
+    snprintf(paths[i], length, "%s/p%u.wasm", dir, i);
+
+    bench_module_config config = {
+        .type_count = 100 + i % 50,
+        .func_count = 200,
+        .export_count = 200,
+        .body_size = 16,
+        .name_length = 32,
+        .seed = i + 1,
+    };
+    bench_buf_clear(&module);
+    bench_build_module(&module, &config);
+    FILE *file = fopen(paths[i], "wb");
+    ok = file != NULL &&
+         fwrite(module.data, 1, module.size, file) == module.size;
+    if (file) {
+      fclose(file);
+    }
+  }
+  bench_buf_deinit(&module);
+  return ok;
+}
+
+static void bench_remove_load_corpus(const char *dir, char **paths) {
+  for (uint32_t i = 0; i < bench_startup_corpus_size && paths[i]; i++) {
+    unlink(paths[i]);
+    free(paths[i]);
+  }
+  rmdir(dir);
+}
+
+static long bench_rss_kb(void) {
+  FILE *file = fopen("/proc/self/statm", "r");
+  long size, resident = 0;
+  if (file) {
+    if (fscanf(file, "%ld %ld", &size, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(file);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Loads the corpus, one after another with `wasm_load_module_from_file` if
+// `threads` is 0. The modules are still alive when the memory is measured.
+static void bench_load_corpus(char **paths, uint32_t threads,
+                              bench_load_result *result) {
+  long rss = bench_rss_kb();
+  uint64_t start = bench_now_ns();
+  result->loaded = 0;
+  result->interned_bytes = 0;
+  if (threads == 0) {
+    for (uint32_t i = 0; i < bench_startup_corpus_size; i++) {
+      result->loaded += wasm_load_module_from_file(paths[i]) != NULL;
+    }
+  } else {
+    wasm_module_set *set = wasm_load_modules(
+        (const char **)paths, bench_startup_corpus_size, threads);
+    for (size_t i = 0; set && i < set->count; i++) {
+      result->loaded += set->modules[i] != NULL;
+    }
+    result->interned_bytes = set ? wasm_intern_size(set->table) : 0;
+  }
+  result->ns = bench_now_ns() - start;
+  result->rss_kb = bench_rss_kb() - rss;
+}
+
+// Runs `bench_load_corpus` in a child process. Returns false on failure.
+static bool bench_run_load(char **paths, uint32_t threads,
+                           bench_load_result *result) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    bench_load_corpus(paths, threads, result);
+    bool ok = write(fds[1], result, sizeof(*result)) == sizeof(*result);
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  bool ok = pid > 0 && read(fds[0], result, sizeof(*result)) ==
+                           (ssize_t)sizeof(*result);
+  close(fds[0]);
+  if (pid > 0) {
+    waitpid(pid, NULL, 0);
+  }
+  return ok && result->loaded == bench_startup_corpus_size;
+}
+
+static void bench_report_load(const char *name, const bench_load_result *result,
+                              const bench_load_result *baseline) {
+  printf("%-40s %12.2f ms %9.2fx\n", name, (double)result->ns / 1e6,
+         (double)baseline->ns / (double)result->ns);
+  char label[80];
+  snprintf(label, sizeof(label), "%s rss", name);
+  printf("%-40s %12.2f MiB %8.2fx\n", label, (double)result->rss_kb / 1024.0,
+         (double)result->rss_kb / (double)baseline->rss_kb);
+}
+
+void bench_startup(void) {
+  char dir[] = "/tmp/wasm_bench_pluginsXXXXXX";
+  char *paths[bench_startup_corpus_size] = {NULL};
+
+  if (!bench_write_load_corpus(dir, paths)) {
+    puts("bench_startup: failed to write the corpus");
+    bench_remove_load_corpus(dir, paths);
+    return;
+  }
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = cpus < 1 ? 1 : (uint32_t)cpus;
+  if (max_threads > bench_startup_threads_max) {
+    max_threads = bench_startup_threads_max;
+  }
+
+  bench_load_result sequential, single, parallel;
+  if (!bench_run_load(paths, 0, &sequential) ||
+      !bench_run_load(paths, 1, &single)) {
+    puts("bench_startup: failed to load the corpus");
+    bench_remove_load_corpus(dir, paths);
+    return;
+  }
+  bench_report_load("load plugins sequential", &sequential, &sequential);
+  bench_report_load("load plugins interned 1 thread", &single, &sequential);
+  if (max_threads > 1) {
+    char label[64];
+    snprintf(label, sizeof(label), "load plugins interned %u threads",
+             max_threads);
+    if (bench_run_load(paths, max_threads, &parallel)) {
+      bench_report_load(label, &parallel, &sequential);
+    } else {
+      puts("bench_startup: failed to load the corpus");
+    }
+  }
+  printf("%-40s %12zu bytes\n", "interned names and types",
+         single.interned_bytes);
+
+  bench_remove_load_corpus(dir, paths);
+}
@@ -0,0 +1,200 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// One instance per host thread, all importing the same shared memory. The
+// parallel sum splits an array of i32 between the threads and every thread
+// adds its partial sum to the result with one atomic instruction. The counter
+// benchmark does nothing but contended atomic increments.
+//
+// (import "env" "memory" (memory 256 256 shared))
+// (func $sum (param $start i32) (param $end i32) (local $acc i64)
+//   loop
+//     (local.set $acc (i64.add (local.get $acc)
+//                              (i64.load32_u (local.get $start))))
+//     (br_if 0 (i32.lt_u (local.tee $start (i32.add (local.get $start)
+//                                                   (i32.const 4)))
+//                        (local.get $end)))
+//   end
+//   (drop (i64.atomic.rmw.add (i32.const 0) (local.get $acc))))
+// (func $count (param $n i32)
+//   loop
+//     (drop (i32.atomic.rmw.add (i32.const 8) (i32.const 1)))
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end)
+static const unsigned char bench_threads_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0A, 0x02, 0x60,
+    0x02, 0x7F, 0x7F, 0x00, 0x60, 0x01, 0x7F, 0x00, 0x02, 0x12, 0x01, 0x03,
+    0x65, 0x6E, 0x76, 0x06, 0x6D, 0x65, 0x6D, 0x6F, 0x72, 0x79, 0x02, 0x03,
+    0x80, 0x02, 0x80, 0x02, 0x03, 0x03, 0x02, 0x00, 0x01, 0x0A, 0x40, 0x02,
+    0x26, 0x01, 0x01, 0x7E, 0x03, 0x40, 0x20, 0x02, 0x20, 0x00, 0x35, 0x02,
+    0x00, 0x7C, 0x21, 0x02, 0x20, 0x00, 0x41, 0x04, 0x6A, 0x22, 0x00, 0x20,
+    0x01, 0x49, 0x0D, 0x00, 0x0B, 0x41, 0x00, 0x20, 0x02, 0xFE, 0x1F, 0x03,
+    0x00, 0x1A, 0x0B, 0x17, 0x00, 0x03, 0x40, 0x41, 0x08, 0x41, 0x01, 0xFE,
+    0x1E, 0x02, 0x00, 0x1A, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D,
+    0x00, 0x0B, 0x0B};
+
+enum {
+  bench_func_sum,
+  bench_func_count,
+};
+
+#define bench_threads_max 8
+// The array starts after the two results and fills the rest of the memory.
+#define bench_array_start 64u
+#define bench_array_end (256u * 65536)
+#define bench_sum_repeat 4
+#define bench_count_ops (4u * 1024 * 1024)
+
+typedef struct {
+  wasm_instance *instance;
+  uint32_t funcidx;
+  wasm_value args[2];
+  int repeat;
+  enum wasm_trap trap;
+} bench_thread;
+
+static void *bench_thread_main(void *arg) {
+  bench_thread *thread = arg;
+  for (int i = 0; i < thread->repeat && !thread->trap; i++) {
+    thread->trap =
+        wasm_invoke(thread->instance, thread->funcidx, thread->args, NULL);
+  }
+  return NULL;
+}
+
+// Runs all threads and returns the wall time or 0 if one of them trapped.
+static uint64_t bench_run_threads(bench_thread *threads, int count) {
+  pthread_t handles[bench_threads_max];
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < count; i++) {
+    pthread_create(&handles[i], NULL, bench_thread_main, &threads[i]);
+  }
+  for (int i = 0; i < count; i++) {
+    pthread_join(handles[i], NULL);
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  for (int i = 0; i < count; i++) {
+    if (threads[i].trap) {
+      printf("thread failed: %s\n", wasm_trap_to_str(threads[i].trap));
+      return 0;
+    }
+  }
+  return ns;
+}
+
+static void bench_parallel_sum(wasm_instance **instances, int count,
+                               uint64_t expected, uint64_t *single_ns) {
+  bench_thread threads[bench_threads_max];
+  uint32_t elements = (bench_array_end - bench_array_start) / 4;
+
+  for (int i = 0; i < count; i++) {
+    uint32_t first = elements / count * i;
+    uint32_t last = i == count - 1 ? elements : elements / count * (i + 1);
+    threads[i] = (bench_thread){instances[i], bench_func_sum, {{0}, {0}},
+                                bench_sum_repeat, wasm_trap_none};
+    threads[i].args[0].i32 = (int32_t)(bench_array_start + first * 4);
+    threads[i].args[1].i32 = (int32_t)(bench_array_start + last * 4);
+  }
+
+  unsigned char *memory = instances[0]->memory;
+  memset(memory, 0, 8);
+  uint64_t ns = bench_run_threads(threads, count);
+  if (ns == 0) {
+    return;
+  }
+
+  uint64_t sum;
+  memcpy(&sum, memory, 8);
+  if (sum != expected * bench_sum_repeat) {
+    printf("parallel sum with %d threads is wrong\n", count);
+    return;
+  }
+
+  if (count == 1) {
+    *single_ns = ns;
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "parallel sum %d threads (%.2fx)", count,
+           (double)*single_ns / (double)ns);
+  bench_report_throughput(
+      label, ns,
+      (uint64_t)(bench_array_end - bench_array_start) * bench_sum_repeat);
+}
+
+static void bench_atomic_counter(wasm_instance **instances, int count) {
+  bench_thread threads[bench_threads_max];
+  for (int i = 0; i < count; i++) {
+    threads[i] = (bench_thread){instances[i], bench_func_count, {{0}, {0}},
+                                1, wasm_trap_none};
+    threads[i].args[0].i32 = (int32_t)(bench_count_ops / count);
+  }
+
+  uint64_t ns = bench_run_threads(threads, count);
+  if (ns == 0) {
+    return;
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "atomic counter %d threads", count);
+  bench_report(label, ns, bench_count_ops / count * count);
+}
+
+void bench_threads(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = cpus < 1                   ? 1
+                    : cpus > bench_threads_max ? bench_threads_max
+                                               : (int)cpus;
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_threads_module,
+                          sizeof(bench_threads_module));
+  wasm_module *module = wasm_load_module(&reader);
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_shared_memory *memory = wasm_create_shared_memory(256, 256);
+  if (memory) {
+    wasm_host_imports_add_memory(&imports, "env", "memory", memory);
+    wasm_release_shared_memory(memory);
+  }
+
+  // Instances are created up front, only running them is parallel.
+  wasm_instance *instances[bench_threads_max] = {NULL};
+  bool ok = module != NULL && memory != NULL;
+  for (int i = 0; ok && i < max_threads; i++) {
+    instances[i] = wasm_instantiate(module, &imports);
+    ok = instances[i] != NULL;
+  }
+
+  if (!ok) {
+    puts("bench_threads: failed to instantiate module");
+  } else {
+    uint64_t expected = 0;
+    for (uint32_t i = bench_array_start; i < bench_array_end; i += 4) {
+      uint32_t value = i * 2654435761u >> 8;
+      memcpy(memory->data + i, &value, 4);
+      expected += value;
+    }
+
+    uint64_t single_ns = 0;
+    for (int count = 1; count <= max_threads; count++) {
+      bench_parallel_sum(instances, count, expected, &single_ns);
+    }
+    for (int count = 1; count <= max_threads; count++) {
+      bench_atomic_counter(instances, count);
+    }
+  }
+
+  for (int i = 0; i < max_threads; i++) {
+    wasm_free_instance(instances[i]);
+  }
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+}
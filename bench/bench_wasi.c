@@ -0,0 +1,169 @@
+#include "bench.h"
+#include "wasm/wasm.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include "wasm/wasm_wasi.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Throughput of fd_read/fd_write. A guest `cat` copies a file from stdin to
+// stdout in 64 KiB chunks and is compared with the native `cat`.
+
+#define bench_wasi_file_size (64 * 1024 * 1024)
+
+// (memory (export "memory") 2)
+// (data (i32.const 0) "\00\00\01\00\00\00\01\00") ;; iovec for reads
+// (func (export "_start") (local $n i32) (local $p i32) (local $w i32)
+//   block
+//     loop
+//       (if (call $fd_read (i32.const 0) (i32.const 0) (i32.const 1)
+//                          (i32.const 8))
+//         (then return))
+//       (br_if 1 (i32.eqz (local.tee $n (i32.load (i32.const 8)))))
+//       (local.set $p (i32.const 65536))
+//       loop
+//         (i32.store (i32.const 16) (local.get $p))
+//         (i32.store (i32.const 20) (local.get $n))
+//         (if (call $fd_write (i32.const 1) (i32.const 16) (i32.const 1)
+//                             (i32.const 24))
+//           (then return))
+//         (local.set $w (i32.load (i32.const 24)))
+//         (local.set $p (i32.add (local.get $p) (local.get $w)))
+//         (br_if 0 (local.tee $n (i32.sub (local.get $n) (local.get $w))))
+//       end
+//       br 0
+//     end
+//   end)
+static const unsigned char bench_cat_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0C, 0x02, 0x60,
+    0x04, 0x7F, 0x7F, 0x7F, 0x7F, 0x01, 0x7F, 0x60, 0x00, 0x00, 0x02, 0x44,
+    0x02, 0x16, 0x77, 0x61, 0x73, 0x69, 0x5F, 0x73, 0x6E, 0x61, 0x70, 0x73,
+    0x68, 0x6F, 0x74, 0x5F, 0x70, 0x72, 0x65, 0x76, 0x69, 0x65, 0x77, 0x31,
+    0x07, 0x66, 0x64, 0x5F, 0x72, 0x65, 0x61, 0x64, 0x00, 0x00, 0x16, 0x77,
+    0x61, 0x73, 0x69, 0x5F, 0x73, 0x6E, 0x61, 0x70, 0x73, 0x68, 0x6F, 0x74,
+    0x5F, 0x70, 0x72, 0x65, 0x76, 0x69, 0x65, 0x77, 0x31, 0x08, 0x66, 0x64,
+    0x5F, 0x77, 0x72, 0x69, 0x74, 0x65, 0x00, 0x00, 0x03, 0x02, 0x01, 0x01,
+    0x05, 0x03, 0x01, 0x00, 0x02, 0x07, 0x13, 0x02, 0x06, 0x5F, 0x73, 0x74,
+    0x61, 0x72, 0x74, 0x00, 0x02, 0x06, 0x6D, 0x65, 0x6D, 0x6F, 0x72, 0x79,
+    0x02, 0x00, 0x0A, 0x62, 0x01, 0x60, 0x01, 0x03, 0x7F, 0x02, 0x40, 0x03,
+    0x40, 0x41, 0x00, 0x41, 0x00, 0x41, 0x01, 0x41, 0x08, 0x10, 0x00, 0x04,
+    0x40, 0x0F, 0x0B, 0x41, 0x08, 0x28, 0x02, 0x00, 0x22, 0x00, 0x45, 0x0D,
+    0x01, 0x41, 0x80, 0x80, 0x04, 0x21, 0x01, 0x03, 0x40, 0x41, 0x10, 0x20,
+    0x01, 0x36, 0x02, 0x00, 0x41, 0x14, 0x20, 0x00, 0x36, 0x02, 0x00, 0x41,
+    0x01, 0x41, 0x10, 0x41, 0x01, 0x41, 0x18, 0x10, 0x01, 0x04, 0x40, 0x0F,
+    0x0B, 0x41, 0x18, 0x28, 0x02, 0x00, 0x21, 0x02, 0x20, 0x01, 0x20, 0x02,
+    0x6A, 0x21, 0x01, 0x20, 0x00, 0x20, 0x02, 0x6B, 0x22, 0x00, 0x0D, 0x00,
+    0x0B, 0x0C, 0x00, 0x0B, 0x0B, 0x0B, 0x0B, 0x0E, 0x01, 0x00, 0x41, 0x00,
+    0x0B, 0x08, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00};
+
+// Creates a temporary file with `size` bytes. Returns false on failure.
+static bool bench_create_file(char *path, size_t size) {
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return false;
+  }
+
+  static unsigned char chunk[65536];
+  for (size_t i = 0; i < sizeof(chunk); i++) {
+    chunk[i] = (unsigned char)(i * 31 + 7);
+  }
+
+  bool success = true;
+  for (size_t written = 0; written < size && success;
+       written += sizeof(chunk)) {
+    success = write(fd, chunk, sizeof(chunk)) == (ssize_t)sizeof(chunk);
+  }
+  close(fd);
+  return success;
+}
+
+static void bench_wasm_cat(wasm_module *module, const char *in_path,
+                           const char *out_path) {
+  int in = open(in_path, O_RDONLY);
+  int out = open(out_path, O_WRONLY | O_TRUNC);
+  if (in < 0 || out < 0) {
+    puts("bench_wasi: failed to open files");
+    goto end;
+  }
+
+  wasm_wasi wasi;
+  char *argv[] = {"cat"};
+  wasm_init_wasi(&wasi, 1, argv, NULL);
+  wasi.fds[0] = in;
+  wasi.fds[1] = out;
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_wasi_add_imports(&wasi, &imports);
+  wasm_instance *instance = wasm_instantiate(module, &imports);
+
+  if (instance == NULL) {
+    puts("bench_wasi: failed to instantiate module");
+  } else {
+    wasm_export *start =
+        wasm_module_find_export(module, "_start", wasm_export_func);
+
+    uint64_t start_ns = bench_now_ns();
+    enum wasm_trap trap = wasm_invoke(instance, start->idx, NULL, NULL);
+    uint64_t ns = bench_now_ns() - start_ns;
+
+    if (trap || lseek(out, 0, SEEK_END) != bench_wasi_file_size) {
+      printf("wasm cat failed: %s\n", wasm_trap_to_str(trap));
+    } else {
+      bench_report_throughput("wasm cat (fd_read/fd_write)", ns,
+                              bench_wasi_file_size);
+    }
+  }
+
+  wasm_free_instance(instance);
+  wasm_deinit_host_imports(&imports);
+
+end:
+  if (in >= 0) {
+    close(in);
+  }
+  if (out >= 0) {
+    close(out);
+  }
+}
+
+static void bench_native_cat(const char *in_path, const char *out_path) {
+  char command[256];
+  snprintf(command, sizeof(command), "cat %s > %s", in_path, out_path);
+
+  uint64_t start = bench_now_ns();
+  int status = system(command);
+  uint64_t ns = bench_now_ns() - start;
+
+  if (status != 0) {
+    puts("native cat failed");
+    return;
+  }
+  bench_report_throughput("native cat", ns, bench_wasi_file_size);
+}
+
+void bench_wasi(void) {
+  char in_path[] = "/tmp/wasm_bench_in_XXXXXX";
+  char out_path[] = "/tmp/wasm_bench_out_XXXXXX";
+  if (!bench_create_file(in_path, bench_wasi_file_size) ||
+      !bench_create_file(out_path, 0)) {
+    puts("bench_wasi: failed to create temporary files");
+    return;
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bench_cat_module, sizeof(bench_cat_module));
+  wasm_module *module = wasm_load_module(&reader);
+
+  if (module == NULL) {
+    puts("bench_wasi: failed to load module");
+  } else {
+    bench_wasm_cat(module, in_path, out_path);
+    bench_native_cat(in_path, out_path);
+  }
+
+  wasm_free_module(module);
+  unlink(in_path);
+  unlink(out_path);
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wasm.dir/tests/tests.c.o"
+  "CMakeFiles/wasm.dir/tests/tests.c.o.d"
+  "wasm"
+  "wasm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/wasm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
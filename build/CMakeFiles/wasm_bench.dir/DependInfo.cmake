@@ -0,0 +1,37 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/bench.c" "CMakeFiles/wasm_bench.dir/bench/bench.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench.c.o.d"
+  "/root/repo/bench/bench_alloc.c" "CMakeFiles/wasm_bench.dir/bench/bench_alloc.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_alloc.c.o.d"
+  "/root/repo/bench/bench_async.c" "CMakeFiles/wasm_bench.dir/bench/bench_async.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_async.c.o.d"
+  "/root/repo/bench/bench_builder.c" "CMakeFiles/wasm_bench.dir/bench/bench_builder.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_builder.c.o.d"
+  "/root/repo/bench/bench_bulk.c" "CMakeFiles/wasm_bench.dir/bench/bench_bulk.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_bulk.c.o.d"
+  "/root/repo/bench/bench_calls.c" "CMakeFiles/wasm_bench.dir/bench/bench_calls.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_calls.c.o.d"
+  "/root/repo/bench/bench_check.c" "CMakeFiles/wasm_bench.dir/bench/bench_check.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_check.c.o.d"
+  "/root/repo/bench/bench_host.c" "CMakeFiles/wasm_bench.dir/bench/bench_host.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_host.c.o.d"
+  "/root/repo/bench/bench_indirect.c" "CMakeFiles/wasm_bench.dir/bench/bench_indirect.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_indirect.c.o.d"
+  "/root/repo/bench/bench_parse.c" "CMakeFiles/wasm_bench.dir/bench/bench_parse.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_parse.c.o.d"
+  "/root/repo/bench/bench_print.c" "CMakeFiles/wasm_bench.dir/bench/bench_print.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_print.c.o.d"
+  "/root/repo/bench/bench_regs.c" "CMakeFiles/wasm_bench.dir/bench/bench_regs.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_regs.c.o.d"
+  "/root/repo/bench/bench_sched.c" "CMakeFiles/wasm_bench.dir/bench/bench_sched.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_sched.c.o.d"
+  "/root/repo/bench/bench_sections.c" "CMakeFiles/wasm_bench.dir/bench/bench_sections.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_sections.c.o.d"
+  "/root/repo/bench/bench_simd.c" "CMakeFiles/wasm_bench.dir/bench/bench_simd.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_simd.c.o.d"
+  "/root/repo/bench/bench_startup.c" "CMakeFiles/wasm_bench.dir/bench/bench_startup.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_startup.c.o.d"
+  "/root/repo/bench/bench_threads.c" "CMakeFiles/wasm_bench.dir/bench/bench_threads.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_threads.c.o.d"
+  "/root/repo/bench/bench_wasi.c" "CMakeFiles/wasm_bench.dir/bench/bench_wasi.c.o" "gcc" "CMakeFiles/wasm_bench.dir/bench/bench_wasi.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/build/CMakeFiles/wasm_lib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
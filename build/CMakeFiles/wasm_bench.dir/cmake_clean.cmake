@@ -0,0 +1,45 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wasm_bench.dir/bench/bench.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_alloc.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_alloc.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_async.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_async.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_builder.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_builder.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_bulk.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_bulk.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_calls.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_calls.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_check.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_check.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_host.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_host.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_indirect.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_indirect.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_parse.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_parse.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_print.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_print.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_regs.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_regs.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_sched.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_sched.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_sections.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_sections.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_simd.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_simd.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_startup.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_startup.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_threads.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_threads.c.o.d"
+  "CMakeFiles/wasm_bench.dir/bench/bench_wasi.c.o"
+  "CMakeFiles/wasm_bench.dir/bench/bench_wasi.c.o.d"
+  "wasm_bench"
+  "wasm_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/wasm_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
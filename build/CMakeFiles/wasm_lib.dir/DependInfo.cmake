@@ -0,0 +1,35 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/wasm/wasm.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm.c.o.d"
+  "/root/repo/src/wasm/wasm_atomic.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_atomic.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_atomic.c.o.d"
+  "/root/repo/src/wasm/wasm_check.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_check.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_check.c.o.d"
+  "/root/repo/src/wasm/wasm_common.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_common.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_common.c.o.d"
+  "/root/repo/src/wasm/wasm_compile.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_compile.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_compile.c.o.d"
+  "/root/repo/src/wasm/wasm_exec.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_exec.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_exec.c.o.d"
+  "/root/repo/src/wasm/wasm_host.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_host.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_host.c.o.d"
+  "/root/repo/src/wasm/wasm_intern.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_intern.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_intern.c.o.d"
+  "/root/repo/src/wasm/wasm_perf.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_perf.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_perf.c.o.d"
+  "/root/repo/src/wasm/wasm_print.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_print.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_print.c.o.d"
+  "/root/repo/src/wasm/wasm_reader.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_reader.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_reader.c.o.d"
+  "/root/repo/src/wasm/wasm_sched.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_sched.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_sched.c.o.d"
+  "/root/repo/src/wasm/wasm_simd.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_simd.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_simd.c.o.d"
+  "/root/repo/src/wasm/wasm_utf8.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_utf8.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_utf8.c.o.d"
+  "/root/repo/src/wasm/wasm_validate.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_validate.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_validate.c.o.d"
+  "/root/repo/src/wasm/wasm_vec.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_vec.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_vec.c.o.d"
+  "/root/repo/src/wasm/wasm_wasi.c" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_wasi.c.o" "gcc" "CMakeFiles/wasm_lib.dir/src/wasm/wasm_wasi.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_atomic.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_atomic.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_check.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_check.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_common.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_common.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_compile.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_compile.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_exec.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_exec.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_host.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_host.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_intern.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_intern.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_perf.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_perf.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_print.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_print.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_reader.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_reader.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_sched.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_sched.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_simd.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_simd.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_utf8.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_utf8.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_validate.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_validate.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_vec.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_vec.c.o.d"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_wasi.c.o"
+  "CMakeFiles/wasm_lib.dir/src/wasm/wasm_wasi.c.o.d"
+  "libwasm_lib.a"
+  "libwasm_lib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/wasm_lib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
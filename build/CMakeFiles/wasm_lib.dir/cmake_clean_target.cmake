@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libwasm_lib.a"
+)
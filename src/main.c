@@ -1,12 +1,193 @@
+#include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "wasm/wasm.h"
+#include "wasm/wasm_check.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include "wasm/wasm_perf.h"
+#include "wasm/wasm_print.h"
+#include "wasm/wasm_wasi.h"
 
+extern char **environ;
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [--stats] <file.wasm> [args...]\n"
+          "       %s --check <file.wasm|dir>... [-j threads] [--json]\n"
+          "         [--max-memory bytes]\n"
+          "       %s --wat <file.wasm> [-j threads]\n",
+          program, program, program);
+}
+
+// Adds `path` if it is a file, or every .wasm file below it if it is a
+// directory.
+typedef wasm_vec_of(char *) path_vec;
+
+static void collect_modules(const char *path, path_vec *paths) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    perror(path);
+    return;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    *wasm_vec_append(paths) = strdup(path);
+    return;
+  }
+
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    perror(path);
+    return;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    const char *name = entry->d_name;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+      continue;
+    }
+
+    size_t length = strlen(path) + strlen(name) + 2;
+    char *child = malloc(length);
+    snprintf(child, length, "%s/%s", path, name);
+    size_t name_length = strlen(name);
+    if (stat(child, &st) == 0 &&
+        (S_ISDIR(st.st_mode) ||
+         (name_length > 5 && strcmp(name + name_length - 5, ".wasm") == 0))) {
+      collect_modules(child, paths);
+    }
+    free(child);
+  }
+  closedir(dir);
+}
+
+static int compare_paths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Loads and validates many modules in parallel and prints one line per
+// module, as JSON with `--json`.
+static int check_main(int argc, char **argv) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t thread_count = cpus < 1 ? 1 : (uint32_t)cpus;
+  bool json = false;
+  size_t memory_limit = 0;
+  path_vec paths;
+  wasm_vec_init(&paths);
+
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = true;
+    } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      int value = atoi(argv[++i]);
+      thread_count = value > 0 ? (uint32_t)value : 1;
+    } else if (strcmp(argv[i], "--max-memory") == 0 && i + 1 < argc) {
+      memory_limit = (size_t)strtoull(argv[++i], NULL, 10);
+    } else {
+      collect_modules(argv[i], &paths);
+    }
+  }
+
+  size_t count = wasm_vec_size(&paths);
+  if (count == 0) {
+    fprintf(stderr, "No modules to check.\n");
+    wasm_vec_deinit(&paths);
+    return 1;
+  }
+  qsort(paths.start, count, sizeof(char *), compare_paths);
+
+  wasm_check_result *results = wasm_alloc_array(wasm_check_result, count);
+  uint64_t start = wasm_now_ns();
+  wasm_check_modules((const char **)paths.start, count, thread_count,
+                     memory_limit, results);
+  uint64_t ns = wasm_now_ns() - start;
+
+  size_t failed = 0;
+  for (size_t i = 0; i < count; i++) {
+    wasm_check_result *result = &results[i];
+    failed += !result->ok;
+    if (json) {
+      wasm_print_check_json(stdout, result);
+    } else {
+      printf("%s %s: %zu bytes, %u functions, parse %.3f ms, validate %.3f "
+             "ms\n",
+             result->ok ? "ok  " : "FAIL", result->path, result->bytes,
+             result->func_count, (double)result->parse_ns / 1e6,
+             (double)result->validate_ns / 1e6);
+    }
+  }
+  fprintf(stderr, "%zu modules, %zu failed, %.1f ms on %u threads\n", count,
+          failed, (double)ns / 1e6, thread_count);
+
+  for (char **path = paths.start; path != paths.end; path++) {
+    free(*path);
+  }
+  wasm_vec_deinit(&paths);
+  wasm_free(results);
+  return failed ? 1 : 0;
+}
+
+// Prints a module in the text format to stdout.
+static int wat_main(int argc, char **argv) {
+  const char *file_name = NULL;
+  uint32_t thread_count = 1;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      int value = atoi(argv[++i]);
+      thread_count = value > 0 ? (uint32_t)value : 1;
+    } else {
+      file_name = argv[i];
+    }
+  }
+  if (file_name == NULL) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  wasm_module *module = wasm_load_module_from_file(file_name);
+  if (module == NULL) {
+    fprintf(stderr, "Failed to load wasm module.\n");
+    return 1;
+  }
+
+  wasm_text_out out;
+  wasm_init_text_out(&out, STDOUT_FILENO);
+  bool ok = wasm_print_wat(&out, module, thread_count);
+  ok = wasm_flush_text_out(&out) && ok;
+  if (!ok) {
+    fprintf(stderr, "Failed to print wasm module.\n");
+  }
+  wasm_deinit_text_out(&out);
+  wasm_free_module(module);
+  return ok ? 0 : 1;
+}
+
+// Runs the `_start` function of a wasi module. The remaining arguments are
+// passed to the module. With `--stats` the counters of the load and the run
+// are printed to stderr at the end.
 int main(int argc, char **argv) {
-  if (argc != 2) {
-    fprintf(stderr,
-            "Program requires one argument which is the wasm file to exec.");
+  if (argc >= 2 && strcmp(argv[1], "--check") == 0) {
+    return check_main(argc, argv);
+  }
+  if (argc >= 2 && strcmp(argv[1], "--wat") == 0) {
+    return wat_main(argc, argv);
+  }
 
+  const char *program = argv[0];
+  wasm_perf_stats stats;
+  bool print_stats = argc >= 2 && strcmp(argv[1], "--stats") == 0;
+  if (print_stats) {
+    argc--;
+    argv++;
+    wasm_init_perf_stats(&stats);
+    wasm_set_perf_stats(&stats);
+  }
+  if (argc < 2) {
+    usage(program);
     return 1;
   }
 
@@ -15,6 +196,61 @@ int main(int argc, char **argv) {
   wasm_module *module = wasm_load_module_from_file(file_name);
 
   if (module == NULL) {
-    fprintf(stderr, "Failed to load wasm module.");
+    fprintf(stderr, "Failed to load wasm module.\n");
+    if (print_stats) {
+      wasm_set_perf_stats(NULL);
+      wasm_deinit_perf_stats(&stats);
+    }
+    return 1;
+  }
+
+  int exit_code = 1;
+  wasm_wasi wasi;
+  wasm_init_wasi(&wasi, argc - 1, argv + 1, environ);
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_instance *instance = NULL;
+
+  if (!wasm_wasi_add_imports(&wasi, &imports)) {
+    goto end;
+  }
+
+  instance = wasm_instantiate(module, &imports);
+  if (instance == NULL) {
+    fprintf(stderr, "Failed to instantiate wasm module.\n");
+    goto end;
+  }
+
+  wasm_export *start =
+      wasm_module_find_export(module, "_start", wasm_export_func);
+  if (start == NULL) {
+    fprintf(stderr, "Module has no _start function.\n");
+    goto end;
+  }
+  if (start->idx >=
+      module->import_func_count + (uint32_t)wasm_vec_size(&module->funcs)) {
+    fprintf(stderr, "Invalid _start function index %u.\n", start->idx);
+    goto end;
+  }
+
+  enum wasm_trap trap = wasm_invoke(instance, start->idx, NULL, NULL);
+  if (trap == wasm_trap_none) {
+    exit_code = 0;
+  } else if (trap == wasm_trap_exit) {
+    exit_code = wasi.exit_code;
+  } else {
+    fprintf(stderr, "Trap: %s\n", wasm_trap_to_str(trap));
+  }
+
+end:
+  if (print_stats) {
+    wasm_set_perf_stats(NULL);
+    wasm_print_perf_stats(stderr, &stats, 10);
+    wasm_deinit_perf_stats(&stats);
   }
+  wasm_free_instance(instance);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+  return exit_code;
 }
@@ -1,6 +1,9 @@
 #include "wasm/wasm.h"
 
 #include "wasm/wasm_common.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_perf.h"
+#include "wasm/wasm_utf8.h"
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -18,6 +21,8 @@ static bool wasm_char_to_valtype(unsigned char c, enum wasm_valtype *out) {
     return *out = wasm_valtype_f32, true;
   case 0x7C:
     return *out = wasm_valtype_f64, true;
+  case 0x7B:
+    return *out = wasm_valtype_v128, true;
   default:
     return false;
   }
@@ -41,50 +46,80 @@ const char *wasm_valtype_to_str(enum wasm_valtype type) {
     return "f32";
   case wasm_valtype_f64:
     return "f64";
+  case wasm_valtype_v128:
+    return "v128";
   default:
     return "invalid";
   }
 }
 
-void wasm_release_function_type(wasm_function_type *type) {
-  wasm_vec_deinit(&type->param_types);
+bool wasm_function_type_equal(wasm_function_type *a, wasm_function_type *b) {
+  if (a->result_count != b->result_count || a->param_count != b->param_count) {
+    return false;
+  }
+  if (a->result_count == 1 && a->result_type != b->result_type) {
+    return false;
+  }
+  return a->param_count == 0 ||
+         memcmp(a->params, b->params, a->param_count) == 0;
 }
 
 void wasm_init_global(wasm_global *global) {
-  wasm_vec_init(&global->initializer, wasm_global);
+  wasm_vec_init(&global->initializer);
 }
 
 void wasm_deinit_global(wasm_global *global) {
   wasm_vec_deinit(&global->initializer);
 }
 
-void wasm_init_export(wasm_export *export) { export->name = NULL; }
+void wasm_deinit_code(wasm_code *code) {
+  wasm_free_compiled_func(code->compiled);
+}
 
-void wasm_deinit_export(wasm_export *export) { wasm_free(export->name); }
+void wasm_init_elem(wasm_elem *elem) {
+  wasm_vec_init(&elem->offset);
+  wasm_vec_init(&elem->init);
+}
 
-void wasm_init_code(wasm_code *code) {
-  wasm_vec_init(&code->locals, wasm_locals);
-  wasm_vec_init(&code->expr, wasm_expr);
+void wasm_deinit_elem(wasm_elem *elem) {
+  wasm_vec_deinit(&elem->offset);
+  wasm_vec_deinit(&elem->init);
 }
 
-void wasm_deinit_code(wasm_code *code) {
-  wasm_vec_deinit(&code->locals);
-  wasm_vec_deinit(&code->expr);
+void wasm_init_data(wasm_data *data) {
+  data->is_passive = false;
+  data->memidx = 0;
+  wasm_vec_init(&data->offset);
+  wasm_vec_init(&data->init);
+}
+
+void wasm_deinit_data(wasm_data *data) {
+  wasm_vec_deinit(&data->offset);
+  wasm_vec_deinit(&data->init);
 }
 
 void wasm_free_module(wasm_module *module) {
   if (module) {
-    wasm_vec_for_each(&module->function_types,
-                      (void (*)(void *))(&wasm_release_function_type));
     wasm_vec_deinit(&module->function_types);
+    wasm_vec_deinit(&module->type_ids);
+    wasm_vec_deinit(&module->imports);
     wasm_vec_deinit(&module->funcs);
+    wasm_vec_deinit(&module->tables);
+    wasm_vec_deinit(&module->mems);
     wasm_vec_for_each(&module->globals,
                       (void (*)(void *))(&wasm_deinit_global));
     wasm_vec_deinit(&module->globals);
-    wasm_vec_for_each(&module->exports, (void(*))(void *)(&wasm_deinit_export));
     wasm_vec_deinit(&module->exports);
+    wasm_vec_for_each(&module->elems, (void (*)(void *))(&wasm_deinit_elem));
+    wasm_vec_deinit(&module->elems);
     wasm_vec_for_each(&module->codes, (void (*)(void *))(&wasm_deinit_code));
     wasm_vec_deinit(&module->codes);
+    wasm_vec_for_each(&module->datas, (void (*)(void *))(&wasm_deinit_data));
+    wasm_vec_deinit(&module->datas);
+    wasm_vec_deinit(&module->valtypes);
+    wasm_vec_deinit(&module->names);
+    wasm_vec_deinit(&module->code_bytes);
+    wasm_vec_deinit(&module->locals);
 
     wasm_free(module);
   }
@@ -114,256 +149,995 @@ bool wasm_load_header(wasm_reader *reader, wasm_module_header *header) {
   return true;
 }
 
-bool wasm_read_expr(wasm_reader *reader, wasm_vec *expr) {
-  while (1) {
-    unsigned char command;
-    if (!wasm_read(reader, &command, 1)) {
-      fprintf(stderr, "IO error while parsing expr.\n");
+// Copies the bytes of a leb128 number into `out`.
+static bool wasm_copy_leb(wasm_reader *reader, wasm_byte_vec *out) {
+  unsigned char c;
+  // A 64 bit leb has at most 10 bytes.
+  for (int i = 0; i < 10; i++) {
+    if (!wasm_read_obj(reader, &c)) {
+      return false;
     }
-
-    if (command == 0x0B) {
+    *wasm_vec_append(out) = c;
+    if ((c & 128) == 0) {
       return true;
     }
+  }
+  return false;
+}
 
-    *((unsigned char *)wasm_vec_append(expr)) = command;
+// Reads a constant expression as used by global initializers and segment
+// offsets. Only a single instruction is allowed in the MVP. The bytes of the
+// instruction are stored in `expr` without the terminating 0x0B.
+bool wasm_read_const_expr(wasm_reader *reader, wasm_expr *expr) {
+  unsigned char command;
+  if (!wasm_read(reader, &command, 1)) {
+    fprintf(stderr, "IO error while parsing expr.\n");
+    return false;
+  }
+  *wasm_vec_append(expr) = command;
+
+  bool ok;
+  switch (command) {
+  case 0x41: // i32.const
+  case 0x42: // i64.const
+  case 0x23: // global.get
+    ok = wasm_copy_leb(reader, expr);
+    break;
+  case 0x43: // f32.const
+    ok = wasm_read(reader, wasm_vec_append_n(expr, 4), 4);
+    break;
+  case 0x44: // f64.const
+    ok = wasm_read(reader, wasm_vec_append_n(expr, 8), 8);
+    break;
+  case 0xFD: { // v128.const
+    unsigned char sub;
+    ok = wasm_read(reader, &sub, 1) && sub == 0x0C;
+    *wasm_vec_append(expr) = sub;
+    ok = ok && wasm_read(reader, wasm_vec_append_n(expr, 16), 16);
+  } break;
+  default:
+    fprintf(stderr, "Instruction 0x%02X is not allowed in a constant expr.\n",
+            command);
+    return false;
   }
 
-  return false;
+  if (!ok || !wasm_read(reader, &command, 1) || command != 0x0B) {
+    fprintf(stderr, "Error while parsing constant expr.\n");
+    return false;
+  }
+
+  return true;
 }
 
-bool wasm_load_module_sections(wasm_reader *reader, wasm_module *module) {
-  assert(reader);
-  assert(module);
+bool wasm_read_limits(wasm_reader *reader, wasm_limits *limits) {
+  unsigned char flags;
+  if (!wasm_read(reader, &flags, 1) || flags > 3) {
+    fprintf(stderr, "Invalid limits.\n");
+    return false;
+  }
 
-  char section_type;
-  char last_section_type =
-      0; // Last section that we parsed (except custom section)
+  limits->has_max = (flags & 1) != 0;
+  limits->is_shared = (flags & 2) != 0;
+  limits->max = 0;
+  if (!wasm_read_leb_u32_2(reader, &limits->min) ||
+      (limits->has_max && !wasm_read_leb_u32_2(reader, &limits->max))) {
+    fprintf(stderr, "Error reading limits.\n");
+    return false;
+  }
 
-  // Keep reading sections until the reader ends.
-  while (wasm_read(reader, &section_type, 1)) {
-    uint32_t section_length = wasm_read_leb_u32(reader);
+  if (limits->has_max && limits->max < limits->min) {
+    fprintf(stderr, "Limits maximum is smaller than the minimum.\n");
+    return false;
+  }
 
-    // All sections except for the custom section (id=0) must be in order.
-    if (section_type != 0 && section_type < last_section_type) {
-      fprintf(stderr, "Invalid order of sections.\n");
-      return false;
-    }
+  if (limits->is_shared && !limits->has_max) {
+    fprintf(stderr, "Shared limits must have a maximum.\n");
+    return false;
+  }
 
-    switch (section_type) {
-    // Custom section. There can be an unlimited number of custom sections
-    // (id=0) inbetween other sections. They can contain e.g. debugging
-    // information. We just skip them.
-    case 0: {
-      if (!wasm_seek(reader, section_length)) {
-        fprintf(stderr, "Error skipping custom section.\n");
-        return false;
-      }
-    } break;
+  return true;
+}
 
-    // Function type section. A vector of function types.
-    case 1: {
-      uint32_t type_count = wasm_read_leb_u32(reader);
+// Heap bytes a module load on this thread may allocate, 0 for no limit.
+static __thread size_t wasm_module_memory_limit = 0;
 
-      for (size_t i = 0; i < type_count; i++) {
-        // First byte needs to be 0x60.
-        {
-          char c;
-          if (!wasm_read(reader, &c, 1)) {
-            fprintf(stderr, "IO error loading function 0x60 byte.\n");
-            return false;
-          }
+void wasm_set_module_memory_limit(size_t max_bytes) {
+  wasm_module_memory_limit = max_bytes;
+}
 
-          if (c != 0x60) {
-            fprintf(stderr, "Function needs to start with 0x60.\n");
-            return false;
-          }
-        }
+// Loads check this after every section and every function body and data
+// segment, so a module can't allocate much more than the limit.
+static bool wasm_check_memory_limit() {
+  if (wasm_alloc_limit_exceeded()) {
+    fprintf(stderr, "Module exceeds the memory limit.\n");
+    return false;
+  }
+  return true;
+}
 
-        // We create a function object.
-        wasm_function_type *func =
-            (wasm_function_type *)wasm_vec_append(&module->function_types);
+// Reserves room for `count` elements of a vector whose size comes from the
+// module. Large reservations are checked against the memory limit before they
+// are made and a failed allocation fails the load.
+#define wasm_load_reserve(vec, count)                                          \
+  ((size_t)((vec)->capacity - (vec)->end) >= (size_t)(count) ||               \
+   wasm_load_grow((vec), sizeof(*(vec)->start), (count)))
+
+static bool wasm_load_grow(void *vec, size_t item_size, size_t count) {
+  if (count > SIZE_MAX / item_size ||
+      !wasm_alloc_limit_allows(count * item_size)) {
+    fprintf(stderr, "Module exceeds the memory limit.\n");
+    return false;
+  }
+  if (!_wasm_vec_try_grow(vec, item_size, count)) {
+    fprintf(stderr, "Out of memory.\n");
+    return false;
+  }
+  return true;
+}
+
+// Reads the length of a vector. Every element takes at least one byte, so
+// lengths beyond the rest of the section are rejected before anything is
+// allocated for them.
+static bool wasm_read_count(wasm_reader *reader, uint32_t *count) {
+  if (!wasm_read_leb_u32_2(reader, count) || *count > reader->size) {
+    fprintf(stderr, "Invalid vector length.\n");
+    return false;
+  }
+  return true;
+}
 
-        wasm_vec_init(&func->param_types, enum wasm_valtype);
+// Reads a name into the name pool of the module or its intern table. `out` is
+// set to its offset.
+static bool wasm_read_name(wasm_reader *reader, wasm_module *module,
+                           uint32_t *out) {
+  uint32_t length;
+  if (!wasm_read_leb_u32_2(reader, &length) || length > reader->size) {
+    return false;
+  }
 
-        // Parameters.
-        {
-          uint32_t param_count = wasm_read_leb_u32(reader);
+  *out = (uint32_t)wasm_vec_size(&module->names);
+  char *name = (char *)wasm_vec_append_n(&module->names, length + 1);
+  if (length > 0 && !wasm_read(reader, name, length)) {
+    return false;
+  }
+  name[length] = '\0';
 
-          for (size_t i = 0; i < param_count; i++) {
-            enum wasm_valtype *type = wasm_vec_append(&func->param_types);
+  if (!wasm_validate_utf8(name, length)) {
+    fprintf(stderr, "Invalid UTF-8 in name.\n");
+    return false;
+  }
 
-            if (!wasm_read_valtype(reader, type)) {
-              fprintf(stderr, "Error while reading param type.");
-              return false;
-            }
-          }
+  // The name pool is only a buffer then.
+  if (module->interned) {
+    module->names.end = (unsigned char *)name;
+    if (!wasm_intern(module->interned, name, length, out)) {
+      fprintf(stderr, "Intern table is full.\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+// Position of a section in the binary. The data count section (id=12) comes
+// before the code section.
+static int wasm_section_order(char section_type) {
+  if (section_type == 12) {
+    return 10;
+  }
+  return section_type < 10 ? section_type : section_type + 1;
+}
+
+// Decodes the payload of one section into `module`.
+static bool wasm_load_section(wasm_reader *reader, wasm_module *module,
+                              char section_type, uint32_t section_length) {
+  switch (section_type) {
+  // Custom section. There can be an unlimited number of custom sections
+  // (id=0) inbetween other sections. They can contain e.g. debugging
+  // information. We just skip them.
+  case 0: {
+    if (!wasm_seek(reader, section_length)) {
+      fprintf(stderr, "Error skipping custom section.\n");
+      return false;
+    }
+  } break;
+
+  // Function type section. A vector of function types.
+  case 1: {
+    uint32_t type_count;
+    if (!wasm_read_count(reader, &type_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->function_types, type_count)) {
+      return false;
+    }
+    // Every parameter takes at least one byte of the section so the types can
+    // point into `valtypes` without it ever moving. There is only one type
+    // section.
+    if (!wasm_load_reserve(&module->valtypes, section_length)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < type_count; i++) {
+      // First byte needs to be 0x60.
+      {
+        char c;
+        if (!wasm_read(reader, &c, 1)) {
+          fprintf(stderr, "IO error loading function 0x60 byte.\n");
+          return false;
         }
 
-        // Result type(s).
-        {
-          uint32_t result_count = wasm_read_leb_u32(reader);
+        if (c != 0x60) {
+          fprintf(stderr, "Function needs to start with 0x60.\n");
+          return false;
+        }
+      }
 
-          // There can only be one return type in the wasm spec right now.
-          if (result_count != 1) {
-            fprintf(stderr, "Only one result type supported.");
-          }
+      // We create a function object.
+      wasm_function_type *func = wasm_vec_append(&module->function_types);
+
+      func->params = NULL;
+      func->param_count = 0;
+      func->result_count = 0;
+      func->result_type = wasm_valtype_error;
+
+      // Parameters.
+      {
+        uint32_t param_count;
+        if (!wasm_read_count(reader, &param_count) ||
+            param_count > (size_t)(module->valtypes.capacity -
+                                   module->valtypes.end)) {
+          fprintf(stderr, "Invalid parameter count.\n");
+          return false;
+        }
 
-          // No loop here since there can currently only be one return type.
-          if (!wasm_read_valtype(reader, &func->result_type)) {
-            fprintf(stderr, "Error while reading result type.");
+        unsigned char *params =
+            wasm_vec_append_n(&module->valtypes, param_count);
+        func->params = params;
+        func->param_count = param_count;
+        for (size_t i = 0; i < param_count; i++) {
+          enum wasm_valtype type;
+          if (!wasm_read_valtype(reader, &type)) {
+            fprintf(stderr, "Error while reading param type.");
             return false;
           }
+          params[i] = (unsigned char)type;
         }
       }
-    } break;
 
-    // func section.
-    case 3: {
-      uint32_t func_count = wasm_read_leb_u32(reader);
+      // Result type(s).
+      {
+        uint32_t result_count = wasm_read_leb_u32(reader);
 
-      for (size_t i = 0; i < func_count; i++) {
-        wasm_typeidx *func = wasm_vec_append(&module->funcs);
-        *func = wasm_read_leb_u32(reader);
+        // There can only be one return type in the wasm spec right now.
+        if (result_count > 1) {
+          fprintf(stderr, "Only one result type supported.");
+          return false;
+        }
+
+        // No loop here since there can currently only be one return type.
+        enum wasm_valtype result_type = wasm_valtype_error;
+        if (result_count == 1 && !wasm_read_valtype(reader, &result_type)) {
+          fprintf(stderr, "Error while reading result type.");
+          return false;
+        }
+        func->result_count = (uint8_t)result_count;
+        func->result_type = (uint8_t)result_type;
       }
-    } break;
+    }
+  } break;
 
-    // global section.
-    case 6: {
-      uint32_t global_count = wasm_read_leb_u32(reader);
+  // import section. Imported functions and globals are resolved when the
+  // module gets instantiated.
+  case 2: {
+    uint32_t import_count;
+    if (!wasm_read_count(reader, &import_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->imports, import_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->names, section_length)) {
+      return false;
+    }
+    size_t type_count = wasm_vec_size(&module->function_types);
 
-      for (size_t i = 0; i < global_count; i++) {
-        wasm_global *global = wasm_vec_append(&module->globals);
-        wasm_init_global(global);
+    for (size_t i = 0; i < import_count; i++) {
+      wasm_import *import = wasm_vec_append(&module->imports);
+
+      // names
+      if (!wasm_read_name(reader, module, &import->module_name) ||
+          !wasm_read_name(reader, module, &import->name)) {
+        fprintf(stderr, "Error reading import name.\n");
+        return false;
+      }
 
-        // type
-        global->type = wasm_read_leb_u32(reader);
+      // import description
+      unsigned char c;
+      if (!wasm_read(reader, &c, 1)) {
+        fprintf(stderr, "Error reading import description.\n");
+        return false;
+      }
 
-        // mutablility
-        unsigned char c;
-        wasm_read(reader, &c, 1);
-        if (c > 1) {
-          fprintf(stderr, "Level of mutability not supported (%u)", c);
+      switch (c) {
+      case 0:
+        import->type = wasm_import_func;
+        if (!wasm_read_leb_u32_2(reader, &import->desc.func) ||
+            import->desc.func >= type_count) {
+          fprintf(stderr, "Invalid type of imported function.\n");
           return false;
         }
-        global->is_mutable = c == 1;
-
-        // initializer
-        if (!wasm_read_expr(reader, &global->initializer)) {
+        module->import_func_count++;
+        break;
+      case 1:
+        import->type = wasm_import_table;
+        // Only funcref tables exist in the MVP.
+        if (!wasm_read(reader, &c, 1) || c != 0x70 ||
+            !wasm_read_limits(reader, &import->desc.table) ||
+            import->desc.table.is_shared) {
+          fprintf(stderr, "Invalid imported table.\n");
+          return false;
+        }
+        module->import_table_count++;
+        break;
+      case 2:
+        import->type = wasm_import_mem;
+        if (!wasm_read_limits(reader, &import->desc.mem)) {
+          return false;
+        }
+        module->import_mem_count++;
+        break;
+      case 3:
+        import->type = wasm_import_global;
+        if (!wasm_read_valtype(reader, &import->desc.global.type) ||
+            !wasm_read(reader, &c, 1) || c > 1) {
+          fprintf(stderr, "Invalid imported global.\n");
           return false;
         }
+        import->desc.global.is_mutable = c == 1;
+        module->import_global_count++;
+        break;
+      default:
+        fprintf(stderr, "Invalid import description found.\n");
+        return false;
+      }
+    }
+  } break;
+
+  // func section.
+  case 3: {
+    uint32_t func_count;
+    if (!wasm_read_count(reader, &func_count)) {
+      return false;
+    }
+    size_t type_count = wasm_vec_size(&module->function_types);
+    if (!wasm_load_reserve(&module->funcs, func_count)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < func_count; i++) {
+      wasm_typeidx *func = wasm_vec_append(&module->funcs);
+      if (!wasm_read_leb_u32_2(reader, func) || *func >= type_count) {
+        fprintf(stderr, "Invalid function type index.\n");
+        return false;
       }
-    } break;
+    }
+  } break;
 
-    // exports
-    case 7: {
-      uint32_t export_count = wasm_read_leb_u32(reader);
+  // table section. Only one table is allowed in the MVP.
+  case 4: {
+    uint32_t table_count;
+    if (!wasm_read_count(reader, &table_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->tables, table_count)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < table_count; i++) {
+      unsigned char elem_type;
+      if (!wasm_read(reader, &elem_type, 1) || elem_type != 0x70) {
+        fprintf(stderr, "Only funcref tables are supported.\n");
+        return false;
+      }
+      wasm_limits *limits = wasm_vec_append(&module->tables);
+      if (!wasm_read_limits(reader, limits)) {
+        return false;
+      }
+      if (limits->is_shared) {
+        fprintf(stderr, "Tables can't be shared.\n");
+        return false;
+      }
+    }
 
-      for (size_t i = 0; i < export_count; i++) {
-        wasm_export *export = wasm_vec_append(&module->exports);
+    if (module->import_table_count + wasm_vec_size(&module->tables) > 1) {
+      fprintf(stderr, "Only one table is supported.\n");
+      return false;
+    }
+  } break;
 
-        // name
-        if (!wasm_read_string(reader, &export->name)) {
-          fprintf(stderr, "Error reading export name.\n");
-          return false;
-        }
+  // mem section. Only one memory is allowed in the MVP.
+  case 5: {
+    uint32_t mem_count;
+    if (!wasm_read_count(reader, &mem_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->mems, mem_count)) {
+      return false;
+    }
 
-        // export description
-        unsigned char c;
-        if (!wasm_read(reader, &c, 1)) {
-          fprintf(stderr, "Error reading export description.\n");
+    for (size_t i = 0; i < mem_count; i++) {
+      if (!wasm_read_limits(reader, wasm_vec_append(&module->mems))) {
+        return false;
+      }
+    }
+
+    if (module->import_mem_count + wasm_vec_size(&module->mems) > 1) {
+      fprintf(stderr, "Only one memory is supported.\n");
+      return false;
+    }
+  } break;
+
+  // global section.
+  case 6: {
+    uint32_t global_count;
+    if (!wasm_read_count(reader, &global_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->globals, global_count)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < global_count; i++) {
+      wasm_global *global = wasm_vec_append(&module->globals);
+      wasm_init_global(global);
+
+      // type
+      if (!wasm_read_valtype(reader, &global->type)) {
+        fprintf(stderr, "Error reading global type.\n");
+        return false;
+      }
+
+      // mutablility
+      unsigned char c;
+      wasm_read(reader, &c, 1);
+      if (c > 1) {
+        fprintf(stderr, "Level of mutability not supported (%u)", c);
+        return false;
+      }
+      global->is_mutable = c == 1;
+
+      // initializer
+      if (!wasm_read_const_expr(reader, &global->initializer)) {
+        return false;
+      }
+    }
+  } break;
+
+  // exports
+  case 7: {
+    uint32_t export_count;
+    if (!wasm_read_count(reader, &export_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->exports, export_count)) {
+      return false;
+    }
+    // A name never takes more room than it does in the section.
+    if (!wasm_load_reserve(&module->names, section_length)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < export_count; i++) {
+      wasm_export *export = wasm_vec_append(&module->exports);
+
+      // name
+      if (!wasm_read_name(reader, module, &export->name)) {
+        fprintf(stderr, "Error reading export name.\n");
+        return false;
+      }
+
+      // export description
+      unsigned char c;
+      if (!wasm_read(reader, &c, 1)) {
+        fprintf(stderr, "Error reading export description.\n");
+        return false;
+      }
+
+      // The index spaces are complete since their sections come first.
+      size_t index_count;
+      switch (c) {
+      case 0:
+        export->type = wasm_export_func;
+        index_count =
+            module->import_func_count + wasm_vec_size(&module->funcs);
+        break;
+      case 1:
+        export->type = wasm_export_table;
+        index_count =
+            module->import_table_count + wasm_vec_size(&module->tables);
+        break;
+      case 2:
+        export->type = wasm_export_mem;
+        index_count = module->import_mem_count + wasm_vec_size(&module->mems);
+        break;
+      case 3:
+        export->type = wasm_export_global;
+        index_count =
+            module->import_global_count + wasm_vec_size(&module->globals);
+        break;
+      default:
+        fprintf(stderr, "Invalid export description found.\n");
+        return false;
+      }
+
+      // export index
+      if (!wasm_read_leb_u32_2(reader, &export->idx) ||
+          export->idx >= index_count) {
+        fprintf(stderr, "Invalid export index.\n");
+        return false;
+      }
+    }
+  } break;
+
+  // start section. Index of a function that is called on instantiation.
+  case 8: {
+    if (!wasm_read_leb_u32_2(reader, &module->start)) {
+      fprintf(stderr, "Error reading start function.\n");
+      return false;
+    }
+    module->has_start = true;
+  } break;
+
+  // elem section. Initializers for tables.
+  case 9: {
+    uint32_t elem_count;
+    if (!wasm_read_count(reader, &elem_count)) {
+      return false;
+    }
+    if (!wasm_load_reserve(&module->elems, elem_count)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < elem_count; i++) {
+      wasm_elem *elem = wasm_vec_append(&module->elems);
+      wasm_init_elem(elem);
+
+      // 0 is the MVP encoding with an implicit table 0. 2 has an explicit
+      // table index and element kind.
+      uint32_t flags;
+      unsigned char elem_kind = 0;
+      elem->tableidx = 0;
+      if (!wasm_read_leb_u32_2(reader, &flags) || (flags != 0 && flags != 2) ||
+          (flags == 2 && !wasm_read_leb_u32_2(reader, &elem->tableidx)) ||
+          !wasm_read_const_expr(reader, &elem->offset) ||
+          (flags == 2 && !wasm_read(reader, &elem_kind, 1)) ||
+          elem_kind != 0) {
+        fprintf(stderr, "Unsupported element segment.\n");
+        return false;
+      }
+
+      uint32_t func_count;
+      if (!wasm_read_count(reader, &func_count)) {
+        return false;
+      }
+      if (!wasm_load_reserve(&elem->init, func_count)) {
+        return false;
+      }
+      for (size_t i_func = 0; i_func < func_count; i_func++) {
+        if (!wasm_read_leb_u32_2(reader, wasm_vec_append(&elem->init))) {
+          fprintf(stderr, "Error reading element segment.\n");
           return false;
         }
+      }
+    }
+  } break;
 
-        if (c > 4) {
-          switch (c) {
-          case 0:
-            export->type = wasm_export_func;
-            break;
-          case 1:
-            export->type = wasm_export_table;
-            break;
-          case 2:
-            export->type = wasm_export_mem;
-            break;
-          case 3:
-            export->type = wasm_export_global;
-            break;
-          default:
-            fprintf(stderr, "Invalid export description found.\n");
-            return false;
-          }
-        }
+  // Code segements. Contains a vector of function bodies.
+  case 10: {
+    uint32_t func_count;
+    if (!wasm_read_count(reader, &func_count)) {
+      return false;
+    }
 
-        // export index
-        export->idx = wasm_read_leb_u32(reader);
+    if (func_count != wasm_vec_size(&module->funcs)) {
+      fprintf(stderr, "Function and code section sizes differ.\n");
+      return false;
+    }
+    if (!wasm_load_reserve(&module->codes, func_count)) {
+      return false;
+    }
+    // The instructions are never larger than the bodies so they are all
+    // copied into one buffer.
+    if (!wasm_load_reserve(&module->code_bytes, section_length)) {
+      return false;
+    }
+
+    wasm_perf_stats *perf = wasm_get_perf_stats();
+    for (size_t i_func = 0; i_func < func_count; i_func++) {
+      wasm_perf_sample perf_start;
+      if (perf) {
+        wasm_perf_read(&perf_start);
       }
-    } break;
 
-    // Code segements. Contains a vector of
-    case 10: {
-      uint32_t func_count = wasm_read_leb_u32(reader);
+      uint32_t code_size;
+      if (!wasm_read_leb_u32_2(reader, &code_size) ||
+          code_size > reader->size) {
+        fprintf(stderr, "Error reading code size.\n");
+        return false;
+      }
 
-      for (size_t i_func = 0; i_func < func_count; i_func++) {
-        // This variable may be used for skipping but we don't need it.
-        /*uint32_t code_size =*/wasm_read_leb_u32(reader);
+      wasm_code *code = wasm_vec_append(&module->codes);
+      code->compiled = NULL;
+      code->expr_offset = (uint32_t)wasm_vec_size(&module->code_bytes);
+      code->expr_size = 0;
+      code->locals_offset = (uint32_t)wasm_vec_size(&module->locals);
+      code->locals_count = 0;
+
+      // We don't know the size of the locals in advance so we read the whole
+      // body first and move the instructions to its start later.
+      unsigned char *body = wasm_vec_append_n(&module->code_bytes, code_size);
+      if (code_size == 0 || !wasm_read(reader, body, code_size)) {
+        fprintf(stderr, "Error reading function body.\n");
+        return false;
+      }
 
-        wasm_code *code = wasm_vec_append(&module->codes);
-        wasm_init_code(code);
+      wasm_reader body_reader;
+      wasm_init_memory_reader(&body_reader, body, code_size);
 
-        // vec<locals>.
-        uint32_t local_count = wasm_read_leb_u32(reader);
-        for (size_t i_local = 0; i_local < local_count; i_local++) {
-          wasm_locals *locals = wasm_vec_append(&code->locals);
+      // vec<locals>.
+      uint32_t local_count;
+      if (!wasm_read_count(&body_reader, &local_count)) {
+        return false;
+      }
+      code->locals_count = local_count;
+      if (!wasm_load_reserve(&module->locals, local_count)) {
+        return false;
+      }
+      for (size_t i_local = 0; i_local < local_count; i_local++) {
+        wasm_locals *locals = wasm_vec_append(&module->locals);
 
-          if (!wasm_read_leb_u32_2(reader, &locals->n) ||
-              !wasm_read_valtype(reader, &locals->type)) {
-            fprintf(stderr, "Error while reading local variable definition.");
-            return false;
-          }
+        if (!wasm_read_leb_u32_2(&body_reader, &locals->n) ||
+            !wasm_read_valtype(&body_reader, &locals->type)) {
+          fprintf(stderr, "Error while reading local variable definition.");
+          return false;
         }
+      }
+
+      // expr. The final 0x0B is not stored.
+      size_t expr_size = body_reader.size;
+      if (expr_size == 0 || body[code_size - 1] != 0x0B) {
+        fprintf(stderr, "Function body needs to end with 0x0B.\n");
+        return false;
+      }
+      memmove(body, body_reader.device, expr_size - 1);
+      code->expr_size = (uint32_t)(expr_size - 1);
+      module->code_bytes.end = body + code->expr_size;
 
-        // expr.
-        wasm_read_expr(reader, &code->expr);
+      if (!wasm_check_memory_limit()) {
+        return false;
+      }
+      if (perf) {
+        wasm_perf_func *func = wasm_vec_append(&perf->funcs);
+        func->funcidx = module->import_func_count + (uint32_t)i_func;
+        func->size = code_size;
+        memset(&func->sample, 0, sizeof(func->sample));
+        wasm_perf_add(&func->sample, &perf_start);
       }
-    } break;
+    }
+  } break;
 
-    case 2:  // import
-    case 4:  // table
-    case 5:  // mem
-    case 8:  // start
-    case 9:  // elem
-    case 11: // data
-      fprintf(stderr, "Parsing section %u is not implemented yet\n",
-              section_type);
+  // data section. Initializers for the linear memory.
+  case 11: {
+    uint32_t data_count;
+    if (!wasm_read_count(reader, &data_count)) {
       return false;
+    }
+    if (!wasm_load_reserve(&module->datas, data_count)) {
+      return false;
+    }
 
-    default:
-      fprintf(stderr, "Unknown section found: %u\n", section_type);
+    if (module->has_data_count && data_count != module->data_count) {
+      fprintf(stderr, "Data count and data section sizes differ.\n");
       return false;
     }
 
+    for (size_t i = 0; i < data_count; i++) {
+      wasm_data *data = wasm_vec_append(&module->datas);
+      wasm_init_data(data);
+
+      // 0: active with memory 0, 1: passive, 2: active with a memory index.
+      uint32_t flags;
+      if (!wasm_read_leb_u32_2(reader, &flags) || flags > 2) {
+        fprintf(stderr, "Invalid data segment flags.\n");
+        return false;
+      }
+      data->is_passive = flags == 1;
+      data->memidx = 0;
+
+      uint32_t size;
+      if ((flags == 2 && !wasm_read_leb_u32_2(reader, &data->memidx)) ||
+          (flags != 1 && !wasm_read_const_expr(reader, &data->offset)) ||
+          !wasm_read_leb_u32_2(reader, &size) || size > reader->size) {
+        fprintf(stderr, "Error reading data segment.\n");
+        return false;
+      }
+
+      if (!wasm_load_reserve(&data->init, size)) {
+        return false;
+      }
+      if (size > 0 &&
+          !wasm_read(reader, wasm_vec_append_n(&data->init, size), size)) {
+        fprintf(stderr, "Error reading data segment contents.\n");
+        return false;
+      }
+      if (!wasm_check_memory_limit()) {
+        return false;
+      }
+    }
+  } break;
+
+  // data count section. Allows validating data indices in the code section.
+  case 12: {
+    if (!wasm_read_leb_u32_2(reader, &module->data_count)) {
+      fprintf(stderr, "Error reading data count.\n");
+      return false;
+    }
+    module->has_data_count = true;
+  } break;
+
+  default:
+    fprintf(stderr, "Unknown section found: %u\n", section_type);
+    return false;
+  }
+  return true;
+}
+
+bool wasm_load_module_sections(wasm_reader *reader, wasm_module *module,
+                               wasm_load_stats *stats) {
+  assert(reader);
+  assert(module);
+
+  char section_type;
+  char last_section_type =
+      0; // Last section that we parsed (except custom section)
+  // Sections are measured once for the load stats and the perf stats.
+  wasm_perf_stats *perf = wasm_get_perf_stats();
+  bool measure = stats || perf;
+
+  // Keep reading sections until the reader ends.
+  while (wasm_read(reader, &section_type, 1)) {
+    uint32_t section_length;
+    if (!wasm_read_leb_u32_2(reader, &section_length) ||
+        section_length > reader->size) {
+      fprintf(stderr, "Invalid section length.\n");
+      return false;
+    }
+
+    // All sections except for the custom section (id=0) must be in order and
+    // appear at most once.
+    if (section_type != 0 && wasm_section_order(section_type) <=
+                                 wasm_section_order(last_section_type)) {
+      fprintf(stderr, "Invalid order of sections.\n");
+      return false;
+    }
+
+    wasm_perf_sample start;
+    if (measure) {
+      wasm_perf_read(&start);
+    }
+    // The reader ends with the section while it is decoded, so counts and
+    // sizes in the payload are bounded by the section even when the size of
+    // the input isn't known, e.g. for pipes.
+    size_t rest = reader->size;
+    reader->size = section_length;
+    bool ok = wasm_load_section(reader, module, section_type, section_length);
+    if (ok && reader->size != 0) {
+      fprintf(stderr, "Section size mismatch.\n");
+      ok = false;
+    }
+    reader->size = rest == SIZE_MAX ? rest : rest - section_length;
+    if (!ok || !wasm_check_memory_limit()) {
+      return false;
+    }
+    unsigned char id = (unsigned char)section_type;
+    if (measure && id < wasm_section_count) {
+      wasm_perf_sample unused = {0};
+      wasm_perf_sample *total = perf ? &perf->sections[id] : &unused;
+      uint64_t ns = total->ns;
+      wasm_perf_add(total, &start);
+      if (stats) {
+        stats->section_ns[id] += total->ns - ns;
+        stats->section_bytes[id] += section_length;
+      }
+    }
     last_section_type = section_type;
   }
+
+  // The data section may be missing even though a data count is declared.
+  if (module->has_data_count &&
+      module->data_count != wasm_vec_size(&module->datas)) {
+    fprintf(stderr, "Data count and data section sizes differ.\n");
+    return false;
+  }
+  return true;
+}
+
+static uint32_t wasm_hash_function_type(wasm_function_type *type) {
+  // FNV-1a over the parameters and the result.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < type->param_count; i++) {
+    hash = (hash ^ (uint32_t)type->params[i]) * 16777619u;
+  }
+  hash = (hash ^ 0xFF) * 16777619u;
+  if (type->result_count) {
+    hash = (hash ^ (uint32_t)type->result_type) * 16777619u;
+  }
+  return hash;
+}
+
+// Moves the parameter types to the intern table of the module. A type is
+// stored as its parameters followed by the result, its offset is the id.
+static bool wasm_intern_shared_types(wasm_module *module) {
+  size_t type_count = wasm_vec_size(&module->function_types);
+  uint32_t *ids = wasm_vec_append_n(&module->type_ids, type_count);
+  wasm_byte_vec key;
+  wasm_vec_init(&key);
+
+  bool ok = true;
+  for (size_t i = 0; ok && i < type_count; i++) {
+    wasm_function_type *type = wasm_vec_get(&module->function_types, i);
+    key.end = key.start;
+    unsigned char *bytes = wasm_vec_append_n(&key, type->param_count + 1);
+    if (type->param_count) {
+      memcpy(bytes, type->params, type->param_count);
+    }
+    bytes[type->param_count] = type->result_count ? type->result_type : 0;
+
+    ok = wasm_intern(module->interned, key.start,
+                     (uint32_t)wasm_vec_size(&key), &ids[i]);
+    type->params = wasm_intern_data(module->interned, ids[i]);
+  }
+
+  wasm_vec_deinit(&key);
+  wasm_vec_deinit(&module->valtypes);
+  if (!ok) {
+    fprintf(stderr, "Intern table is full.\n");
+  }
+  return ok;
+}
+
+// Assigns the canonical ids. The id of a type is the index of the first type
+// that is equal to it. Equal types are found with an open addressing hash
+// table so this stays linear for modules with many types.
+static bool wasm_intern_types(wasm_module *module) {
+  size_t type_count = wasm_vec_size(&module->function_types);
+  if (module->interned) {
+    return wasm_intern_shared_types(module);
+  }
+  if (type_count == 0) {
+    return true;
+  }
+
+  size_t bucket_count = 16;
+  while (bucket_count < type_count * 2) {
+    bucket_count *= 2;
+  }
+
+  uint32_t *buckets = wasm_alloc_array(uint32_t, bucket_count);
+  memset(buckets, 0xFF, bucket_count * sizeof(uint32_t));
+
+  uint32_t *ids = wasm_vec_append_n(&module->type_ids, type_count);
+  for (uint32_t i = 0; i < type_count; i++) {
+    wasm_function_type *type = wasm_vec_get(&module->function_types, i);
+    size_t bucket = wasm_hash_function_type(type) & (bucket_count - 1);
+
+    for (;; bucket = (bucket + 1) & (bucket_count - 1)) {
+      if (buckets[bucket] == UINT32_MAX) {
+        buckets[bucket] = i;
+        ids[i] = i;
+        break;
+      }
+      if (wasm_function_type_equal(
+              type, wasm_vec_get(&module->function_types, buckets[bucket]))) {
+        ids[i] = buckets[bucket];
+        break;
+      }
+    }
+  }
+
+  wasm_free(buckets);
   return true;
 }
 
+// An empty module.
+static wasm_module *wasm_create_module(void) {
+  wasm_module *module = wasm_alloc(wasm_module);
+  wasm_vec_init(&module->function_types);
+  wasm_vec_init(&module->type_ids);
+  wasm_vec_init(&module->imports);
+  wasm_vec_init(&module->funcs);
+  wasm_vec_init(&module->tables);
+  wasm_vec_init(&module->mems);
+  wasm_vec_init(&module->globals);
+  wasm_vec_init(&module->exports);
+  wasm_vec_init(&module->elems);
+  wasm_vec_init(&module->codes);
+  wasm_vec_init(&module->datas);
+  wasm_vec_init(&module->valtypes);
+  wasm_vec_init(&module->names);
+  wasm_vec_init(&module->code_bytes);
+  wasm_vec_init(&module->locals);
+  module->interned = NULL;
+  module->import_func_count = 0;
+  module->import_table_count = 0;
+  module->import_mem_count = 0;
+  module->import_global_count = 0;
+  module->indirect_call_count = 0;
+  module->has_start = false;
+  module->start = 0;
+  module->has_data_count = false;
+  module->data_count = 0;
+  return module;
+}
+
+static wasm_module *wasm_load_module_into(wasm_reader *reader,
+                                          wasm_intern_table *table,
+                                          wasm_load_stats *stats);
+
 wasm_module *wasm_load_module(wasm_reader *reader) {
+  return wasm_load_module_into(reader, NULL, NULL);
+}
+
+wasm_module *wasm_load_module_with_stats(wasm_reader *reader,
+                                         wasm_load_stats *stats) {
+  return wasm_load_module_into(reader, NULL, stats);
+}
+
+wasm_module *wasm_load_module_interned(wasm_reader *reader,
+                                       wasm_intern_table *table) {
+  return wasm_load_module_into(reader, table, NULL);
+}
+
+static wasm_module *wasm_load_module_into(wasm_reader *reader,
+                                          wasm_intern_table *table,
+                                          wasm_load_stats *stats) {
+  uint64_t start = 0;
+  if (stats) {
+    memset(stats, 0, sizeof(*stats));
+    start = wasm_now_ns();
+  }
+
   // Read header.
   wasm_module_header header;
+  wasm_perf_stats *perf = wasm_get_perf_stats();
+  wasm_perf_sample perf_start;
+  if (perf) {
+    wasm_perf_read(&perf_start);
+  }
   if (!wasm_load_header(reader, &header)) {
     return NULL;
   }
+  if (perf) {
+    wasm_perf_add(&perf->header, &perf_start);
+  }
 
   // Load sections. We free `module` ourselves on failure. `wasm_free_module`
   // handle deleting partially laoded modules.
-  wasm_module *module = wasm_alloc(wasm_module);
-  wasm_vec_init(&module->function_types, wasm_function_type);
-  wasm_vec_init(&module->funcs, wasm_typeidx);
-  wasm_vec_init(&module->globals, wasm_global);
-  wasm_vec_init(&module->exports, wasm_export);
-  wasm_vec_init(&module->codes, wasm_code);
-
-  if (wasm_load_module_sections(reader, module)) {
+  wasm_set_alloc_limit(wasm_module_memory_limit);
+  wasm_module *module = wasm_create_module();
+  module->header = header;
+  module->interned = table;
+
+  bool ok = wasm_load_module_sections(reader, module, stats);
+  wasm_set_alloc_limit(0);
+  if (ok && table) {
+    // Only used as a buffer while reading the names.
+    wasm_vec_deinit(&module->names);
+  }
+  if (ok && wasm_intern_types(module)) {
+    if (stats) {
+      stats->total_ns = wasm_now_ns() - start;
+    }
     return module;
   } else {
     wasm_free_module(module);
@@ -371,6 +1145,153 @@ wasm_module *wasm_load_module(wasm_reader *reader) {
   }
 }
 
+const char *wasm_section_name(unsigned char id) {
+  static const char *names[wasm_section_count] = {
+      "custom", "type",  "import",  "function", "table", "memory",   "global",
+      "export", "start", "element", "code",     "data",  "datacount"};
+  return id < wasm_section_count ? names[id] : "unknown";
+}
+
+bool wasm_read_section_directory(wasm_section_directory *directory,
+                                 const void *data, size_t size) {
+  directory->data = data;
+  directory->size = size;
+  wasm_vec_init(&directory->sections);
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, data, size);
+  wasm_module_header header;
+  if (!wasm_load_header(&reader, &header)) {
+    return false;
+  }
+
+  unsigned char id;
+  unsigned char last_id = 0;
+  while (wasm_read(&reader, &id, 1)) {
+    uint32_t length;
+    if (!wasm_read_leb_u32_2(&reader, &length) || length > reader.size) {
+      fprintf(stderr, "Invalid section length.\n");
+      return false;
+    }
+    if (id >= wasm_section_count) {
+      fprintf(stderr, "Unknown section found: %u\n", id);
+      return false;
+    }
+    if (id != 0 && wasm_section_order(id) <= wasm_section_order(last_id)) {
+      fprintf(stderr, "Invalid order of sections.\n");
+      return false;
+    }
+
+    wasm_section_entry *entry = wasm_vec_append(&directory->sections);
+    entry->id = id;
+    entry->offset = size - reader.size;
+    entry->length = length;
+    entry->name = NULL;
+
+    // Only the name of custom sections is read, everything else is skipped.
+    if (id == 0) {
+      wasm_reader name_reader;
+      wasm_init_memory_reader(&name_reader, reader.device, length);
+      if (!wasm_read_string(&name_reader, &entry->name)) {
+        fprintf(stderr, "Error reading custom section name.\n");
+        return false;
+      }
+      entry->offset += length - name_reader.size;
+      entry->length = (uint32_t)name_reader.size;
+    } else {
+      last_id = id;
+    }
+
+    wasm_seek(&reader, length);
+  }
+
+  return true;
+}
+
+void wasm_deinit_section_directory(wasm_section_directory *directory) {
+  for (wasm_section_entry *entry = directory->sections.start;
+       entry != directory->sections.end; entry++) {
+    wasm_free(entry->name);
+  }
+  wasm_vec_deinit(&directory->sections);
+}
+
+const wasm_section_entry *
+wasm_section_directory_find(const wasm_section_directory *directory,
+                            unsigned char id, const char *name) {
+  for (wasm_section_entry *entry = directory->sections.start;
+       entry != directory->sections.end; entry++) {
+    if (entry->id == id &&
+        (id != 0 || (name != NULL && strcmp(entry->name, name) == 0))) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+wasm_module *wasm_decode_sections(const wasm_section_directory *directory,
+                                  uint32_t mask) {
+  // Imports and functions refer to types, the code needs the function count,
+  // exports need every index space and the data section is checked against
+  // the data count.
+  if (mask & wasm_section_bit(10)) {
+    mask |= wasm_section_bit(3);
+  }
+  if (mask & wasm_section_bit(7)) {
+    mask |= wasm_section_bit(2) | wasm_section_bit(3) | wasm_section_bit(4) |
+            wasm_section_bit(5) | wasm_section_bit(6);
+  }
+  if (mask & (wasm_section_bit(2) | wasm_section_bit(3))) {
+    mask |= wasm_section_bit(1);
+  }
+  if (mask & wasm_section_bit(11)) {
+    mask |= wasm_section_bit(12);
+  }
+
+  wasm_set_alloc_limit(wasm_module_memory_limit);
+  wasm_module *module = wasm_create_module();
+  memcpy(&module->header, directory->data, sizeof(module->header));
+
+  // Custom sections have no decoded form.
+  for (wasm_section_entry *entry = directory->sections.start;
+       entry != directory->sections.end; entry++) {
+    if (entry->id == 0 || (mask & wasm_section_bit(entry->id)) == 0) {
+      continue;
+    }
+
+    // The reader ends with the section so a broken payload can't run into
+    // the next one.
+    wasm_reader reader;
+    wasm_init_memory_reader(&reader, directory->data + entry->offset,
+                            entry->length);
+    bool ok = wasm_load_section(&reader, module, (char)entry->id,
+                                entry->length);
+    if (ok && reader.size != 0) {
+      fprintf(stderr, "Section size mismatch.\n");
+      ok = false;
+    }
+    if (!ok || !wasm_check_memory_limit()) {
+      wasm_set_alloc_limit(0);
+      wasm_free_module(module);
+      return NULL;
+    }
+  }
+  wasm_set_alloc_limit(0);
+
+  if ((mask & wasm_section_bit(11)) && module->has_data_count &&
+      module->data_count != wasm_vec_size(&module->datas)) {
+    fprintf(stderr, "Data count and data section sizes differ.\n");
+    wasm_free_module(module);
+    return NULL;
+  }
+
+  if (!wasm_intern_types(module)) {
+    wasm_free_module(module);
+    return NULL;
+  }
+  return module;
+}
+
 wasm_module *wasm_load_module_from_file(const char *file_name) {
   FILE *file = fopen(file_name, "rb");
 
@@ -389,20 +1310,53 @@ wasm_module *wasm_load_module_from_file(const char *file_name) {
   return result;
 }
 
-void wasm_print_module(wasm_module *module) {
-  // types
-  for (wasm_function_type *type = module->function_types.start;
-       type != module->function_types.end; type++) {
-    printf("type: params( ");
-    for (enum wasm_valtype *param = type->param_types.start;
-         param != type->param_types.end; param++) {
-      printf("%s ", wasm_valtype_to_str(*param));
+wasm_typeidx wasm_module_func_typeidx(wasm_module *module, uint32_t funcidx) {
+  if (funcidx >= module->import_func_count) {
+    return *wasm_vec_get(&module->funcs, funcidx - module->import_func_count);
+  }
+
+  // Imported functions come first.
+  for (wasm_import *import = module->imports.start;; import++) {
+    if (import->type == wasm_import_func && funcidx-- == 0) {
+      return import->desc.func;
     }
-    printf(") returns( %s )\n", wasm_valtype_to_str(type->result_type));
   }
+}
 
-  // funcs
-  for (uint32_t *idx = module->funcs.start; idx != module->funcs.end; idx++) {
-    printf("func with type %u\n", *idx);
+wasm_function_type *wasm_module_func_type(wasm_module *module,
+                                          uint32_t funcidx) {
+  if (funcidx >= module->import_func_count + wasm_vec_size(&module->funcs)) {
+    return NULL;
   }
-}
\ No newline at end of file
+  return wasm_vec_get(&module->function_types,
+                      wasm_module_func_typeidx(module, funcidx));
+}
+
+uint32_t wasm_module_type_id(wasm_module *module, wasm_typeidx typeidx) {
+  return *wasm_vec_get(&module->type_ids, typeidx);
+}
+
+const char *wasm_module_name(const wasm_module *module, uint32_t name) {
+  if (module->interned) {
+    return (const char *)wasm_intern_data(module->interned, name);
+  }
+  assert(name < wasm_vec_size(&module->names));
+  return (const char *)module->names.start + name;
+}
+
+const unsigned char *wasm_code_expr(const wasm_module *module,
+                                    const wasm_code *code) {
+  return module->code_bytes.start + code->expr_offset;
+}
+
+wasm_export *wasm_module_find_export(wasm_module *module, const char *name,
+                                     enum wasm_export_type type) {
+  for (wasm_export *export = module->exports.start;
+       export != module->exports.end; export++) {
+    if (export->type == type &&
+        strcmp(wasm_module_name(module, export->name), name) == 0) {
+      return export;
+    }
+  }
+  return NULL;
+}
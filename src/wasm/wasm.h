@@ -1,36 +1,87 @@
 #pragma once
 
+#include "wasm/wasm_intern.h"
 #include "wasm/wasm_reader.h"
 #include "wasm/wasm_vec.h"
 #include "wasm_common.h"
 #include <stdint.h>
 
-// Function type.
-// XXX: since there is only 4 values it might be worth considering using a char
-// and #defines instead.
+// Value types. Types that are stored in bulk, like the parameters of function
+// types, take one byte each.
 enum wasm_valtype {
   wasm_valtype_error,
   wasm_valtype_i32,
   wasm_valtype_i64,
   wasm_valtype_f32,
   wasm_valtype_f64,
+  wasm_valtype_v128,
 };
 
+// Returns the text format name of a value type, e.g. "i32".
+const char *wasm_valtype_to_str(enum wasm_valtype type);
+
+typedef wasm_vec_of(unsigned char) wasm_byte_vec;
+
+// Function type.
 typedef struct {
-  // Storing `wasm_valtype`.
-  wasm_vec param_types;
-  enum wasm_valtype result_type;
+  // One `enum wasm_valtype` per parameter. The parameters of all types of a
+  // module are packed into `wasm_module.valtypes`, host function types own
+  // theirs.
+  const unsigned char *params;
+  uint32_t param_count;
+  // Either 0 or 1 since there can only be one result type in the spec right
+  // now. `result_type` is only valid if this is 1.
+  uint8_t result_count;
+  uint8_t result_type;
 } wasm_function_type;
+typedef wasm_vec_of(wasm_function_type) wasm_function_type_vec;
 
 typedef uint32_t wasm_typeidx;
-// Storing `unsigned char`.
-typedef wasm_vec wasm_expr;
+typedef wasm_vec_of(uint32_t) wasm_u32_vec;
+typedef wasm_byte_vec wasm_expr;
 
 typedef struct {
   enum wasm_valtype type;
   bool is_mutable;
   wasm_expr initializer;
 } wasm_global;
+typedef wasm_vec_of(wasm_global) wasm_global_vec;
+
+// Size limits of memories and tables.
+typedef struct {
+  uint32_t min;
+  uint32_t max;
+  bool has_max;
+  // Shared memories can be accessed by several threads. They always have a
+  // maximum.
+  bool is_shared;
+} wasm_limits;
+typedef wasm_vec_of(wasm_limits) wasm_limits_vec;
+
+enum wasm_import_type {
+  wasm_import_func,
+  wasm_import_table,
+  wasm_import_mem,
+  wasm_import_global
+};
+
+// Names of imports and exports are offsets into `wasm_module.names`, see
+// `wasm_module_name`.
+typedef struct {
+  uint32_t module_name;
+  uint32_t name;
+  enum wasm_import_type type;
+  union {
+    wasm_typeidx func;
+    wasm_limits table;
+    wasm_limits mem;
+    struct {
+      enum wasm_valtype type;
+      bool is_mutable;
+    } global;
+  } desc;
+} wasm_import;
+typedef wasm_vec_of(wasm_import) wasm_import_vec;
 
 enum wasm_export_type {
   wasm_export_func,
@@ -40,25 +91,54 @@ enum wasm_export_type {
 };
 
 typedef struct {
-  char *name;
+  uint32_t name;
   enum wasm_export_type type;
   uint32_t idx;
 } wasm_export;
+typedef wasm_vec_of(wasm_export) wasm_export_vec;
 
 typedef struct {
   uint32_t n;
   enum wasm_valtype type;
 } wasm_locals;
+typedef wasm_vec_of(wasm_locals) wasm_locals_vec;
 
+struct wasm_compiled_func;
+
+// A function body. The instructions of all bodies are packed into
+// `wasm_module.code_bytes` and their locals into `wasm_module.locals`.
 typedef struct {
-  // Storing `wasm_locals`.
-  wasm_vec locals;
-  wasm_expr expr;
+  // Without the final 0x0B.
+  uint32_t expr_offset;
+  uint32_t expr_size;
+  uint32_t locals_offset;
+  uint32_t locals_count;
+  // Decoded form of the body which is created when the module gets
+  // instantiated.
+  struct wasm_compiled_func *compiled;
 } wasm_code;
+typedef wasm_vec_of(wasm_code) wasm_code_vec;
+
+// Initializer of a linear memory. Passive segments are only copied by
+// `memory.init` and have no offset.
+typedef struct {
+  bool is_passive;
+  uint32_t memidx;
+  wasm_expr offset;
+  wasm_byte_vec init;
+} wasm_data;
+typedef wasm_vec_of(wasm_data) wasm_data_vec;
+
+// Initializer of a table.
+typedef struct {
+  uint32_t tableidx;
+  wasm_expr offset;
+  // Function indices.
+  wasm_u32_vec init;
+} wasm_elem;
+typedef wasm_vec_of(wasm_elem) wasm_elem_vec;
 
-// void wasm_init_function_type_params(wasm_function_type *type, size_t
-// param_count);
-void wasm_release_function_type(wasm_function_type *type);
+bool wasm_function_type_equal(wasm_function_type *a, wasm_function_type *b);
 
 // The header of a wasm module.
 typedef struct {
@@ -69,22 +149,150 @@ typedef struct {
 // All data contained in a wasm module.
 typedef struct {
   wasm_module_header header;
-  // Storing `wasm_function_type`.
-  wasm_vec function_types;
-  // Storing `wasm_typeidx`.
-  wasm_vec funcs;
-  // Storing `wasm_global`.
-  wasm_vec globals;
-  // Storing `wasm_export`.
-  wasm_vec exports;
-  // Storing `wasm_code`.
-  wasm_vec codes;
+  wasm_function_type_vec function_types;
+  // Canonical id of every function type. Structurally equal types have the
+  // same id so comparing signatures is one compare.
+  wasm_u32_vec type_ids;
+  wasm_import_vec imports;
+  // Type index of every function.
+  wasm_u32_vec funcs;
+  // All tables store funcrefs in the MVP.
+  wasm_limits_vec tables;
+  wasm_limits_vec mems;
+  wasm_global_vec globals;
+  wasm_export_vec exports;
+  wasm_elem_vec elems;
+  wasm_code_vec codes;
+  wasm_data_vec datas;
+
+  // Storage shared by all entries of a kind so a module is a few large
+  // allocations instead of several per function: the parameter types of all
+  // function types, the NUL terminated import and export names, and the
+  // instructions and locals of all function bodies.
+  wasm_byte_vec valtypes;
+  wasm_byte_vec names;
+  wasm_byte_vec code_bytes;
+  wasm_locals_vec locals;
+  // Set if the parameter types and names are kept in a table that is shared
+  // with other modules instead. `valtypes` and `names` are empty then, names
+  // are offsets into the table and the canonical type ids are the offsets of
+  // the interned types, so they can be compared across modules.
+  wasm_intern_table *interned;
+
+  // Imported functions and globals come first in their index spaces.
+  uint32_t import_func_count;
+  uint32_t import_table_count;
+  uint32_t import_mem_count;
+  uint32_t import_global_count;
+
+  // Number of `call_indirect` instructions in all compiled functions. Each of
+  // them has its own inline cache in an instance.
+  uint32_t indirect_call_count;
+
+  bool has_start;
+  uint32_t start;
+
+  // The data count section is required by `memory.init` and `data.drop`.
+  bool has_data_count;
+  uint32_t data_count;
 } wasm_module;
 
 // A wasm program is called a "module". It contains sections similar to how an
 // elf/PE executable.
 wasm_module *wasm_load_module(wasm_reader *reader);
 wasm_module *wasm_load_module_from_file(const char *file_name);
+// Same as `wasm_load_module` but stores the parameter types and names in
+// `table`, which has to outlive the module. Several threads can load modules
+// into the same table.
+wasm_module *wasm_load_module_interned(wasm_reader *reader,
+                                       wasm_intern_table *table);
 void wasm_free_module(wasm_module *module);
 
-void wasm_print_module(wasm_module *module);
\ No newline at end of file
+// Makes module loads on the calling thread fail once they allocated more than
+// `max_bytes`, so untrusted modules can't exhaust the heap. 0 removes the
+// limit. Does nothing in builds without allocation accounting.
+void wasm_set_module_memory_limit(size_t max_bytes);
+
+// Section ids go up to the data count section.
+#define wasm_section_count 13
+
+// Where the time of a module load went. Indexed by section id, custom
+// sections are counted at 0.
+typedef struct {
+  uint64_t total_ns;
+  uint64_t section_ns[wasm_section_count];
+  uint64_t section_bytes[wasm_section_count];
+} wasm_load_stats;
+
+// Same as `wasm_load_module` but measures every section.
+wasm_module *wasm_load_module_with_stats(wasm_reader *reader,
+                                         wasm_load_stats *stats);
+
+// Returns e.g. "type" or "code". Returns "unknown" for invalid ids.
+const char *wasm_section_name(unsigned char id);
+
+// Location of one section in a module binary.
+typedef struct {
+  unsigned char id;
+  // The payload starts `offset` bytes after the start of the binary. The
+  // payload of a custom section starts after its name.
+  size_t offset;
+  uint32_t length;
+  // Name of a custom section, NULL for other sections.
+  char *name;
+} wasm_section_entry;
+typedef wasm_vec_of(wasm_section_entry) wasm_section_entry_vec;
+
+// Index of the sections of a module in memory. Building it only follows the
+// length prefixes of the sections, their payloads are decoded on demand.
+typedef struct {
+  const unsigned char *data;
+  size_t size;
+  // In the order of the binary.
+  wasm_section_entry_vec sections;
+} wasm_section_directory;
+
+// `data` has to outlive the directory. The directory has to be deinitialized
+// even if reading it fails.
+bool wasm_read_section_directory(wasm_section_directory *directory,
+                                 const void *data, size_t size);
+void wasm_deinit_section_directory(wasm_section_directory *directory);
+
+// Returns the first section with `id` or NULL. Custom sections (id 0) are
+// looked up by `name`.
+const wasm_section_entry *
+wasm_section_directory_find(const wasm_section_directory *directory,
+                            unsigned char id, const char *name);
+
+// Selects a section for `wasm_decode_sections`.
+#define wasm_section_bit(id) (1u << (id))
+
+// Decodes only the sections in `mask` into a module where everything else is
+// empty, e.g. `wasm_section_bit(7)` for the exports. Sections that refer to
+// the types, functions or other index spaces decode those as well. Such a
+// module can be inspected but not instantiated.
+wasm_module *wasm_decode_sections(const wasm_section_directory *directory,
+                                  uint32_t mask);
+
+// Returns the type index of a function in the function index space which
+// includes the imported functions. `funcidx` must be valid.
+wasm_typeidx wasm_module_func_typeidx(wasm_module *module, uint32_t funcidx);
+
+// Returns the type of a function in the function index space. Returns NULL if
+// `funcidx` is out of range.
+wasm_function_type *wasm_module_func_type(wasm_module *module,
+                                          uint32_t funcidx);
+
+// Returns the canonical id of the type `typeidx`.
+uint32_t wasm_module_type_id(wasm_module *module, wasm_typeidx typeidx);
+
+// Returns a name of an import or export.
+const char *wasm_module_name(const wasm_module *module, uint32_t name);
+
+// Returns the instructions of a function body.
+const unsigned char *wasm_code_expr(const wasm_module *module,
+                                    const wasm_code *code);
+
+// Looks up an export by name and type. Returns NULL if there is none.
+wasm_export *wasm_module_find_export(wasm_module *module, const char *name,
+                                     enum wasm_export_type type);
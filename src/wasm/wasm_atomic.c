@@ -0,0 +1,196 @@
+#include "wasm/wasm_atomic.h"
+
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_exec.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+wasm_shared_memory *wasm_create_shared_memory(uint32_t min, uint32_t max) {
+  if (min > max || max > 65536) {
+    fprintf(stderr, "Invalid shared memory limits.\n");
+    return NULL;
+  }
+
+  size_t reserved = (max > 0 ? (size_t)max : 1) * wasm_page_size;
+  void *data = wasm_reserve_n(reserved);
+  if (data == NULL) {
+    fprintf(stderr, "Failed to reserve shared memory.\n");
+    return NULL;
+  }
+
+  wasm_shared_memory *memory = wasm_alloc(wasm_shared_memory);
+  memory->data = data;
+  atomic_init(&memory->size, (size_t)min * wasm_page_size);
+  memory->max_pages = max;
+  atomic_init(&memory->refs, 1);
+  return memory;
+}
+
+void wasm_retain_shared_memory(wasm_shared_memory *memory) {
+  atomic_fetch_add(&memory->refs, 1);
+}
+
+void wasm_release_shared_memory(wasm_shared_memory *memory) {
+  if (memory == NULL || atomic_fetch_sub(&memory->refs, 1) != 1) {
+    return;
+  }
+
+  size_t max_pages = memory->max_pages;
+  wasm_free_reserved(memory->data,
+                     (max_pages > 0 ? max_pages : 1) * wasm_page_size);
+  wasm_free(memory);
+}
+
+int32_t wasm_shared_memory_grow(wasm_shared_memory *memory, uint32_t delta) {
+  size_t size = atomic_load(&memory->size);
+  size_t new_size;
+  do {
+    uint32_t pages = (uint32_t)(size / wasm_page_size);
+    if (delta > memory->max_pages - pages) {
+      return -1;
+    }
+    new_size = size + (size_t)delta * wasm_page_size;
+  } while (!atomic_compare_exchange_weak(&memory->size, &size, new_size));
+
+  return (int32_t)(size / wasm_page_size);
+}
+
+// Threads that wait on an address are parked in a queue that is picked by
+// hashing the address. Each waiter sleeps on its own futex word so that
+// `notify` wakes exactly the threads it counts.
+typedef struct wasm_waiter {
+  unsigned char *address;
+  // Set to 1 by the notifying thread.
+  _Atomic uint32_t woken;
+  struct wasm_waiter *next;
+} wasm_waiter;
+
+typedef struct {
+  pthread_mutex_t lock;
+  wasm_waiter *head;
+} wasm_wait_queue;
+
+#define wasm_wait_queue_count 64
+
+static wasm_wait_queue wasm_wait_queues[wasm_wait_queue_count] = {
+    [0 ... wasm_wait_queue_count - 1] = {PTHREAD_MUTEX_INITIALIZER, NULL}};
+
+static wasm_wait_queue *wasm_wait_queue_of(unsigned char *address) {
+  return &wasm_wait_queues[((uintptr_t)address >> 2) % wasm_wait_queue_count];
+}
+
+// Sleeps while `*word` is 0. Can return early, callers check the word again.
+static void wasm_futex_wait(_Atomic uint32_t *word, uint64_t timeout) {
+#ifdef __linux__
+  struct timespec ts = {(time_t)(timeout / 1000000000u),
+                        (long)(timeout % 1000000000u)};
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, 0,
+          timeout == UINT64_MAX ? NULL : &ts, NULL, 0);
+#else
+  (void)word;
+  (void)timeout;
+  sched_yield();
+#endif
+}
+
+static void wasm_futex_wake(_Atomic uint32_t *word) {
+#ifdef __linux__
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+  (void)word;
+#endif
+}
+
+static enum wasm_wait_result wasm_atomic_wait(unsigned char *address,
+                                              uint64_t expected, bool is_64,
+                                              int64_t timeout) {
+  wasm_wait_queue *queue = wasm_wait_queue_of(address);
+
+  // The value is compared while the queue is locked so a `notify` that comes
+  // after the store which changed the value can't be missed.
+  pthread_mutex_lock(&queue->lock);
+  uint64_t value = is_64 ? atomic_load((_Atomic uint64_t *)address)
+                         : atomic_load((_Atomic uint32_t *)address);
+  if (value != expected) {
+    pthread_mutex_unlock(&queue->lock);
+    return wasm_wait_not_equal;
+  }
+
+  wasm_waiter waiter = {address, 0, NULL};
+  wasm_waiter **tail = &queue->head;
+  while (*tail != NULL) {
+    tail = &(*tail)->next;
+  }
+  *tail = &waiter;
+  pthread_mutex_unlock(&queue->lock);
+
+  uint64_t deadline =
+      timeout < 0 ? UINT64_MAX : wasm_now_ns() + (uint64_t)timeout;
+  while (atomic_load(&waiter.woken) == 0) {
+    uint64_t now = wasm_now_ns();
+    if (now >= deadline) {
+      break;
+    }
+    wasm_futex_wait(&waiter.woken,
+                    deadline == UINT64_MAX ? UINT64_MAX : deadline - now);
+  }
+
+  // A notify can still arrive until the waiter is removed from the queue.
+  pthread_mutex_lock(&queue->lock);
+  bool woken = atomic_load(&waiter.woken) != 0;
+  if (!woken) {
+    wasm_waiter **link = &queue->head;
+    while (*link != &waiter) {
+      link = &(*link)->next;
+    }
+    *link = waiter.next;
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return woken ? wasm_wait_ok : wasm_wait_timed_out;
+}
+
+enum wasm_wait_result wasm_atomic_wait32(unsigned char *address,
+                                         uint32_t expected, int64_t timeout) {
+  return wasm_atomic_wait(address, expected, false, timeout);
+}
+
+enum wasm_wait_result wasm_atomic_wait64(unsigned char *address,
+                                         uint64_t expected, int64_t timeout) {
+  return wasm_atomic_wait(address, expected, true, timeout);
+}
+
+uint32_t wasm_atomic_notify(unsigned char *address, uint32_t count) {
+  wasm_wait_queue *queue = wasm_wait_queue_of(address);
+  uint32_t woken = 0;
+
+  pthread_mutex_lock(&queue->lock);
+  wasm_waiter **link = &queue->head;
+  while (*link != NULL && woken < count) {
+    wasm_waiter *waiter = *link;
+    if (waiter->address != address) {
+      link = &waiter->next;
+      continue;
+    }
+
+    // The waiter can't return before the lock is released so its stack slot
+    // stays valid for the wake up.
+    *link = waiter->next;
+    atomic_store(&waiter->woken, 1);
+    wasm_futex_wake(&waiter->woken);
+    woken++;
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return woken;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A linear memory that can be used by several instances at the same time, e.g.
+// one instance of a module per host thread. The maximum size is reserved up
+// front so that the data never moves when another thread grows the memory.
+// Pages that are never touched don't take up physical memory.
+typedef struct wasm_shared_memory {
+  unsigned char *data;
+  // Current size in bytes. It only grows.
+  _Atomic size_t size;
+  uint32_t max_pages;
+  // The creator and every instance that uses the memory hold a reference.
+  atomic_uint refs;
+} wasm_shared_memory;
+
+// Creates a shared memory of `min` pages that can grow up to `max` pages.
+// Returns NULL if the memory can't be reserved.
+wasm_shared_memory *wasm_create_shared_memory(uint32_t min, uint32_t max);
+void wasm_retain_shared_memory(wasm_shared_memory *memory);
+// Frees the memory when the last reference is released.
+void wasm_release_shared_memory(wasm_shared_memory *memory);
+
+// Grows the memory by `delta` pages. Returns the old number of pages or -1 if
+// the maximum would be exceeded. Safe to call from several threads.
+int32_t wasm_shared_memory_grow(wasm_shared_memory *memory, uint32_t delta);
+
+// Results of `memory.atomic.wait32` and `memory.atomic.wait64`.
+enum wasm_wait_result {
+  wasm_wait_ok,
+  wasm_wait_not_equal,
+  wasm_wait_timed_out,
+};
+
+// Blocks the calling thread until `wasm_atomic_notify` is called for
+// `address`, unless the value at `address` is not `expected`. `timeout` is in
+// nanoseconds and a negative timeout waits forever. `address` must be aligned.
+enum wasm_wait_result wasm_atomic_wait32(unsigned char *address,
+                                         uint32_t expected, int64_t timeout);
+enum wasm_wait_result wasm_atomic_wait64(unsigned char *address,
+                                         uint64_t expected, int64_t timeout);
+
+// Wakes up to `count` threads waiting on `address` in the order they started
+// waiting. Returns the number of woken threads.
+uint32_t wasm_atomic_notify(unsigned char *address, uint32_t count);
@@ -0,0 +1,189 @@
+#include "wasm/wasm_check.h"
+
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_reader.h"
+#include "wasm/wasm_validate.h"
+#include <string.h>
+
+// Reads a whole file. Returns NULL on failure.
+static unsigned char *wasm_read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  unsigned char *data = NULL;
+  long length;
+  if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 &&
+      fseek(file, 0, SEEK_SET) == 0) {
+    // One more byte so empty files get a buffer as well.
+    data = wasm_alloc_n((size_t)length + 1);
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+      wasm_free(data);
+      data = NULL;
+    }
+    *size = (size_t)length;
+  }
+  if (data == NULL) {
+    fprintf(stderr, "%s: Error reading file.\n", path);
+  }
+
+  fclose(file);
+  return data;
+}
+
+static void wasm_check_module(wasm_check_result *result) {
+  memset(&result->stats, 0, sizeof(result->stats));
+  result->ok = false;
+  result->bytes = 0;
+  result->parse_ns = 0;
+  result->validate_ns = 0;
+  result->func_count = 0;
+
+  unsigned char *data = wasm_read_file(result->path, &result->bytes);
+  wasm_reset_thread_allocs();
+  if (data == NULL) {
+    result->allocations = 0;
+    result->peak_bytes = 0;
+    return;
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, data, result->bytes);
+  uint64_t start = wasm_now_ns();
+  wasm_module *module = wasm_load_module_with_stats(&reader, &result->stats);
+  uint64_t parsed = wasm_now_ns();
+  result->parse_ns = parsed - start;
+
+  // Compiling the functions checks their structure and immediates, the
+  // validator the types of their operands and the rest of the module.
+  if (module) {
+    result->func_count = (uint32_t)wasm_vec_size(&module->funcs);
+    result->ok = wasm_compile_module(module) && wasm_validate_module(module);
+    result->validate_ns = wasm_now_ns() - parsed;
+  }
+
+  wasm_free_module(module);
+  wasm_thread_allocs allocs = wasm_get_thread_allocs();
+  result->allocations = allocs.count;
+  result->peak_bytes = allocs.peak_bytes;
+  wasm_free(data);
+}
+
+typedef struct {
+  const char **paths;
+  wasm_check_result *results;
+  size_t memory_limit;
+} wasm_check_batch;
+
+static void wasm_check_task(void *context, size_t index) {
+  wasm_check_batch *batch = context;
+  batch->results[index].path = batch->paths[index];
+  wasm_set_module_memory_limit(batch->memory_limit);
+  wasm_check_module(&batch->results[index]);
+  wasm_set_module_memory_limit(0);
+}
+
+void wasm_check_modules(const char **paths, size_t count,
+                        uint32_t thread_count, size_t memory_limit,
+                        wasm_check_result *results) {
+  wasm_check_batch batch = {paths, results, memory_limit};
+  wasm_parallel_for(count, thread_count, wasm_check_task, &batch);
+}
+
+typedef struct {
+  const char **paths;
+  wasm_module_set *set;
+} wasm_load_batch;
+
+static void wasm_load_task(void *context, size_t index) {
+  wasm_load_batch *batch = context;
+  size_t size;
+  unsigned char *data = wasm_read_file(batch->paths[index], &size);
+  if (data == NULL) {
+    return;
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, data, size);
+  batch->set->modules[index] =
+      wasm_load_module_interned(&reader, batch->set->table);
+  if (batch->set->modules[index] == NULL) {
+    fprintf(stderr, "%s: Error loading module.\n", batch->paths[index]);
+  }
+  wasm_free(data);
+}
+
+wasm_module_set *wasm_load_modules(const char **paths, size_t count,
+                                   uint32_t thread_count) {
+  wasm_intern_table *table = wasm_create_intern_table();
+  if (table == NULL) {
+    return NULL;
+  }
+
+  wasm_module_set *set = wasm_alloc(wasm_module_set);
+  set->table = table;
+  set->count = count;
+  set->modules = wasm_alloc_array(wasm_module *, count ? count : 1);
+  for (size_t i = 0; i < count; i++) {
+    set->modules[i] = NULL;
+  }
+
+  wasm_load_batch batch = {paths, set};
+  wasm_parallel_for(count, thread_count, wasm_load_task, &batch);
+  return set;
+}
+
+void wasm_free_module_set(wasm_module_set *set) {
+  if (set) {
+    for (size_t i = 0; i < set->count; i++) {
+      wasm_free_module(set->modules[i]);
+    }
+    wasm_free(set->modules);
+    wasm_free_intern_table(set->table);
+    wasm_free(set);
+  }
+}
+
+static void wasm_print_json_string(FILE *out, const char *str) {
+  fputc('"', out);
+  for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(out, "\\%c", *c);
+    } else if (*c < 0x20) {
+      fprintf(out, "\\u%04x", *c);
+    } else {
+      fputc(*c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+void wasm_print_check_json(FILE *out, const wasm_check_result *result) {
+  fputs("{\"file\":", out);
+  wasm_print_json_string(out, result->path);
+  fprintf(out,
+          ",\"ok\":%s,\"bytes\":%zu,\"parse_ns\":%llu,\"validate_ns\":%llu,"
+          "\"functions\":%u,\"allocations\":%zu,\"peak_bytes\":%lld,"
+          "\"sections\":{",
+          result->ok ? "true" : "false", result->bytes,
+          (unsigned long long)result->parse_ns,
+          (unsigned long long)result->validate_ns, result->func_count,
+          result->allocations, (long long)result->peak_bytes);
+
+  bool first = true;
+  for (unsigned char id = 0; id < wasm_section_count; id++) {
+    if (result->stats.section_bytes[id] == 0 &&
+        result->stats.section_ns[id] == 0) {
+      continue;
+    }
+    fprintf(out, "%s\"%s\":{\"ns\":%llu,\"bytes\":%llu}", first ? "" : ",",
+            wasm_section_name(id),
+            (unsigned long long)result->stats.section_ns[id],
+            (unsigned long long)result->stats.section_bytes[id]);
+    first = false;
+  }
+  fputs("}}\n", out);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Result of loading and validating one module file.
+typedef struct {
+  const char *path;
+  bool ok;
+  size_t bytes;
+  // Reading the file is not part of the parse time.
+  uint64_t parse_ns;
+  uint64_t validate_ns;
+  wasm_load_stats stats;
+  // Functions defined by the module.
+  uint32_t func_count;
+  // Heap usage of parsing and validating.
+  size_t allocations;
+  int64_t peak_bytes;
+} wasm_check_result;
+
+// Loads and validates the modules in `paths` on `thread_count` threads.
+// `results[i]` is the result of `paths[i]`. Loading a module fails once it
+// allocated more than `memory_limit` bytes, 0 for no limit.
+void wasm_check_modules(const char **paths, size_t count,
+                        uint32_t thread_count, size_t memory_limit,
+                        wasm_check_result *results);
+
+// Modules loaded together that share one intern table for their names and
+// function types.
+typedef struct {
+  wasm_intern_table *table;
+  size_t count;
+  // NULL where loading failed.
+  wasm_module **modules;
+} wasm_module_set;
+
+// Loads the modules in `paths` on `thread_count` threads. `modules[i]` is the
+// module of `paths[i]`. Returns NULL if the intern table can't be created.
+wasm_module_set *wasm_load_modules(const char **paths, size_t count,
+                                   uint32_t thread_count);
+// Frees the modules and their intern table. Instances of the modules have to
+// be freed before.
+void wasm_free_module_set(wasm_module_set *set);
+
+// Writes a result as a JSON object on a single line.
+void wasm_print_check_json(FILE *out, const wasm_check_result *result);
@@ -1,20 +1,254 @@
 #include "wasm_common.h"
 #include "assert.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <time.h>
 
-static _Atomic size_t wasm_alloc_count_ = 0;
+#ifdef __GLIBC__
+#include <malloc.h>
+#define wasm_usable_size(ptr) malloc_usable_size(ptr)
+#else
+#define wasm_usable_size(ptr) ((void)(ptr), (size_t)0)
+#endif
 
-size_t wasm_alloc_count() { return wasm_alloc_count_; }
-void wasm_alloc_inc() { wasm_alloc_count_++; }
-void wasm_alloc_dec() { wasm_alloc_count_--; }
+#ifndef WASM_NO_ALLOC_ACCOUNTING
+// Objects a thread allocated minus the ones it freed. Only the owning thread
+// writes its counter so it doesn't need atomic read-modify-writes, other
+// threads only read it to sum up the total. Counters are in a list that
+// `wasm_alloc_count` walks, exited threads add theirs to `wasm_retired_count`.
+typedef struct wasm_alloc_counter {
+  _Atomic int64_t objects;
+  struct wasm_alloc_counter *next;
+} wasm_alloc_counter;
+
+static pthread_mutex_t wasm_counters_lock = PTHREAD_MUTEX_INITIALIZER;
+static wasm_alloc_counter *wasm_counters = NULL;
+static int64_t wasm_retired_count = 0;
+static pthread_key_t wasm_counter_key;
+static pthread_once_t wasm_counter_key_once = PTHREAD_ONCE_INIT;
+
+static __thread wasm_alloc_counter *wasm_thread_counter = NULL;
+
+// Everything else is private to the thread.
+static __thread wasm_thread_allocs wasm_thread_allocs_;
+// Bytes at which the thread exceeds its limit, INT64_MAX without a limit.
+static __thread int64_t wasm_thread_limit = INT64_MAX;
+static __thread bool wasm_thread_limit_exceeded = false;
+
+static void wasm_retire_counter(void *arg) {
+  wasm_alloc_counter *counter = arg;
+  pthread_mutex_lock(&wasm_counters_lock);
+  wasm_alloc_counter **link = &wasm_counters;
+  while (*link != counter) {
+    link = &(*link)->next;
+  }
+  *link = counter->next;
+  wasm_retired_count += atomic_load(&counter->objects);
+  pthread_mutex_unlock(&wasm_counters_lock);
+
+  wasm_thread_counter = NULL;
+  free(counter);
+}
+
+static void wasm_create_counter_key() {
+  pthread_key_create(&wasm_counter_key, wasm_retire_counter);
+}
+
+static wasm_alloc_counter *wasm_register_counter() {
+  wasm_alloc_counter *counter = malloc(sizeof(wasm_alloc_counter));
+  if (counter == NULL) {
+    abort();
+  }
+  atomic_init(&counter->objects, 0);
+
+  pthread_once(&wasm_counter_key_once, wasm_create_counter_key);
+  pthread_setspecific(wasm_counter_key, counter);
+  pthread_mutex_lock(&wasm_counters_lock);
+  counter->next = wasm_counters;
+  wasm_counters = counter;
+  pthread_mutex_unlock(&wasm_counters_lock);
+
+  wasm_thread_counter = counter;
+  return counter;
+}
+
+static inline void wasm_count_objects(int64_t delta) {
+  wasm_alloc_counter *counter = wasm_thread_counter;
+  if (__builtin_expect(counter == NULL, 0)) {
+    counter = wasm_register_counter();
+  }
+  atomic_store_explicit(
+      &counter->objects,
+      atomic_load_explicit(&counter->objects, memory_order_relaxed) + delta,
+      memory_order_relaxed);
+}
+
+size_t wasm_alloc_count() {
+  pthread_mutex_lock(&wasm_counters_lock);
+  int64_t count = wasm_retired_count;
+  for (wasm_alloc_counter *counter = wasm_counters; counter;
+       counter = counter->next) {
+    count += atomic_load_explicit(&counter->objects, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&wasm_counters_lock);
+  return (size_t)count;
+}
+
+static inline void wasm_count_bytes(int64_t delta) {
+  wasm_thread_allocs *allocs = &wasm_thread_allocs_;
+  allocs->bytes += delta;
+  if (allocs->bytes > allocs->peak_bytes) {
+    allocs->peak_bytes = allocs->bytes;
+  }
+  if (allocs->bytes > wasm_thread_limit) {
+    wasm_thread_limit_exceeded = true;
+  }
+}
+
+static void *wasm_count_alloc(void *ptr) {
+  if (ptr) {
+    wasm_count_objects(1);
+    wasm_thread_allocs_.count++;
+    wasm_count_bytes((int64_t)wasm_usable_size(ptr));
+  }
+  return ptr;
+}
+
+void *wasm_alloc_bytes(size_t n) { return wasm_count_alloc(malloc(n)); }
+
+void *wasm_calloc_bytes(size_t n) { return wasm_count_alloc(calloc(1, n)); }
+
+void *wasm_realloc_bytes(void *ptr, size_t n) {
+  if (ptr == NULL) {
+    return wasm_alloc_bytes(n);
+  }
+
+  size_t old_size = wasm_usable_size(ptr);
+  void *new_ptr = realloc(ptr, n);
+  if (new_ptr) {
+    wasm_count_bytes((int64_t)wasm_usable_size(new_ptr) - (int64_t)old_size);
+  }
+  return new_ptr;
+}
 
 void wasm_free(void *obj) {
   if (obj) {
-    wasm_alloc_dec();
+    wasm_count_objects(-1);
+    wasm_count_bytes(-(int64_t)wasm_usable_size(obj));
     free(obj);
   }
 }
 
+void wasm_reset_thread_allocs() {
+  wasm_thread_allocs_ = (wasm_thread_allocs){0, 0, 0};
+  wasm_thread_limit = INT64_MAX;
+  wasm_thread_limit_exceeded = false;
+}
+
+wasm_thread_allocs wasm_get_thread_allocs() { return wasm_thread_allocs_; }
+
+void wasm_set_alloc_limit(size_t max_bytes) {
+  wasm_thread_limit_exceeded = false;
+  if (max_bytes == 0 || max_bytes > (size_t)INT64_MAX) {
+    wasm_thread_limit = INT64_MAX;
+    return;
+  }
+
+  int64_t bytes = wasm_thread_allocs_.bytes;
+  wasm_thread_limit = bytes > INT64_MAX - (int64_t)max_bytes
+                          ? INT64_MAX
+                          : bytes + (int64_t)max_bytes;
+}
+
+bool wasm_alloc_limit_exceeded() { return wasm_thread_limit_exceeded; }
+
+bool wasm_alloc_limit_allows(size_t bytes) {
+  if (wasm_thread_limit == INT64_MAX) {
+    return true;
+  }
+  // The bytes of a thread can be negative if it frees what others allocated.
+  int64_t held = wasm_thread_allocs_.bytes;
+  return !wasm_thread_limit_exceeded && held <= wasm_thread_limit &&
+         bytes <= (uint64_t)wasm_thread_limit - (uint64_t)held;
+}
+#else
+size_t wasm_alloc_count() { return 0; }
+
+#define wasm_count_objects(delta) ((void)(delta))
+#endif
+
+void *wasm_reserve_n(size_t n) {
+  void *ptr = mmap(NULL, n, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ptr == MAP_FAILED) {
+    return NULL;
+  }
+  wasm_count_objects(1);
+  return ptr;
+}
+
+void wasm_free_reserved(void *ptr, size_t n) {
+  if (ptr) {
+    wasm_count_objects(-1);
+    munmap(ptr, n);
+  }
+}
+
 bool wasm_is_little_endian() {
   unsigned int is_little_endian = 1;
   return ((int8_t *)&is_little_endian)[0];
-}
\ No newline at end of file
+}
+
+uint64_t wasm_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+  void (*task)(void *context, size_t index);
+  void *context;
+  size_t count;
+  atomic_size_t next;
+} wasm_parallel_batch;
+
+// Workers take the next index until there are none left, so a few large
+// tasks don't hold up the rest.
+static void *wasm_parallel_worker(void *arg) {
+  wasm_parallel_batch *batch = arg;
+  for (;;) {
+    size_t i = atomic_fetch_add(&batch->next, 1);
+    if (i >= batch->count) {
+      return NULL;
+    }
+    batch->task(batch->context, i);
+  }
+}
+
+void wasm_parallel_for(size_t count, uint32_t thread_count,
+                       void (*task)(void *context, size_t index),
+                       void *context) {
+  wasm_parallel_batch batch = {task, context, count, 0};
+  if (thread_count > count) {
+    thread_count = (uint32_t)count;
+  }
+
+  // The calling thread is one of the workers.
+  pthread_t *threads = NULL;
+  uint32_t started = 0;
+  if (thread_count > 1) {
+    threads = wasm_alloc_array(pthread_t, thread_count - 1);
+    for (; started < thread_count - 1; started++) {
+      if (pthread_create(&threads[started], NULL, wasm_parallel_worker,
+                         &batch)) {
+        break;
+      }
+    }
+  }
+  wasm_parallel_worker(&batch);
+  for (uint32_t i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  wasm_free(threads);
+}
@@ -5,18 +5,85 @@
 #include <stdlib.h>
 
 // We count the number of allocations and deallocations to find leaks. The tests
-// check the number of allocated objects after each test.
+// check the number of allocated objects after each test. Every thread counts
+// for itself so allocating on many threads doesn't contend on one counter, the
+// total is summed up on demand.
 size_t wasm_alloc_count();
-void wasm_alloc_inc();
-void wasm_alloc_dec();
+
+// Heap usage of the calling thread since the last reset. Bytes are what the
+// allocator hands out and are subtracted by the thread that frees them, so
+// this measures work that allocates and frees on one thread, e.g. loading a
+// module.
+typedef struct {
+  size_t count;
+  int64_t bytes;
+  int64_t peak_bytes;
+} wasm_thread_allocs;
 
 // Alloc/free functions that alloc an object or an array of object of a certain
 // type.
-#define wasm_alloc(type) (wasm_alloc_inc(), (type *)malloc(sizeof(type)))
+#define wasm_alloc(type) ((type *)wasm_alloc_bytes(sizeof(type)))
 #define wasm_alloc_array(type, size)                                           \
-  (wasm_alloc_inc(), (type *)malloc(sizeof(type) * size))
-void wasm_free(void *obj);
+  ((type *)wasm_alloc_bytes(sizeof(type) * (size)))
 
 // Alloc functions that alloc `n` bytes.
-#define wasm_alloc_n(n) (wasm_alloc_inc(), malloc(n))
-#define wasm_realloc_n(ptr, size) (realloc(ptr, size))
+#define wasm_alloc_n(n) wasm_alloc_bytes(n)
+#define wasm_calloc_n(n) wasm_calloc_bytes(n)
+#define wasm_realloc_n(ptr, size) wasm_realloc_bytes(ptr, size)
+
+#ifdef WASM_NO_ALLOC_ACCOUNTING
+// Without accounting the allocation functions are the plain libc ones and
+// nothing is counted.
+static inline void *wasm_alloc_bytes(size_t n) { return malloc(n); }
+static inline void *wasm_calloc_bytes(size_t n) { return calloc(1, n); }
+static inline void *wasm_realloc_bytes(void *ptr, size_t n) {
+  return realloc(ptr, n);
+}
+static inline void wasm_free(void *obj) { free(obj); }
+
+static inline void wasm_reset_thread_allocs() {}
+static inline wasm_thread_allocs wasm_get_thread_allocs() {
+  return (wasm_thread_allocs){0, 0, 0};
+}
+static inline void wasm_set_alloc_limit(size_t max_bytes) { (void)max_bytes; }
+static inline bool wasm_alloc_limit_exceeded() { return false; }
+static inline bool wasm_alloc_limit_allows(size_t bytes) {
+  (void)bytes;
+  return true;
+}
+#else
+void *wasm_alloc_bytes(size_t n);
+void *wasm_calloc_bytes(size_t n);
+void *wasm_realloc_bytes(void *ptr, size_t n);
+void wasm_free(void *obj);
+
+void wasm_reset_thread_allocs();
+wasm_thread_allocs wasm_get_thread_allocs();
+
+// Sets a limit of `max_bytes` more than the calling thread holds right now.
+// Allocations beyond it still succeed but mark the thread as over the limit.
+// Code that allocates on behalf of untrusted input checks
+// `wasm_alloc_limit_exceeded` regularly and gives up. 0 removes the limit.
+void wasm_set_alloc_limit(size_t max_bytes);
+bool wasm_alloc_limit_exceeded();
+// Returns false if allocating `bytes` more would exceed the limit, so large
+// allocations can be refused before they are made.
+bool wasm_alloc_limit_allows(size_t bytes);
+#endif
+
+// Reserves `n` bytes of zeroed virtual memory. Pages only take up physical
+// memory once they are touched, so large stacks and memories are cheap as long
+// as they are mostly unused. Returns NULL on failure.
+void *wasm_reserve_n(size_t n);
+void wasm_free_reserved(void *ptr, size_t n);
+
+bool wasm_is_little_endian();
+
+// Monotonic time in nanoseconds.
+uint64_t wasm_now_ns();
+
+// Runs `task` for every index below `count` on `thread_count` threads, the
+// calling thread included.
+void wasm_parallel_for(size_t count, uint32_t thread_count,
+                       void (*task)(void *context, size_t index),
+                       void *context);
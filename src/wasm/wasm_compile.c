@@ -0,0 +1,1008 @@
+#include "wasm/wasm_compile.h"
+
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_reader.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define wasm_no_patch UINT32_MAX
+
+// Static information about every opcode.
+typedef struct {
+  bool valid;
+  enum wasm_immediate imm;
+  int8_t pops;
+  int8_t pushes;
+} wasm_opcode_info;
+
+static const wasm_opcode_info wasm_opcode_infos[0x500] = {
+#define WASM_OPCODE_INFO(code, ident, text, imm, pops, pushes)                 \
+  [code] = {true, wasm_imm_##imm, pops, pushes},
+    WASM_OPCODES(WASM_OPCODE_INFO)
+#undef WASM_OPCODE_INFO
+};
+
+// An entry of the control stack. Every block, loop and if creates one.
+typedef struct {
+  uint16_t op;
+  // Height of the operand stack when the block was entered.
+  uint32_t height;
+  // Number of results.
+  uint32_t arity;
+  // First instruction of a loop.
+  uint32_t start;
+  // Linked list of forward branches that need to be patched with the end of
+  // the block. The `a` field of each branch points to the next one.
+  uint32_t patch;
+  // The `if` instruction which jumps to the else branch or the end.
+  uint32_t if_instr;
+  // The rest of the block can't be reached, e.g. after a `br`.
+  bool unreachable;
+} wasm_control;
+
+// An operand whose `local.get` or `i32.const` was not emitted yet because the
+// instruction that consumes it may read the local or the constant directly.
+typedef struct {
+  bool is_const;
+  // Local index or constant.
+  uint32_t value;
+} wasm_operand;
+
+typedef struct {
+  wasm_module *module;
+  wasm_compiled_func *func;
+  wasm_reader reader;
+  wasm_vec_of(wasm_control) controls;
+  uint32_t height;
+  uint32_t global_count;
+  bool has_memory;
+  bool has_table;
+  // Deferred operands. They are always the top entries of the operand stack,
+  // everything below them is stored in its stack slot.
+  wasm_vec_of(wasm_operand) deferred;
+  // Register instruction that stored the top of the stack if it was the last
+  // one emitted. A following `local.set` stores into the local instead.
+  uint32_t last_result;
+} wasm_compiler;
+
+static bool wasm_register_ir = true;
+
+void wasm_set_register_ir(bool enabled) { wasm_register_ir = enabled; }
+
+static wasm_instr *wasm_emit(wasm_compiler *c, uint16_t op) {
+  wasm_instr *instr = wasm_vec_append(&c->func->instrs);
+  instr->op = op;
+  instr->a = 0;
+  instr->b.i64 = 0;
+  return instr;
+}
+
+static uint32_t wasm_next_instr(wasm_compiler *c) {
+  return (uint32_t)wasm_vec_size(&c->func->instrs);
+}
+
+static wasm_instr *wasm_instr_at(wasm_compiler *c, uint32_t index) {
+  return wasm_vec_get(&c->func->instrs, index);
+}
+
+static wasm_control *wasm_top_control(wasm_compiler *c) {
+  return c->controls.end - 1;
+}
+
+static bool wasm_pop(wasm_compiler *c, uint32_t n) {
+  wasm_control *control = wasm_top_control(c);
+
+  if (c->height - control->height < n) {
+    // The stack is polymorphic in unreachable code.
+    if (control->unreachable) {
+      c->height = control->height;
+      return true;
+    }
+    fprintf(stderr, "Operand stack underflow.\n");
+    return false;
+  }
+
+  c->height -= n;
+  return true;
+}
+
+static void wasm_push(wasm_compiler *c, uint32_t n) {
+  c->height += n;
+  if (c->height > c->func->max_height) {
+    c->func->max_height = c->height;
+  }
+}
+
+static void wasm_set_unreachable(wasm_compiler *c) {
+  wasm_control *control = wasm_top_control(c);
+  control->unreachable = true;
+  c->height = control->height;
+}
+
+static bool wasm_read_block_type(wasm_compiler *c, uint32_t *arity) {
+  unsigned char type;
+  if (!wasm_read(&c->reader, &type, 1)) {
+    return false;
+  }
+
+  switch (type) {
+  case 0x40:
+    return *arity = 0, true;
+  case 0x7F:
+  case 0x7E:
+  case 0x7D:
+  case 0x7C:
+  case 0x7B:
+    return *arity = 1, true;
+  default:
+    fprintf(stderr, "Block type 0x%02X is not supported.\n", type);
+    return false;
+  }
+}
+
+static void wasm_push_control(wasm_compiler *c, uint16_t op, uint32_t arity) {
+  wasm_control *control = wasm_vec_append(&c->controls);
+  control->op = op;
+  control->height = c->height;
+  control->arity = arity;
+  control->start = wasm_next_instr(c);
+  control->patch = wasm_no_patch;
+  control->if_instr = wasm_no_patch;
+  control->unreachable = false;
+}
+
+// Fills in the target of a branch to the label `depth`. Branches to the
+// function's label jump to the final `return`.
+static bool wasm_emit_branch(wasm_compiler *c, uint16_t op, uint32_t depth) {
+  size_t control_count = wasm_vec_size(&c->controls);
+  if (depth >= control_count) {
+    fprintf(stderr, "Invalid branch depth %u.\n", depth);
+    return false;
+  }
+
+  wasm_control *control = wasm_top_control(c) - depth;
+  wasm_instr *instr = wasm_emit(c, op);
+  uint32_t index = wasm_next_instr(c) - 1;
+
+  // Loops branch to their start which has no results in the MVP.
+  instr->b.br.arity = control->op == wasm_op_loop ? 0 : control->arity;
+  instr->b.br.height = c->func->local_count + control->height;
+
+  if (c->height < instr->b.br.arity && !wasm_top_control(c)->unreachable) {
+    fprintf(stderr, "Operand stack underflow.\n");
+    return false;
+  }
+
+  if (control->op == wasm_op_loop) {
+    instr->op = op == wasm_op_br ? wasm_op_br_loop : wasm_op_br_if_loop;
+    instr->a = control->start;
+  } else {
+    instr->a = control->patch;
+    control->patch = index;
+  }
+
+  return true;
+}
+
+// Ends the block on top of the control stack.
+static bool wasm_end_block(wasm_compiler *c) {
+  wasm_control *control = wasm_top_control(c);
+  uint32_t end = wasm_next_instr(c);
+
+  if (!control->unreachable && c->height != control->height + control->arity) {
+    fprintf(stderr, "Block leaves %u values on the stack instead of %u.\n",
+            c->height - control->height, control->arity);
+    return false;
+  }
+
+  if (control->if_instr != wasm_no_patch) {
+    if (control->arity != 0) {
+      fprintf(stderr, "If with a result needs an else branch.\n");
+      return false;
+    }
+    wasm_instr_at(c, control->if_instr)->a = end;
+  }
+
+  for (uint32_t i = control->patch; i != wasm_no_patch;) {
+    wasm_instr *instr = wasm_instr_at(c, i);
+    i = instr->a;
+    instr->a = end;
+  }
+
+  c->height = control->height + control->arity;
+  c->controls.end--;
+  return true;
+}
+
+// Data indices can only be used if the module has a data count section.
+static bool wasm_read_data_index(wasm_compiler *c, uint32_t *dataidx) {
+  return wasm_read_leb_u32_2(&c->reader, dataidx) &&
+         c->module->has_data_count && *dataidx < c->module->data_count;
+}
+
+// Number of lanes of the vector accessed by a lane instruction.
+static uint32_t wasm_lane_count(uint16_t op) {
+  switch (op) {
+  case wasm_op_i8x16_extract_lane_s:
+  case wasm_op_i8x16_extract_lane_u:
+  case wasm_op_i8x16_replace_lane:
+  case wasm_op_v128_load8_lane:
+  case wasm_op_v128_store8_lane:
+    return 16;
+  case wasm_op_i16x8_extract_lane_s:
+  case wasm_op_i16x8_extract_lane_u:
+  case wasm_op_i16x8_replace_lane:
+  case wasm_op_v128_load16_lane:
+  case wasm_op_v128_store16_lane:
+    return 8;
+  case wasm_op_i32x4_extract_lane:
+  case wasm_op_i32x4_replace_lane:
+  case wasm_op_f32x4_extract_lane:
+  case wasm_op_f32x4_replace_lane:
+  case wasm_op_v128_load32_lane:
+  case wasm_op_v128_store32_lane:
+    return 4;
+  default:
+    return 2;
+  }
+}
+
+// Reads a lane index into `b.i32`.
+static bool wasm_read_lane(wasm_compiler *c, uint16_t op, wasm_instr *instr) {
+  unsigned char lane;
+  if (!wasm_read(&c->reader, &lane, 1) || lane >= wasm_lane_count(op)) {
+    return false;
+  }
+  instr->b.i32 = lane;
+  return true;
+}
+
+// Reads 16 bytes. The low half is stored in `instr` and the high half in a
+// following data instruction.
+static bool wasm_read_v128(wasm_compiler *c, wasm_instr *instr) {
+  unsigned char bytes[16];
+  if (!wasm_read(&c->reader, bytes, 16)) {
+    return false;
+  }
+  memcpy(&instr->b.i64, bytes, 8);
+  memcpy(&wasm_emit(c, wasm_op_data)->b.i64, bytes + 8, 8);
+  return true;
+}
+
+uint32_t wasm_natural_align(uint16_t op) {
+  // From i32.load to i64.store32.
+  static const uint8_t mvp[] = {2, 3, 2, 3, 0, 0, 1, 1, 0, 0, 1, 1,
+                                2, 2, 2, 3, 2, 3, 0, 1, 0, 1, 2};
+  // The atomic loads, stores and read-modify-write instructions come in
+  // groups of the same 7 access sizes.
+  static const uint8_t atomics[7] = {2, 3, 0, 1, 0, 1, 2};
+
+  if (op >= wasm_op_i32_load && op <= wasm_op_i64_store32) {
+    return mvp[op - wasm_op_i32_load];
+  }
+  switch (op) {
+  case wasm_op_v128_load:
+  case wasm_op_v128_store:
+    return 4;
+  case wasm_op_v128_load8x8_s:
+  case wasm_op_v128_load8x8_u:
+  case wasm_op_v128_load16x4_s:
+  case wasm_op_v128_load16x4_u:
+  case wasm_op_v128_load32x2_s:
+  case wasm_op_v128_load32x2_u:
+  case wasm_op_v128_load64_splat:
+  case wasm_op_v128_load64_zero:
+  case wasm_op_memory_atomic_wait64:
+    return 3;
+  case wasm_op_v128_load8_splat:
+    return 0;
+  case wasm_op_v128_load16_splat:
+    return 1;
+  case wasm_op_v128_load32_splat:
+  case wasm_op_v128_load32_zero:
+  case wasm_op_memory_atomic_notify:
+  case wasm_op_memory_atomic_wait32:
+    return 2;
+  default:
+    break;
+  }
+  if (op >= wasm_op_v128_load8_lane && op <= wasm_op_v128_store64_lane) {
+    return (op - wasm_op_v128_load8_lane) % 4;
+  }
+  if (op >= wasm_op_i32_atomic_load) {
+    return atomics[(op - wasm_op_i32_atomic_load) % 7];
+  }
+  return 0;
+}
+
+// Frame slot of the operand stack entry at `height`.
+static uint32_t wasm_stack_slot(wasm_compiler *c, uint32_t height) {
+  return c->func->local_count + height;
+}
+
+// Operand stack height without the deferred operands. The interpreter's stack
+// pointer is at this height after a register instruction.
+static uint16_t wasm_stored_height(wasm_compiler *c) {
+  return (uint16_t)wasm_stack_slot(
+      c, c->height - (uint32_t)wasm_vec_size(&c->deferred));
+}
+
+// Emits the deferred operands except for the top `keep` ones so they end up
+// in their stack slots.
+static void wasm_materialize(wasm_compiler *c, size_t keep) {
+  size_t count = wasm_vec_size(&c->deferred);
+  if (count <= keep) {
+    return;
+  }
+
+  size_t n = count - keep;
+  for (size_t i = 0; i < n; i++) {
+    wasm_operand operand = c->deferred.start[i];
+    if (operand.is_const) {
+      wasm_emit(c, wasm_op_i32_const)->b.i32 = (int32_t)operand.value;
+    } else {
+      wasm_emit(c, wasm_op_local_get)->a = operand.value;
+    }
+  }
+  memmove(c->deferred.start, c->deferred.start + n,
+          keep * sizeof(wasm_operand));
+  c->deferred.end -= n;
+}
+
+// Register forms address slots with 16 bits. Frames that get larger and
+// unreachable code, where the stack height is unknown, keep the stack form.
+static bool wasm_use_registers(wasm_compiler *c) {
+  return wasm_register_ir && !wasm_top_control(c)->unreachable &&
+         wasm_stack_slot(c, c->height) < UINT16_MAX;
+}
+
+static bool wasm_has_register_form(uint16_t op) {
+  switch (op) {
+  case wasm_op_local_get:
+  case wasm_op_local_set:
+  case wasm_op_local_tee:
+  case wasm_op_i32_const:
+  case wasm_op_drop:
+  case wasm_op_i32_eqz:
+#define WASM_REG_CASE(name, result, commutes, expr) case wasm_op_##name:
+    WASM_REG_I32_BINOPS(WASM_REG_CASE)
+    WASM_REG_I64_BINOPS(WASM_REG_CASE)
+#undef WASM_REG_CASE
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Evaluates an i32 operator with constant operands.
+static bool wasm_fold_i32(uint16_t op, int32_t x, int32_t y, int32_t *out) {
+  switch (op) {
+  case wasm_op_i32_eqz:
+    return *out = x == 0, true;
+#define WASM_FOLD_CASE(name, result, commutes, expr)                           \
+  case wasm_op_##name:                                                         \
+    return *out = (expr), true;
+    WASM_REG_I32_BINOPS(WASM_FOLD_CASE)
+#undef WASM_FOLD_CASE
+  default:
+    return false;
+  }
+}
+
+// Returns the register form of an operator and whether it has an `_imm` form
+// and commutes.
+static uint16_t wasm_register_op(uint16_t op, bool *has_imm, bool *commutes) {
+  *has_imm = false;
+  *commutes = false;
+  switch (op) {
+  case wasm_op_i32_eqz:
+    return wasm_op_reg_i32_eqz;
+#define WASM_REG_I32_CASE(name, result, is_commutative, expr)                  \
+  case wasm_op_##name:                                                         \
+    *has_imm = true;                                                           \
+    *commutes = is_commutative;                                                \
+    return wasm_op_reg_##name;
+    WASM_REG_I32_BINOPS(WASM_REG_I32_CASE)
+#undef WASM_REG_I32_CASE
+#define WASM_REG_I64_CASE(name, result, is_commutative, expr)                  \
+  case wasm_op_##name:                                                         \
+    *commutes = is_commutative;                                                \
+    return wasm_op_reg_##name;
+    WASM_REG_I64_BINOPS(WASM_REG_I64_CASE)
+#undef WASM_REG_I64_CASE
+  default:
+    assert(false);
+    return op;
+  }
+}
+
+// Compiles an operator with one or two operands to its register form. Deferred
+// operands are read from their locals, constants are folded or become the
+// immediate. The result is stored in the stack slot of the first operand.
+static bool wasm_compile_register_op(wasm_compiler *c, uint16_t op) {
+  uint32_t n = op == wasm_op_i32_eqz ? 1 : 2;
+  if (!wasm_pop(c, n)) {
+    return false;
+  }
+  uint32_t height = c->height;
+
+  // Only the operands may stay deferred.
+  wasm_materialize(c, n);
+  size_t deferred = wasm_vec_size(&c->deferred);
+  wasm_operand operands[2];
+  bool is_deferred[2];
+  for (uint32_t i = 0; i < n; i++) {
+    is_deferred[i] = i + deferred >= n;
+    if (is_deferred[i]) {
+      operands[i] = c->deferred.start[i + deferred - n];
+    }
+  }
+
+  bool has_imm, commutes;
+  uint16_t reg_op = wasm_register_op(op, &has_imm, &commutes);
+  bool x_const = is_deferred[0] && operands[0].is_const;
+  bool y_const = n == 2 && is_deferred[1] && operands[1].is_const;
+
+  int32_t folded;
+  if (x_const && (n == 1 || y_const) &&
+      wasm_fold_i32(op, (int32_t)operands[0].value,
+                    n == 2 ? (int32_t)operands[1].value : 0, &folded)) {
+    c->deferred.end -= deferred;
+    *wasm_vec_append(&c->deferred) = (wasm_operand){true, (uint32_t)folded};
+    wasm_push(c, 1);
+    return true;
+  }
+
+  if (x_const && n == 2 && !y_const && commutes) {
+    wasm_operand operand = operands[0];
+    operands[0] = operands[1];
+    operands[1] = operand;
+    x_const = false;
+    y_const = true;
+  }
+  // Constants that can't be an immediate are stored in their stack slot.
+  if (x_const || (y_const && !has_imm)) {
+    bool keep_y = n == 2 && is_deferred[1] && (!y_const || has_imm);
+    wasm_materialize(c, keep_y ? 1 : 0);
+    deferred = wasm_vec_size(&c->deferred);
+    for (uint32_t i = 0; i + deferred < n; i++) {
+      is_deferred[i] = false;
+    }
+    y_const = y_const && has_imm;
+  }
+
+  wasm_instr *instr = wasm_emit(c, y_const ? reg_op + 1 : reg_op);
+  uint32_t slots[2];
+  for (uint32_t i = 0; i < n; i++) {
+    slots[i] =
+        is_deferred[i] ? operands[i].value : wasm_stack_slot(c, height + i);
+  }
+  instr->b.reg.dst = (uint16_t)wasm_stack_slot(c, height);
+  instr->b.reg.x = (uint16_t)slots[0];
+  if (y_const) {
+    instr->a = operands[1].value;
+  } else if (n == 2) {
+    instr->b.reg.y = (uint16_t)slots[1];
+  }
+
+  c->deferred.end = c->deferred.start;
+  wasm_push(c, 1);
+  instr->b.reg.sp = wasm_stored_height(c);
+  c->last_result = wasm_next_instr(c) - 1;
+  return true;
+}
+
+// `local.set` and `local.tee`. Deferred values are copied into the local and
+// results of register instructions are stored into it directly.
+static bool wasm_compile_register_set(wasm_compiler *c, uint16_t op,
+                                      uint32_t localidx, uint32_t last_result) {
+  bool is_tee = op == wasm_op_local_tee;
+  if (!wasm_pop(c, 1)) {
+    return false;
+  }
+  if (is_tee) {
+    wasm_push(c, 1);
+  }
+
+  if (wasm_vec_size(&c->deferred) > 0) {
+    wasm_operand operand = c->deferred.end[-1];
+    // Deferred reads of the local have to happen before it is written.
+    for (wasm_operand *other = c->deferred.start; other != c->deferred.end - 1;
+         other++) {
+      if (!other->is_const && other->value == localidx) {
+        wasm_materialize(c, 1);
+        break;
+      }
+    }
+    if (!is_tee) {
+      c->deferred.end--;
+    }
+
+    if (operand.is_const || operand.value != localidx) {
+      wasm_instr *instr =
+          wasm_emit(c, operand.is_const ? wasm_op_reg_const : wasm_op_reg_copy);
+      instr->b.reg.dst = (uint16_t)localidx;
+      if (operand.is_const) {
+        instr->a = operand.value;
+      } else {
+        instr->b.reg.x = (uint16_t)operand.value;
+      }
+      instr->b.reg.sp = wasm_stored_height(c);
+    }
+  } else if (last_result != wasm_no_patch &&
+             last_result == wasm_next_instr(c) - 1) {
+    // Nothing is deferred after a register instruction so nothing else can
+    // read the local.
+    if (is_tee) {
+      *wasm_vec_append(&c->deferred) = (wasm_operand){false, localidx};
+    }
+    wasm_instr *instr = wasm_instr_at(c, last_result);
+    instr->b.reg.dst = (uint16_t)localidx;
+    instr->b.reg.sp = wasm_stored_height(c);
+  } else {
+    wasm_emit(c, op)->a = localidx;
+  }
+  return true;
+}
+
+// Compiles instructions that have a register form. `last_result` is the
+// `last_result` of the compiler before this instruction.
+static bool wasm_compile_register_instr(wasm_compiler *c, uint16_t op,
+                                        uint32_t last_result) {
+  wasm_reader *reader = &c->reader;
+
+  switch (op) {
+  case wasm_op_local_get:
+  case wasm_op_local_set:
+  case wasm_op_local_tee: {
+    uint32_t localidx;
+    if (!wasm_read_leb_u32_2(reader, &localidx) ||
+        localidx >= c->func->local_count) {
+      fprintf(stderr, "Invalid immediate of instruction 0x%X.\n", op);
+      return false;
+    }
+    if (op != wasm_op_local_get) {
+      return wasm_compile_register_set(c, op, localidx, last_result);
+    }
+    *wasm_vec_append(&c->deferred) = (wasm_operand){false, localidx};
+    wasm_push(c, 1);
+  } break;
+
+  case wasm_op_i32_const: {
+    int32_t value;
+    if (!wasm_read_leb_s32(reader, &value)) {
+      fprintf(stderr, "Invalid immediate of instruction 0x%X.\n", op);
+      return false;
+    }
+    *wasm_vec_append(&c->deferred) = (wasm_operand){true, (uint32_t)value};
+    wasm_push(c, 1);
+  } break;
+
+  // Dropped operands that were deferred are never loaded.
+  case wasm_op_drop: {
+    if (!wasm_pop(c, 1)) {
+      return false;
+    }
+    if (wasm_vec_size(&c->deferred) > 0) {
+      c->deferred.end--;
+    } else {
+      wasm_emit(c, op);
+    }
+  } break;
+
+  default:
+    return wasm_compile_register_op(c, op);
+  }
+
+  return true;
+}
+
+// A tail call returns the result of the callee from the calling function.
+static bool wasm_end_tail_call(wasm_compiler *c, wasm_function_type *callee) {
+  wasm_function_type *type = c->func->type;
+  if (callee->result_count != type->result_count ||
+      (type->result_count && callee->result_type != type->result_type)) {
+    fprintf(stderr, "Tail call to a function with another result type.\n");
+    return false;
+  }
+  wasm_set_unreachable(c);
+  return true;
+}
+
+static bool wasm_compile_instr(wasm_compiler *c, uint16_t op) {
+  const wasm_opcode_info *info = &wasm_opcode_infos[op];
+  wasm_reader *reader = &c->reader;
+
+  uint32_t last_result = c->last_result;
+  c->last_result = wasm_no_patch;
+  if (wasm_has_register_form(op) && wasm_use_registers(c)) {
+    return wasm_compile_register_instr(c, op, last_result);
+  }
+  // Everything else expects its operands on the stack.
+  wasm_materialize(c, 0);
+
+  switch (op) {
+  case wasm_op_unreachable: {
+    wasm_emit(c, op);
+    wasm_set_unreachable(c);
+  } break;
+
+  case wasm_op_nop:
+    break;
+
+  case wasm_op_block:
+  case wasm_op_loop: {
+    uint32_t arity;
+    if (!wasm_read_block_type(c, &arity)) {
+      return false;
+    }
+    wasm_push_control(c, op, arity);
+  } break;
+
+  case wasm_op_if: {
+    uint32_t arity;
+    if (!wasm_read_block_type(c, &arity) || !wasm_pop(c, 1)) {
+      return false;
+    }
+    wasm_emit(c, op);
+    wasm_push_control(c, op, arity);
+    wasm_top_control(c)->if_instr = wasm_next_instr(c) - 1;
+  } break;
+
+  case wasm_op_else: {
+    wasm_control *control = wasm_top_control(c);
+    if (control->op != wasm_op_if || control->if_instr == wasm_no_patch) {
+      fprintf(stderr, "Else without if.\n");
+      return false;
+    }
+    if (!control->unreachable &&
+        c->height != control->height + control->arity) {
+      fprintf(stderr, "If branch leaves the wrong number of values.\n");
+      return false;
+    }
+
+    // The then branch jumps over the else branch.
+    wasm_instr *jump = wasm_emit(c, wasm_op_jump);
+    jump->a = control->patch;
+    control->patch = wasm_next_instr(c) - 1;
+
+    wasm_instr_at(c, control->if_instr)->a = wasm_next_instr(c);
+    control->if_instr = wasm_no_patch;
+    control->unreachable = false;
+    c->height = control->height;
+  } break;
+
+  case wasm_op_end: {
+    // The end of the function itself is not part of `expr`.
+    if (wasm_vec_size(&c->controls) == 1) {
+      fprintf(stderr, "Unexpected end of function.\n");
+      return false;
+    }
+    return wasm_end_block(c);
+  }
+
+  case wasm_op_br:
+  case wasm_op_br_if: {
+    uint32_t depth;
+    if (!wasm_read_leb_u32_2(reader, &depth) ||
+        (op == wasm_op_br_if && !wasm_pop(c, 1)) ||
+        !wasm_emit_branch(c, op, depth)) {
+      return false;
+    }
+    if (op == wasm_op_br) {
+      wasm_set_unreachable(c);
+    }
+  } break;
+
+  case wasm_op_br_table: {
+    uint32_t count;
+    if (!wasm_read_leb_u32_2(reader, &count) || !wasm_pop(c, 1)) {
+      return false;
+    }
+
+    // The table is followed by one `br` for each label and the default.
+    wasm_emit(c, op)->a = count;
+    for (uint32_t i = 0; i <= count; i++) {
+      uint32_t depth;
+      if (!wasm_read_leb_u32_2(reader, &depth) ||
+          !wasm_emit_branch(c, wasm_op_br, depth)) {
+        return false;
+      }
+    }
+    wasm_set_unreachable(c);
+  } break;
+
+  case wasm_op_return: {
+    wasm_instr *instr = wasm_emit(c, op);
+    instr->b.br.arity = c->func->type->result_count;
+    if (!wasm_top_control(c)->unreachable &&
+        c->height < instr->b.br.arity) {
+      fprintf(stderr, "Operand stack underflow.\n");
+      return false;
+    }
+    wasm_set_unreachable(c);
+  } break;
+
+  case wasm_op_call:
+  case wasm_op_return_call: {
+    uint32_t funcidx;
+    if (!wasm_read_leb_u32_2(reader, &funcidx)) {
+      return false;
+    }
+
+    wasm_function_type *type = wasm_module_func_type(c->module, funcidx);
+    if (type == NULL) {
+      fprintf(stderr, "Call to unknown function %u.\n", funcidx);
+      return false;
+    }
+
+    wasm_instr *instr = wasm_emit(c, op);
+    instr->a = funcidx;
+    instr->b.br.arity = type->param_count;
+    instr->b.br.height = type->result_count;
+
+    if (!wasm_pop(c, instr->b.br.arity)) {
+      return false;
+    }
+    if (op == wasm_op_return_call) {
+      return wasm_end_tail_call(c, type);
+    }
+    wasm_push(c, type->result_count);
+  } break;
+
+  case wasm_op_call_indirect:
+  case wasm_op_return_call_indirect: {
+    uint32_t typeidx;
+    unsigned char tableidx;
+    if (!wasm_read_leb_u32_2(reader, &typeidx) ||
+        !wasm_read(reader, &tableidx, 1) || tableidx != 0 || !c->has_table ||
+        typeidx >= wasm_vec_size(&c->module->function_types)) {
+      fprintf(stderr, "Invalid call_indirect.\n");
+      return false;
+    }
+
+    // The callee is checked against the canonical type id. The following data
+    // instruction holds the index of the inline cache of this call site.
+    wasm_function_type *type =
+        wasm_vec_get(&c->module->function_types, typeidx);
+    uint32_t param_count = type->param_count;
+
+    wasm_instr *instr = wasm_emit(c, op);
+    instr->a = wasm_module_type_id(c->module, typeidx);
+    instr->b.br.arity = param_count;
+    instr->b.br.height = type->result_count;
+    wasm_emit(c, wasm_op_data)->a = c->module->indirect_call_count++;
+
+    if (!wasm_pop(c, 1 + param_count)) {
+      return false;
+    }
+    if (op == wasm_op_return_call_indirect) {
+      return wasm_end_tail_call(c, type);
+    }
+    wasm_push(c, type->result_count);
+  } break;
+
+  default: {
+    if (!info->valid || info->pops < 0) {
+      fprintf(stderr, "Unsupported instruction 0x%X.\n", op);
+      return false;
+    }
+
+    wasm_instr *instr = wasm_emit(c, op);
+    bool ok = true;
+
+    switch (info->imm) {
+    case wasm_imm_none:
+      break;
+    case wasm_imm_local:
+      ok = wasm_read_leb_u32_2(reader, &instr->a) &&
+           instr->a < c->func->local_count;
+      break;
+    case wasm_imm_global:
+      ok = wasm_read_leb_u32_2(reader, &instr->a) &&
+           instr->a < c->global_count;
+      break;
+    case wasm_imm_memarg: {
+      uint32_t align;
+      ok = c->has_memory && wasm_read_leb_u32_2(reader, &align) &&
+           wasm_read_leb_u32_2(reader, &instr->a) &&
+           (op < wasm_opcode_prefix_fe || align == wasm_natural_align(op));
+    } break;
+    case wasm_imm_memory: {
+      unsigned char memidx;
+      ok = c->has_memory && wasm_read(reader, &memidx, 1) && memidx == 0;
+    } break;
+    case wasm_imm_memory_init: {
+      unsigned char memidx;
+      ok = c->has_memory && wasm_read_data_index(c, &instr->a) &&
+           wasm_read(reader, &memidx, 1) && memidx == 0;
+    } break;
+    case wasm_imm_memory_copy: {
+      unsigned char memidx[2];
+      ok = c->has_memory && wasm_read(reader, memidx, 2) && memidx[0] == 0 &&
+           memidx[1] == 0;
+    } break;
+    case wasm_imm_data:
+      ok = wasm_read_data_index(c, &instr->a);
+      break;
+    case wasm_imm_i32:
+      ok = wasm_read_leb_s32(reader, &instr->b.i32);
+      break;
+    case wasm_imm_i64:
+      ok = wasm_read_leb_s64(reader, &instr->b.i64);
+      break;
+    case wasm_imm_f32:
+      ok = wasm_read_f32(reader, &instr->b.f32);
+      break;
+    case wasm_imm_f64:
+      ok = wasm_read_f64(reader, &instr->b.f64);
+      break;
+    case wasm_imm_v128:
+      ok = wasm_read_v128(c, instr);
+      break;
+    case wasm_imm_shuffle:
+      // `instr` may move when the data instruction is appended.
+      ok = wasm_read_v128(c, instr);
+      instr = wasm_instr_at(c, wasm_next_instr(c) - 2);
+      for (int i = 0; ok && i < 8; i++) {
+        ok = ((uint8_t *)&instr->b.i64)[i] < 32 &&
+             ((uint8_t *)&instr[1].b.i64)[i] < 32;
+      }
+      break;
+    case wasm_imm_lane:
+      ok = wasm_read_lane(c, op, instr);
+      break;
+    case wasm_imm_memarg_lane: {
+      uint32_t align;
+      ok = c->has_memory && wasm_read_leb_u32_2(reader, &align) &&
+           wasm_read_leb_u32_2(reader, &instr->a) &&
+           wasm_read_lane(c, op, instr);
+    } break;
+    case wasm_imm_reserved: {
+      unsigned char reserved;
+      ok = wasm_read(reader, &reserved, 1) && reserved == 0;
+    } break;
+    default:
+      ok = false;
+      break;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "Invalid immediate of instruction 0x%X.\n", op);
+      return false;
+    }
+
+    if (!wasm_pop(c, info->pops)) {
+      return false;
+    }
+    wasm_push(c, info->pushes);
+  } break;
+  }
+
+  return true;
+}
+
+static bool wasm_compile_code(wasm_compiler *c, wasm_code *code) {
+  wasm_compiled_func *func = c->func;
+
+  // Count the locals. They are run-length encoded.
+  uint64_t local_count = func->param_count;
+  wasm_locals *locals = c->module->locals.start + code->locals_offset;
+  for (uint32_t i = 0; i < code->locals_count; i++) {
+    local_count += locals[i].n;
+  }
+  if (local_count > 50000) {
+    fprintf(stderr, "Too many locals.\n");
+    return false;
+  }
+  func->local_count = (uint32_t)local_count;
+
+  // The function body is the outermost block.
+  wasm_init_memory_reader(&c->reader, wasm_code_expr(c->module, code),
+                          code->expr_size);
+  c->height = 0;
+  wasm_push_control(c, wasm_op_block, func->type->result_count);
+
+  while (c->reader.size > 0) {
+    unsigned char byte;
+    if (!wasm_read(&c->reader, &byte, 1)) {
+      return false;
+    }
+
+    uint16_t op = byte;
+    if (byte == 0xFC) {
+      uint32_t sub;
+      if (!wasm_read_leb_u32_2(&c->reader, &sub) || sub >= 0x100) {
+        fprintf(stderr, "Invalid prefixed instruction.\n");
+        return false;
+      }
+      op = wasm_opcode_prefix_fc + sub;
+    } else if (byte == 0xFD) {
+      uint32_t sub;
+      if (!wasm_read_leb_u32_2(&c->reader, &sub) || sub >= 0x100) {
+        fprintf(stderr, "Invalid SIMD instruction.\n");
+        return false;
+      }
+      op = wasm_opcode_prefix_fd + sub;
+    } else if (byte == 0xFE) {
+      uint32_t sub;
+      if (!wasm_read_leb_u32_2(&c->reader, &sub) || sub >= 0x100) {
+        fprintf(stderr, "Invalid atomic instruction.\n");
+        return false;
+      }
+      op = wasm_opcode_prefix_fe + sub;
+    }
+
+    if (!wasm_compile_instr(c, op)) {
+      return false;
+    }
+  }
+
+  if (wasm_vec_size(&c->controls) != 1) {
+    fprintf(stderr, "Function body has unclosed blocks.\n");
+    return false;
+  }
+
+  // The implicit end of the function returns.
+  wasm_materialize(c, 0);
+  if (!wasm_end_block(c)) {
+    return false;
+  }
+  wasm_emit(c, wasm_op_return)->b.br.arity = func->type->result_count;
+  func->frame_size = func->local_count + func->max_height;
+
+  return true;
+}
+
+bool wasm_compile_module(wasm_module *module) {
+  wasm_compiler c;
+  c.module = module;
+  c.global_count =
+      module->import_global_count + (uint32_t)wasm_vec_size(&module->globals);
+  c.has_memory =
+      wasm_vec_size(&module->mems) > 0 || module->import_mem_count > 0;
+  c.has_table = wasm_vec_size(&module->tables) > 0 ||
+                module->import_table_count > 0;
+  wasm_vec_init(&c.controls);
+  wasm_vec_init(&c.deferred);
+
+  bool ok = true;
+  for (size_t i = 0; ok && i < wasm_vec_size(&module->codes); i++) {
+    wasm_code *code = wasm_vec_get(&module->codes, i);
+    if (code->compiled) {
+      continue;
+    }
+
+    wasm_compiled_func *func = wasm_alloc(wasm_compiled_func);
+    func->type = wasm_module_func_type(
+        module, module->import_func_count + (uint32_t)i);
+    func->param_count = func->type->param_count;
+    func->max_height = 0;
+    wasm_vec_init(&func->instrs);
+    code->compiled = func;
+
+    c.func = func;
+    c.controls.end = c.controls.start;
+    c.deferred.end = c.deferred.start;
+    c.last_result = wasm_no_patch;
+    if (!wasm_compile_code(&c, code)) {
+      fprintf(stderr, "Error compiling function %zu.\n",
+              module->import_func_count + i);
+      wasm_free_compiled_func(func);
+      code->compiled = NULL;
+      ok = false;
+    }
+  }
+
+  wasm_vec_deinit(&c.controls);
+  wasm_vec_deinit(&c.deferred);
+  return ok;
+}
+
+void wasm_free_compiled_func(wasm_compiled_func *func) {
+  if (func) {
+    wasm_vec_deinit(&func->instrs);
+    wasm_free(func);
+  }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include "wasm/wasm_opcodes.h"
+#include <stdint.h>
+
+// Binary operators that have register forms:
+// `X(name, result field, commutes, expr)` where `x` and `y` are the operands.
+// Unsigned types are used where signed overflow would be undefined in C.
+#define WASM_REG_I32_BINOPS(X)                                                 \
+  X(i32_eq, i32, true, x == y)                                                 \
+  X(i32_ne, i32, true, x != y)                                                 \
+  X(i32_lt_s, i32, false, x < y)                                               \
+  X(i32_lt_u, i32, false, (uint32_t)x < (uint32_t)y)                           \
+  X(i32_gt_s, i32, false, x > y)                                               \
+  X(i32_gt_u, i32, false, (uint32_t)x > (uint32_t)y)                           \
+  X(i32_le_s, i32, false, x <= y)                                              \
+  X(i32_le_u, i32, false, (uint32_t)x <= (uint32_t)y)                          \
+  X(i32_ge_s, i32, false, x >= y)                                              \
+  X(i32_ge_u, i32, false, (uint32_t)x >= (uint32_t)y)                          \
+  X(i32_add, i32, true, (int32_t)((uint32_t)x + (uint32_t)y))                  \
+  X(i32_sub, i32, false, (int32_t)((uint32_t)x - (uint32_t)y))                 \
+  X(i32_mul, i32, true, (int32_t)((uint32_t)x * (uint32_t)y))                  \
+  X(i32_and, i32, true, x & y)                                                 \
+  X(i32_or, i32, true, x | y)                                                  \
+  X(i32_xor, i32, true, x ^ y)                                                 \
+  X(i32_shl, i32, false, (int32_t)((uint32_t)x << (y & 31)))                   \
+  X(i32_shr_s, i32, false, x >> (y & 31))                                      \
+  X(i32_shr_u, i32, false, (int32_t)((uint32_t)x >> (y & 31)))
+
+#define WASM_REG_I64_BINOPS(X)                                                 \
+  X(i64_eq, i32, true, x == y)                                                 \
+  X(i64_ne, i32, true, x != y)                                                 \
+  X(i64_lt_s, i32, false, x < y)                                               \
+  X(i64_lt_u, i32, false, (uint64_t)x < (uint64_t)y)                           \
+  X(i64_gt_s, i32, false, x > y)                                               \
+  X(i64_gt_u, i32, false, (uint64_t)x > (uint64_t)y)                           \
+  X(i64_le_s, i32, false, x <= y)                                              \
+  X(i64_le_u, i32, false, (uint64_t)x <= (uint64_t)y)                          \
+  X(i64_ge_s, i32, false, x >= y)                                              \
+  X(i64_ge_u, i32, false, (uint64_t)x >= (uint64_t)y)                          \
+  X(i64_add, i64, true, (int64_t)((uint64_t)x + (uint64_t)y))                  \
+  X(i64_sub, i64, false, (int64_t)((uint64_t)x - (uint64_t)y))                 \
+  X(i64_mul, i64, true, (int64_t)((uint64_t)x * (uint64_t)y))                  \
+  X(i64_and, i64, true, x & y)                                                 \
+  X(i64_or, i64, true, x | y)                                                  \
+  X(i64_xor, i64, true, x ^ y)                                                 \
+  X(i64_shl, i64, false, (int64_t)((uint64_t)x << (y & 63)))                   \
+  X(i64_shr_s, i64, false, x >> (y & 63))                                      \
+  X(i64_shr_u, i64, false, (int64_t)((uint64_t)x >> (y & 63)))
+
+#define WASM_REG_OPCODE(name, result, commutes, expr) wasm_op_reg_##name,
+#define WASM_REG_IMM_OPCODE(name, result, commutes, expr)                      \
+  wasm_op_reg_##name, wasm_op_reg_##name##_imm,
+
+// Instructions that only exist in compiled code. They start after the ranges
+// that are reserved for prefixed opcodes.
+enum wasm_internal_opcode {
+  // Unconditional jump to `a` without touching the stack. Emitted for `else`.
+  wasm_op_jump = 0x500,
+  // Holds more immediates of the previous instruction. It is never executed.
+  wasm_op_data,
+  // `br` and `br_if` that jump back to the start of a loop. They are the
+  // checkpoints where long running loops can be preempted.
+  wasm_op_br_loop,
+  wasm_op_br_if_loop,
+
+  // Register forms. Their operands are frame slots, i.e. locals or operand
+  // stack entries at a position that is known when compiling, so they don't
+  // have to be pushed first. They read `fp[b.reg.x]` and `fp[b.reg.y]`, the
+  // `_imm` forms read `fp[b.reg.x]` and the constant `a`. The result is
+  // stored in `fp[b.reg.dst]` and the operand stack ends at `fp + b.reg.sp`
+  // afterwards.
+  wasm_op_reg_copy,
+  // Stores the constant `a`.
+  wasm_op_reg_const,
+  wasm_op_reg_i32_eqz,
+  WASM_REG_I32_BINOPS(WASM_REG_IMM_OPCODE)
+  WASM_REG_I64_BINOPS(WASM_REG_OPCODE)
+};
+
+// A decoded instruction. Immediates are decoded and branch targets are
+// resolved to instruction indices so the interpreter never has to scan for the
+// matching `end`.
+typedef struct {
+  uint16_t op;
+  // Branch target, local/global/function index or memory offset.
+  uint32_t a;
+  union {
+    int32_t i32;
+    int64_t i64;
+    float f32;
+    double f64;
+    // Branches keep `arity` values and drop the stack to `height` which is
+    // relative to the start of the frame (it includes the locals).
+    // Calls store the parameter and result count of the callee.
+    struct {
+      uint32_t arity;
+      uint32_t height;
+    } br;
+    struct {
+      uint16_t dst;
+      uint16_t x;
+      uint16_t y;
+      uint16_t sp;
+    } reg;
+  } b;
+} wasm_instr;
+
+typedef struct wasm_compiled_func {
+  wasm_function_type *type;
+  uint32_t param_count;
+  // Number of locals including the parameters.
+  uint32_t local_count;
+  // Maximum height of the operand stack.
+  uint32_t max_height;
+  // Number of value stack slots a call takes: the locals followed by the
+  // operand stack.
+  uint32_t frame_size;
+  wasm_vec_of(wasm_instr) instrs;
+} wasm_compiled_func;
+
+// Selects whether the compiler lowers stack code to register forms, e.g. to
+// compare against plain stack code. On by default. Only affects functions that
+// are compiled afterwards.
+void wasm_set_register_ir(bool enabled);
+
+// Compiles the bodies of all functions of the module. Functions that were
+// already compiled are skipped. Returns false if a body is invalid.
+bool wasm_compile_module(wasm_module *module);
+void wasm_free_compiled_func(wasm_compiled_func *func);
+
+// Log2 of the access size of a load, store or atomic instruction, which is the
+// alignment the text format leaves out and atomics have to declare.
+uint32_t wasm_natural_align(uint16_t op);
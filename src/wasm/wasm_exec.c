@@ -0,0 +1,1887 @@
+#include "wasm/wasm_exec.h"
+
+#include "wasm/wasm_atomic.h"
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_host.h"
+#include "wasm/wasm_perf.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+const char *wasm_trap_to_str(enum wasm_trap trap) {
+  switch (trap) {
+  case wasm_trap_none:
+    return "none";
+  case wasm_trap_unreachable:
+    return "unreachable";
+  case wasm_trap_memory_out_of_bounds:
+    return "out of bounds memory access";
+  case wasm_trap_integer_divide_by_zero:
+    return "integer divide by zero";
+  case wasm_trap_integer_overflow:
+    return "integer overflow";
+  case wasm_trap_invalid_conversion:
+    return "invalid conversion to integer";
+  case wasm_trap_call_stack_exhausted:
+    return "call stack exhausted";
+  case wasm_trap_undefined_element:
+    return "undefined element";
+  case wasm_trap_uninitialized_element:
+    return "uninitialized element";
+  case wasm_trap_indirect_call_type_mismatch:
+    return "indirect call type mismatch";
+  case wasm_trap_host:
+    return "host function failed";
+  case wasm_trap_exit:
+    return "exit";
+  case wasm_trap_unaligned_atomic:
+    return "unaligned atomic";
+  case wasm_trap_expected_shared_memory:
+    return "expected shared memory";
+  case wasm_trap_interrupted:
+    return "interrupted";
+  case wasm_trap_undefined_function:
+    return "undefined function";
+  default:
+    return "invalid";
+  }
+}
+
+void wasm_instance_trap(wasm_instance *instance, enum wasm_trap trap) {
+  instance->trap = trap;
+}
+
+// Float operations that differ between C and wasm.
+
+static float wasm_f32_min(float a, float b) {
+  if (isnan(a) || isnan(b)) {
+    return NAN;
+  }
+  if (a == b) {
+    // -0 is smaller than 0.
+    return signbit(a) ? a : b;
+  }
+  return a < b ? a : b;
+}
+
+static float wasm_f32_max(float a, float b) {
+  if (isnan(a) || isnan(b)) {
+    return NAN;
+  }
+  if (a == b) {
+    return signbit(a) ? b : a;
+  }
+  return a > b ? a : b;
+}
+
+static double wasm_f64_min(double a, double b) {
+  if (isnan(a) || isnan(b)) {
+    return NAN;
+  }
+  if (a == b) {
+    return signbit(a) ? a : b;
+  }
+  return a < b ? a : b;
+}
+
+static double wasm_f64_max(double a, double b) {
+  if (isnan(a) || isnan(b)) {
+    return NAN;
+  }
+  if (a == b) {
+    return signbit(a) ? b : a;
+  }
+  return a > b ? a : b;
+}
+
+static uint32_t wasm_rotl32(uint32_t x, uint32_t n) {
+  n &= 31;
+  return n ? (x << n) | (x >> (32 - n)) : x;
+}
+
+static uint32_t wasm_rotr32(uint32_t x, uint32_t n) {
+  n &= 31;
+  return n ? (x >> n) | (x << (32 - n)) : x;
+}
+
+static uint64_t wasm_rotl64(uint64_t x, uint64_t n) {
+  n &= 63;
+  return n ? (x << n) | (x >> (64 - n)) : x;
+}
+
+static uint64_t wasm_rotr64(uint64_t x, uint64_t n) {
+  n &= 63;
+  return n ? (x >> n) | (x << (64 - n)) : x;
+}
+
+static int32_t wasm_clz32(uint32_t x) { return x ? __builtin_clz(x) : 32; }
+static int32_t wasm_ctz32(uint32_t x) { return x ? __builtin_ctz(x) : 32; }
+static int64_t wasm_clz64(uint64_t x) { return x ? __builtin_clzll(x) : 64; }
+static int64_t wasm_ctz64(uint64_t x) { return x ? __builtin_ctzll(x) : 64; }
+
+// Float to int conversions. The bounds are the first values that are out of
+// range. `trap` is set if the value can't be represented.
+
+#define WASM_TRUNC(name, from, to, min, max)                                   \
+  static to name(from x, enum wasm_trap *trap) {                               \
+    if (isnan(x)) {                                                            \
+      *trap = wasm_trap_invalid_conversion;                                    \
+      return 0;                                                                \
+    }                                                                          \
+    if (!(x > min && x < max)) {                                               \
+      *trap = wasm_trap_integer_overflow;                                      \
+      return 0;                                                                \
+    }                                                                          \
+    return (to)x;                                                              \
+  }
+
+WASM_TRUNC(wasm_i32_trunc_f32_s, float, int32_t, -2147483904.0f, 2147483648.0f)
+WASM_TRUNC(wasm_i32_trunc_f32_u, float, uint32_t, -1.0f, 4294967296.0f)
+WASM_TRUNC(wasm_i32_trunc_f64_s, double, int32_t, -2147483649.0, 2147483648.0)
+WASM_TRUNC(wasm_i32_trunc_f64_u, double, uint32_t, -1.0, 4294967296.0)
+WASM_TRUNC(wasm_i64_trunc_f32_s, float, int64_t, -9223373136366403584.0f,
+           9223372036854775808.0f)
+WASM_TRUNC(wasm_i64_trunc_f32_u, float, uint64_t, -1.0f,
+           18446744073709551616.0f)
+WASM_TRUNC(wasm_i64_trunc_f64_s, double, int64_t, -9223372036854777856.0,
+           9223372036854775808.0)
+WASM_TRUNC(wasm_i64_trunc_f64_u, double, uint64_t, -1.0,
+           18446744073709551616.0)
+
+// Saturating conversions clamp instead of trapping and map NaN to 0.
+#define WASM_TRUNC_SAT(name, from, to, min, max, to_min, to_max)               \
+  static to name(from x) {                                                     \
+    if (isnan(x)) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    if (x <= min) {                                                            \
+      return to_min;                                                           \
+    }                                                                          \
+    if (x >= max) {                                                            \
+      return to_max;                                                           \
+    }                                                                          \
+    return (to)x;                                                              \
+  }
+
+WASM_TRUNC_SAT(wasm_i32_trunc_sat_f32_s, float, int32_t, -2147483904.0f,
+               2147483648.0f, INT32_MIN, INT32_MAX)
+WASM_TRUNC_SAT(wasm_i32_trunc_sat_f32_u, float, uint32_t, -1.0f,
+               4294967296.0f, 0, UINT32_MAX)
+WASM_TRUNC_SAT(wasm_i32_trunc_sat_f64_s, double, int32_t, -2147483649.0,
+               2147483648.0, INT32_MIN, INT32_MAX)
+WASM_TRUNC_SAT(wasm_i32_trunc_sat_f64_u, double, uint32_t, -1.0,
+               4294967296.0, 0, UINT32_MAX)
+WASM_TRUNC_SAT(wasm_i64_trunc_sat_f32_s, float, int64_t,
+               -9223373136366403584.0f, 9223372036854775808.0f, INT64_MIN,
+               INT64_MAX)
+WASM_TRUNC_SAT(wasm_i64_trunc_sat_f32_u, float, uint64_t, -1.0f,
+               18446744073709551616.0f, 0, UINT64_MAX)
+WASM_TRUNC_SAT(wasm_i64_trunc_sat_f64_s, double, int64_t,
+               -9223372036854777856.0, 9223372036854775808.0, INT64_MIN,
+               INT64_MAX)
+WASM_TRUNC_SAT(wasm_i64_trunc_sat_f64_u, double, uint64_t, -1.0,
+               18446744073709551616.0, 0, UINT64_MAX)
+
+// SIMD instructions. They use the scalar helpers above.
+#include "wasm/wasm_simd_ops.h"
+
+// Other threads can grow a shared memory so the cached size is reloaded before
+// an access is reported as out of bounds.
+static __attribute__((noinline)) bool
+wasm_reload_memory_size(wasm_instance *instance, uint64_t end) {
+  if (instance->shared_memory == NULL) {
+    return false;
+  }
+  instance->memory_size = atomic_load(&instance->shared_memory->size);
+  return end <= instance->memory_size;
+}
+
+// Returns true if the bytes below `end` are in bounds of the memory.
+static inline bool wasm_memory_in_bounds(wasm_instance *instance,
+                                         uint64_t end) {
+  return end <= instance->memory_size || wasm_reload_memory_size(instance, end);
+}
+
+// Called when an instance used up its fuel. Without a hook the fuel is simply
+// refilled.
+static __attribute__((noinline)) bool wasm_checkpoint(wasm_instance *instance) {
+  if (instance->checkpoint == NULL) {
+    instance->fuel = INT64_MAX;
+    return true;
+  }
+  return instance->checkpoint(instance);
+}
+
+// Where a call returns to. Pushed by a call, the callee runs with the
+// parameters at the top of the caller's operand stack as its first locals.
+typedef struct wasm_frame {
+  // The caller, NULL for the first call of a `wasm_exec` which returns to the
+  // host.
+  wasm_compiled_func *func;
+  wasm_instr *ip;
+  wasm_value *fp;
+} wasm_frame;
+
+static enum wasm_trap wasm_call(wasm_instance *instance, wasm_func *func,
+                                wasm_value *args);
+static enum wasm_trap wasm_call_host(wasm_instance *instance, wasm_func *func,
+                                     wasm_value *args);
+static wasm_value *wasm_exec_simd(wasm_instance *instance, wasm_instr *ip,
+                                  wasm_value *sp);
+static wasm_value *wasm_exec_atomic(wasm_instance *instance, wasm_instr *ip,
+                                    wasm_value *sp, enum wasm_trap *trap);
+
+// Executes a compiled function. The parameters are already stored at `fp` and
+// the result is stored at `fp[0]`. Calls to other compiled functions are run
+// by the same loop: the caller is pushed to `instance->frames` and restored
+// when the callee returns.
+static enum wasm_trap wasm_exec(wasm_instance *instance,
+                                wasm_compiled_func *func, wasm_value *fp) {
+  uint32_t call_depth = instance->call_depth;
+  if (call_depth >= instance->max_call_depth) {
+    return wasm_trap_call_stack_exhausted;
+  }
+  instance->frames[instance->call_depth++] = (wasm_frame){NULL, NULL, NULL};
+
+  wasm_instr *code, *ip;
+  wasm_value *sp;
+  enum wasm_trap trap = wasm_trap_none;
+  // Target of a call and the instruction after the call.
+  wasm_func *callee;
+  wasm_instr *next;
+#ifdef WASM_DISPATCH_COUNTING
+  uint64_t dispatches = 0;
+#endif
+  // Operands of the register forms. They are shared by all of them so that
+  // unoptimized builds don't give each one its own stack slots, which would
+  // make deep recursion overflow the native stack. The i32 forms are exact
+  // with sign extended operands.
+  int64_t x, y;
+
+  // Starts `func` with its parameters at `fp`.
+enter:
+  if (fp + func->frame_size > instance->stack_end) {
+    trap = wasm_trap_call_stack_exhausted;
+    goto end;
+  }
+  if (--instance->fuel <= 0 && !wasm_checkpoint(instance)) {
+    trap = wasm_trap_interrupted;
+    goto end;
+  }
+
+  // Locals that are not parameters start with zero.
+  memset(fp + func->param_count, 0,
+         (func->local_count - func->param_count) * sizeof(wasm_value));
+
+  code = func->instrs.start;
+  ip = code;
+  sp = fp + func->local_count;
+
+// Operand access. `sp` points to the first free slot.
+#define WASM_UNOP(field, expr)                                                 \
+  sp[-1].field = (expr);                                                       \
+  break
+#define WASM_BINOP(field, expr)                                                \
+  sp[-2].field = (expr);                                                       \
+  sp--;                                                                        \
+  break
+// Pops the table index of `call_indirect` and looks up `callee`. The
+// following data instruction holds the index of the inline cache. The table
+// is immutable so a function that passed the checks for an index will always
+// pass them.
+#define WASM_INDIRECT_CALLEE()                                                 \
+  {                                                                            \
+    uint32_t index = U32((--sp)->i32);                                         \
+    wasm_inline_cache *cache = &instance->inline_caches[ip[1].a];              \
+    callee = cache->target;                                                    \
+    if (callee == NULL || cache->index != index) {                             \
+      if (index >= instance->table_size) {                                     \
+        trap = wasm_trap_undefined_element;                                    \
+        goto end;                                                              \
+      }                                                                        \
+      callee = instance->table[index];                                         \
+      if (callee == NULL) {                                                    \
+        trap = wasm_trap_uninitialized_element;                                \
+        goto end;                                                              \
+      }                                                                        \
+      if (callee->type_id != ip->a) {                                          \
+        trap = wasm_trap_indirect_call_type_mismatch;                          \
+        goto end;                                                              \
+      }                                                                        \
+      cache->index = index;                                                    \
+      cache->target = callee;                                                  \
+    }                                                                          \
+  }
+#define A32 sp[-2].i32
+#define B32 sp[-1].i32
+#define A64 sp[-2].i64
+#define B64 sp[-1].i64
+#define U32(x) ((uint32_t)(x))
+#define U64(x) ((uint64_t)(x))
+#define WASM_TRUNC_OP(field, func, from)                                       \
+  sp[-1].field = func(sp[-1].from, &trap);                                     \
+  if (trap) {                                                                  \
+    goto end;                                                                  \
+  }                                                                            \
+  break
+
+// Memory access. The effective address is checked against the memory size.
+#define WASM_ADDRESS(size)                                                     \
+  uint64_t address = (uint64_t)U32(sp[-1].i32) + ip->a;                        \
+  if (!wasm_memory_in_bounds(instance, address + (size))) {                    \
+    trap = wasm_trap_memory_out_of_bounds;                                     \
+    goto end;                                                                  \
+  }                                                                            \
+  unsigned char *memory = instance->memory + address
+#define WASM_LOAD(field, type, result_type)                                    \
+  {                                                                            \
+    WASM_ADDRESS(sizeof(type));                                                \
+    type value;                                                                \
+    memcpy(&value, memory, sizeof(type));                                      \
+    sp[-1].field = (result_type)value;                                         \
+  }                                                                            \
+  break
+#define WASM_STORE(field, type)                                                \
+  {                                                                            \
+    sp--;                                                                      \
+    WASM_ADDRESS(sizeof(type));                                                \
+    type value = (type)sp[0].field;                                            \
+    memcpy(memory, &value, sizeof(type));                                      \
+    sp--;                                                                      \
+  }                                                                            \
+  break
+// Loads `size` bytes into the low lanes of a zeroed vector `v` and replaces
+// the address with `expr`.
+#define WASM_SIMD_LOAD(size, expr)                                             \
+  {                                                                            \
+    WASM_ADDRESS(size);                                                        \
+    wasm_v128 v;                                                               \
+    memset(&v, 0, sizeof(v));                                                  \
+    memcpy(&v, memory, size);                                                  \
+    sp[-1].v128 = (expr);                                                      \
+  }                                                                            \
+  break
+#define WASM_SIMD_LOAD_LANE(field)                                             \
+  {                                                                            \
+    wasm_v128 v = (--sp)->v128;                                                \
+    WASM_ADDRESS(sizeof(v.field[0]));                                          \
+    memcpy(&v.field[ip->b.i32], memory, sizeof(v.field[0]));                   \
+    sp[-1].v128 = v;                                                           \
+  }                                                                            \
+  break
+#define WASM_SIMD_STORE_LANE(field)                                            \
+  {                                                                            \
+    wasm_v128 v = (--sp)->v128;                                                \
+    WASM_ADDRESS(sizeof(v.field[0]));                                          \
+    memcpy(memory, &v.field[ip->b.i32], sizeof(v.field[0]));                   \
+    sp--;                                                                      \
+  }                                                                            \
+  break
+#define WASM_SIMD_REPLACE_LANE(field, value)                                   \
+  sp[-2].v128.field[ip->b.i32] = (value);                                      \
+  sp--;                                                                        \
+  break
+
+  for (;;) {
+#ifdef WASM_DISPATCH_COUNTING
+    dispatches++;
+#endif
+    switch (ip->op) {
+    case wasm_op_unreachable:
+      trap = wasm_trap_unreachable;
+      goto end;
+
+    case wasm_op_if:
+      sp--;
+      if (sp->i32 == 0) {
+        ip = code + ip->a;
+        continue;
+      }
+      break;
+
+    case wasm_op_jump:
+      ip = code + ip->a;
+      continue;
+
+    case wasm_op_br_if:
+      sp--;
+      if (sp->i32 == 0) {
+        break;
+      }
+      // fallthrough
+    case wasm_op_br: {
+      wasm_value *dst = fp + ip->b.br.height;
+      if (ip->b.br.arity) {
+        *dst++ = sp[-1];
+      }
+      sp = dst;
+      ip = code + ip->a;
+      continue;
+    }
+
+    // Backward branches are checkpoints so that loops can be preempted. Loops
+    // have no results so the stack is only dropped.
+    case wasm_op_br_if_loop:
+      sp--;
+      if (sp->i32 == 0) {
+        break;
+      }
+      // fallthrough
+    case wasm_op_br_loop:
+      if (--instance->fuel <= 0 && !wasm_checkpoint(instance)) {
+        trap = wasm_trap_interrupted;
+        goto end;
+      }
+      sp = fp + ip->b.br.height;
+      ip = code + ip->a;
+      continue;
+
+    case wasm_op_br_table: {
+      // The labels follow the table as `br` instructions. The last one is the
+      // default label.
+      uint32_t index = U32(sp[-1].i32);
+      sp--;
+      ip += 1 + (index < ip->a ? index : ip->a);
+      continue;
+    }
+
+    case wasm_op_return:
+      if (ip->b.br.arity) {
+        fp[0] = sp[-1];
+      }
+    ret: {
+      wasm_frame *frame = &instance->frames[--instance->call_depth];
+      if (frame->func == NULL) {
+        goto end;
+      }
+      // The results are stored where the parameters were.
+      sp = fp + func->type->result_count;
+      func = frame->func;
+      code = func->instrs.start;
+      ip = frame->ip;
+      fp = frame->fp;
+      continue;
+    }
+
+    case wasm_op_call:
+      callee = &instance->funcs[ip->a];
+      next = ip + 1;
+      goto call;
+
+    case wasm_op_call_indirect:
+      WASM_INDIRECT_CALLEE();
+      next = ip + 2;
+    call: {
+      wasm_value *args = sp - ip->b.br.arity;
+      if (callee->host) {
+        trap = wasm_call_host(instance, callee, args);
+        if (trap) {
+          goto end;
+        }
+        sp = args + ip->b.br.height;
+        ip = next;
+        continue;
+      }
+      if (instance->call_depth >= instance->max_call_depth) {
+        trap = wasm_trap_call_stack_exhausted;
+        goto end;
+      }
+      instance->frames[instance->call_depth++] = (wasm_frame){func, next, fp};
+      func = callee->compiled;
+      fp = args;
+      goto enter;
+    }
+
+    // Tail calls replace the frame of the caller, so they don't count towards
+    // the call depth.
+    case wasm_op_return_call:
+      callee = &instance->funcs[ip->a];
+      goto tail_call;
+
+    case wasm_op_return_call_indirect:
+      WASM_INDIRECT_CALLEE();
+    tail_call: {
+      wasm_value *args = sp - ip->b.br.arity;
+      if (callee->host) {
+        trap = wasm_call_host(instance, callee, args);
+        if (trap) {
+          goto end;
+        }
+        if (ip->b.br.height) {
+          fp[0] = args[0];
+        }
+        goto ret;
+      }
+      // The arguments are above the locals so copying forward is safe.
+      for (uint32_t i = 0; i < ip->b.br.arity; i++) {
+        fp[i] = args[i];
+      }
+      func = callee->compiled;
+      goto enter;
+    }
+
+    case wasm_op_drop:
+      sp--;
+      break;
+
+    case wasm_op_select:
+      if (sp[-1].i32 == 0) {
+        sp[-3] = sp[-2];
+      }
+      sp -= 2;
+      break;
+
+    case wasm_op_local_get:
+      *sp++ = fp[ip->a];
+      break;
+    case wasm_op_local_set:
+      fp[ip->a] = *--sp;
+      break;
+    case wasm_op_local_tee:
+      fp[ip->a] = sp[-1];
+      break;
+    case wasm_op_global_get:
+      *sp++ = instance->globals[ip->a];
+      break;
+    case wasm_op_global_set:
+      instance->globals[ip->a] = *--sp;
+      break;
+
+    case wasm_op_i32_load:
+      WASM_LOAD(i32, int32_t, int32_t);
+    case wasm_op_i64_load:
+      WASM_LOAD(i64, int64_t, int64_t);
+    case wasm_op_f32_load:
+      WASM_LOAD(f32, float, float);
+    case wasm_op_f64_load:
+      WASM_LOAD(f64, double, double);
+    case wasm_op_i32_load8_s:
+      WASM_LOAD(i32, int8_t, int32_t);
+    case wasm_op_i32_load8_u:
+      WASM_LOAD(i32, uint8_t, int32_t);
+    case wasm_op_i32_load16_s:
+      WASM_LOAD(i32, int16_t, int32_t);
+    case wasm_op_i32_load16_u:
+      WASM_LOAD(i32, uint16_t, int32_t);
+    case wasm_op_i64_load8_s:
+      WASM_LOAD(i64, int8_t, int64_t);
+    case wasm_op_i64_load8_u:
+      WASM_LOAD(i64, uint8_t, int64_t);
+    case wasm_op_i64_load16_s:
+      WASM_LOAD(i64, int16_t, int64_t);
+    case wasm_op_i64_load16_u:
+      WASM_LOAD(i64, uint16_t, int64_t);
+    case wasm_op_i64_load32_s:
+      WASM_LOAD(i64, int32_t, int64_t);
+    case wasm_op_i64_load32_u:
+      WASM_LOAD(i64, uint32_t, int64_t);
+
+    case wasm_op_i32_store:
+      WASM_STORE(i32, int32_t);
+    case wasm_op_i64_store:
+      WASM_STORE(i64, int64_t);
+    case wasm_op_f32_store:
+      WASM_STORE(f32, float);
+    case wasm_op_f64_store:
+      WASM_STORE(f64, double);
+    case wasm_op_i32_store8:
+      WASM_STORE(i32, uint8_t);
+    case wasm_op_i32_store16:
+      WASM_STORE(i32, uint16_t);
+    case wasm_op_i64_store8:
+      WASM_STORE(i64, uint8_t);
+    case wasm_op_i64_store16:
+      WASM_STORE(i64, uint16_t);
+    case wasm_op_i64_store32:
+      WASM_STORE(i64, uint32_t);
+
+    case wasm_op_memory_size:
+      wasm_reload_memory_size(instance, 0);
+      (sp++)->i32 = (int32_t)(instance->memory_size / wasm_page_size);
+      break;
+
+    case wasm_op_memory_grow: {
+      uint32_t old_pages = (uint32_t)(instance->memory_size / wasm_page_size);
+      uint32_t delta = U32(sp[-1].i32);
+      sp[-1].i32 = -1;
+
+      if (instance->shared_memory) {
+        // The data of a shared memory is reserved up front and never moves.
+        sp[-1].i32 = wasm_shared_memory_grow(instance->shared_memory, delta);
+        wasm_reload_memory_size(instance, 0);
+      } else if (delta <= instance->memory_max_pages - old_pages) {
+        size_t new_size = (size_t)(old_pages + delta) * wasm_page_size;
+        unsigned char *memory = delta ? wasm_realloc_n(instance->memory,
+                                                       new_size)
+                                      : instance->memory;
+        if (memory != NULL) {
+          memset(memory + instance->memory_size, 0,
+                 new_size - instance->memory_size);
+          instance->memory = memory;
+          instance->memory_size = new_size;
+          sp[-1].i32 = (int32_t)old_pages;
+        }
+      }
+    } break;
+
+    // Bulk memory. The whole range is checked once and then handed to the C
+    // library which copies in large chunks.
+    case wasm_op_memory_init: {
+      uint32_t dst = U32(sp[-3].i32);
+      uint32_t src = U32(sp[-2].i32);
+      uint32_t size = U32(sp[-1].i32);
+      sp -= 3;
+      if ((uint64_t)src + size > instance->data_sizes[ip->a] ||
+          !wasm_memory_in_bounds(instance, (uint64_t)dst + size)) {
+        trap = wasm_trap_memory_out_of_bounds;
+        goto end;
+      }
+      if (size > 0) {
+        wasm_data *data = wasm_vec_get(&instance->module->datas, ip->a);
+        memcpy(instance->memory + dst, (unsigned char *)data->init.start + src,
+               size);
+      }
+    } break;
+
+    case wasm_op_data_drop:
+      instance->data_sizes[ip->a] = 0;
+      break;
+
+    case wasm_op_memory_copy: {
+      uint32_t dst = U32(sp[-3].i32);
+      uint32_t src = U32(sp[-2].i32);
+      uint32_t size = U32(sp[-1].i32);
+      sp -= 3;
+      if (!wasm_memory_in_bounds(instance, (uint64_t)src + size) ||
+          !wasm_memory_in_bounds(instance, (uint64_t)dst + size)) {
+        trap = wasm_trap_memory_out_of_bounds;
+        goto end;
+      }
+      memmove(instance->memory + dst, instance->memory + src, size);
+    } break;
+
+    case wasm_op_memory_fill: {
+      uint32_t dst = U32(sp[-3].i32);
+      uint32_t size = U32(sp[-1].i32);
+      sp -= 3;
+      if (!wasm_memory_in_bounds(instance, (uint64_t)dst + size)) {
+        trap = wasm_trap_memory_out_of_bounds;
+        goto end;
+      }
+      memset(instance->memory + dst, sp[1].i32, size);
+    } break;
+
+    case wasm_op_i32_const:
+      (sp++)->i32 = ip->b.i32;
+      break;
+    case wasm_op_i64_const:
+      (sp++)->i64 = ip->b.i64;
+      break;
+    case wasm_op_f32_const:
+      (sp++)->f32 = ip->b.f32;
+      break;
+    case wasm_op_f64_const:
+      (sp++)->f64 = ip->b.f64;
+      break;
+
+    // i32 comparisons.
+    case wasm_op_i32_eqz:
+      WASM_UNOP(i32, sp[-1].i32 == 0);
+    case wasm_op_i32_eq:
+      WASM_BINOP(i32, A32 == B32);
+    case wasm_op_i32_ne:
+      WASM_BINOP(i32, A32 != B32);
+    case wasm_op_i32_lt_s:
+      WASM_BINOP(i32, A32 < B32);
+    case wasm_op_i32_lt_u:
+      WASM_BINOP(i32, U32(A32) < U32(B32));
+    case wasm_op_i32_gt_s:
+      WASM_BINOP(i32, A32 > B32);
+    case wasm_op_i32_gt_u:
+      WASM_BINOP(i32, U32(A32) > U32(B32));
+    case wasm_op_i32_le_s:
+      WASM_BINOP(i32, A32 <= B32);
+    case wasm_op_i32_le_u:
+      WASM_BINOP(i32, U32(A32) <= U32(B32));
+    case wasm_op_i32_ge_s:
+      WASM_BINOP(i32, A32 >= B32);
+    case wasm_op_i32_ge_u:
+      WASM_BINOP(i32, U32(A32) >= U32(B32));
+
+    // i64 comparisons.
+    case wasm_op_i64_eqz:
+      sp[-1].i32 = sp[-1].i64 == 0;
+      break;
+    case wasm_op_i64_eq:
+      WASM_BINOP(i32, A64 == B64);
+    case wasm_op_i64_ne:
+      WASM_BINOP(i32, A64 != B64);
+    case wasm_op_i64_lt_s:
+      WASM_BINOP(i32, A64 < B64);
+    case wasm_op_i64_lt_u:
+      WASM_BINOP(i32, U64(A64) < U64(B64));
+    case wasm_op_i64_gt_s:
+      WASM_BINOP(i32, A64 > B64);
+    case wasm_op_i64_gt_u:
+      WASM_BINOP(i32, U64(A64) > U64(B64));
+    case wasm_op_i64_le_s:
+      WASM_BINOP(i32, A64 <= B64);
+    case wasm_op_i64_le_u:
+      WASM_BINOP(i32, U64(A64) <= U64(B64));
+    case wasm_op_i64_ge_s:
+      WASM_BINOP(i32, A64 >= B64);
+    case wasm_op_i64_ge_u:
+      WASM_BINOP(i32, U64(A64) >= U64(B64));
+
+    // Float comparisons.
+    case wasm_op_f32_eq:
+      WASM_BINOP(i32, sp[-2].f32 == sp[-1].f32);
+    case wasm_op_f32_ne:
+      WASM_BINOP(i32, sp[-2].f32 != sp[-1].f32);
+    case wasm_op_f32_lt:
+      WASM_BINOP(i32, sp[-2].f32 < sp[-1].f32);
+    case wasm_op_f32_gt:
+      WASM_BINOP(i32, sp[-2].f32 > sp[-1].f32);
+    case wasm_op_f32_le:
+      WASM_BINOP(i32, sp[-2].f32 <= sp[-1].f32);
+    case wasm_op_f32_ge:
+      WASM_BINOP(i32, sp[-2].f32 >= sp[-1].f32);
+    case wasm_op_f64_eq:
+      WASM_BINOP(i32, sp[-2].f64 == sp[-1].f64);
+    case wasm_op_f64_ne:
+      WASM_BINOP(i32, sp[-2].f64 != sp[-1].f64);
+    case wasm_op_f64_lt:
+      WASM_BINOP(i32, sp[-2].f64 < sp[-1].f64);
+    case wasm_op_f64_gt:
+      WASM_BINOP(i32, sp[-2].f64 > sp[-1].f64);
+    case wasm_op_f64_le:
+      WASM_BINOP(i32, sp[-2].f64 <= sp[-1].f64);
+    case wasm_op_f64_ge:
+      WASM_BINOP(i32, sp[-2].f64 >= sp[-1].f64);
+
+    // i32 arithmetic. Unsigned types are used where signed overflow would be
+    // undefined in C.
+    case wasm_op_i32_clz:
+      WASM_UNOP(i32, wasm_clz32(U32(sp[-1].i32)));
+    case wasm_op_i32_ctz:
+      WASM_UNOP(i32, wasm_ctz32(U32(sp[-1].i32)));
+    case wasm_op_i32_popcnt:
+      WASM_UNOP(i32, __builtin_popcount(U32(sp[-1].i32)));
+    case wasm_op_i32_add:
+      WASM_BINOP(i32, (int32_t)(U32(A32) + U32(B32)));
+    case wasm_op_i32_sub:
+      WASM_BINOP(i32, (int32_t)(U32(A32) - U32(B32)));
+    case wasm_op_i32_mul:
+      WASM_BINOP(i32, (int32_t)(U32(A32) * U32(B32)));
+    case wasm_op_i32_div_s:
+      if (B32 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      if (A32 == INT32_MIN && B32 == -1) {
+        trap = wasm_trap_integer_overflow;
+        goto end;
+      }
+      WASM_BINOP(i32, A32 / B32);
+    case wasm_op_i32_div_u:
+      if (B32 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i32, (int32_t)(U32(A32) / U32(B32)));
+    case wasm_op_i32_rem_s:
+      if (B32 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i32, B32 == -1 ? 0 : A32 % B32);
+    case wasm_op_i32_rem_u:
+      if (B32 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i32, (int32_t)(U32(A32) % U32(B32)));
+    case wasm_op_i32_and:
+      WASM_BINOP(i32, A32 & B32);
+    case wasm_op_i32_or:
+      WASM_BINOP(i32, A32 | B32);
+    case wasm_op_i32_xor:
+      WASM_BINOP(i32, A32 ^ B32);
+    case wasm_op_i32_shl:
+      WASM_BINOP(i32, (int32_t)(U32(A32) << (B32 & 31)));
+    case wasm_op_i32_shr_s:
+      WASM_BINOP(i32, A32 >> (B32 & 31));
+    case wasm_op_i32_shr_u:
+      WASM_BINOP(i32, (int32_t)(U32(A32) >> (B32 & 31)));
+    case wasm_op_i32_rotl:
+      WASM_BINOP(i32, (int32_t)wasm_rotl32(U32(A32), U32(B32)));
+    case wasm_op_i32_rotr:
+      WASM_BINOP(i32, (int32_t)wasm_rotr32(U32(A32), U32(B32)));
+
+    // i64 arithmetic.
+    case wasm_op_i64_clz:
+      WASM_UNOP(i64, wasm_clz64(U64(sp[-1].i64)));
+    case wasm_op_i64_ctz:
+      WASM_UNOP(i64, wasm_ctz64(U64(sp[-1].i64)));
+    case wasm_op_i64_popcnt:
+      WASM_UNOP(i64, __builtin_popcountll(U64(sp[-1].i64)));
+    case wasm_op_i64_add:
+      WASM_BINOP(i64, (int64_t)(U64(A64) + U64(B64)));
+    case wasm_op_i64_sub:
+      WASM_BINOP(i64, (int64_t)(U64(A64) - U64(B64)));
+    case wasm_op_i64_mul:
+      WASM_BINOP(i64, (int64_t)(U64(A64) * U64(B64)));
+    case wasm_op_i64_div_s:
+      if (B64 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      if (A64 == INT64_MIN && B64 == -1) {
+        trap = wasm_trap_integer_overflow;
+        goto end;
+      }
+      WASM_BINOP(i64, A64 / B64);
+    case wasm_op_i64_div_u:
+      if (B64 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i64, (int64_t)(U64(A64) / U64(B64)));
+    case wasm_op_i64_rem_s:
+      if (B64 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i64, B64 == -1 ? 0 : A64 % B64);
+    case wasm_op_i64_rem_u:
+      if (B64 == 0) {
+        trap = wasm_trap_integer_divide_by_zero;
+        goto end;
+      }
+      WASM_BINOP(i64, (int64_t)(U64(A64) % U64(B64)));
+    case wasm_op_i64_and:
+      WASM_BINOP(i64, A64 & B64);
+    case wasm_op_i64_or:
+      WASM_BINOP(i64, A64 | B64);
+    case wasm_op_i64_xor:
+      WASM_BINOP(i64, A64 ^ B64);
+    case wasm_op_i64_shl:
+      WASM_BINOP(i64, (int64_t)(U64(A64) << (B64 & 63)));
+    case wasm_op_i64_shr_s:
+      WASM_BINOP(i64, A64 >> (B64 & 63));
+    case wasm_op_i64_shr_u:
+      WASM_BINOP(i64, (int64_t)(U64(A64) >> (B64 & 63)));
+    case wasm_op_i64_rotl:
+      WASM_BINOP(i64, (int64_t)wasm_rotl64(U64(A64), U64(B64)));
+    case wasm_op_i64_rotr:
+      WASM_BINOP(i64, (int64_t)wasm_rotr64(U64(A64), U64(B64)));
+
+    // f32 arithmetic.
+    case wasm_op_f32_abs:
+      WASM_UNOP(f32, fabsf(sp[-1].f32));
+    case wasm_op_f32_neg:
+      WASM_UNOP(f32, -sp[-1].f32);
+    case wasm_op_f32_ceil:
+      WASM_UNOP(f32, ceilf(sp[-1].f32));
+    case wasm_op_f32_floor:
+      WASM_UNOP(f32, floorf(sp[-1].f32));
+    case wasm_op_f32_trunc:
+      WASM_UNOP(f32, truncf(sp[-1].f32));
+    case wasm_op_f32_nearest:
+      WASM_UNOP(f32, nearbyintf(sp[-1].f32));
+    case wasm_op_f32_sqrt:
+      WASM_UNOP(f32, sqrtf(sp[-1].f32));
+    case wasm_op_f32_add:
+      WASM_BINOP(f32, sp[-2].f32 + sp[-1].f32);
+    case wasm_op_f32_sub:
+      WASM_BINOP(f32, sp[-2].f32 - sp[-1].f32);
+    case wasm_op_f32_mul:
+      WASM_BINOP(f32, sp[-2].f32 * sp[-1].f32);
+    case wasm_op_f32_div:
+      WASM_BINOP(f32, sp[-2].f32 / sp[-1].f32);
+    case wasm_op_f32_min:
+      WASM_BINOP(f32, wasm_f32_min(sp[-2].f32, sp[-1].f32));
+    case wasm_op_f32_max:
+      WASM_BINOP(f32, wasm_f32_max(sp[-2].f32, sp[-1].f32));
+    case wasm_op_f32_copysign:
+      WASM_BINOP(f32, copysignf(sp[-2].f32, sp[-1].f32));
+
+    // f64 arithmetic.
+    case wasm_op_f64_abs:
+      WASM_UNOP(f64, fabs(sp[-1].f64));
+    case wasm_op_f64_neg:
+      WASM_UNOP(f64, -sp[-1].f64);
+    case wasm_op_f64_ceil:
+      WASM_UNOP(f64, ceil(sp[-1].f64));
+    case wasm_op_f64_floor:
+      WASM_UNOP(f64, floor(sp[-1].f64));
+    case wasm_op_f64_trunc:
+      WASM_UNOP(f64, trunc(sp[-1].f64));
+    case wasm_op_f64_nearest:
+      WASM_UNOP(f64, nearbyint(sp[-1].f64));
+    case wasm_op_f64_sqrt:
+      WASM_UNOP(f64, sqrt(sp[-1].f64));
+    case wasm_op_f64_add:
+      WASM_BINOP(f64, sp[-2].f64 + sp[-1].f64);
+    case wasm_op_f64_sub:
+      WASM_BINOP(f64, sp[-2].f64 - sp[-1].f64);
+    case wasm_op_f64_mul:
+      WASM_BINOP(f64, sp[-2].f64 * sp[-1].f64);
+    case wasm_op_f64_div:
+      WASM_BINOP(f64, sp[-2].f64 / sp[-1].f64);
+    case wasm_op_f64_min:
+      WASM_BINOP(f64, wasm_f64_min(sp[-2].f64, sp[-1].f64));
+    case wasm_op_f64_max:
+      WASM_BINOP(f64, wasm_f64_max(sp[-2].f64, sp[-1].f64));
+    case wasm_op_f64_copysign:
+      WASM_BINOP(f64, copysign(sp[-2].f64, sp[-1].f64));
+
+    // Conversions.
+    case wasm_op_i32_wrap_i64:
+      WASM_UNOP(i32, (int32_t)U64(sp[-1].i64));
+    case wasm_op_i32_trunc_f32_s:
+      WASM_TRUNC_OP(i32, wasm_i32_trunc_f32_s, f32);
+    case wasm_op_i32_trunc_f32_u:
+      WASM_TRUNC_OP(i32, wasm_i32_trunc_f32_u, f32);
+    case wasm_op_i32_trunc_f64_s:
+      WASM_TRUNC_OP(i32, wasm_i32_trunc_f64_s, f64);
+    case wasm_op_i32_trunc_f64_u:
+      WASM_TRUNC_OP(i32, wasm_i32_trunc_f64_u, f64);
+    case wasm_op_i64_extend_i32_s:
+      WASM_UNOP(i64, (int64_t)sp[-1].i32);
+    case wasm_op_i64_extend_i32_u:
+      WASM_UNOP(i64, (int64_t)U32(sp[-1].i32));
+    case wasm_op_i64_trunc_f32_s:
+      WASM_TRUNC_OP(i64, wasm_i64_trunc_f32_s, f32);
+    case wasm_op_i64_trunc_f32_u:
+      WASM_TRUNC_OP(i64, wasm_i64_trunc_f32_u, f32);
+    case wasm_op_i64_trunc_f64_s:
+      WASM_TRUNC_OP(i64, wasm_i64_trunc_f64_s, f64);
+    case wasm_op_i64_trunc_f64_u:
+      WASM_TRUNC_OP(i64, wasm_i64_trunc_f64_u, f64);
+    case wasm_op_f32_convert_i32_s:
+      WASM_UNOP(f32, (float)sp[-1].i32);
+    case wasm_op_f32_convert_i32_u:
+      WASM_UNOP(f32, (float)U32(sp[-1].i32));
+    case wasm_op_f32_convert_i64_s:
+      WASM_UNOP(f32, (float)sp[-1].i64);
+    case wasm_op_f32_convert_i64_u:
+      WASM_UNOP(f32, (float)U64(sp[-1].i64));
+    case wasm_op_f32_demote_f64:
+      WASM_UNOP(f32, (float)sp[-1].f64);
+    case wasm_op_f64_convert_i32_s:
+      WASM_UNOP(f64, (double)sp[-1].i32);
+    case wasm_op_f64_convert_i32_u:
+      WASM_UNOP(f64, (double)U32(sp[-1].i32));
+    case wasm_op_f64_convert_i64_s:
+      WASM_UNOP(f64, (double)sp[-1].i64);
+    case wasm_op_f64_convert_i64_u:
+      WASM_UNOP(f64, (double)U64(sp[-1].i64));
+    case wasm_op_f64_promote_f32:
+      WASM_UNOP(f64, (double)sp[-1].f32);
+
+    // Reinterpretations only change the static type.
+    case wasm_op_i32_reinterpret_f32:
+    case wasm_op_f32_reinterpret_i32:
+    case wasm_op_i64_reinterpret_f64:
+    case wasm_op_f64_reinterpret_i64:
+      break;
+
+    // Sign extension.
+    case wasm_op_i32_extend8_s:
+      WASM_UNOP(i32, (int8_t)sp[-1].i32);
+    case wasm_op_i32_extend16_s:
+      WASM_UNOP(i32, (int16_t)sp[-1].i32);
+    case wasm_op_i64_extend8_s:
+      WASM_UNOP(i64, (int8_t)sp[-1].i64);
+    case wasm_op_i64_extend16_s:
+      WASM_UNOP(i64, (int16_t)sp[-1].i64);
+    case wasm_op_i64_extend32_s:
+      WASM_UNOP(i64, (int32_t)sp[-1].i64);
+
+    // Saturating conversions.
+    case wasm_op_i32_trunc_sat_f32_s:
+      WASM_UNOP(i32, wasm_i32_trunc_sat_f32_s(sp[-1].f32));
+    case wasm_op_i32_trunc_sat_f32_u:
+      WASM_UNOP(i32, (int32_t)wasm_i32_trunc_sat_f32_u(sp[-1].f32));
+    case wasm_op_i32_trunc_sat_f64_s:
+      WASM_UNOP(i32, wasm_i32_trunc_sat_f64_s(sp[-1].f64));
+    case wasm_op_i32_trunc_sat_f64_u:
+      WASM_UNOP(i32, (int32_t)wasm_i32_trunc_sat_f64_u(sp[-1].f64));
+    case wasm_op_i64_trunc_sat_f32_s:
+      WASM_UNOP(i64, wasm_i64_trunc_sat_f32_s(sp[-1].f32));
+    case wasm_op_i64_trunc_sat_f32_u:
+      WASM_UNOP(i64, (int64_t)wasm_i64_trunc_sat_f32_u(sp[-1].f32));
+    case wasm_op_i64_trunc_sat_f64_s:
+      WASM_UNOP(i64, wasm_i64_trunc_sat_f64_s(sp[-1].f64));
+    case wasm_op_i64_trunc_sat_f64_u:
+      WASM_UNOP(i64, (int64_t)wasm_i64_trunc_sat_f64_u(sp[-1].f64));
+
+    // Register forms.
+    case wasm_op_reg_copy:
+      fp[ip->b.reg.dst] = fp[ip->b.reg.x];
+      sp = fp + ip->b.reg.sp;
+      break;
+    case wasm_op_reg_const:
+      fp[ip->b.reg.dst].i32 = (int32_t)ip->a;
+      sp = fp + ip->b.reg.sp;
+      break;
+    case wasm_op_reg_i32_eqz:
+      fp[ip->b.reg.dst].i32 = fp[ip->b.reg.x].i32 == 0;
+      sp = fp + ip->b.reg.sp;
+      break;
+#define WASM_REG_I32_CASES(name, result, commutes, expr)                       \
+  case wasm_op_reg_##name:                                                     \
+    x = fp[ip->b.reg.x].i32;                                                   \
+    y = fp[ip->b.reg.y].i32;                                                   \
+    fp[ip->b.reg.dst].result = (expr);                                         \
+    sp = fp + ip->b.reg.sp;                                                    \
+    break;                                                                     \
+  case wasm_op_reg_##name##_imm:                                               \
+    x = fp[ip->b.reg.x].i32;                                                   \
+    y = (int32_t)ip->a;                                                        \
+    fp[ip->b.reg.dst].result = (expr);                                         \
+    sp = fp + ip->b.reg.sp;                                                    \
+    break;
+      WASM_REG_I32_BINOPS(WASM_REG_I32_CASES)
+#undef WASM_REG_I32_CASES
+#define WASM_REG_I64_CASES(name, result, commutes, expr)                       \
+  case wasm_op_reg_##name:                                                     \
+    x = fp[ip->b.reg.x].i64;                                                   \
+    y = fp[ip->b.reg.y].i64;                                                   \
+    fp[ip->b.reg.dst].result = (expr);                                         \
+    sp = fp + ip->b.reg.sp;                                                    \
+    break;
+      WASM_REG_I64_BINOPS(WASM_REG_I64_CASES)
+#undef WASM_REG_I64_CASES
+
+    default:
+      // SIMD and atomic instructions are executed out of line so that their
+      // temporaries don't grow the frame of every recursive call and don't
+      // slow down the dispatch of the scalar instructions.
+      if (ip->op >= wasm_opcode_prefix_fd &&
+          ip->op < wasm_opcode_prefix_fd + 0x100) {
+        sp = wasm_exec_simd(instance, ip, sp);
+        if (sp == NULL) {
+          trap = wasm_trap_memory_out_of_bounds;
+          goto end;
+        }
+        // Constants and shuffles are followed by a data instruction.
+        ip += ip->op == wasm_op_v128_const || ip->op == wasm_op_i8x16_shuffle;
+        break;
+      }
+      if (ip->op >= wasm_opcode_prefix_fe) {
+        sp = wasm_exec_atomic(instance, ip, sp, &trap);
+        if (sp == NULL) {
+          goto end;
+        }
+        break;
+      }
+      // The compiler only emits supported instructions.
+      assert(false);
+      trap = wasm_trap_unreachable;
+      goto end;
+    }
+
+    ip++;
+  }
+
+end:
+  // Traps unwind all calls of this activation.
+  instance->call_depth = call_depth;
+#ifdef WASM_DISPATCH_COUNTING
+  instance->dispatch_count += dispatches;
+#endif
+  return trap;
+}
+
+// Executes a SIMD instruction. Returns the new stack pointer or NULL if a
+// memory access is out of bounds.
+static __attribute__((noinline)) wasm_value *
+wasm_exec_simd(wasm_instance *instance, wasm_instr *ip, wasm_value *sp) {
+  enum wasm_trap trap;
+
+  switch (ip->op) {
+  // The 16 bytes of a constant and the lanes of a shuffle are split between
+  // the instruction and the following data instruction.
+  case wasm_op_v128_const:
+    sp->v128.i64[0] = ip[0].b.i64;
+    sp->v128.i64[1] = ip[1].b.i64;
+    sp++;
+    break;
+
+  case wasm_op_i8x16_shuffle: {
+    wasm_v128 lanes;
+    lanes.i64[0] = ip[0].b.i64;
+    lanes.i64[1] = ip[1].b.i64;
+    sp[-2].v128 = wasm_simd_i8x16_shuffle(sp[-2].v128, sp[-1].v128, lanes);
+    sp--;
+  } break;
+
+  case wasm_op_v128_load:
+    WASM_SIMD_LOAD(16, v);
+  case wasm_op_v128_load8x8_s:
+    WASM_SIMD_LOAD(8, wasm_simd_i16x8_extend_low_i8x16_s(v));
+  case wasm_op_v128_load8x8_u:
+    WASM_SIMD_LOAD(8, wasm_simd_i16x8_extend_low_i8x16_u(v));
+  case wasm_op_v128_load16x4_s:
+    WASM_SIMD_LOAD(8, wasm_simd_i32x4_extend_low_i16x8_s(v));
+  case wasm_op_v128_load16x4_u:
+    WASM_SIMD_LOAD(8, wasm_simd_i32x4_extend_low_i16x8_u(v));
+  case wasm_op_v128_load32x2_s:
+    WASM_SIMD_LOAD(8, wasm_simd_i64x2_extend_low_i32x4_s(v));
+  case wasm_op_v128_load32x2_u:
+    WASM_SIMD_LOAD(8, wasm_simd_i64x2_extend_low_i32x4_u(v));
+  case wasm_op_v128_load8_splat:
+    WASM_SIMD_LOAD(1, wasm_simd_i8x16_splat(v.u8[0]));
+  case wasm_op_v128_load16_splat:
+    WASM_SIMD_LOAD(2, wasm_simd_i16x8_splat(v.u16[0]));
+  case wasm_op_v128_load32_splat:
+    WASM_SIMD_LOAD(4, wasm_simd_i32x4_splat(v.i32[0]));
+  case wasm_op_v128_load64_splat:
+    WASM_SIMD_LOAD(8, wasm_simd_i64x2_splat(v.i64[0]));
+  case wasm_op_v128_load32_zero:
+    WASM_SIMD_LOAD(4, v);
+  case wasm_op_v128_load64_zero:
+    WASM_SIMD_LOAD(8, v);
+  case wasm_op_v128_store: {
+    sp--;
+    WASM_ADDRESS(16);
+    memcpy(memory, &sp[0].v128, 16);
+    sp--;
+  } break;
+  case wasm_op_v128_load8_lane:
+    WASM_SIMD_LOAD_LANE(u8);
+  case wasm_op_v128_load16_lane:
+    WASM_SIMD_LOAD_LANE(u16);
+  case wasm_op_v128_load32_lane:
+    WASM_SIMD_LOAD_LANE(u32);
+  case wasm_op_v128_load64_lane:
+    WASM_SIMD_LOAD_LANE(u64);
+  case wasm_op_v128_store8_lane:
+    WASM_SIMD_STORE_LANE(u8);
+  case wasm_op_v128_store16_lane:
+    WASM_SIMD_STORE_LANE(u16);
+  case wasm_op_v128_store32_lane:
+    WASM_SIMD_STORE_LANE(u32);
+  case wasm_op_v128_store64_lane:
+    WASM_SIMD_STORE_LANE(u64);
+
+  case wasm_op_i8x16_splat:
+    WASM_UNOP(v128, wasm_simd_i8x16_splat(sp[-1].i32));
+  case wasm_op_i16x8_splat:
+    WASM_UNOP(v128, wasm_simd_i16x8_splat(sp[-1].i32));
+  case wasm_op_i32x4_splat:
+    WASM_UNOP(v128, wasm_simd_i32x4_splat(sp[-1].i32));
+  case wasm_op_i64x2_splat:
+    WASM_UNOP(v128, wasm_simd_i64x2_splat(sp[-1].i64));
+  case wasm_op_f32x4_splat:
+    WASM_UNOP(v128, wasm_simd_f32x4_splat(sp[-1].f32));
+  case wasm_op_f64x2_splat:
+    WASM_UNOP(v128, wasm_simd_f64x2_splat(sp[-1].f64));
+
+  case wasm_op_i8x16_extract_lane_s:
+    WASM_UNOP(i32, sp[-1].v128.i8[ip->b.i32]);
+  case wasm_op_i8x16_extract_lane_u:
+    WASM_UNOP(i32, sp[-1].v128.u8[ip->b.i32]);
+  case wasm_op_i16x8_extract_lane_s:
+    WASM_UNOP(i32, sp[-1].v128.i16[ip->b.i32]);
+  case wasm_op_i16x8_extract_lane_u:
+    WASM_UNOP(i32, sp[-1].v128.u16[ip->b.i32]);
+  case wasm_op_i32x4_extract_lane:
+    WASM_UNOP(i32, sp[-1].v128.i32[ip->b.i32]);
+  case wasm_op_i64x2_extract_lane:
+    WASM_UNOP(i64, sp[-1].v128.i64[ip->b.i32]);
+  case wasm_op_f32x4_extract_lane:
+    WASM_UNOP(f32, sp[-1].v128.f32[ip->b.i32]);
+  case wasm_op_f64x2_extract_lane:
+    WASM_UNOP(f64, sp[-1].v128.f64[ip->b.i32]);
+  case wasm_op_i8x16_replace_lane:
+    WASM_SIMD_REPLACE_LANE(i8, (int8_t)sp[-1].i32);
+  case wasm_op_i16x8_replace_lane:
+    WASM_SIMD_REPLACE_LANE(i16, (int16_t)sp[-1].i32);
+  case wasm_op_i32x4_replace_lane:
+    WASM_SIMD_REPLACE_LANE(i32, sp[-1].i32);
+  case wasm_op_i64x2_replace_lane:
+    WASM_SIMD_REPLACE_LANE(i64, sp[-1].i64);
+  case wasm_op_f32x4_replace_lane:
+    WASM_SIMD_REPLACE_LANE(f32, sp[-1].f32);
+  case wasm_op_f64x2_replace_lane:
+    WASM_SIMD_REPLACE_LANE(f64, sp[-1].f64);
+
+  case wasm_op_v128_bitselect:
+    sp[-3].v128 =
+        wasm_simd_v128_bitselect(sp[-3].v128, sp[-2].v128, sp[-1].v128);
+    sp -= 2;
+    break;
+
+#define WASM_SIMD_UNOP_CASE(name)                                              \
+  case wasm_op_##name:                                                         \
+    WASM_UNOP(v128, wasm_simd_##name(sp[-1].v128));
+#define WASM_SIMD_BINOP_CASE(name)                                             \
+  case wasm_op_##name:                                                         \
+    WASM_BINOP(v128, wasm_simd_##name(sp[-2].v128, sp[-1].v128));
+#define WASM_SIMD_SHIFT_CASE(name)                                             \
+  case wasm_op_##name:                                                         \
+    WASM_BINOP(v128, wasm_simd_##name(sp[-2].v128, sp[-1].i32));
+#define WASM_SIMD_TEST_CASE(name)                                              \
+  case wasm_op_##name:                                                         \
+    WASM_UNOP(i32, wasm_simd_##name(sp[-1].v128));
+  WASM_SIMD_UNOPS(WASM_SIMD_UNOP_CASE)
+  WASM_SIMD_BINOPS(WASM_SIMD_BINOP_CASE)
+  WASM_SIMD_SHIFTS(WASM_SIMD_SHIFT_CASE)
+  WASM_SIMD_TESTS(WASM_SIMD_TEST_CASE)
+#undef WASM_SIMD_UNOP_CASE
+#undef WASM_SIMD_BINOP_CASE
+#undef WASM_SIMD_SHIFT_CASE
+#undef WASM_SIMD_TEST_CASE
+  default:
+    assert(false);
+    break;
+  }
+  return sp;
+
+end:
+  (void)trap;
+  return NULL;
+}
+
+// Atomic accesses trap if the address is not a multiple of the access size.
+// Linear memory is not declared `_Atomic` so the accessed bytes are cast to
+// atomic types of the same size, which are lock free on all supported hosts.
+#define WASM_ATOMIC_ADDRESS(type)                                              \
+  WASM_ADDRESS(sizeof(type));                                                  \
+  if (address % sizeof(type) != 0) {                                           \
+    trap = wasm_trap_unaligned_atomic;                                         \
+    goto end;                                                                  \
+  }                                                                            \
+  _Atomic type *atomic = (_Atomic type *)memory
+#define WASM_ATOMIC_LOAD(field, type, result_type)                             \
+  {                                                                            \
+    WASM_ATOMIC_ADDRESS(type);                                                 \
+    sp[-1].field = (result_type)atomic_load(atomic);                           \
+  }                                                                            \
+  break
+#define WASM_ATOMIC_STORE(field, type)                                         \
+  {                                                                            \
+    sp--;                                                                      \
+    WASM_ATOMIC_ADDRESS(type);                                                 \
+    atomic_store(atomic, (type)sp[0].field);                                   \
+    sp--;                                                                      \
+  }                                                                            \
+  break
+// Read-modify-write instructions return the old value.
+#define WASM_ATOMIC_RMW(field, type, result_type, func)                        \
+  {                                                                            \
+    sp--;                                                                      \
+    WASM_ATOMIC_ADDRESS(type);                                                 \
+    sp[-1].field = (result_type)func(atomic, (type)sp[0].field);               \
+  }                                                                            \
+  break
+#define WASM_ATOMIC_CMPXCHG(field, type, result_type)                          \
+  {                                                                            \
+    sp -= 2;                                                                   \
+    WASM_ATOMIC_ADDRESS(type);                                                 \
+    type expected = (type)sp[0].field;                                         \
+    atomic_compare_exchange_strong(atomic, &expected, (type)sp[1].field);      \
+    sp[-1].field = (result_type)expected;                                      \
+  }                                                                            \
+  break
+// All 7 access sizes of a read-modify-write operation.
+#define WASM_ATOMIC_RMW_CASES(name, func)                                      \
+  case wasm_op_i32_atomic_rmw_##name:                                          \
+    WASM_ATOMIC_RMW(i32, uint32_t, int32_t, func);                             \
+  case wasm_op_i64_atomic_rmw_##name:                                          \
+    WASM_ATOMIC_RMW(i64, uint64_t, int64_t, func);                             \
+  case wasm_op_i32_atomic_rmw8_##name##_u:                                     \
+    WASM_ATOMIC_RMW(i32, uint8_t, int32_t, func);                              \
+  case wasm_op_i32_atomic_rmw16_##name##_u:                                    \
+    WASM_ATOMIC_RMW(i32, uint16_t, int32_t, func);                             \
+  case wasm_op_i64_atomic_rmw8_##name##_u:                                     \
+    WASM_ATOMIC_RMW(i64, uint8_t, int64_t, func);                              \
+  case wasm_op_i64_atomic_rmw16_##name##_u:                                    \
+    WASM_ATOMIC_RMW(i64, uint16_t, int64_t, func);                             \
+  case wasm_op_i64_atomic_rmw32_##name##_u:                                    \
+    WASM_ATOMIC_RMW(i64, uint32_t, int64_t, func);
+
+// Executes an atomic instruction. Returns the new stack pointer or NULL if the
+// instruction trapped.
+static __attribute__((noinline)) wasm_value *
+wasm_exec_atomic(wasm_instance *instance, wasm_instr *ip, wasm_value *sp,
+                 enum wasm_trap *trap_out) {
+  enum wasm_trap trap;
+
+  switch (ip->op) {
+  case wasm_op_memory_atomic_notify: {
+    sp--;
+    WASM_ATOMIC_ADDRESS(uint32_t);
+    (void)atomic;
+    // Nobody can wait on a memory that isn't shared.
+    sp[-1].i32 = instance->shared_memory
+                     ? (int32_t)wasm_atomic_notify(memory, U32(sp[0].i32))
+                     : 0;
+  } break;
+
+  case wasm_op_memory_atomic_wait32: {
+    sp -= 2;
+    WASM_ATOMIC_ADDRESS(uint32_t);
+    if (instance->shared_memory == NULL) {
+      trap = wasm_trap_expected_shared_memory;
+      goto end;
+    }
+    (void)atomic;
+    sp[-1].i32 =
+        (int32_t)wasm_atomic_wait32(memory, U32(sp[0].i32), sp[1].i64);
+  } break;
+
+  case wasm_op_memory_atomic_wait64: {
+    sp -= 2;
+    WASM_ATOMIC_ADDRESS(uint64_t);
+    if (instance->shared_memory == NULL) {
+      trap = wasm_trap_expected_shared_memory;
+      goto end;
+    }
+    (void)atomic;
+    sp[-1].i32 =
+        (int32_t)wasm_atomic_wait64(memory, U64(sp[0].i64), sp[1].i64);
+  } break;
+
+  case wasm_op_atomic_fence:
+    atomic_thread_fence(memory_order_seq_cst);
+    break;
+
+  case wasm_op_i32_atomic_load:
+    WASM_ATOMIC_LOAD(i32, uint32_t, int32_t);
+  case wasm_op_i64_atomic_load:
+    WASM_ATOMIC_LOAD(i64, uint64_t, int64_t);
+  case wasm_op_i32_atomic_load8_u:
+    WASM_ATOMIC_LOAD(i32, uint8_t, int32_t);
+  case wasm_op_i32_atomic_load16_u:
+    WASM_ATOMIC_LOAD(i32, uint16_t, int32_t);
+  case wasm_op_i64_atomic_load8_u:
+    WASM_ATOMIC_LOAD(i64, uint8_t, int64_t);
+  case wasm_op_i64_atomic_load16_u:
+    WASM_ATOMIC_LOAD(i64, uint16_t, int64_t);
+  case wasm_op_i64_atomic_load32_u:
+    WASM_ATOMIC_LOAD(i64, uint32_t, int64_t);
+
+  case wasm_op_i32_atomic_store:
+    WASM_ATOMIC_STORE(i32, uint32_t);
+  case wasm_op_i64_atomic_store:
+    WASM_ATOMIC_STORE(i64, uint64_t);
+  case wasm_op_i32_atomic_store8:
+    WASM_ATOMIC_STORE(i32, uint8_t);
+  case wasm_op_i32_atomic_store16:
+    WASM_ATOMIC_STORE(i32, uint16_t);
+  case wasm_op_i64_atomic_store8:
+    WASM_ATOMIC_STORE(i64, uint8_t);
+  case wasm_op_i64_atomic_store16:
+    WASM_ATOMIC_STORE(i64, uint16_t);
+  case wasm_op_i64_atomic_store32:
+    WASM_ATOMIC_STORE(i64, uint32_t);
+
+  WASM_ATOMIC_RMW_CASES(add, atomic_fetch_add)
+  WASM_ATOMIC_RMW_CASES(sub, atomic_fetch_sub)
+  WASM_ATOMIC_RMW_CASES(and, atomic_fetch_and)
+  WASM_ATOMIC_RMW_CASES(or, atomic_fetch_or)
+  WASM_ATOMIC_RMW_CASES(xor, atomic_fetch_xor)
+  WASM_ATOMIC_RMW_CASES(xchg, atomic_exchange)
+
+  case wasm_op_i32_atomic_rmw_cmpxchg:
+    WASM_ATOMIC_CMPXCHG(i32, uint32_t, int32_t);
+  case wasm_op_i64_atomic_rmw_cmpxchg:
+    WASM_ATOMIC_CMPXCHG(i64, uint64_t, int64_t);
+  case wasm_op_i32_atomic_rmw8_cmpxchg_u:
+    WASM_ATOMIC_CMPXCHG(i32, uint8_t, int32_t);
+  case wasm_op_i32_atomic_rmw16_cmpxchg_u:
+    WASM_ATOMIC_CMPXCHG(i32, uint16_t, int32_t);
+  case wasm_op_i64_atomic_rmw8_cmpxchg_u:
+    WASM_ATOMIC_CMPXCHG(i64, uint8_t, int64_t);
+  case wasm_op_i64_atomic_rmw16_cmpxchg_u:
+    WASM_ATOMIC_CMPXCHG(i64, uint16_t, int64_t);
+  case wasm_op_i64_atomic_rmw32_cmpxchg_u:
+    WASM_ATOMIC_CMPXCHG(i64, uint32_t, int64_t);
+
+  default:
+    assert(false);
+    break;
+  }
+  return sp;
+
+end:
+  *trap_out = trap;
+  return NULL;
+}
+
+#undef WASM_ATOMIC_ADDRESS
+#undef WASM_ATOMIC_LOAD
+#undef WASM_ATOMIC_STORE
+#undef WASM_ATOMIC_RMW
+#undef WASM_ATOMIC_CMPXCHG
+#undef WASM_ATOMIC_RMW_CASES
+
+#undef WASM_UNOP
+#undef WASM_BINOP
+#undef A32
+#undef WASM_INDIRECT_CALLEE
+#undef B32
+#undef A64
+#undef B64
+#undef U32
+#undef U64
+#undef WASM_TRUNC_OP
+#undef WASM_ADDRESS
+#undef WASM_LOAD
+#undef WASM_STORE
+#undef WASM_SIMD_LOAD
+#undef WASM_SIMD_LOAD_LANE
+#undef WASM_SIMD_STORE_LANE
+#undef WASM_SIMD_REPLACE_LANE
+
+static enum wasm_trap wasm_call_host(wasm_instance *instance, wasm_func *func,
+                                     wasm_value *args) {
+  // Nested calls from the host into wasm start above the arguments.
+  wasm_value *stack_top = instance->stack_top;
+  instance->stack_top = args + func->type->param_count;
+  enum wasm_trap trap = func->host->trampoline(func->host, instance, args);
+  instance->stack_top = stack_top;
+  return trap;
+}
+
+static enum wasm_trap wasm_call(wasm_instance *instance, wasm_func *func,
+                                wasm_value *args) {
+  if (func->host) {
+    return wasm_call_host(instance, func, args);
+  }
+  return wasm_exec(instance, func->compiled, args);
+}
+
+enum wasm_trap wasm_invoke(wasm_instance *instance, uint32_t funcidx,
+                           const wasm_value *args, wasm_value *results) {
+  wasm_module *module = instance->module;
+  if (funcidx >=
+      module->import_func_count + (uint32_t)wasm_vec_size(&module->funcs)) {
+    return wasm_trap_undefined_function;
+  }
+
+  wasm_func *func = &instance->funcs[funcidx];
+  size_t param_count = func->type->param_count;
+  wasm_value *fp = instance->stack_top;
+
+  if (fp + param_count + 1 > instance->stack_end) {
+    return wasm_trap_call_stack_exhausted;
+  }
+
+  if (param_count > 0) {
+    memcpy(fp, args, param_count * sizeof(wasm_value));
+  }
+  instance->trap = wasm_trap_none;
+
+  // Calls of host functions back into the instance are part of the outer call.
+  wasm_perf_stats *perf =
+      instance->call_depth == 0 ? wasm_get_perf_stats() : NULL;
+  wasm_perf_sample perf_start;
+  if (perf) {
+    wasm_perf_read(&perf_start);
+  }
+  enum wasm_trap trap = wasm_call(instance, func, fp);
+  if (perf) {
+    wasm_perf_add(&perf->invoke, &perf_start);
+    perf->invoke_count++;
+  }
+  if (trap == wasm_trap_none && func->type->result_count && results) {
+    *results = fp[0];
+  }
+
+  instance->trap = wasm_trap_none;
+  return trap;
+}
+
+// Evaluates a constant expression of a global initializer or a segment offset.
+static bool wasm_eval_const_expr(wasm_instance *instance, wasm_expr *expr,
+                                 wasm_value *out) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, expr->start, wasm_vec_size(expr));
+
+  unsigned char op;
+  if (!wasm_read(&reader, &op, 1)) {
+    return false;
+  }
+
+  memset(out, 0, sizeof(*out));
+  switch (op) {
+  case wasm_op_i32_const:
+    return wasm_read_leb_s32(&reader, &out->i32);
+  case wasm_op_i64_const:
+    return wasm_read_leb_s64(&reader, &out->i64);
+  case wasm_op_f32_const:
+    return wasm_read_f32(&reader, &out->f32);
+  case wasm_op_f64_const:
+    return wasm_read_f64(&reader, &out->f64);
+  case 0xFD: {
+    unsigned char sub;
+    return wasm_read(&reader, &sub, 1) && sub == 0x0C &&
+           wasm_read(&reader, out->v128.u8, 16);
+  }
+  case wasm_op_global_get: {
+    // Only imported globals can be referenced.
+    uint32_t globalidx;
+    if (!wasm_read_leb_u32_2(&reader, &globalidx) ||
+        globalidx >= instance->module->import_global_count) {
+      return false;
+    }
+    *out = instance->globals[globalidx];
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+static bool wasm_init_table(wasm_instance *instance) {
+  wasm_module *module = instance->module;
+
+  if (wasm_vec_size(&module->tables) > 0) {
+    wasm_limits *limits = wasm_vec_get(&module->tables, 0);
+    if (limits->min > 10000000) {
+      fprintf(stderr, "Table is too large.\n");
+      return false;
+    }
+
+    instance->table_size = limits->min;
+    instance->table = wasm_alloc_array(wasm_func *, limits->min + 1);
+    memset(instance->table, 0, limits->min * sizeof(wasm_func *));
+  }
+
+  instance->inline_caches =
+      wasm_alloc_array(wasm_inline_cache, module->indirect_call_count + 1);
+  memset(instance->inline_caches, 0,
+         module->indirect_call_count * sizeof(wasm_inline_cache));
+
+  // Copy the element segments into the table.
+  uint32_t func_count =
+      module->import_func_count + (uint32_t)wasm_vec_size(&module->funcs);
+  for (wasm_elem *elem = module->elems.start; elem != module->elems.end;
+       elem++) {
+    wasm_value offset;
+    if (elem->tableidx != 0 ||
+        !wasm_eval_const_expr(instance, &elem->offset, &offset)) {
+      fprintf(stderr, "Invalid element segment.\n");
+      return false;
+    }
+
+    uint32_t start = (uint32_t)offset.i32;
+    size_t size = wasm_vec_size(&elem->init);
+    if ((uint64_t)start + size > instance->table_size) {
+      fprintf(stderr, "Element segment does not fit into the table.\n");
+      return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      uint32_t funcidx = *wasm_vec_get(&elem->init, i);
+      if (funcidx >= func_count) {
+        fprintf(stderr, "Invalid function in element segment.\n");
+        return false;
+      }
+      instance->table[start + i] = &instance->funcs[funcidx];
+    }
+  }
+
+  return true;
+}
+
+// Only shared memories can be imported so that every instance can keep the
+// data pointer of its memory.
+static bool wasm_resolve_memory_import(wasm_instance *instance,
+                                       wasm_host_imports *imports,
+                                       wasm_import *import) {
+  const char *module_name =
+      wasm_module_name(instance->module, import->module_name);
+  const char *name = wasm_module_name(instance->module, import->name);
+  wasm_host_memory *host =
+      imports ? wasm_host_imports_find_memory(imports, module_name, name)
+              : NULL;
+  if (host == NULL) {
+    fprintf(stderr, "Unresolved import %s.%s.\n", module_name, name);
+    return false;
+  }
+
+  wasm_limits *limits = &import->desc.mem;
+  wasm_shared_memory *memory = host->memory;
+  size_t pages = atomic_load(&memory->size) / wasm_page_size;
+  if (!limits->is_shared || pages < limits->min ||
+      memory->max_pages > limits->max) {
+    fprintf(stderr, "Import %s.%s has incompatible limits.\n", module_name,
+            name);
+    return false;
+  }
+
+  wasm_retain_shared_memory(memory);
+  instance->shared_memory = memory;
+  return true;
+}
+
+static bool wasm_resolve_imports(wasm_instance *instance,
+                                 wasm_host_imports *imports) {
+  wasm_module *module = instance->module;
+  uint32_t funcidx = 0;
+
+  for (wasm_import *import = module->imports.start;
+       import != module->imports.end; import++) {
+    if (import->type == wasm_import_mem) {
+      if (!wasm_resolve_memory_import(instance, imports, import)) {
+        return false;
+      }
+      continue;
+    }
+
+    const char *module_name = wasm_module_name(module, import->module_name);
+    const char *name = wasm_module_name(module, import->name);
+    if (import->type != wasm_import_func) {
+      fprintf(stderr, "Importing %s.%s is not supported yet.\n", module_name,
+              name);
+      return false;
+    }
+
+    wasm_host_func *host =
+        imports ? wasm_host_imports_find(imports, module_name, name) : NULL;
+    if (host == NULL) {
+      fprintf(stderr, "Unresolved import %s.%s.\n", module_name, name);
+      return false;
+    }
+
+    wasm_func *func = &instance->funcs[funcidx++];
+    if (!wasm_function_type_equal(func->type, &host->type)) {
+      fprintf(stderr, "Import %s.%s has the wrong signature.\n", module_name,
+              name);
+      return false;
+    }
+    func->host = host;
+  }
+
+  return true;
+}
+
+static bool wasm_init_memory(wasm_instance *instance) {
+  wasm_module *module = instance->module;
+
+  if (wasm_vec_size(&module->mems) > 0) {
+    wasm_limits *limits = wasm_vec_get(&module->mems, 0);
+    if (limits->min > 65536) {
+      fprintf(stderr, "Memory is larger than 4GiB.\n");
+      return false;
+    }
+
+    if (limits->is_shared) {
+      instance->shared_memory =
+          wasm_create_shared_memory(limits->min, limits->max);
+      if (instance->shared_memory == NULL) {
+        return false;
+      }
+    }
+  }
+
+  if (instance->shared_memory) {
+    instance->memory = instance->shared_memory->data;
+    instance->memory_size = atomic_load(&instance->shared_memory->size);
+    instance->memory_max_pages = instance->shared_memory->max_pages;
+  } else if (wasm_vec_size(&module->mems) > 0) {
+    wasm_limits *limits = wasm_vec_get(&module->mems, 0);
+    instance->memory_size = (size_t)limits->min * wasm_page_size;
+    instance->memory_max_pages = limits->has_max ? limits->max : 65536;
+    instance->memory = wasm_calloc_n(instance->memory_size);
+    if (instance->memory == NULL) {
+      fprintf(stderr, "Failed to allocate memory.\n");
+      return false;
+    }
+  }
+
+  // Copy the active data segments into the memory. Only passive segments
+  // remain available for `memory.init`.
+  size_t data_count = wasm_vec_size(&module->datas);
+  instance->data_sizes = wasm_alloc_array(uint32_t, data_count + 1);
+
+  for (size_t i = 0; i < data_count; i++) {
+    wasm_data *data = wasm_vec_get(&module->datas, i);
+    instance->data_sizes[i] =
+        data->is_passive ? (uint32_t)wasm_vec_size(&data->init) : 0;
+    if (data->is_passive) {
+      continue;
+    }
+
+    wasm_value offset;
+    if (data->memidx != 0 ||
+        !wasm_eval_const_expr(instance, &data->offset, &offset)) {
+      fprintf(stderr, "Invalid data segment.\n");
+      return false;
+    }
+
+    size_t size = wasm_vec_size(&data->init);
+    uint32_t start = (uint32_t)offset.i32;
+    if ((uint64_t)start + size > instance->memory_size) {
+      fprintf(stderr, "Data segment does not fit into memory.\n");
+      return false;
+    }
+    if (size > 0) {
+      memcpy(instance->memory + start, data->init.start, size);
+    }
+  }
+
+  return true;
+}
+
+static wasm_instance *wasm_create_instance(wasm_module *module,
+                                           wasm_host_imports *imports);
+
+wasm_instance *wasm_instantiate(wasm_module *module,
+                                wasm_host_imports *imports) {
+  wasm_perf_stats *perf = wasm_get_perf_stats();
+  if (perf == NULL) {
+    return wasm_create_instance(module, imports);
+  }
+
+  wasm_perf_sample start;
+  wasm_perf_read(&start);
+  wasm_instance *instance = wasm_create_instance(module, imports);
+  wasm_perf_add(&perf->instantiate, &start);
+  return instance;
+}
+
+static wasm_instance *wasm_create_instance(wasm_module *module,
+                                           wasm_host_imports *imports) {
+  wasm_perf_stats *perf = wasm_get_perf_stats();
+  wasm_perf_sample perf_start;
+  if (perf) {
+    wasm_perf_read(&perf_start);
+  }
+  if (!wasm_compile_module(module)) {
+    return NULL;
+  }
+  if (perf) {
+    wasm_perf_add(&perf->compile, &perf_start);
+  }
+  wasm_simd_init();
+
+  wasm_instance *instance = wasm_alloc(wasm_instance);
+  uint32_t func_count =
+      module->import_func_count + (uint32_t)wasm_vec_size(&module->funcs);
+  uint32_t global_count =
+      module->import_global_count + (uint32_t)wasm_vec_size(&module->globals);
+
+  instance->module = module;
+  instance->funcs = wasm_alloc_array(wasm_func, func_count + 1);
+  instance->globals = wasm_alloc_array(wasm_value, global_count + 1);
+  instance->table = NULL;
+  instance->table_size = 0;
+  instance->inline_caches = NULL;
+  instance->memory = NULL;
+  instance->memory_size = 0;
+  instance->memory_max_pages = 0;
+  instance->shared_memory = NULL;
+  instance->data_sizes = NULL;
+  instance->stack = wasm_reserve_n(wasm_stack_size * sizeof(wasm_value));
+  instance->stack_top = instance->stack;
+  instance->stack_end = instance->stack + wasm_stack_size;
+  instance->frames = NULL;
+  instance->call_depth = 0;
+  instance->max_call_depth = 0;
+  instance->fuel = INT64_MAX;
+  instance->checkpoint = NULL;
+  instance->checkpoint_user = NULL;
+  instance->trap = wasm_trap_none;
+#ifdef WASM_DISPATCH_COUNTING
+  instance->dispatch_count = 0;
+#endif
+
+  if (instance->stack == NULL ||
+      !wasm_instance_set_max_call_depth(instance, wasm_max_call_depth)) {
+    fprintf(stderr, "Failed to reserve the stack.\n");
+    goto error;
+  }
+
+  for (uint32_t i = 0; i < func_count; i++) {
+    wasm_func *func = &instance->funcs[i];
+    wasm_typeidx typeidx = wasm_module_func_typeidx(module, i);
+    func->type = wasm_vec_get(&module->function_types, typeidx);
+    func->type_id = wasm_module_type_id(module, typeidx);
+    func->host = NULL;
+    func->compiled =
+        i < module->import_func_count
+            ? NULL
+            : wasm_vec_get(&module->codes, i - module->import_func_count)
+                  ->compiled;
+  }
+
+  if (!wasm_resolve_imports(instance, imports)) {
+    goto error;
+  }
+
+  // Globals.
+  for (size_t i = 0; i < wasm_vec_size(&module->globals); i++) {
+    wasm_global *global = wasm_vec_get(&module->globals, i);
+    if (!wasm_eval_const_expr(instance, &global->initializer,
+                              &instance->globals[module->import_global_count +
+                                                 i])) {
+      fprintf(stderr, "Invalid global initializer.\n");
+      goto error;
+    }
+  }
+
+  if (!wasm_init_table(instance) || !wasm_init_memory(instance)) {
+    goto error;
+  }
+
+  if (module->has_start) {
+    if (module->start >= func_count) {
+      fprintf(stderr, "Invalid start function.\n");
+      goto error;
+    }
+
+    enum wasm_trap trap = wasm_invoke(instance, module->start, NULL, NULL);
+    if (trap) {
+      fprintf(stderr, "Start function trapped: %s\n", wasm_trap_to_str(trap));
+      goto error;
+    }
+  }
+
+  return instance;
+
+error:
+  wasm_free_instance(instance);
+  return NULL;
+}
+
+bool wasm_instance_set_max_call_depth(wasm_instance *instance,
+                                      uint32_t depth) {
+  // Only the frames that are used take up memory.
+  wasm_frame *frames = wasm_reserve_n(depth * sizeof(wasm_frame));
+  if (frames == NULL) {
+    return false;
+  }
+  wasm_free_reserved(instance->frames,
+                     instance->max_call_depth * sizeof(wasm_frame));
+  instance->frames = frames;
+  instance->max_call_depth = depth;
+  return true;
+}
+
+void wasm_free_instance(wasm_instance *instance) {
+  if (instance) {
+    wasm_free(instance->funcs);
+    wasm_free(instance->globals);
+    wasm_free(instance->table);
+    wasm_free(instance->inline_caches);
+    if (instance->shared_memory) {
+      wasm_release_shared_memory(instance->shared_memory);
+    } else {
+      wasm_free(instance->memory);
+    }
+    wasm_free(instance->data_sizes);
+    wasm_free_reserved(instance->stack, wasm_stack_size * sizeof(wasm_value));
+    wasm_free_reserved(instance->frames,
+                       instance->max_call_depth * sizeof(wasm_frame));
+    wasm_free(instance);
+  }
+}
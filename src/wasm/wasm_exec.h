@@ -0,0 +1,165 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include "wasm/wasm_simd.h"
+#include <stdint.h>
+
+// A value on the value stack. The type is known statically so it is not stored.
+typedef union {
+  int32_t i32;
+  int64_t i64;
+  float f32;
+  double f64;
+  wasm_v128 v128;
+} wasm_value;
+
+// Reasons why the execution was aborted.
+enum wasm_trap {
+  wasm_trap_none,
+  wasm_trap_unreachable,
+  wasm_trap_memory_out_of_bounds,
+  wasm_trap_integer_divide_by_zero,
+  wasm_trap_integer_overflow,
+  wasm_trap_invalid_conversion,
+  wasm_trap_call_stack_exhausted,
+  // Table index of `call_indirect` is out of bounds.
+  wasm_trap_undefined_element,
+  wasm_trap_uninitialized_element,
+  wasm_trap_indirect_call_type_mismatch,
+  // A host function failed.
+  wasm_trap_host,
+  // The module asked to terminate, e.g. with the wasi `proc_exit`.
+  wasm_trap_exit,
+  // The address of an atomic instruction is not naturally aligned.
+  wasm_trap_unaligned_atomic,
+  // `memory.atomic.wait` was used on a memory that isn't shared.
+  wasm_trap_expected_shared_memory,
+  // The checkpoint hook of the instance aborted the execution.
+  wasm_trap_interrupted,
+  // `wasm_invoke` was called with an index that isn't a function.
+  wasm_trap_undefined_function,
+};
+
+const char *wasm_trap_to_str(enum wasm_trap trap);
+
+struct wasm_host_func;
+struct wasm_host_imports;
+struct wasm_shared_memory;
+struct wasm_compiled_func;
+
+// A function in the function index space of an instance.
+typedef struct {
+  wasm_function_type *type;
+  // Canonical id of `type`, see `wasm_module.type_ids`.
+  uint32_t type_id;
+  // Set for imported functions.
+  const struct wasm_host_func *host;
+  // Set for functions that are defined in the module.
+  struct wasm_compiled_func *compiled;
+} wasm_func;
+
+// Monomorphic inline cache of a `call_indirect` call site. It remembers the
+// last table index and the function that passed the checks for it.
+typedef struct {
+  uint32_t index;
+  wasm_func *target;
+} wasm_inline_cache;
+
+// Size of the wasm page in bytes.
+#define wasm_page_size 65536
+
+// Number of value stack slots of an instance. The stack is reserved up front
+// but only the touched part takes up physical memory.
+#define wasm_stack_size (1024 * 1024)
+// Default maximum number of nested calls, see
+// `wasm_instance_set_max_call_depth`.
+#define wasm_max_call_depth 10000
+
+struct wasm_frame;
+
+struct wasm_instance;
+
+// Called when an instance used up its fuel. The hook has to refill `fuel`. It
+// can suspend the execution, e.g. to run other instances on the thread, and
+// returns false to abort it with `wasm_trap_interrupted`.
+typedef bool (*wasm_checkpoint_hook)(struct wasm_instance *instance);
+
+// The runtime state of a module.
+typedef struct wasm_instance {
+  wasm_module *module;
+  // Storing one entry for each function including the imported ones.
+  wasm_func *funcs;
+  wasm_value *globals;
+
+  // The table. Entries are NULL if they are not initialized.
+  wasm_func **table;
+  uint32_t table_size;
+  // One cache for each `call_indirect` in the module.
+  wasm_inline_cache *inline_caches;
+
+  // Linear memory. Values are stored in little endian.
+  unsigned char *memory;
+  // Size of the memory in bytes.
+  size_t memory_size;
+  uint32_t memory_max_pages;
+  // Set if the memory is shared. `memory` and `memory_size` cache its data and
+  // size. Other threads can grow it so the size is reloaded before an access
+  // is reported as out of bounds.
+  struct wasm_shared_memory *shared_memory;
+  // Remaining size of every data segment. Dropped segments and active ones
+  // after the instantiation have size 0.
+  uint32_t *data_sizes;
+
+  // Value stack for locals and operands of all active calls. `stack_top` is
+  // the first free slot when no wasm code is running.
+  wasm_value *stack;
+  wasm_value *stack_top;
+  wasm_value *stack_end;
+  // Where each active call returns to. Calls between wasm functions don't
+  // use the native stack, so the recursion depth is only limited by
+  // `max_call_depth` and the size of the value stack.
+  struct wasm_frame *frames;
+  uint32_t call_depth;
+  uint32_t max_call_depth;
+
+  // Decremented at every call and backward branch. `checkpoint` is called
+  // when it reaches zero. It starts at INT64_MAX so that instances without a
+  // hook never stop.
+  int64_t fuel;
+  wasm_checkpoint_hook checkpoint;
+  void *checkpoint_user;
+
+  // Set by host functions to abort the execution.
+  enum wasm_trap trap;
+
+#ifdef WASM_DISPATCH_COUNTING
+  // Number of instructions the interpreter dispatched.
+  uint64_t dispatch_count;
+#endif
+} wasm_instance;
+
+// Creates an instance of `module`. Function and memory imports are resolved
+// against `imports` which may be NULL. The module must outlive the instance.
+// Returns NULL if an import can't be resolved or if the start function traps.
+//
+// Instances have to be created on one thread but each of them can then run on
+// its own thread. Instances that import the same shared memory see each
+// other's stores.
+wasm_instance *wasm_instantiate(wasm_module *module,
+                                struct wasm_host_imports *imports);
+void wasm_free_instance(wasm_instance *instance);
+
+// Calls the function `funcidx`. `args` has to match the parameters of the
+// function and the result is stored in `results` if there is one. Returns
+// `wasm_trap_undefined_function` if the module has no function `funcidx`.
+enum wasm_trap wasm_invoke(wasm_instance *instance, uint32_t funcidx,
+                           const wasm_value *args, wasm_value *results);
+
+// Limits the number of nested calls. Deeper calls trap with
+// `wasm_trap_call_stack_exhausted`. Must not be called while the instance
+// runs. Returns false if the frames can't be reserved, the old limit stays.
+bool wasm_instance_set_max_call_depth(wasm_instance *instance,
+                                      uint32_t depth);
+
+// Aborts the execution after the current host function returns.
+void wasm_instance_trap(wasm_instance *instance, enum wasm_trap trap);
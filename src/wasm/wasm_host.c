@@ -0,0 +1,304 @@
+#include "wasm/wasm_host.h"
+
+#include "wasm/wasm_common.h"
+#include <stdio.h>
+#include <string.h>
+
+// Trampolines for typed native functions. One trampoline is generated for
+// every signature with up to 3 parameters. It loads the arguments from the
+// value stack into C parameters so they are passed in registers and stores
+// the result back on the stack.
+
+#define WASM_HOST_CTYPE_void void
+#define WASM_HOST_CTYPE_i32 int32_t
+#define WASM_HOST_CTYPE_i64 int64_t
+#define WASM_HOST_CTYPE_f32 float
+#define WASM_HOST_CTYPE_f64 double
+
+// Every type has a code which is used to index the trampoline table.
+#define WASM_HOST_CODE_void 0
+#define WASM_HOST_CODE_i32 1
+#define WASM_HOST_CODE_i64 2
+#define WASM_HOST_CODE_f32 3
+#define WASM_HOST_CODE_f64 4
+
+#define WASM_HOST_STORE_void(call) ((void)args, call)
+#define WASM_HOST_STORE_i32(call) (args[0].i32 = call)
+#define WASM_HOST_STORE_i64(call) (args[0].i64 = call)
+#define WASM_HOST_STORE_f32(call) (args[0].f32 = call)
+#define WASM_HOST_STORE_f64(call) (args[0].f64 = call)
+
+#define WASM_HOST_INDEX(r, a, b, c) ((r)*125 + (a)*25 + (b)*5 + (c))
+#define wasm_host_trampoline_count WASM_HOST_INDEX(5, 0, 0, 0)
+
+#define WASM_HOST_TRAMPOLINE(name, r, native_params, native_args)            \
+  static enum wasm_trap name(const wasm_host_func *func,                      \
+                             wasm_instance *instance, wasm_value *args) {     \
+    typedef WASM_HOST_CTYPE_##r(*native_t) native_params;                     \
+    WASM_HOST_STORE_##r(((native_t)func->native) native_args);                \
+    return instance->trap;                                                     \
+  }
+
+#define WASM_HOST_TRAMPOLINE_0(r)                                              \
+  WASM_HOST_TRAMPOLINE(wasm_host_trampoline_##r, r,                            \
+                       (wasm_instance *, void *), (instance, func->user))
+#define WASM_HOST_TRAMPOLINE_1(r, a)                                           \
+  WASM_HOST_TRAMPOLINE(                                                        \
+      wasm_host_trampoline_##r##_##a, r,                                       \
+      (wasm_instance *, void *, WASM_HOST_CTYPE_##a),                          \
+      (instance, func->user, args[0].a))
+#define WASM_HOST_TRAMPOLINE_2(r, a, b)                                        \
+  WASM_HOST_TRAMPOLINE(                                                        \
+      wasm_host_trampoline_##r##_##a##_##b, r,                                 \
+      (wasm_instance *, void *, WASM_HOST_CTYPE_##a, WASM_HOST_CTYPE_##b),     \
+      (instance, func->user, args[0].a, args[1].b))
+#define WASM_HOST_TRAMPOLINE_3(r, a, b, c)                                     \
+  WASM_HOST_TRAMPOLINE(wasm_host_trampoline_##r##_##a##_##b##_##c, r,          \
+                       (wasm_instance *, void *, WASM_HOST_CTYPE_##a,          \
+                        WASM_HOST_CTYPE_##b, WASM_HOST_CTYPE_##c),             \
+                       (instance, func->user, args[0].a, args[1].b,            \
+                        args[2].c))
+
+// Every level of the signature needs its own macro since macros can't expand
+// recursively.
+#define WASM_HOST_FOR_EACH_RESULT(X) X(void) X(i32) X(i64) X(f32) X(f64)
+#define WASM_HOST_FOR_EACH_PARAM_1(X, ...)                                     \
+  X(__VA_ARGS__, i32) X(__VA_ARGS__, i64) X(__VA_ARGS__, f32) X(__VA_ARGS__, f64)
+#define WASM_HOST_FOR_EACH_PARAM_2(X, ...)                                     \
+  X(__VA_ARGS__, i32) X(__VA_ARGS__, i64) X(__VA_ARGS__, f32) X(__VA_ARGS__, f64)
+#define WASM_HOST_FOR_EACH_PARAM_3(X, ...)                                     \
+  X(__VA_ARGS__, i32) X(__VA_ARGS__, i64) X(__VA_ARGS__, f32) X(__VA_ARGS__, f64)
+
+#define WASM_HOST_DEFINE_0(r)                                                  \
+  WASM_HOST_TRAMPOLINE_0(r)                                                    \
+  WASM_HOST_FOR_EACH_PARAM_1(WASM_HOST_DEFINE_1, r)
+#define WASM_HOST_DEFINE_1(r, a)                                               \
+  WASM_HOST_TRAMPOLINE_1(r, a)                                                 \
+  WASM_HOST_FOR_EACH_PARAM_2(WASM_HOST_DEFINE_2, r, a)
+#define WASM_HOST_DEFINE_2(r, a, b)                                            \
+  WASM_HOST_TRAMPOLINE_2(r, a, b)                                              \
+  WASM_HOST_FOR_EACH_PARAM_3(WASM_HOST_TRAMPOLINE_3, r, a, b)
+
+WASM_HOST_FOR_EACH_RESULT(WASM_HOST_DEFINE_0)
+
+#define WASM_HOST_ENTRY_0(r)                                                   \
+  [WASM_HOST_INDEX(WASM_HOST_CODE_##r, 0, 0, 0)] = &wasm_host_trampoline_##r,  \
+  WASM_HOST_FOR_EACH_PARAM_1(WASM_HOST_ENTRY_1, r)
+#define WASM_HOST_ENTRY_1(r, a)                                                \
+  [WASM_HOST_INDEX(WASM_HOST_CODE_##r, WASM_HOST_CODE_##a, 0, 0)] =            \
+      &wasm_host_trampoline_##r##_##a,                                         \
+  WASM_HOST_FOR_EACH_PARAM_2(WASM_HOST_ENTRY_2, r, a)
+#define WASM_HOST_ENTRY_2(r, a, b)                                             \
+  [WASM_HOST_INDEX(WASM_HOST_CODE_##r, WASM_HOST_CODE_##a,                     \
+                   WASM_HOST_CODE_##b, 0)] =                                   \
+      &wasm_host_trampoline_##r##_##a##_##b,                                   \
+  WASM_HOST_FOR_EACH_PARAM_3(WASM_HOST_ENTRY_3, r, a, b)
+#define WASM_HOST_ENTRY_3(r, a, b, c)                                          \
+  [WASM_HOST_INDEX(WASM_HOST_CODE_##r, WASM_HOST_CODE_##a, WASM_HOST_CODE_##b, \
+                   WASM_HOST_CODE_##c)] =                                      \
+      &wasm_host_trampoline_##r##_##a##_##b##_##c,
+
+static const wasm_host_trampoline
+    wasm_host_trampolines[wasm_host_trampoline_count] = {
+        WASM_HOST_FOR_EACH_RESULT(WASM_HOST_ENTRY_0)};
+
+// The codes of `enum wasm_valtype` match the ones of the trampoline table.
+static wasm_host_trampoline
+wasm_host_find_trampoline(wasm_function_type *type) {
+  if (type->param_count > 3) {
+    return NULL;
+  }
+
+  int codes[3] = {0, 0, 0};
+  for (size_t i = 0; i < type->param_count; i++) {
+    codes[i] = type->params[i];
+  }
+  int result = type->result_count ? type->result_type : 0;
+
+  return wasm_host_trampolines[WASM_HOST_INDEX(result, codes[0], codes[1],
+                                               codes[2])];
+}
+
+static bool wasm_char_to_host_valtype(char c, enum wasm_valtype *out) {
+  switch (c) {
+  case 'i':
+    return *out = wasm_valtype_i32, true;
+  case 'I':
+    return *out = wasm_valtype_i64, true;
+  case 'f':
+    return *out = wasm_valtype_f32, true;
+  case 'F':
+    return *out = wasm_valtype_f64, true;
+  default:
+    return false;
+  }
+}
+
+bool wasm_parse_signature(const char *signature, wasm_function_type *type) {
+  // There are fewer parameters than characters.
+  unsigned char *params = wasm_alloc_array(unsigned char, strlen(signature));
+  type->params = params;
+  type->param_count = 0;
+  type->result_count = 0;
+  type->result_type = wasm_valtype_error;
+
+  enum wasm_valtype valtype;
+  const char *c = signature;
+  if (*c++ != '(') {
+    goto error;
+  }
+
+  for (; *c != ')'; c++) {
+    if (!wasm_char_to_host_valtype(*c, &valtype)) {
+      goto error;
+    }
+    params[type->param_count++] = (unsigned char)valtype;
+  }
+  c++;
+
+  if (*c != '\0') {
+    if (!wasm_char_to_host_valtype(*c++, &valtype) || *c != '\0') {
+      goto error;
+    }
+    type->result_count = 1;
+    type->result_type = (uint8_t)valtype;
+  }
+
+  return true;
+
+error:
+  fprintf(stderr, "Invalid host function signature \"%s\".\n", signature);
+  wasm_release_signature(type);
+  return false;
+}
+
+void wasm_release_signature(wasm_function_type *type) {
+  wasm_free((void *)type->params);
+  type->params = NULL;
+  type->param_count = 0;
+}
+
+static char *wasm_host_strdup(const char *str) {
+  size_t length = strlen(str);
+  char *copy = wasm_alloc_array(char, length + 1);
+  memcpy(copy, str, length + 1);
+  return copy;
+}
+
+void wasm_init_host_imports(wasm_host_imports *imports) {
+  wasm_vec_init(&imports->funcs);
+  wasm_vec_init(&imports->memories);
+}
+
+void wasm_deinit_host_imports(wasm_host_imports *imports) {
+  for (wasm_host_func *func = imports->funcs.start; func != imports->funcs.end;
+       func++) {
+    wasm_free(func->module_name);
+    wasm_free(func->name);
+    wasm_release_signature(&func->type);
+  }
+  wasm_vec_deinit(&imports->funcs);
+
+  for (wasm_host_memory *memory = imports->memories.start;
+       memory != imports->memories.end; memory++) {
+    wasm_free(memory->module_name);
+    wasm_free(memory->name);
+    wasm_release_shared_memory(memory->memory);
+  }
+  wasm_vec_deinit(&imports->memories);
+}
+
+static wasm_host_func *wasm_host_imports_append(wasm_host_imports *imports,
+                                                const char *module_name,
+                                                const char *name,
+                                                const char *signature) {
+  wasm_function_type type;
+  if (!wasm_parse_signature(signature, &type)) {
+    return NULL;
+  }
+
+  wasm_host_func *func = wasm_vec_append(&imports->funcs);
+  func->module_name = wasm_host_strdup(module_name);
+  func->name = wasm_host_strdup(name);
+  func->type = type;
+  func->trampoline = NULL;
+  func->native = NULL;
+  func->user = NULL;
+  return func;
+}
+
+bool wasm_host_imports_add_raw(wasm_host_imports *imports,
+                               const char *module_name, const char *name,
+                               const char *signature,
+                               wasm_host_trampoline trampoline, void *user) {
+  wasm_host_func *func =
+      wasm_host_imports_append(imports, module_name, name, signature);
+  if (func == NULL) {
+    return false;
+  }
+
+  func->trampoline = trampoline;
+  func->user = user;
+  return true;
+}
+
+bool _wasm_host_imports_add(wasm_host_imports *imports,
+                            const char *module_name, const char *name,
+                            const char *signature, void (*native)(void),
+                            void *user) {
+  wasm_function_type type;
+  if (!wasm_parse_signature(signature, &type)) {
+    return false;
+  }
+  wasm_host_trampoline trampoline = wasm_host_find_trampoline(&type);
+  wasm_release_signature(&type);
+
+  if (trampoline == NULL) {
+    fprintf(stderr, "No trampoline for host function signature \"%s\".\n",
+            signature);
+    return false;
+  }
+
+  wasm_host_func *func =
+      wasm_host_imports_append(imports, module_name, name, signature);
+  func->trampoline = trampoline;
+  func->native = native;
+  func->user = user;
+  return true;
+}
+
+wasm_host_func *wasm_host_imports_find(wasm_host_imports *imports,
+                                       const char *module_name,
+                                       const char *name) {
+  for (wasm_host_func *func = imports->funcs.start; func != imports->funcs.end;
+       func++) {
+    if (strcmp(func->module_name, module_name) == 0 &&
+        strcmp(func->name, name) == 0) {
+      return func;
+    }
+  }
+  return NULL;
+}
+
+void wasm_host_imports_add_memory(wasm_host_imports *imports,
+                                  const char *module_name, const char *name,
+                                  wasm_shared_memory *memory) {
+  wasm_host_memory *host = wasm_vec_append(&imports->memories);
+  host->module_name = wasm_host_strdup(module_name);
+  host->name = wasm_host_strdup(name);
+  host->memory = memory;
+  wasm_retain_shared_memory(memory);
+}
+
+wasm_host_memory *wasm_host_imports_find_memory(wasm_host_imports *imports,
+                                                const char *module_name,
+                                                const char *name) {
+  for (wasm_host_memory *memory = imports->memories.start;
+       memory != imports->memories.end; memory++) {
+    if (strcmp(memory->module_name, module_name) == 0 &&
+        strcmp(memory->name, name) == 0) {
+      return memory;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include "wasm/wasm_atomic.h"
+#include "wasm/wasm_exec.h"
+
+struct wasm_host_func;
+
+// Calls a host function. The arguments are read from `args` and the result is
+// written back to `args[0]`. `args` points into the value stack of the
+// instance so nothing has to be copied or allocated.
+typedef enum wasm_trap (*wasm_host_trampoline)(
+    const struct wasm_host_func *func, wasm_instance *instance,
+    wasm_value *args);
+
+// A function that is provided by the host and can be imported by modules.
+typedef struct wasm_host_func {
+  char *module_name;
+  char *name;
+  wasm_function_type type;
+  wasm_host_trampoline trampoline;
+  // Native function with a typed signature. It is called by a generated
+  // trampoline. NULL if `trampoline` is provided by the user.
+  void (*native)(void);
+  void *user;
+} wasm_host_func;
+typedef wasm_vec_of(wasm_host_func) wasm_host_func_vec;
+
+// A shared memory that is provided by the host.
+typedef struct {
+  char *module_name;
+  char *name;
+  wasm_shared_memory *memory;
+} wasm_host_memory;
+typedef wasm_vec_of(wasm_host_memory) wasm_host_memory_vec;
+
+// The set of host functions and memories that modules can import. Host
+// functions must not be added while an instance that uses them exists.
+typedef struct wasm_host_imports {
+  wasm_host_func_vec funcs;
+  wasm_host_memory_vec memories;
+} wasm_host_imports;
+
+void wasm_init_host_imports(wasm_host_imports *imports);
+void wasm_deinit_host_imports(wasm_host_imports *imports);
+
+// Signatures are written as "(params)result" where every type is a single
+// character: i = i32, I = i64, f = f32 and F = f64. E.g. "(iI)f" or "()".
+bool wasm_parse_signature(const char *signature, wasm_function_type *type);
+// Frees the parameters of a type made by `wasm_parse_signature`.
+void wasm_release_signature(wasm_function_type *type);
+
+// Adds a function that takes its arguments directly from the value stack.
+bool wasm_host_imports_add_raw(wasm_host_imports *imports,
+                               const char *module_name, const char *name,
+                               const char *signature,
+                               wasm_host_trampoline trampoline, void *user);
+
+// Adds a native function with a typed C signature. The native function gets
+// the instance and `user` followed by the wasm parameters, e.g.
+// `int32_t add(wasm_instance *instance, void *user, int32_t a, int32_t b)` with
+// the signature "(ii)i". Signatures with up to 3 parameters are supported.
+bool _wasm_host_imports_add(wasm_host_imports *imports,
+                            const char *module_name, const char *name,
+                            const char *signature, void (*native)(void),
+                            void *user);
+#define wasm_host_imports_add(imports, module_name, name, signature, native,   \
+                              user)                                            \
+  _wasm_host_imports_add(imports, module_name, name, signature,               \
+                         (void (*)(void))(native), user)
+
+// Returns NULL if there is no such function.
+wasm_host_func *wasm_host_imports_find(wasm_host_imports *imports,
+                                       const char *module_name,
+                                       const char *name);
+
+// Adds a shared memory. The imports hold a reference to `memory` until they
+// are deinitialized. Only shared memories can be imported.
+void wasm_host_imports_add_memory(wasm_host_imports *imports,
+                                  const char *module_name, const char *name,
+                                  wasm_shared_memory *memory);
+
+// Returns NULL if there is no such memory.
+wasm_host_memory *wasm_host_imports_find_memory(wasm_host_imports *imports,
+                                                const char *module_name,
+                                                const char *name);
@@ -0,0 +1,206 @@
+#include "wasm/wasm_intern.h"
+
+#include "wasm/wasm_common.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+// Strings are stored after their 4 byte length in one reserved mapping, so
+// they never move when the table grows. Offsets are 32 bits.
+#define wasm_intern_capacity ((size_t)1 << 30)
+// Strings are spread over independent hash tables by their hash so threads
+// that add strings rarely wait for each other.
+#define wasm_intern_shard_count 16
+#define wasm_intern_empty UINT32_MAX
+
+typedef struct {
+  uint32_t hash;
+  // Offset of the string or `wasm_intern_empty`.
+  uint32_t offset;
+} wasm_intern_entry;
+
+// Open addressing hash table of the strings with one lock.
+typedef struct {
+  pthread_rwlock_t lock;
+  wasm_intern_entry *entries;
+  // 0 or a power of two.
+  size_t capacity;
+  size_t count;
+} wasm_intern_shard;
+
+struct wasm_intern_table {
+  unsigned char *data;
+  // Bytes of `data` in use.
+  atomic_size_t size;
+  wasm_intern_shard shards[wasm_intern_shard_count];
+};
+
+wasm_intern_table *wasm_create_intern_table(void) {
+  wasm_intern_table *table = wasm_alloc(wasm_intern_table);
+  table->data = wasm_reserve_n(wasm_intern_capacity);
+  if (table->data == NULL) {
+    wasm_free(table);
+    return NULL;
+  }
+  atomic_init(&table->size, 0);
+
+  for (size_t i = 0; i < wasm_intern_shard_count; i++) {
+    wasm_intern_shard *shard = &table->shards[i];
+    pthread_rwlock_init(&shard->lock, NULL);
+    shard->entries = NULL;
+    shard->capacity = 0;
+    shard->count = 0;
+  }
+  return table;
+}
+
+void wasm_free_intern_table(wasm_intern_table *table) {
+  if (table) {
+    for (size_t i = 0; i < wasm_intern_shard_count; i++) {
+      pthread_rwlock_destroy(&table->shards[i].lock);
+      wasm_free(table->shards[i].entries);
+    }
+    wasm_free_reserved(table->data, wasm_intern_capacity);
+    wasm_free(table);
+  }
+}
+
+static uint32_t wasm_intern_hash(const unsigned char *data, uint32_t size) {
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// The low bits of the hash select the shard, the others the slot.
+static size_t wasm_intern_slot(uint32_t hash, size_t capacity) {
+  return (hash / wasm_intern_shard_count) & (capacity - 1);
+}
+
+// Returns the offset of the string or `wasm_intern_empty`. The lock of the
+// shard has to be held.
+static uint32_t wasm_intern_find(wasm_intern_table *table,
+                                 wasm_intern_shard *shard, uint32_t hash,
+                                 const void *data, uint32_t size) {
+  if (shard->capacity == 0) {
+    return wasm_intern_empty;
+  }
+
+  size_t mask = shard->capacity - 1;
+  for (size_t i = wasm_intern_slot(hash, shard->capacity);;
+       i = (i + 1) & mask) {
+    wasm_intern_entry *entry = &shard->entries[i];
+    if (entry->offset == wasm_intern_empty) {
+      return wasm_intern_empty;
+    }
+    if (entry->hash == hash) {
+      uint32_t length;
+      memcpy(&length, table->data + entry->offset - sizeof(length),
+             sizeof(length));
+      if (length == size &&
+          memcmp(table->data + entry->offset, data, size) == 0) {
+        return entry->offset;
+      }
+    }
+  }
+}
+
+static void wasm_intern_insert(wasm_intern_shard *shard,
+                               wasm_intern_entry entry) {
+  size_t mask = shard->capacity - 1;
+  size_t i = wasm_intern_slot(entry.hash, shard->capacity);
+  while (shard->entries[i].offset != wasm_intern_empty) {
+    i = (i + 1) & mask;
+  }
+  shard->entries[i] = entry;
+}
+
+// Keeps the shard at most half full.
+static void wasm_intern_grow(wasm_intern_shard *shard) {
+  if ((shard->count + 1) * 2 <= shard->capacity) {
+    return;
+  }
+
+  wasm_intern_entry *old = shard->entries;
+  size_t old_capacity = shard->capacity;
+  shard->capacity = old_capacity ? old_capacity * 2 : 64;
+  shard->entries = wasm_alloc_array(wasm_intern_entry, shard->capacity);
+  memset(shard->entries, 0xFF, shard->capacity * sizeof(wasm_intern_entry));
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old[i].offset != wasm_intern_empty) {
+      wasm_intern_insert(shard, old[i]);
+    }
+  }
+  wasm_free(old);
+}
+
+// Copies a string to the end of the storage and returns its offset.
+static bool wasm_intern_store(wasm_intern_table *table, const void *data,
+                              uint32_t size, uint32_t *offset) {
+  // Shards store concurrently, so the space is claimed atomically.
+  size_t needed = sizeof(size) + size + 1;
+  size_t start = atomic_load(&table->size);
+  do {
+    if (needed > wasm_intern_capacity - start) {
+      return false;
+    }
+  } while (!atomic_compare_exchange_weak(&table->size, &start,
+                                         start + needed));
+
+  unsigned char *copy = table->data + start;
+  memcpy(copy, &size, sizeof(size));
+  memcpy(copy + sizeof(size), data, size);
+  copy[sizeof(size) + size] = '\0';
+  *offset = (uint32_t)(start + sizeof(size));
+  return true;
+}
+
+bool wasm_intern(wasm_intern_table *table, const void *data, uint32_t size,
+                 uint32_t *offset) {
+  uint32_t hash = wasm_intern_hash(data, size);
+  wasm_intern_shard *shard = &table->shards[hash % wasm_intern_shard_count];
+
+  pthread_rwlock_rdlock(&shard->lock);
+  *offset = wasm_intern_find(table, shard, hash, data, size);
+  pthread_rwlock_unlock(&shard->lock);
+  if (*offset != wasm_intern_empty) {
+    return true;
+  }
+
+  // Another thread may have added it in between.
+  pthread_rwlock_wrlock(&shard->lock);
+  *offset = wasm_intern_find(table, shard, hash, data, size);
+  bool ok = true;
+  if (*offset == wasm_intern_empty) {
+    ok = wasm_intern_store(table, data, size, offset);
+    if (ok) {
+      wasm_intern_grow(shard);
+      wasm_intern_insert(shard, (wasm_intern_entry){hash, *offset});
+      shard->count++;
+    }
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  return ok;
+}
+
+const unsigned char *wasm_intern_data(const wasm_intern_table *table,
+                                      uint32_t offset) {
+  return table->data + offset;
+}
+
+size_t wasm_intern_count(wasm_intern_table *table) {
+  size_t count = 0;
+  for (size_t i = 0; i < wasm_intern_shard_count; i++) {
+    wasm_intern_shard *shard = &table->shards[i];
+    pthread_rwlock_rdlock(&shard->lock);
+    count += shard->count;
+    pthread_rwlock_unlock(&shard->lock);
+  }
+  return count;
+}
+
+size_t wasm_intern_size(wasm_intern_table *table) {
+  return atomic_load(&table->size);
+}
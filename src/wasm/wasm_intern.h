@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A set of byte strings that is shared by modules loaded on different threads,
+// e.g. the names of imports and exports and the function types of a plugin
+// directory. Every distinct string is stored once and identified by its offset
+// in the table, so equal strings of different modules have the same offset.
+//
+// Interning is safe from several threads. Lookups of strings that are already
+// in the table only take a shared lock. The strings never move, so reading one
+// by its offset needs no lock at all.
+typedef struct wasm_intern_table wasm_intern_table;
+
+// Returns NULL if the storage can't be reserved.
+wasm_intern_table *wasm_create_intern_table(void);
+void wasm_free_intern_table(wasm_intern_table *table);
+
+// Adds `size` bytes at `data` unless they are in the table already and sets
+// `offset` to the offset of the stored copy. The copy is followed by a NUL
+// byte. Returns false if the table is full.
+bool wasm_intern(wasm_intern_table *table, const void *data, uint32_t size,
+                 uint32_t *offset);
+
+// Returns the string at `offset`.
+const unsigned char *wasm_intern_data(const wasm_intern_table *table,
+                                      uint32_t offset);
+
+// Number of distinct strings and the bytes they take up.
+size_t wasm_intern_count(wasm_intern_table *table);
+size_t wasm_intern_size(wasm_intern_table *table);
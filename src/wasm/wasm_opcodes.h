@@ -0,0 +1,568 @@
+#pragma once
+
+// Instruction table. Every entry is
+// `X(opcode, identifier, text, immediate kind, pops, pushes)`.
+//
+// Prefixed instructions (0xFC xx, the SIMD instructions 0xFD xx and the atomic
+// instructions 0xFE xx) are numbered `wasm_opcode_prefix_fc + xx` and so on so
+// that all opcodes fit in one integer space. A pop/push count of -1 means that
+// the stack effect depends on the immediates or on the enclosing block.
+#define WASM_OPCODES(X)                                                        \
+  X(0x000, unreachable, "unreachable", none, 0, 0)                             \
+  X(0x001, nop, "nop", none, 0, 0)                                             \
+  X(0x002, block, "block", block, -1, -1)                                      \
+  X(0x003, loop, "loop", block, -1, -1)                                        \
+  X(0x004, if, "if", block, -1, -1)                                            \
+  X(0x005, else, "else", none, -1, -1)                                         \
+  X(0x00B, end, "end", none, -1, -1)                                           \
+  X(0x00C, br, "br", label, -1, -1)                                            \
+  X(0x00D, br_if, "br_if", label, -1, -1)                                      \
+  X(0x00E, br_table, "br_table", br_table, -1, -1)                             \
+  X(0x00F, return, "return", none, -1, -1)                                     \
+  X(0x010, call, "call", func, -1, -1)                                         \
+  X(0x011, call_indirect, "call_indirect", call_indirect, -1, -1)              \
+  X(0x012, return_call, "return_call", func, -1, -1)                           \
+  X(0x013, return_call_indirect, "return_call_indirect", call_indirect, -1,    \
+    -1)                                                                        \
+  X(0x01A, drop, "drop", none, 1, 0)                                           \
+  X(0x01B, select, "select", none, 3, 1)                                       \
+  X(0x020, local_get, "local.get", local, 0, 1)                                \
+  X(0x021, local_set, "local.set", local, 1, 0)                                \
+  X(0x022, local_tee, "local.tee", local, 1, 1)                                \
+  X(0x023, global_get, "global.get", global, 0, 1)                             \
+  X(0x024, global_set, "global.set", global, 1, 0)                             \
+  X(0x028, i32_load, "i32.load", memarg, 1, 1)                                 \
+  X(0x029, i64_load, "i64.load", memarg, 1, 1)                                 \
+  X(0x02A, f32_load, "f32.load", memarg, 1, 1)                                 \
+  X(0x02B, f64_load, "f64.load", memarg, 1, 1)                                 \
+  X(0x02C, i32_load8_s, "i32.load8_s", memarg, 1, 1)                           \
+  X(0x02D, i32_load8_u, "i32.load8_u", memarg, 1, 1)                           \
+  X(0x02E, i32_load16_s, "i32.load16_s", memarg, 1, 1)                         \
+  X(0x02F, i32_load16_u, "i32.load16_u", memarg, 1, 1)                         \
+  X(0x030, i64_load8_s, "i64.load8_s", memarg, 1, 1)                           \
+  X(0x031, i64_load8_u, "i64.load8_u", memarg, 1, 1)                           \
+  X(0x032, i64_load16_s, "i64.load16_s", memarg, 1, 1)                         \
+  X(0x033, i64_load16_u, "i64.load16_u", memarg, 1, 1)                         \
+  X(0x034, i64_load32_s, "i64.load32_s", memarg, 1, 1)                         \
+  X(0x035, i64_load32_u, "i64.load32_u", memarg, 1, 1)                         \
+  X(0x036, i32_store, "i32.store", memarg, 2, 0)                               \
+  X(0x037, i64_store, "i64.store", memarg, 2, 0)                               \
+  X(0x038, f32_store, "f32.store", memarg, 2, 0)                               \
+  X(0x039, f64_store, "f64.store", memarg, 2, 0)                               \
+  X(0x03A, i32_store8, "i32.store8", memarg, 2, 0)                             \
+  X(0x03B, i32_store16, "i32.store16", memarg, 2, 0)                           \
+  X(0x03C, i64_store8, "i64.store8", memarg, 2, 0)                             \
+  X(0x03D, i64_store16, "i64.store16", memarg, 2, 0)                           \
+  X(0x03E, i64_store32, "i64.store32", memarg, 2, 0)                           \
+  X(0x03F, memory_size, "memory.size", memory, 0, 1)                           \
+  X(0x040, memory_grow, "memory.grow", memory, 1, 1)                           \
+  X(0x041, i32_const, "i32.const", i32, 0, 1)                                  \
+  X(0x042, i64_const, "i64.const", i64, 0, 1)                                  \
+  X(0x043, f32_const, "f32.const", f32, 0, 1)                                  \
+  X(0x044, f64_const, "f64.const", f64, 0, 1)                                  \
+  X(0x045, i32_eqz, "i32.eqz", none, 1, 1)                                     \
+  X(0x046, i32_eq, "i32.eq", none, 2, 1)                                       \
+  X(0x047, i32_ne, "i32.ne", none, 2, 1)                                       \
+  X(0x048, i32_lt_s, "i32.lt_s", none, 2, 1)                                   \
+  X(0x049, i32_lt_u, "i32.lt_u", none, 2, 1)                                   \
+  X(0x04A, i32_gt_s, "i32.gt_s", none, 2, 1)                                   \
+  X(0x04B, i32_gt_u, "i32.gt_u", none, 2, 1)                                   \
+  X(0x04C, i32_le_s, "i32.le_s", none, 2, 1)                                   \
+  X(0x04D, i32_le_u, "i32.le_u", none, 2, 1)                                   \
+  X(0x04E, i32_ge_s, "i32.ge_s", none, 2, 1)                                   \
+  X(0x04F, i32_ge_u, "i32.ge_u", none, 2, 1)                                   \
+  X(0x050, i64_eqz, "i64.eqz", none, 1, 1)                                     \
+  X(0x051, i64_eq, "i64.eq", none, 2, 1)                                       \
+  X(0x052, i64_ne, "i64.ne", none, 2, 1)                                       \
+  X(0x053, i64_lt_s, "i64.lt_s", none, 2, 1)                                   \
+  X(0x054, i64_lt_u, "i64.lt_u", none, 2, 1)                                   \
+  X(0x055, i64_gt_s, "i64.gt_s", none, 2, 1)                                   \
+  X(0x056, i64_gt_u, "i64.gt_u", none, 2, 1)                                   \
+  X(0x057, i64_le_s, "i64.le_s", none, 2, 1)                                   \
+  X(0x058, i64_le_u, "i64.le_u", none, 2, 1)                                   \
+  X(0x059, i64_ge_s, "i64.ge_s", none, 2, 1)                                   \
+  X(0x05A, i64_ge_u, "i64.ge_u", none, 2, 1)                                   \
+  X(0x05B, f32_eq, "f32.eq", none, 2, 1)                                       \
+  X(0x05C, f32_ne, "f32.ne", none, 2, 1)                                       \
+  X(0x05D, f32_lt, "f32.lt", none, 2, 1)                                       \
+  X(0x05E, f32_gt, "f32.gt", none, 2, 1)                                       \
+  X(0x05F, f32_le, "f32.le", none, 2, 1)                                       \
+  X(0x060, f32_ge, "f32.ge", none, 2, 1)                                       \
+  X(0x061, f64_eq, "f64.eq", none, 2, 1)                                       \
+  X(0x062, f64_ne, "f64.ne", none, 2, 1)                                       \
+  X(0x063, f64_lt, "f64.lt", none, 2, 1)                                       \
+  X(0x064, f64_gt, "f64.gt", none, 2, 1)                                       \
+  X(0x065, f64_le, "f64.le", none, 2, 1)                                       \
+  X(0x066, f64_ge, "f64.ge", none, 2, 1)                                       \
+  X(0x067, i32_clz, "i32.clz", none, 1, 1)                                     \
+  X(0x068, i32_ctz, "i32.ctz", none, 1, 1)                                     \
+  X(0x069, i32_popcnt, "i32.popcnt", none, 1, 1)                               \
+  X(0x06A, i32_add, "i32.add", none, 2, 1)                                     \
+  X(0x06B, i32_sub, "i32.sub", none, 2, 1)                                     \
+  X(0x06C, i32_mul, "i32.mul", none, 2, 1)                                     \
+  X(0x06D, i32_div_s, "i32.div_s", none, 2, 1)                                 \
+  X(0x06E, i32_div_u, "i32.div_u", none, 2, 1)                                 \
+  X(0x06F, i32_rem_s, "i32.rem_s", none, 2, 1)                                 \
+  X(0x070, i32_rem_u, "i32.rem_u", none, 2, 1)                                 \
+  X(0x071, i32_and, "i32.and", none, 2, 1)                                     \
+  X(0x072, i32_or, "i32.or", none, 2, 1)                                       \
+  X(0x073, i32_xor, "i32.xor", none, 2, 1)                                     \
+  X(0x074, i32_shl, "i32.shl", none, 2, 1)                                     \
+  X(0x075, i32_shr_s, "i32.shr_s", none, 2, 1)                                 \
+  X(0x076, i32_shr_u, "i32.shr_u", none, 2, 1)                                 \
+  X(0x077, i32_rotl, "i32.rotl", none, 2, 1)                                   \
+  X(0x078, i32_rotr, "i32.rotr", none, 2, 1)                                   \
+  X(0x079, i64_clz, "i64.clz", none, 1, 1)                                     \
+  X(0x07A, i64_ctz, "i64.ctz", none, 1, 1)                                     \
+  X(0x07B, i64_popcnt, "i64.popcnt", none, 1, 1)                               \
+  X(0x07C, i64_add, "i64.add", none, 2, 1)                                     \
+  X(0x07D, i64_sub, "i64.sub", none, 2, 1)                                     \
+  X(0x07E, i64_mul, "i64.mul", none, 2, 1)                                     \
+  X(0x07F, i64_div_s, "i64.div_s", none, 2, 1)                                 \
+  X(0x080, i64_div_u, "i64.div_u", none, 2, 1)                                 \
+  X(0x081, i64_rem_s, "i64.rem_s", none, 2, 1)                                 \
+  X(0x082, i64_rem_u, "i64.rem_u", none, 2, 1)                                 \
+  X(0x083, i64_and, "i64.and", none, 2, 1)                                     \
+  X(0x084, i64_or, "i64.or", none, 2, 1)                                       \
+  X(0x085, i64_xor, "i64.xor", none, 2, 1)                                     \
+  X(0x086, i64_shl, "i64.shl", none, 2, 1)                                     \
+  X(0x087, i64_shr_s, "i64.shr_s", none, 2, 1)                                 \
+  X(0x088, i64_shr_u, "i64.shr_u", none, 2, 1)                                 \
+  X(0x089, i64_rotl, "i64.rotl", none, 2, 1)                                   \
+  X(0x08A, i64_rotr, "i64.rotr", none, 2, 1)                                   \
+  X(0x08B, f32_abs, "f32.abs", none, 1, 1)                                     \
+  X(0x08C, f32_neg, "f32.neg", none, 1, 1)                                     \
+  X(0x08D, f32_ceil, "f32.ceil", none, 1, 1)                                   \
+  X(0x08E, f32_floor, "f32.floor", none, 1, 1)                                 \
+  X(0x08F, f32_trunc, "f32.trunc", none, 1, 1)                                 \
+  X(0x090, f32_nearest, "f32.nearest", none, 1, 1)                             \
+  X(0x091, f32_sqrt, "f32.sqrt", none, 1, 1)                                   \
+  X(0x092, f32_add, "f32.add", none, 2, 1)                                     \
+  X(0x093, f32_sub, "f32.sub", none, 2, 1)                                     \
+  X(0x094, f32_mul, "f32.mul", none, 2, 1)                                     \
+  X(0x095, f32_div, "f32.div", none, 2, 1)                                     \
+  X(0x096, f32_min, "f32.min", none, 2, 1)                                     \
+  X(0x097, f32_max, "f32.max", none, 2, 1)                                     \
+  X(0x098, f32_copysign, "f32.copysign", none, 2, 1)                           \
+  X(0x099, f64_abs, "f64.abs", none, 1, 1)                                     \
+  X(0x09A, f64_neg, "f64.neg", none, 1, 1)                                     \
+  X(0x09B, f64_ceil, "f64.ceil", none, 1, 1)                                   \
+  X(0x09C, f64_floor, "f64.floor", none, 1, 1)                                 \
+  X(0x09D, f64_trunc, "f64.trunc", none, 1, 1)                                 \
+  X(0x09E, f64_nearest, "f64.nearest", none, 1, 1)                             \
+  X(0x09F, f64_sqrt, "f64.sqrt", none, 1, 1)                                   \
+  X(0x0A0, f64_add, "f64.add", none, 2, 1)                                     \
+  X(0x0A1, f64_sub, "f64.sub", none, 2, 1)                                     \
+  X(0x0A2, f64_mul, "f64.mul", none, 2, 1)                                     \
+  X(0x0A3, f64_div, "f64.div", none, 2, 1)                                     \
+  X(0x0A4, f64_min, "f64.min", none, 2, 1)                                     \
+  X(0x0A5, f64_max, "f64.max", none, 2, 1)                                     \
+  X(0x0A6, f64_copysign, "f64.copysign", none, 2, 1)                           \
+  X(0x0A7, i32_wrap_i64, "i32.wrap_i64", none, 1, 1)                           \
+  X(0x0A8, i32_trunc_f32_s, "i32.trunc_f32_s", none, 1, 1)                     \
+  X(0x0A9, i32_trunc_f32_u, "i32.trunc_f32_u", none, 1, 1)                     \
+  X(0x0AA, i32_trunc_f64_s, "i32.trunc_f64_s", none, 1, 1)                     \
+  X(0x0AB, i32_trunc_f64_u, "i32.trunc_f64_u", none, 1, 1)                     \
+  X(0x0AC, i64_extend_i32_s, "i64.extend_i32_s", none, 1, 1)                   \
+  X(0x0AD, i64_extend_i32_u, "i64.extend_i32_u", none, 1, 1)                   \
+  X(0x0AE, i64_trunc_f32_s, "i64.trunc_f32_s", none, 1, 1)                     \
+  X(0x0AF, i64_trunc_f32_u, "i64.trunc_f32_u", none, 1, 1)                     \
+  X(0x0B0, i64_trunc_f64_s, "i64.trunc_f64_s", none, 1, 1)                     \
+  X(0x0B1, i64_trunc_f64_u, "i64.trunc_f64_u", none, 1, 1)                     \
+  X(0x0B2, f32_convert_i32_s, "f32.convert_i32_s", none, 1, 1)                 \
+  X(0x0B3, f32_convert_i32_u, "f32.convert_i32_u", none, 1, 1)                 \
+  X(0x0B4, f32_convert_i64_s, "f32.convert_i64_s", none, 1, 1)                 \
+  X(0x0B5, f32_convert_i64_u, "f32.convert_i64_u", none, 1, 1)                 \
+  X(0x0B6, f32_demote_f64, "f32.demote_f64", none, 1, 1)                       \
+  X(0x0B7, f64_convert_i32_s, "f64.convert_i32_s", none, 1, 1)                 \
+  X(0x0B8, f64_convert_i32_u, "f64.convert_i32_u", none, 1, 1)                 \
+  X(0x0B9, f64_convert_i64_s, "f64.convert_i64_s", none, 1, 1)                 \
+  X(0x0BA, f64_convert_i64_u, "f64.convert_i64_u", none, 1, 1)                 \
+  X(0x0BB, f64_promote_f32, "f64.promote_f32", none, 1, 1)                     \
+  X(0x0BC, i32_reinterpret_f32, "i32.reinterpret_f32", none, 1, 1)             \
+  X(0x0BD, i64_reinterpret_f64, "i64.reinterpret_f64", none, 1, 1)             \
+  X(0x0BE, f32_reinterpret_i32, "f32.reinterpret_i32", none, 1, 1)             \
+  X(0x0BF, f64_reinterpret_i64, "f64.reinterpret_i64", none, 1, 1)             \
+  X(0x0C0, i32_extend8_s, "i32.extend8_s", none, 1, 1)                         \
+  X(0x0C1, i32_extend16_s, "i32.extend16_s", none, 1, 1)                       \
+  X(0x0C2, i64_extend8_s, "i64.extend8_s", none, 1, 1)                         \
+  X(0x0C3, i64_extend16_s, "i64.extend16_s", none, 1, 1)                       \
+  X(0x0C4, i64_extend32_s, "i64.extend32_s", none, 1, 1)                       \
+  X(0x100, i32_trunc_sat_f32_s, "i32.trunc_sat_f32_s", none, 1, 1)             \
+  X(0x101, i32_trunc_sat_f32_u, "i32.trunc_sat_f32_u", none, 1, 1)             \
+  X(0x102, i32_trunc_sat_f64_s, "i32.trunc_sat_f64_s", none, 1, 1)             \
+  X(0x103, i32_trunc_sat_f64_u, "i32.trunc_sat_f64_u", none, 1, 1)             \
+  X(0x104, i64_trunc_sat_f32_s, "i64.trunc_sat_f32_s", none, 1, 1)             \
+  X(0x105, i64_trunc_sat_f32_u, "i64.trunc_sat_f32_u", none, 1, 1)             \
+  X(0x106, i64_trunc_sat_f64_s, "i64.trunc_sat_f64_s", none, 1, 1)             \
+  X(0x107, i64_trunc_sat_f64_u, "i64.trunc_sat_f64_u", none, 1, 1)             \
+  X(0x108, memory_init, "memory.init", memory_init, 3, 0)                      \
+  X(0x109, data_drop, "data.drop", data, 0, 0)                                 \
+  X(0x10A, memory_copy, "memory.copy", memory_copy, 3, 0)                      \
+  X(0x10B, memory_fill, "memory.fill", memory, 3, 0)                           \
+  X(0x200, v128_load, "v128.load", memarg, 1, 1)                               \
+  X(0x201, v128_load8x8_s, "v128.load8x8_s", memarg, 1, 1)                     \
+  X(0x202, v128_load8x8_u, "v128.load8x8_u", memarg, 1, 1)                     \
+  X(0x203, v128_load16x4_s, "v128.load16x4_s", memarg, 1, 1)                   \
+  X(0x204, v128_load16x4_u, "v128.load16x4_u", memarg, 1, 1)                   \
+  X(0x205, v128_load32x2_s, "v128.load32x2_s", memarg, 1, 1)                   \
+  X(0x206, v128_load32x2_u, "v128.load32x2_u", memarg, 1, 1)                   \
+  X(0x207, v128_load8_splat, "v128.load8_splat", memarg, 1, 1)                 \
+  X(0x208, v128_load16_splat, "v128.load16_splat", memarg, 1, 1)               \
+  X(0x209, v128_load32_splat, "v128.load32_splat", memarg, 1, 1)               \
+  X(0x20A, v128_load64_splat, "v128.load64_splat", memarg, 1, 1)               \
+  X(0x20B, v128_store, "v128.store", memarg, 2, 0)                             \
+  X(0x20C, v128_const, "v128.const", v128, 0, 1)                               \
+  X(0x20D, i8x16_shuffle, "i8x16.shuffle", shuffle, 2, 1)                      \
+  X(0x20E, i8x16_swizzle, "i8x16.swizzle", none, 2, 1)                         \
+  X(0x20F, i8x16_splat, "i8x16.splat", none, 1, 1)                             \
+  X(0x210, i16x8_splat, "i16x8.splat", none, 1, 1)                             \
+  X(0x211, i32x4_splat, "i32x4.splat", none, 1, 1)                             \
+  X(0x212, i64x2_splat, "i64x2.splat", none, 1, 1)                             \
+  X(0x213, f32x4_splat, "f32x4.splat", none, 1, 1)                             \
+  X(0x214, f64x2_splat, "f64x2.splat", none, 1, 1)                             \
+  X(0x215, i8x16_extract_lane_s, "i8x16.extract_lane_s", lane, 1, 1)           \
+  X(0x216, i8x16_extract_lane_u, "i8x16.extract_lane_u", lane, 1, 1)           \
+  X(0x217, i8x16_replace_lane, "i8x16.replace_lane", lane, 2, 1)               \
+  X(0x218, i16x8_extract_lane_s, "i16x8.extract_lane_s", lane, 1, 1)           \
+  X(0x219, i16x8_extract_lane_u, "i16x8.extract_lane_u", lane, 1, 1)           \
+  X(0x21A, i16x8_replace_lane, "i16x8.replace_lane", lane, 2, 1)               \
+  X(0x21B, i32x4_extract_lane, "i32x4.extract_lane", lane, 1, 1)               \
+  X(0x21C, i32x4_replace_lane, "i32x4.replace_lane", lane, 2, 1)               \
+  X(0x21D, i64x2_extract_lane, "i64x2.extract_lane", lane, 1, 1)               \
+  X(0x21E, i64x2_replace_lane, "i64x2.replace_lane", lane, 2, 1)               \
+  X(0x21F, f32x4_extract_lane, "f32x4.extract_lane", lane, 1, 1)               \
+  X(0x220, f32x4_replace_lane, "f32x4.replace_lane", lane, 2, 1)               \
+  X(0x221, f64x2_extract_lane, "f64x2.extract_lane", lane, 1, 1)               \
+  X(0x222, f64x2_replace_lane, "f64x2.replace_lane", lane, 2, 1)               \
+  X(0x223, i8x16_eq, "i8x16.eq", none, 2, 1)                                   \
+  X(0x224, i8x16_ne, "i8x16.ne", none, 2, 1)                                   \
+  X(0x225, i8x16_lt_s, "i8x16.lt_s", none, 2, 1)                               \
+  X(0x226, i8x16_lt_u, "i8x16.lt_u", none, 2, 1)                               \
+  X(0x227, i8x16_gt_s, "i8x16.gt_s", none, 2, 1)                               \
+  X(0x228, i8x16_gt_u, "i8x16.gt_u", none, 2, 1)                               \
+  X(0x229, i8x16_le_s, "i8x16.le_s", none, 2, 1)                               \
+  X(0x22A, i8x16_le_u, "i8x16.le_u", none, 2, 1)                               \
+  X(0x22B, i8x16_ge_s, "i8x16.ge_s", none, 2, 1)                               \
+  X(0x22C, i8x16_ge_u, "i8x16.ge_u", none, 2, 1)                               \
+  X(0x22D, i16x8_eq, "i16x8.eq", none, 2, 1)                                   \
+  X(0x22E, i16x8_ne, "i16x8.ne", none, 2, 1)                                   \
+  X(0x22F, i16x8_lt_s, "i16x8.lt_s", none, 2, 1)                               \
+  X(0x230, i16x8_lt_u, "i16x8.lt_u", none, 2, 1)                               \
+  X(0x231, i16x8_gt_s, "i16x8.gt_s", none, 2, 1)                               \
+  X(0x232, i16x8_gt_u, "i16x8.gt_u", none, 2, 1)                               \
+  X(0x233, i16x8_le_s, "i16x8.le_s", none, 2, 1)                               \
+  X(0x234, i16x8_le_u, "i16x8.le_u", none, 2, 1)                               \
+  X(0x235, i16x8_ge_s, "i16x8.ge_s", none, 2, 1)                               \
+  X(0x236, i16x8_ge_u, "i16x8.ge_u", none, 2, 1)                               \
+  X(0x237, i32x4_eq, "i32x4.eq", none, 2, 1)                                   \
+  X(0x238, i32x4_ne, "i32x4.ne", none, 2, 1)                                   \
+  X(0x239, i32x4_lt_s, "i32x4.lt_s", none, 2, 1)                               \
+  X(0x23A, i32x4_lt_u, "i32x4.lt_u", none, 2, 1)                               \
+  X(0x23B, i32x4_gt_s, "i32x4.gt_s", none, 2, 1)                               \
+  X(0x23C, i32x4_gt_u, "i32x4.gt_u", none, 2, 1)                               \
+  X(0x23D, i32x4_le_s, "i32x4.le_s", none, 2, 1)                               \
+  X(0x23E, i32x4_le_u, "i32x4.le_u", none, 2, 1)                               \
+  X(0x23F, i32x4_ge_s, "i32x4.ge_s", none, 2, 1)                               \
+  X(0x240, i32x4_ge_u, "i32x4.ge_u", none, 2, 1)                               \
+  X(0x241, f32x4_eq, "f32x4.eq", none, 2, 1)                                   \
+  X(0x242, f32x4_ne, "f32x4.ne", none, 2, 1)                                   \
+  X(0x243, f32x4_lt, "f32x4.lt", none, 2, 1)                                   \
+  X(0x244, f32x4_gt, "f32x4.gt", none, 2, 1)                                   \
+  X(0x245, f32x4_le, "f32x4.le", none, 2, 1)                                   \
+  X(0x246, f32x4_ge, "f32x4.ge", none, 2, 1)                                   \
+  X(0x247, f64x2_eq, "f64x2.eq", none, 2, 1)                                   \
+  X(0x248, f64x2_ne, "f64x2.ne", none, 2, 1)                                   \
+  X(0x249, f64x2_lt, "f64x2.lt", none, 2, 1)                                   \
+  X(0x24A, f64x2_gt, "f64x2.gt", none, 2, 1)                                   \
+  X(0x24B, f64x2_le, "f64x2.le", none, 2, 1)                                   \
+  X(0x24C, f64x2_ge, "f64x2.ge", none, 2, 1)                                   \
+  X(0x24D, v128_not, "v128.not", none, 1, 1)                                   \
+  X(0x24E, v128_and, "v128.and", none, 2, 1)                                   \
+  X(0x24F, v128_andnot, "v128.andnot", none, 2, 1)                             \
+  X(0x250, v128_or, "v128.or", none, 2, 1)                                     \
+  X(0x251, v128_xor, "v128.xor", none, 2, 1)                                   \
+  X(0x252, v128_bitselect, "v128.bitselect", none, 3, 1)                       \
+  X(0x253, v128_any_true, "v128.any_true", none, 1, 1)                         \
+  X(0x254, v128_load8_lane, "v128.load8_lane", memarg_lane, 2, 1)              \
+  X(0x255, v128_load16_lane, "v128.load16_lane", memarg_lane, 2, 1)            \
+  X(0x256, v128_load32_lane, "v128.load32_lane", memarg_lane, 2, 1)            \
+  X(0x257, v128_load64_lane, "v128.load64_lane", memarg_lane, 2, 1)            \
+  X(0x258, v128_store8_lane, "v128.store8_lane", memarg_lane, 2, 0)            \
+  X(0x259, v128_store16_lane, "v128.store16_lane", memarg_lane, 2, 0)          \
+  X(0x25A, v128_store32_lane, "v128.store32_lane", memarg_lane, 2, 0)          \
+  X(0x25B, v128_store64_lane, "v128.store64_lane", memarg_lane, 2, 0)          \
+  X(0x25C, v128_load32_zero, "v128.load32_zero", memarg, 1, 1)                 \
+  X(0x25D, v128_load64_zero, "v128.load64_zero", memarg, 1, 1)                 \
+  X(0x25E, f32x4_demote_f64x2_zero, "f32x4.demote_f64x2_zero", none, 1, 1)     \
+  X(0x25F, f64x2_promote_low_f32x4, "f64x2.promote_low_f32x4", none, 1, 1)     \
+  X(0x260, i8x16_abs, "i8x16.abs", none, 1, 1)                                 \
+  X(0x261, i8x16_neg, "i8x16.neg", none, 1, 1)                                 \
+  X(0x262, i8x16_popcnt, "i8x16.popcnt", none, 1, 1)                           \
+  X(0x263, i8x16_all_true, "i8x16.all_true", none, 1, 1)                       \
+  X(0x264, i8x16_bitmask, "i8x16.bitmask", none, 1, 1)                         \
+  X(0x265, i8x16_narrow_i16x8_s, "i8x16.narrow_i16x8_s", none, 2, 1)           \
+  X(0x266, i8x16_narrow_i16x8_u, "i8x16.narrow_i16x8_u", none, 2, 1)           \
+  X(0x267, f32x4_ceil, "f32x4.ceil", none, 1, 1)                               \
+  X(0x268, f32x4_floor, "f32x4.floor", none, 1, 1)                             \
+  X(0x269, f32x4_trunc, "f32x4.trunc", none, 1, 1)                             \
+  X(0x26A, f32x4_nearest, "f32x4.nearest", none, 1, 1)                         \
+  X(0x26B, i8x16_shl, "i8x16.shl", none, 2, 1)                                 \
+  X(0x26C, i8x16_shr_s, "i8x16.shr_s", none, 2, 1)                             \
+  X(0x26D, i8x16_shr_u, "i8x16.shr_u", none, 2, 1)                             \
+  X(0x26E, i8x16_add, "i8x16.add", none, 2, 1)                                 \
+  X(0x26F, i8x16_add_sat_s, "i8x16.add_sat_s", none, 2, 1)                     \
+  X(0x270, i8x16_add_sat_u, "i8x16.add_sat_u", none, 2, 1)                     \
+  X(0x271, i8x16_sub, "i8x16.sub", none, 2, 1)                                 \
+  X(0x272, i8x16_sub_sat_s, "i8x16.sub_sat_s", none, 2, 1)                     \
+  X(0x273, i8x16_sub_sat_u, "i8x16.sub_sat_u", none, 2, 1)                     \
+  X(0x274, f64x2_ceil, "f64x2.ceil", none, 1, 1)                               \
+  X(0x275, f64x2_floor, "f64x2.floor", none, 1, 1)                             \
+  X(0x276, i8x16_min_s, "i8x16.min_s", none, 2, 1)                             \
+  X(0x277, i8x16_min_u, "i8x16.min_u", none, 2, 1)                             \
+  X(0x278, i8x16_max_s, "i8x16.max_s", none, 2, 1)                             \
+  X(0x279, i8x16_max_u, "i8x16.max_u", none, 2, 1)                             \
+  X(0x27A, f64x2_trunc, "f64x2.trunc", none, 1, 1)                             \
+  X(0x27B, i8x16_avgr_u, "i8x16.avgr_u", none, 2, 1)                           \
+  X(0x27C, i16x8_extadd_pairwise_i8x16_s, "i16x8.extadd_pairwise_i8x16_s",     \
+    none, 1, 1)                                                                \
+  X(0x27D, i16x8_extadd_pairwise_i8x16_u, "i16x8.extadd_pairwise_i8x16_u",     \
+    none, 1, 1)                                                                \
+  X(0x27E, i32x4_extadd_pairwise_i16x8_s, "i32x4.extadd_pairwise_i16x8_s",     \
+    none, 1, 1)                                                                \
+  X(0x27F, i32x4_extadd_pairwise_i16x8_u, "i32x4.extadd_pairwise_i16x8_u",     \
+    none, 1, 1)                                                                \
+  X(0x280, i16x8_abs, "i16x8.abs", none, 1, 1)                                 \
+  X(0x281, i16x8_neg, "i16x8.neg", none, 1, 1)                                 \
+  X(0x282, i16x8_q15mulr_sat_s, "i16x8.q15mulr_sat_s", none, 2, 1)             \
+  X(0x283, i16x8_all_true, "i16x8.all_true", none, 1, 1)                       \
+  X(0x284, i16x8_bitmask, "i16x8.bitmask", none, 1, 1)                         \
+  X(0x285, i16x8_narrow_i32x4_s, "i16x8.narrow_i32x4_s", none, 2, 1)           \
+  X(0x286, i16x8_narrow_i32x4_u, "i16x8.narrow_i32x4_u", none, 2, 1)           \
+  X(0x287, i16x8_extend_low_i8x16_s, "i16x8.extend_low_i8x16_s", none, 1, 1)   \
+  X(0x288, i16x8_extend_high_i8x16_s, "i16x8.extend_high_i8x16_s", none, 1, 1) \
+  X(0x289, i16x8_extend_low_i8x16_u, "i16x8.extend_low_i8x16_u", none, 1, 1)   \
+  X(0x28A, i16x8_extend_high_i8x16_u, "i16x8.extend_high_i8x16_u", none, 1, 1) \
+  X(0x28B, i16x8_shl, "i16x8.shl", none, 2, 1)                                 \
+  X(0x28C, i16x8_shr_s, "i16x8.shr_s", none, 2, 1)                             \
+  X(0x28D, i16x8_shr_u, "i16x8.shr_u", none, 2, 1)                             \
+  X(0x28E, i16x8_add, "i16x8.add", none, 2, 1)                                 \
+  X(0x28F, i16x8_add_sat_s, "i16x8.add_sat_s", none, 2, 1)                     \
+  X(0x290, i16x8_add_sat_u, "i16x8.add_sat_u", none, 2, 1)                     \
+  X(0x291, i16x8_sub, "i16x8.sub", none, 2, 1)                                 \
+  X(0x292, i16x8_sub_sat_s, "i16x8.sub_sat_s", none, 2, 1)                     \
+  X(0x293, i16x8_sub_sat_u, "i16x8.sub_sat_u", none, 2, 1)                     \
+  X(0x294, f64x2_nearest, "f64x2.nearest", none, 1, 1)                         \
+  X(0x295, i16x8_mul, "i16x8.mul", none, 2, 1)                                 \
+  X(0x296, i16x8_min_s, "i16x8.min_s", none, 2, 1)                             \
+  X(0x297, i16x8_min_u, "i16x8.min_u", none, 2, 1)                             \
+  X(0x298, i16x8_max_s, "i16x8.max_s", none, 2, 1)                             \
+  X(0x299, i16x8_max_u, "i16x8.max_u", none, 2, 1)                             \
+  X(0x29B, i16x8_avgr_u, "i16x8.avgr_u", none, 2, 1)                           \
+  X(0x29C, i16x8_extmul_low_i8x16_s, "i16x8.extmul_low_i8x16_s", none, 2, 1)   \
+  X(0x29D, i16x8_extmul_high_i8x16_s, "i16x8.extmul_high_i8x16_s", none, 2, 1) \
+  X(0x29E, i16x8_extmul_low_i8x16_u, "i16x8.extmul_low_i8x16_u", none, 2, 1)   \
+  X(0x29F, i16x8_extmul_high_i8x16_u, "i16x8.extmul_high_i8x16_u", none, 2, 1) \
+  X(0x2A0, i32x4_abs, "i32x4.abs", none, 1, 1)                                 \
+  X(0x2A1, i32x4_neg, "i32x4.neg", none, 1, 1)                                 \
+  X(0x2A3, i32x4_all_true, "i32x4.all_true", none, 1, 1)                       \
+  X(0x2A4, i32x4_bitmask, "i32x4.bitmask", none, 1, 1)                         \
+  X(0x2A7, i32x4_extend_low_i16x8_s, "i32x4.extend_low_i16x8_s", none, 1, 1)   \
+  X(0x2A8, i32x4_extend_high_i16x8_s, "i32x4.extend_high_i16x8_s", none, 1, 1) \
+  X(0x2A9, i32x4_extend_low_i16x8_u, "i32x4.extend_low_i16x8_u", none, 1, 1)   \
+  X(0x2AA, i32x4_extend_high_i16x8_u, "i32x4.extend_high_i16x8_u", none, 1, 1) \
+  X(0x2AB, i32x4_shl, "i32x4.shl", none, 2, 1)                                 \
+  X(0x2AC, i32x4_shr_s, "i32x4.shr_s", none, 2, 1)                             \
+  X(0x2AD, i32x4_shr_u, "i32x4.shr_u", none, 2, 1)                             \
+  X(0x2AE, i32x4_add, "i32x4.add", none, 2, 1)                                 \
+  X(0x2B1, i32x4_sub, "i32x4.sub", none, 2, 1)                                 \
+  X(0x2B5, i32x4_mul, "i32x4.mul", none, 2, 1)                                 \
+  X(0x2B6, i32x4_min_s, "i32x4.min_s", none, 2, 1)                             \
+  X(0x2B7, i32x4_min_u, "i32x4.min_u", none, 2, 1)                             \
+  X(0x2B8, i32x4_max_s, "i32x4.max_s", none, 2, 1)                             \
+  X(0x2B9, i32x4_max_u, "i32x4.max_u", none, 2, 1)                             \
+  X(0x2BA, i32x4_dot_i16x8_s, "i32x4.dot_i16x8_s", none, 2, 1)                 \
+  X(0x2BC, i32x4_extmul_low_i16x8_s, "i32x4.extmul_low_i16x8_s", none, 2, 1)   \
+  X(0x2BD, i32x4_extmul_high_i16x8_s, "i32x4.extmul_high_i16x8_s", none, 2, 1) \
+  X(0x2BE, i32x4_extmul_low_i16x8_u, "i32x4.extmul_low_i16x8_u", none, 2, 1)   \
+  X(0x2BF, i32x4_extmul_high_i16x8_u, "i32x4.extmul_high_i16x8_u", none, 2, 1) \
+  X(0x2C0, i64x2_abs, "i64x2.abs", none, 1, 1)                                 \
+  X(0x2C1, i64x2_neg, "i64x2.neg", none, 1, 1)                                 \
+  X(0x2C3, i64x2_all_true, "i64x2.all_true", none, 1, 1)                       \
+  X(0x2C4, i64x2_bitmask, "i64x2.bitmask", none, 1, 1)                         \
+  X(0x2C7, i64x2_extend_low_i32x4_s, "i64x2.extend_low_i32x4_s", none, 1, 1)   \
+  X(0x2C8, i64x2_extend_high_i32x4_s, "i64x2.extend_high_i32x4_s", none, 1, 1) \
+  X(0x2C9, i64x2_extend_low_i32x4_u, "i64x2.extend_low_i32x4_u", none, 1, 1)   \
+  X(0x2CA, i64x2_extend_high_i32x4_u, "i64x2.extend_high_i32x4_u", none, 1, 1) \
+  X(0x2CB, i64x2_shl, "i64x2.shl", none, 2, 1)                                 \
+  X(0x2CC, i64x2_shr_s, "i64x2.shr_s", none, 2, 1)                             \
+  X(0x2CD, i64x2_shr_u, "i64x2.shr_u", none, 2, 1)                             \
+  X(0x2CE, i64x2_add, "i64x2.add", none, 2, 1)                                 \
+  X(0x2D1, i64x2_sub, "i64x2.sub", none, 2, 1)                                 \
+  X(0x2D5, i64x2_mul, "i64x2.mul", none, 2, 1)                                 \
+  X(0x2D6, i64x2_eq, "i64x2.eq", none, 2, 1)                                   \
+  X(0x2D7, i64x2_ne, "i64x2.ne", none, 2, 1)                                   \
+  X(0x2D8, i64x2_lt_s, "i64x2.lt_s", none, 2, 1)                               \
+  X(0x2D9, i64x2_gt_s, "i64x2.gt_s", none, 2, 1)                               \
+  X(0x2DA, i64x2_le_s, "i64x2.le_s", none, 2, 1)                               \
+  X(0x2DB, i64x2_ge_s, "i64x2.ge_s", none, 2, 1)                               \
+  X(0x2DC, i64x2_extmul_low_i32x4_s, "i64x2.extmul_low_i32x4_s", none, 2, 1)   \
+  X(0x2DD, i64x2_extmul_high_i32x4_s, "i64x2.extmul_high_i32x4_s", none, 2, 1) \
+  X(0x2DE, i64x2_extmul_low_i32x4_u, "i64x2.extmul_low_i32x4_u", none, 2, 1)   \
+  X(0x2DF, i64x2_extmul_high_i32x4_u, "i64x2.extmul_high_i32x4_u", none, 2, 1) \
+  X(0x2E0, f32x4_abs, "f32x4.abs", none, 1, 1)                                 \
+  X(0x2E1, f32x4_neg, "f32x4.neg", none, 1, 1)                                 \
+  X(0x2E3, f32x4_sqrt, "f32x4.sqrt", none, 1, 1)                               \
+  X(0x2E4, f32x4_add, "f32x4.add", none, 2, 1)                                 \
+  X(0x2E5, f32x4_sub, "f32x4.sub", none, 2, 1)                                 \
+  X(0x2E6, f32x4_mul, "f32x4.mul", none, 2, 1)                                 \
+  X(0x2E7, f32x4_div, "f32x4.div", none, 2, 1)                                 \
+  X(0x2E8, f32x4_min, "f32x4.min", none, 2, 1)                                 \
+  X(0x2E9, f32x4_max, "f32x4.max", none, 2, 1)                                 \
+  X(0x2EA, f32x4_pmin, "f32x4.pmin", none, 2, 1)                               \
+  X(0x2EB, f32x4_pmax, "f32x4.pmax", none, 2, 1)                               \
+  X(0x2EC, f64x2_abs, "f64x2.abs", none, 1, 1)                                 \
+  X(0x2ED, f64x2_neg, "f64x2.neg", none, 1, 1)                                 \
+  X(0x2EF, f64x2_sqrt, "f64x2.sqrt", none, 1, 1)                               \
+  X(0x2F0, f64x2_add, "f64x2.add", none, 2, 1)                                 \
+  X(0x2F1, f64x2_sub, "f64x2.sub", none, 2, 1)                                 \
+  X(0x2F2, f64x2_mul, "f64x2.mul", none, 2, 1)                                 \
+  X(0x2F3, f64x2_div, "f64x2.div", none, 2, 1)                                 \
+  X(0x2F4, f64x2_min, "f64x2.min", none, 2, 1)                                 \
+  X(0x2F5, f64x2_max, "f64x2.max", none, 2, 1)                                 \
+  X(0x2F6, f64x2_pmin, "f64x2.pmin", none, 2, 1)                               \
+  X(0x2F7, f64x2_pmax, "f64x2.pmax", none, 2, 1)                               \
+  X(0x2F8, i32x4_trunc_sat_f32x4_s, "i32x4.trunc_sat_f32x4_s", none, 1, 1)     \
+  X(0x2F9, i32x4_trunc_sat_f32x4_u, "i32x4.trunc_sat_f32x4_u", none, 1, 1)     \
+  X(0x2FA, f32x4_convert_i32x4_s, "f32x4.convert_i32x4_s", none, 1, 1)         \
+  X(0x2FB, f32x4_convert_i32x4_u, "f32x4.convert_i32x4_u", none, 1, 1)         \
+  X(0x2FC, i32x4_trunc_sat_f64x2_s_zero, "i32x4.trunc_sat_f64x2_s_zero",       \
+    none, 1, 1)                                                                \
+  X(0x2FD, i32x4_trunc_sat_f64x2_u_zero, "i32x4.trunc_sat_f64x2_u_zero",       \
+    none, 1, 1)                                                                \
+  X(0x2FE, f64x2_convert_low_i32x4_s, "f64x2.convert_low_i32x4_s", none, 1, 1) \
+  X(0x2FF, f64x2_convert_low_i32x4_u, "f64x2.convert_low_i32x4_u", none, 1, 1) \
+  X(0x400, memory_atomic_notify, "memory.atomic.notify", memarg, 2, 1)         \
+  X(0x401, memory_atomic_wait32, "memory.atomic.wait32", memarg, 3, 1)         \
+  X(0x402, memory_atomic_wait64, "memory.atomic.wait64", memarg, 3, 1)         \
+  X(0x403, atomic_fence, "atomic.fence", reserved, 0, 0)                       \
+  X(0x410, i32_atomic_load, "i32.atomic.load", memarg, 1, 1)                   \
+  X(0x411, i64_atomic_load, "i64.atomic.load", memarg, 1, 1)                   \
+  X(0x412, i32_atomic_load8_u, "i32.atomic.load8_u", memarg, 1, 1)             \
+  X(0x413, i32_atomic_load16_u, "i32.atomic.load16_u", memarg, 1, 1)           \
+  X(0x414, i64_atomic_load8_u, "i64.atomic.load8_u", memarg, 1, 1)             \
+  X(0x415, i64_atomic_load16_u, "i64.atomic.load16_u", memarg, 1, 1)           \
+  X(0x416, i64_atomic_load32_u, "i64.atomic.load32_u", memarg, 1, 1)           \
+  X(0x417, i32_atomic_store, "i32.atomic.store", memarg, 2, 0)                 \
+  X(0x418, i64_atomic_store, "i64.atomic.store", memarg, 2, 0)                 \
+  X(0x419, i32_atomic_store8, "i32.atomic.store8", memarg, 2, 0)               \
+  X(0x41A, i32_atomic_store16, "i32.atomic.store16", memarg, 2, 0)             \
+  X(0x41B, i64_atomic_store8, "i64.atomic.store8", memarg, 2, 0)               \
+  X(0x41C, i64_atomic_store16, "i64.atomic.store16", memarg, 2, 0)             \
+  X(0x41D, i64_atomic_store32, "i64.atomic.store32", memarg, 2, 0)             \
+  X(0x41E, i32_atomic_rmw_add, "i32.atomic.rmw.add", memarg, 2, 1)             \
+  X(0x41F, i64_atomic_rmw_add, "i64.atomic.rmw.add", memarg, 2, 1)             \
+  X(0x420, i32_atomic_rmw8_add_u, "i32.atomic.rmw8.add_u", memarg, 2, 1)       \
+  X(0x421, i32_atomic_rmw16_add_u, "i32.atomic.rmw16.add_u", memarg, 2, 1)     \
+  X(0x422, i64_atomic_rmw8_add_u, "i64.atomic.rmw8.add_u", memarg, 2, 1)       \
+  X(0x423, i64_atomic_rmw16_add_u, "i64.atomic.rmw16.add_u", memarg, 2, 1)     \
+  X(0x424, i64_atomic_rmw32_add_u, "i64.atomic.rmw32.add_u", memarg, 2, 1)     \
+  X(0x425, i32_atomic_rmw_sub, "i32.atomic.rmw.sub", memarg, 2, 1)             \
+  X(0x426, i64_atomic_rmw_sub, "i64.atomic.rmw.sub", memarg, 2, 1)             \
+  X(0x427, i32_atomic_rmw8_sub_u, "i32.atomic.rmw8.sub_u", memarg, 2, 1)       \
+  X(0x428, i32_atomic_rmw16_sub_u, "i32.atomic.rmw16.sub_u", memarg, 2, 1)     \
+  X(0x429, i64_atomic_rmw8_sub_u, "i64.atomic.rmw8.sub_u", memarg, 2, 1)       \
+  X(0x42A, i64_atomic_rmw16_sub_u, "i64.atomic.rmw16.sub_u", memarg, 2, 1)     \
+  X(0x42B, i64_atomic_rmw32_sub_u, "i64.atomic.rmw32.sub_u", memarg, 2, 1)     \
+  X(0x42C, i32_atomic_rmw_and, "i32.atomic.rmw.and", memarg, 2, 1)             \
+  X(0x42D, i64_atomic_rmw_and, "i64.atomic.rmw.and", memarg, 2, 1)             \
+  X(0x42E, i32_atomic_rmw8_and_u, "i32.atomic.rmw8.and_u", memarg, 2, 1)       \
+  X(0x42F, i32_atomic_rmw16_and_u, "i32.atomic.rmw16.and_u", memarg, 2, 1)     \
+  X(0x430, i64_atomic_rmw8_and_u, "i64.atomic.rmw8.and_u", memarg, 2, 1)       \
+  X(0x431, i64_atomic_rmw16_and_u, "i64.atomic.rmw16.and_u", memarg, 2, 1)     \
+  X(0x432, i64_atomic_rmw32_and_u, "i64.atomic.rmw32.and_u", memarg, 2, 1)     \
+  X(0x433, i32_atomic_rmw_or, "i32.atomic.rmw.or", memarg, 2, 1)               \
+  X(0x434, i64_atomic_rmw_or, "i64.atomic.rmw.or", memarg, 2, 1)               \
+  X(0x435, i32_atomic_rmw8_or_u, "i32.atomic.rmw8.or_u", memarg, 2, 1)         \
+  X(0x436, i32_atomic_rmw16_or_u, "i32.atomic.rmw16.or_u", memarg, 2, 1)       \
+  X(0x437, i64_atomic_rmw8_or_u, "i64.atomic.rmw8.or_u", memarg, 2, 1)         \
+  X(0x438, i64_atomic_rmw16_or_u, "i64.atomic.rmw16.or_u", memarg, 2, 1)       \
+  X(0x439, i64_atomic_rmw32_or_u, "i64.atomic.rmw32.or_u", memarg, 2, 1)       \
+  X(0x43A, i32_atomic_rmw_xor, "i32.atomic.rmw.xor", memarg, 2, 1)             \
+  X(0x43B, i64_atomic_rmw_xor, "i64.atomic.rmw.xor", memarg, 2, 1)             \
+  X(0x43C, i32_atomic_rmw8_xor_u, "i32.atomic.rmw8.xor_u", memarg, 2, 1)       \
+  X(0x43D, i32_atomic_rmw16_xor_u, "i32.atomic.rmw16.xor_u", memarg, 2, 1)     \
+  X(0x43E, i64_atomic_rmw8_xor_u, "i64.atomic.rmw8.xor_u", memarg, 2, 1)       \
+  X(0x43F, i64_atomic_rmw16_xor_u, "i64.atomic.rmw16.xor_u", memarg, 2, 1)     \
+  X(0x440, i64_atomic_rmw32_xor_u, "i64.atomic.rmw32.xor_u", memarg, 2, 1)     \
+  X(0x441, i32_atomic_rmw_xchg, "i32.atomic.rmw.xchg", memarg, 2, 1)           \
+  X(0x442, i64_atomic_rmw_xchg, "i64.atomic.rmw.xchg", memarg, 2, 1)           \
+  X(0x443, i32_atomic_rmw8_xchg_u, "i32.atomic.rmw8.xchg_u", memarg, 2, 1)     \
+  X(0x444, i32_atomic_rmw16_xchg_u, "i32.atomic.rmw16.xchg_u", memarg, 2, 1)   \
+  X(0x445, i64_atomic_rmw8_xchg_u, "i64.atomic.rmw8.xchg_u", memarg, 2, 1)     \
+  X(0x446, i64_atomic_rmw16_xchg_u, "i64.atomic.rmw16.xchg_u", memarg, 2, 1)   \
+  X(0x447, i64_atomic_rmw32_xchg_u, "i64.atomic.rmw32.xchg_u", memarg, 2, 1)   \
+  X(0x448, i32_atomic_rmw_cmpxchg, "i32.atomic.rmw.cmpxchg", memarg, 3, 1)     \
+  X(0x449, i64_atomic_rmw_cmpxchg, "i64.atomic.rmw.cmpxchg", memarg, 3, 1)     \
+  X(0x44A, i32_atomic_rmw8_cmpxchg_u, "i32.atomic.rmw8.cmpxchg_u",             \
+    memarg, 3, 1)                                                              \
+  X(0x44B, i32_atomic_rmw16_cmpxchg_u, "i32.atomic.rmw16.cmpxchg_u",           \
+    memarg, 3, 1)                                                              \
+  X(0x44C, i64_atomic_rmw8_cmpxchg_u, "i64.atomic.rmw8.cmpxchg_u",             \
+    memarg, 3, 1)                                                              \
+  X(0x44D, i64_atomic_rmw16_cmpxchg_u, "i64.atomic.rmw16.cmpxchg_u",           \
+    memarg, 3, 1)                                                              \
+  X(0x44E, i64_atomic_rmw32_cmpxchg_u, "i64.atomic.rmw32.cmpxchg_u",           \
+    memarg, 3, 1)
+
+#define wasm_opcode_prefix_fc 0x100
+#define wasm_opcode_prefix_fd 0x200
+#define wasm_opcode_prefix_fe 0x400
+
+// Kind of immediate that follows an opcode.
+enum wasm_immediate {
+  wasm_imm_none,
+  // Block type, 0x40 or a value type.
+  wasm_imm_block,
+  // Label index.
+  wasm_imm_label,
+  // vec(label index) followed by the default label.
+  wasm_imm_br_table,
+  // Function index.
+  wasm_imm_func,
+  // Type index and table index.
+  wasm_imm_call_indirect,
+  wasm_imm_local,
+  wasm_imm_global,
+  // Alignment and offset.
+  wasm_imm_memarg,
+  // A single reserved 0x00 byte.
+  wasm_imm_memory,
+  // Data segment index followed by a reserved 0x00 byte.
+  wasm_imm_memory_init,
+  // Two reserved 0x00 bytes.
+  wasm_imm_memory_copy,
+  // Data segment index.
+  wasm_imm_data,
+  wasm_imm_i32,
+  wasm_imm_i64,
+  wasm_imm_f32,
+  wasm_imm_f64,
+  // 16 bytes of a `v128.const`.
+  wasm_imm_v128,
+  // 16 lane indices of `i8x16.shuffle`.
+  wasm_imm_shuffle,
+  // Lane index of extract/replace lane instructions.
+  wasm_imm_lane,
+  // Alignment, offset and lane index.
+  wasm_imm_memarg_lane,
+  // A single reserved 0x00 byte that doesn't refer to a memory.
+  wasm_imm_reserved,
+};
+
+enum wasm_opcode {
+#define WASM_OPCODE_ENUM(code, ident, text, imm, pops, pushes)                 \
+  wasm_op_##ident = code,
+  WASM_OPCODES(WASM_OPCODE_ENUM)
+#undef WASM_OPCODE_ENUM
+};
@@ -0,0 +1,202 @@
+#include "wasm/wasm_perf.h"
+
+#include "wasm/wasm_common.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+static const uint64_t wasm_perf_configs[wasm_perf_event_count] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+#endif
+
+// The counters of a thread are one group, so they are read with a single
+// syscall and are always scheduled together.
+typedef struct {
+  wasm_perf_stats *stats;
+  int fds[wasm_perf_event_count];
+  // Number of open counters and their events in the order of the group.
+  uint32_t count;
+  enum wasm_perf_event order[wasm_perf_event_count];
+} wasm_perf_thread;
+
+static __thread wasm_perf_thread wasm_perf_current = {.stats = NULL};
+
+void wasm_init_perf_stats(wasm_perf_stats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  wasm_vec_init(&stats->funcs);
+}
+
+void wasm_deinit_perf_stats(wasm_perf_stats *stats) {
+  wasm_vec_deinit(&stats->funcs);
+}
+
+#ifdef __linux__
+static int wasm_perf_event_open(uint64_t config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void wasm_perf_open(wasm_perf_thread *thread) {
+  thread->count = 0;
+  for (int i = 0; i < wasm_perf_event_count; i++) {
+    // Events the CPU doesn't have are left out.
+    int group = thread->count ? thread->fds[0] : -1;
+    int fd = wasm_perf_event_open(wasm_perf_configs[i], group);
+    if (fd >= 0) {
+      thread->fds[thread->count] = fd;
+      thread->order[thread->count++] = (enum wasm_perf_event)i;
+    }
+  }
+}
+#else
+// Other hosts have no counters, only the time is measured.
+static void wasm_perf_open(wasm_perf_thread *thread) { thread->count = 0; }
+#endif
+
+static void wasm_perf_close(wasm_perf_thread *thread) {
+  for (uint32_t i = 0; i < thread->count; i++) {
+    close(thread->fds[i]);
+  }
+  thread->count = 0;
+}
+
+void wasm_set_perf_stats(wasm_perf_stats *stats) {
+  wasm_perf_thread *thread = &wasm_perf_current;
+  if (stats && thread->stats == NULL) {
+    wasm_perf_open(thread);
+  } else if (stats == NULL) {
+    wasm_perf_close(thread);
+  }
+
+  thread->stats = stats;
+  if (stats) {
+    stats->events = 0;
+    for (uint32_t i = 0; i < thread->count; i++) {
+      stats->events |= 1u << thread->order[i];
+    }
+  }
+}
+
+wasm_perf_stats *wasm_get_perf_stats() { return wasm_perf_current.stats; }
+
+void wasm_perf_read(wasm_perf_sample *sample) {
+  wasm_perf_thread *thread = &wasm_perf_current;
+  memset(sample->events, 0, sizeof(sample->events));
+  if (thread->count) {
+    struct {
+      uint64_t count;
+      uint64_t values[wasm_perf_event_count];
+    } group;
+    ssize_t size = read(thread->fds[0], &group, sizeof(group));
+    if (size >= (ssize_t)sizeof(uint64_t)) {
+      for (uint64_t i = 0; i < group.count && i < thread->count; i++) {
+        sample->events[thread->order[i]] = group.values[i];
+      }
+    }
+  }
+  // The counters are read first so they don't include the clock.
+  sample->ns = wasm_now_ns();
+}
+
+void wasm_perf_add(wasm_perf_sample *total, const wasm_perf_sample *start) {
+  wasm_perf_sample end;
+  wasm_perf_read(&end);
+  total->ns += end.ns - start->ns;
+  for (int i = 0; i < wasm_perf_event_count; i++) {
+    total->events[i] += end.events[i] - start->events[i];
+  }
+}
+
+const char *wasm_perf_event_name(enum wasm_perf_event event) {
+  static const char *names[wasm_perf_event_count] = {
+      "cycles", "instructions", "cache-misses", "branch-misses"};
+  return (unsigned)event < wasm_perf_event_count ? names[event] : "unknown";
+}
+
+static void wasm_print_perf_sample(FILE *out, uint32_t events,
+                                   const char *name,
+                                   const wasm_perf_sample *sample) {
+  fprintf(out, "%-28s %12.1f", name, (double)sample->ns / 1000.0);
+  for (int i = 0; i < wasm_perf_event_count; i++) {
+    if (events & (1u << i)) {
+      fprintf(out, " %14llu", (unsigned long long)sample->events[i]);
+    } else {
+      fprintf(out, " %14s", "-");
+    }
+  }
+  fputc('\n', out);
+}
+
+static int wasm_compare_func_cycles(const void *a, const void *b) {
+  uint64_t x = ((const wasm_perf_func *)a)->sample.events[wasm_perf_cycles];
+  uint64_t y = ((const wasm_perf_func *)b)->sample.events[wasm_perf_cycles];
+  return (x < y) - (x > y);
+}
+
+static int wasm_compare_func_ns(const void *a, const void *b) {
+  uint64_t x = ((const wasm_perf_func *)a)->sample.ns;
+  uint64_t y = ((const wasm_perf_func *)b)->sample.ns;
+  return (x < y) - (x > y);
+}
+
+void wasm_print_perf_stats(FILE *out, const wasm_perf_stats *stats,
+                           size_t max_funcs) {
+  uint32_t events = stats->events;
+  fprintf(out, "%-28s %12s", "phase", "us");
+  for (int i = 0; i < wasm_perf_event_count; i++) {
+    fprintf(out, " %14s", wasm_perf_event_name((enum wasm_perf_event)i));
+  }
+  fputc('\n', out);
+
+  char name[64];
+  wasm_print_perf_sample(out, events, "header", &stats->header);
+  for (unsigned char id = 0; id < wasm_section_count; id++) {
+    const wasm_perf_sample *sample = &stats->sections[id];
+    if (sample->ns) {
+      snprintf(name, sizeof(name), "section %s", wasm_section_name(id));
+      wasm_print_perf_sample(out, events, name, sample);
+    }
+  }
+
+  // The most expensive bodies.
+  size_t func_count = wasm_vec_size(&stats->funcs);
+  if (func_count > 0 && max_funcs > 0) {
+    wasm_perf_func *funcs = wasm_alloc_array(wasm_perf_func, func_count);
+    memcpy(funcs, stats->funcs.start, func_count * sizeof(wasm_perf_func));
+    qsort(funcs, func_count, sizeof(wasm_perf_func),
+          events & (1u << wasm_perf_cycles) ? wasm_compare_func_cycles
+                                            : wasm_compare_func_ns);
+    for (size_t i = 0; i < func_count && i < max_funcs; i++) {
+      snprintf(name, sizeof(name), "  func %u (%u bytes)", funcs[i].funcidx,
+               funcs[i].size);
+      wasm_print_perf_sample(out, events, name, &funcs[i].sample);
+    }
+    wasm_free(funcs);
+  }
+
+  wasm_print_perf_sample(out, events, "compile", &stats->compile);
+  wasm_print_perf_sample(out, events, "instantiate", &stats->instantiate);
+  snprintf(name, sizeof(name), "invoke (%llu calls)",
+           (unsigned long long)stats->invoke_count);
+  wasm_print_perf_sample(out, events, name, &stats->invoke);
+  if (events == 0) {
+    fputs("Hardware counters are not available, only the time was "
+          "measured.\n",
+          out);
+  }
+}
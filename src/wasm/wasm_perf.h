@@ -0,0 +1,73 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Hardware counters of the phases of module loads and calls. A thread starts
+// recording with `wasm_set_perf_stats`. The counters are read with
+// `perf_event_open` and only count the calling thread in user space. Where the
+// kernel doesn't provide them (containers, VMs, other systems) only the time
+// is measured.
+
+enum wasm_perf_event {
+  wasm_perf_cycles,
+  wasm_perf_instructions,
+  wasm_perf_cache_misses,
+  wasm_perf_branch_misses,
+  wasm_perf_event_count,
+};
+
+typedef struct {
+  uint64_t ns;
+  uint64_t events[wasm_perf_event_count];
+} wasm_perf_sample;
+
+// Decoding of one function body.
+typedef struct {
+  uint32_t funcidx;
+  uint32_t size;
+  wasm_perf_sample sample;
+} wasm_perf_func;
+typedef wasm_vec_of(wasm_perf_func) wasm_perf_func_vec;
+
+typedef struct {
+  // Bit `i` is set if `wasm_perf_event` `i` was counted.
+  uint32_t events;
+  wasm_perf_sample header;
+  // Indexed by section id, custom sections are counted at 0. They include
+  // the functions below.
+  wasm_perf_sample sections[wasm_section_count];
+  // In the order the bodies were decoded.
+  wasm_perf_func_vec funcs;
+  // Validation and compilation of the bodies by `wasm_instantiate`.
+  wasm_perf_sample compile;
+  wasm_perf_sample instantiate;
+  // Outermost calls of `wasm_invoke`.
+  wasm_perf_sample invoke;
+  uint64_t invoke_count;
+} wasm_perf_stats;
+
+void wasm_init_perf_stats(wasm_perf_stats *stats);
+void wasm_deinit_perf_stats(wasm_perf_stats *stats);
+
+// Adds the module loads, instantiations and calls of the calling thread to
+// `stats` from now on. NULL stops recording and closes the counters of the
+// thread.
+void wasm_set_perf_stats(wasm_perf_stats *stats);
+// Returns the stats the calling thread records into or NULL.
+wasm_perf_stats *wasm_get_perf_stats();
+
+// Reads the clock and the counters of the calling thread.
+void wasm_perf_read(wasm_perf_sample *sample);
+// Adds what happened since `start` to `total`.
+void wasm_perf_add(wasm_perf_sample *total, const wasm_perf_sample *start);
+
+// Returns e.g. "cycles".
+const char *wasm_perf_event_name(enum wasm_perf_event event);
+
+// Prints a table of the phases and the `max_funcs` functions that took the
+// most cycles, or time without counters.
+void wasm_print_perf_stats(FILE *out, const wasm_perf_stats *stats,
+                           size_t max_funcs);
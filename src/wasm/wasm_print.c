@@ -0,0 +1,934 @@
+#include "wasm/wasm_print.h"
+
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_opcodes.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Text is written in blocks of about this size.
+#define wasm_text_buffer_size ((size_t)1 << 20)
+// Bodies are printed in chunks of about this many bytes of code.
+#define wasm_text_chunk_bytes (64 * 1024)
+// Room for a line with any instruction except `br_table`, after the indent.
+#define wasm_text_line_max 192
+// Same limit as the compiler.
+#define wasm_text_max_locals 50000
+
+typedef struct {
+  const char *text;
+  uint8_t length;
+  uint8_t imm;
+} wasm_text_opcode;
+
+static const wasm_text_opcode wasm_text_opcodes[0x500] = {
+#define WASM_TEXT_OPCODE(code, ident, text, imm, pops, pushes)                 \
+  [code] = {text, sizeof(text) - 1, wasm_imm_##imm},
+    WASM_OPCODES(WASM_TEXT_OPCODE)
+#undef WASM_TEXT_OPCODE
+};
+
+// Indexed by `enum wasm_valtype`.
+static const char *const wasm_text_valtypes[] = {"", "i32", "i64", "f32",
+                                                 "f64", "v128"};
+
+static const char wasm_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char wasm_hex_digits[16] = "0123456789abcdef";
+
+static void wasm_init_text_out_n(wasm_text_out *out, int fd,
+                                 size_t capacity) {
+  out->fd = fd;
+  out->data = wasm_alloc_n(capacity);
+  out->size = 0;
+  out->capacity = capacity;
+  out->written = 0;
+  out->failed = false;
+}
+
+void wasm_init_text_out(wasm_text_out *out, int fd) {
+  wasm_init_text_out_n(out, fd, wasm_text_buffer_size);
+}
+
+void wasm_deinit_text_out(wasm_text_out *out) {
+  wasm_free(out->data);
+  out->data = NULL;
+  out->size = 0;
+  out->capacity = 0;
+}
+
+static void wasm_text_write(wasm_text_out *out, const char *data,
+                            size_t size) {
+  while (!out->failed && size > 0) {
+    ssize_t n = write(out->fd, data, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      out->failed = true;
+      break;
+    }
+    data += n;
+    size -= (size_t)n;
+    out->written += (uint64_t)n;
+  }
+}
+
+bool wasm_flush_text_out(wasm_text_out *out) {
+  if (out->fd >= 0) {
+    wasm_text_write(out, out->data, out->size);
+    out->size = 0;
+  }
+  return !out->failed;
+}
+
+// Makes room for `n` more bytes and returns where they go. The text is
+// committed with `wasm_text_commit`.
+static char *wasm_text_reserve(wasm_text_out *out, size_t n) {
+  if (out->capacity - out->size < n) {
+    wasm_flush_text_out(out);
+    if (out->capacity - out->size < n) {
+      size_t capacity = out->capacity * 2;
+      if (capacity < out->size + n) {
+        capacity = out->size + n;
+      }
+      out->data = wasm_realloc_n(out->data, capacity);
+      out->capacity = capacity;
+    }
+  }
+  return out->data + out->size;
+}
+
+static void wasm_text_commit(wasm_text_out *out, char *end) {
+  out->size = (size_t)(end - out->data);
+}
+
+static void wasm_text_append(wasm_text_out *out, const char *data,
+                             size_t size) {
+  // Large blocks go to the file directly.
+  if (out->fd >= 0 && size >= out->capacity) {
+    wasm_flush_text_out(out);
+    wasm_text_write(out, data, size);
+    return;
+  }
+  char *p = wasm_text_reserve(out, size);
+  memcpy(p, data, size);
+  wasm_text_commit(out, p + size);
+}
+
+static char *wasm_put(char *p, const char *text, size_t length) {
+  memcpy(p, text, length);
+  return p + length;
+}
+
+#define wasm_put_lit(p, text) wasm_put(p, text, sizeof(text) - 1)
+
+static char *wasm_put_u64(char *p, uint64_t value) {
+  char digits[20];
+  char *end = digits + sizeof(digits), *d = end;
+  while (value >= 100) {
+    d -= 2;
+    memcpy(d, wasm_digit_pairs + value % 100 * 2, 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    d -= 2;
+    memcpy(d, wasm_digit_pairs + value * 2, 2);
+  } else {
+    *--d = (char)('0' + value);
+  }
+  return wasm_put(p, d, (size_t)(end - d));
+}
+
+static char *wasm_put_s64(char *p, int64_t value) {
+  if (value < 0) {
+    *p++ = '-';
+    return wasm_put_u64(p, 0 - (uint64_t)value);
+  }
+  return wasm_put_u64(p, (uint64_t)value);
+}
+
+// Writes the low `digits` hex digits of `value`.
+static char *wasm_put_hex(char *p, uint64_t value, int digits) {
+  for (int i = digits - 1; i >= 0; i--) {
+    p[i] = wasm_hex_digits[value & 0xF];
+    value >>= 4;
+  }
+  return p + digits;
+}
+
+static char *wasm_put_hex_min(char *p, uint64_t value) {
+  int digits = 1;
+  while (digits < 16 && value >> (digits * 4)) {
+    digits++;
+  }
+  return wasm_put_hex(p, value, digits);
+}
+
+// Writes a float as exact hex, e.g. 0x1.8p+1, or inf, nan and nan:0x1 for
+// payloads other than the canonical one.
+static char *wasm_put_float(char *p, uint64_t bits, int mantissa_bits,
+                            int exponent_bits) {
+  uint64_t mantissa = bits & (((uint64_t)1 << mantissa_bits) - 1);
+  int max_exponent = (1 << exponent_bits) - 1;
+  int exponent = (int)(bits >> mantissa_bits) & max_exponent;
+  int bias = max_exponent / 2;
+  if (bits >> (mantissa_bits + exponent_bits)) {
+    *p++ = '-';
+  }
+
+  if (exponent == max_exponent) {
+    if (mantissa == 0) {
+      return wasm_put_lit(p, "inf");
+    }
+    p = wasm_put_lit(p, "nan");
+    if (mantissa != (uint64_t)1 << (mantissa_bits - 1)) {
+      p = wasm_put_lit(p, ":0x");
+      p = wasm_put_hex_min(p, mantissa);
+    }
+    return p;
+  }
+  if (exponent == 0 && mantissa == 0) {
+    return wasm_put_lit(p, "0x0p+0");
+  }
+
+  if (exponent == 0) {
+    // Subnormals are normalized.
+    exponent = 1 - bias;
+    while (!(mantissa >> mantissa_bits)) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    mantissa &= ((uint64_t)1 << mantissa_bits) - 1;
+  } else {
+    exponent -= bias;
+  }
+
+  p = wasm_put_lit(p, "0x1");
+  if (mantissa) {
+    int digits = (mantissa_bits + 3) / 4;
+    mantissa <<= digits * 4 - mantissa_bits;
+    while ((mantissa & 0xF) == 0) {
+      mantissa >>= 4;
+      digits--;
+    }
+    *p++ = '.';
+    p = wasm_put_hex(p, mantissa, digits);
+  }
+  *p++ = 'p';
+  *p++ = exponent < 0 ? '-' : '+';
+  return wasm_put_u64(p, (uint64_t)(exponent < 0 ? -exponent : exponent));
+}
+
+// Writes a quoted string. Needs room for `3 * size + 2` bytes.
+static char *wasm_put_string(char *p, const unsigned char *data, size_t size) {
+  *p++ = '"';
+  for (size_t i = 0; i < size; i++) {
+    unsigned char c = data[i];
+    if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\') {
+      *p++ = (char)c;
+    } else {
+      *p++ = '\\';
+      *p++ = wasm_hex_digits[c >> 4];
+      *p++ = wasm_hex_digits[c & 0xF];
+    }
+  }
+  *p++ = '"';
+  return p;
+}
+
+static char *wasm_put_valtype(char *p, enum wasm_valtype type) {
+  const char *text = (unsigned)type < 6 ? wasm_text_valtypes[type] : "";
+  return wasm_put(p, text, strlen(text));
+}
+
+static char *wasm_put_limits(char *p, const wasm_limits *limits) {
+  p = wasm_put_u64(p, limits->min);
+  if (limits->has_max) {
+    *p++ = ' ';
+    p = wasm_put_u64(p, limits->max);
+  }
+  if (limits->is_shared) {
+    p = wasm_put_lit(p, " shared");
+  }
+  return p;
+}
+
+// Writes ` (;index;)`.
+static char *wasm_put_index_comment(char *p, uint64_t index) {
+  p = wasm_put_lit(p, " (;");
+  p = wasm_put_u64(p, index);
+  return wasm_put_lit(p, ";)");
+}
+
+// Decodes the instructions of a body or a constant expression. The input is
+// trusted to be as long as the loader checked, but its contents are not.
+typedef struct {
+  wasm_text_out *out;
+  const unsigned char *pos;
+  const unsigned char *end;
+  // Number of enclosing blocks.
+  uint32_t depth;
+} wasm_text_printer;
+
+static bool wasm_text_byte(wasm_text_printer *t, unsigned char *out) {
+  if (t->pos == t->end) {
+    return false;
+  }
+  *out = *t->pos++;
+  return true;
+}
+
+static bool wasm_text_u32(wasm_text_printer *t, uint32_t *out) {
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35 && t->pos < t->end; shift += 7) {
+    unsigned char byte = *t->pos++;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *out = value;
+      return shift < 28 || byte < 0x10;
+    }
+  }
+  return false;
+}
+
+static bool wasm_text_s64(wasm_text_printer *t, int64_t *out, int bits) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < bits + 7 && t->pos < t->end; shift += 7) {
+    unsigned char byte = *t->pos++;
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      shift += 7;
+      if (shift < 64 && (byte & 0x40)) {
+        value |= ~(uint64_t)0 << shift;
+      }
+      *out = (int64_t)value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool wasm_text_bytes(wasm_text_printer *t, void *out, size_t size) {
+  if ((size_t)(t->end - t->pos) < size) {
+    return false;
+  }
+  memcpy(out, t->pos, size);
+  t->pos += size;
+  return true;
+}
+
+static bool wasm_text_opcode_at(wasm_text_printer *t, uint16_t *op) {
+  unsigned char byte;
+  if (!wasm_text_byte(t, &byte)) {
+    return false;
+  }
+  *op = byte;
+  if (byte >= 0xFC && byte <= 0xFE) {
+    static const uint16_t prefixes[3] = {
+        wasm_opcode_prefix_fc, wasm_opcode_prefix_fd, wasm_opcode_prefix_fe};
+    uint32_t sub;
+    if (!wasm_text_u32(t, &sub) || sub >= 0x100) {
+      return false;
+    }
+    *op = (uint16_t)(prefixes[byte - 0xFC] + sub);
+  }
+  return wasm_text_opcodes[*op].text != NULL;
+}
+
+// Writes ` N (;@L;)` for a branch to depth `N`.
+static bool wasm_text_label(wasm_text_printer *t, char **p) {
+  uint32_t depth;
+  if (!wasm_text_u32(t, &depth) || depth > t->depth) {
+    return false;
+  }
+  *(*p)++ = ' ';
+  *p = wasm_put_u64(*p, depth);
+  *p = wasm_put_lit(*p, " (;@");
+  *p = wasm_put_u64(*p, t->depth - depth);
+  *p = wasm_put_lit(*p, ";)");
+  return true;
+}
+
+static bool wasm_text_memarg(wasm_text_printer *t, uint16_t op, char **p) {
+  uint32_t align, offset;
+  if (!wasm_text_u32(t, &align) || !wasm_text_u32(t, &offset) || align > 16) {
+    return false;
+  }
+  if (offset) {
+    *p = wasm_put_lit(*p, " offset=");
+    *p = wasm_put_u64(*p, offset);
+  }
+  if (align != wasm_natural_align(op)) {
+    *p = wasm_put_lit(*p, " align=");
+    *p = wasm_put_u64(*p, (uint64_t)1 << align);
+  }
+  return true;
+}
+
+// Writes the immediates of most instructions. Needs `wasm_text_line_max`
+// bytes.
+static bool wasm_text_immediates(wasm_text_printer *t, uint16_t op, char **p) {
+  uint32_t index;
+  unsigned char byte;
+  switch ((enum wasm_immediate)wasm_text_opcodes[op].imm) {
+  case wasm_imm_none:
+    return true;
+  case wasm_imm_block:
+    if (!wasm_text_byte(t, &byte)) {
+      return false;
+    }
+    if (byte != 0x40) {
+      static const char *const types[5] = {"v128", "f64", "f32", "i64",
+                                           "i32"};
+      if (byte < 0x7B || byte > 0x7F) {
+        return false;
+      }
+      *p = wasm_put_lit(*p, " (result ");
+      *p = wasm_put(*p, types[byte - 0x7B], strlen(types[byte - 0x7B]));
+      *(*p)++ = ')';
+    }
+    *p = wasm_put_lit(*p, "  ;; label = @");
+    *p = wasm_put_u64(*p, ++t->depth);
+    return true;
+  case wasm_imm_label:
+    return wasm_text_label(t, p);
+  case wasm_imm_func:
+  case wasm_imm_local:
+  case wasm_imm_global:
+  case wasm_imm_data:
+    if (!wasm_text_u32(t, &index)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_u64(*p, index);
+    return true;
+  case wasm_imm_call_indirect: {
+    uint32_t tableidx;
+    if (!wasm_text_u32(t, &index) || !wasm_text_u32(t, &tableidx)) {
+      return false;
+    }
+    if (tableidx) {
+      *(*p)++ = ' ';
+      *p = wasm_put_u64(*p, tableidx);
+    }
+    *p = wasm_put_lit(*p, " (type ");
+    *p = wasm_put_u64(*p, index);
+    *(*p)++ = ')';
+    return true;
+  }
+  case wasm_imm_memarg:
+    return wasm_text_memarg(t, op, p);
+  case wasm_imm_memory:
+  case wasm_imm_reserved:
+    return wasm_text_byte(t, &byte);
+  case wasm_imm_memory_init:
+    if (!wasm_text_u32(t, &index) || !wasm_text_byte(t, &byte)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_u64(*p, index);
+    return true;
+  case wasm_imm_memory_copy:
+    return wasm_text_byte(t, &byte) && wasm_text_byte(t, &byte);
+  case wasm_imm_i32:
+  case wasm_imm_i64: {
+    int64_t value;
+    bool is_i32 = wasm_text_opcodes[op].imm == wasm_imm_i32;
+    if (!wasm_text_s64(t, &value, is_i32 ? 32 : 64)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_s64(*p, is_i32 ? (int32_t)value : value);
+    return true;
+  }
+  case wasm_imm_f32: {
+    uint32_t bits;
+    if (!wasm_text_bytes(t, &bits, 4)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_float(*p, bits, 23, 8);
+    return true;
+  }
+  case wasm_imm_f64: {
+    uint64_t bits;
+    if (!wasm_text_bytes(t, &bits, 8)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_float(*p, bits, 52, 11);
+    return true;
+  }
+  case wasm_imm_v128: {
+    uint32_t lanes[4];
+    if (!wasm_text_bytes(t, lanes, 16)) {
+      return false;
+    }
+    *p = wasm_put_lit(*p, " i32x4");
+    for (int i = 0; i < 4; i++) {
+      *p = wasm_put_lit(*p, " 0x");
+      *p = wasm_put_hex(*p, lanes[i], 8);
+    }
+    return true;
+  }
+  case wasm_imm_shuffle: {
+    unsigned char lanes[16];
+    if (!wasm_text_bytes(t, lanes, 16)) {
+      return false;
+    }
+    for (int i = 0; i < 16; i++) {
+      *(*p)++ = ' ';
+      *p = wasm_put_u64(*p, lanes[i]);
+    }
+    return true;
+  }
+  case wasm_imm_memarg_lane:
+    if (!wasm_text_memarg(t, op, p)) {
+      return false;
+    }
+    // fallthrough
+  case wasm_imm_lane:
+    if (!wasm_text_byte(t, &byte)) {
+      return false;
+    }
+    *(*p)++ = ' ';
+    *p = wasm_put_u64(*p, byte);
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Writes `br_table` with its labels, which can be any number.
+static bool wasm_text_br_table(wasm_text_printer *t, char **p) {
+  uint32_t count;
+  if (!wasm_text_u32(t, &count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i <= count; i++) {
+    wasm_text_commit(t->out, *p);
+    *p = wasm_text_reserve(t->out, 48);
+    if (!wasm_text_label(t, p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes the instruction at `t->pos` on a line of its own, or inline if
+// `indent` is -1.
+static bool wasm_text_instr(wasm_text_printer *t, int indent) {
+  uint16_t op;
+  if (!wasm_text_opcode_at(t, &op)) {
+    return false;
+  }
+  // These belong to the enclosing block.
+  if (op == wasm_op_end || op == wasm_op_else) {
+    if (t->depth == 0) {
+      return false;
+    }
+    indent -= 2;
+    t->depth -= op == wasm_op_end;
+  }
+
+  char *p = wasm_text_reserve(t->out, wasm_text_line_max +
+                                          (indent > 0 ? (size_t)indent : 0));
+  if (indent >= 0) {
+    *p++ = '\n';
+    memset(p, ' ', (size_t)indent);
+    p += indent;
+  }
+  const wasm_text_opcode *info = &wasm_text_opcodes[op];
+  p = wasm_put(p, info->text, info->length);
+  bool ok = op == wasm_op_br_table ? wasm_text_br_table(t, &p)
+                                   : wasm_text_immediates(t, op, &p);
+  wasm_text_commit(t->out, p);
+  return ok;
+}
+
+// Writes ` (i32.const 1)`.
+static bool wasm_text_const_expr(wasm_text_out *out, const wasm_expr *expr) {
+  wasm_text_printer t = {out, expr->start, expr->end, 0};
+  wasm_text_append(out, " (", 2);
+  bool ok = wasm_text_instr(&t, -1) && t.pos == t.end;
+  wasm_text_append(out, ")", 1);
+  return ok;
+}
+
+static bool wasm_text_func(wasm_text_out *out, const wasm_module *module,
+                           uint32_t index) {
+  const wasm_code *code = &module->codes.start[index];
+  uint32_t typeidx = module->funcs.start[index];
+  if (typeidx >= wasm_vec_size(&module->function_types)) {
+    return false;
+  }
+  const wasm_function_type *type = &module->function_types.start[typeidx];
+
+  char *p = wasm_text_reserve(out, 96 + type->param_count * 5);
+  p = wasm_put_lit(p, "\n  (func");
+  p = wasm_put_index_comment(p, module->import_func_count + index);
+  p = wasm_put_lit(p, " (type ");
+  p = wasm_put_u64(p, typeidx);
+  *p++ = ')';
+  if (type->param_count) {
+    p = wasm_put_lit(p, " (param");
+    for (uint32_t i = 0; i < type->param_count; i++) {
+      *p++ = ' ';
+      p = wasm_put_valtype(p, type->params[i]);
+    }
+    *p++ = ')';
+  }
+  if (type->result_count) {
+    p = wasm_put_lit(p, " (result ");
+    p = wasm_put_valtype(p, type->result_type);
+    *p++ = ')';
+  }
+  wasm_text_commit(out, p);
+
+  // The locals are run-length encoded.
+  const wasm_locals *locals = module->locals.start + code->locals_offset;
+  uint64_t local_count = 0;
+  for (uint32_t i = 0; i < code->locals_count; i++) {
+    local_count += locals[i].n;
+  }
+  if (local_count > wasm_text_max_locals) {
+    return false;
+  }
+  if (local_count) {
+    p = wasm_text_reserve(out, 16 + local_count * 5);
+    p = wasm_put_lit(p, "\n    (local");
+    for (uint32_t i = 0; i < code->locals_count; i++) {
+      for (uint32_t j = 0; j < locals[i].n; j++) {
+        *p++ = ' ';
+        p = wasm_put_valtype(p, locals[i].type);
+      }
+    }
+    *p++ = ')';
+    wasm_text_commit(out, p);
+  }
+
+  const unsigned char *expr = wasm_code_expr(module, code);
+  wasm_text_printer t = {out, expr, expr + code->expr_size, 0};
+  while (t.pos < t.end) {
+    if (!wasm_text_instr(&t, 4 + 2 * (int)t.depth)) {
+      return false;
+    }
+  }
+  wasm_text_append(out, ")", 1);
+  return t.depth == 0;
+}
+
+// Function bodies split into runs of about `wasm_text_chunk_bytes` of code.
+typedef struct {
+  const wasm_module *module;
+  // Function `starts[i]` is the first of chunk `i`, the last entry is the
+  // function count.
+  uint32_t *starts;
+  wasm_text_out *outs;
+} wasm_text_chunks;
+
+static void wasm_text_chunk(void *context, size_t index) {
+  wasm_text_chunks *chunks = context;
+  wasm_text_out *out = &chunks->outs[index];
+  for (uint32_t i = chunks->starts[index]; i < chunks->starts[index + 1];
+       i++) {
+    if (!wasm_text_func(out, chunks->module, i)) {
+      out->failed = true;
+      return;
+    }
+  }
+}
+
+static bool wasm_text_funcs(wasm_text_out *out, const wasm_module *module,
+                            uint32_t thread_count) {
+  uint32_t func_count = (uint32_t)wasm_vec_size(&module->codes);
+  if (func_count != wasm_vec_size(&module->funcs)) {
+    return false;
+  }
+  if (thread_count <= 1) {
+    for (uint32_t i = 0; i < func_count; i++) {
+      if (!wasm_text_func(out, module, i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  wasm_u32_vec starts;
+  wasm_vec_init(&starts);
+  size_t bytes = wasm_text_chunk_bytes;
+  for (uint32_t i = 0; i < func_count; i++) {
+    if (bytes >= wasm_text_chunk_bytes) {
+      *wasm_vec_append(&starts) = i;
+      bytes = 0;
+    }
+    bytes += module->codes.start[i].expr_size;
+  }
+  size_t chunk_count = wasm_vec_size(&starts);
+  *wasm_vec_append(&starts) = func_count;
+
+  // Every chunk is printed into memory and the chunks are copied in order.
+  wasm_text_chunks chunks = {module, starts.start,
+                             wasm_alloc_array(wasm_text_out, chunk_count + 1)};
+  for (size_t i = 0; i < chunk_count; i++) {
+    wasm_init_text_out_n(&chunks.outs[i], -1, 4 * wasm_text_chunk_bytes);
+  }
+  wasm_parallel_for(chunk_count, thread_count, wasm_text_chunk, &chunks);
+
+  bool ok = true;
+  for (size_t i = 0; i < chunk_count; i++) {
+    ok = ok && !chunks.outs[i].failed;
+    if (ok) {
+      wasm_text_append(out, chunks.outs[i].data, chunks.outs[i].size);
+    }
+    wasm_deinit_text_out(&chunks.outs[i]);
+  }
+  wasm_free(chunks.outs);
+  wasm_vec_deinit(&starts);
+  return ok;
+}
+
+static char *wasm_put_name(char *p, const wasm_module *module, uint32_t name) {
+  const char *text = wasm_module_name(module, name);
+  return wasm_put_string(p, (const unsigned char *)text, strlen(text));
+}
+
+static size_t wasm_name_room(const wasm_module *module, uint32_t name) {
+  return 3 * strlen(wasm_module_name(module, name)) + 2;
+}
+
+static void wasm_text_types(wasm_text_out *out, const wasm_module *module) {
+  for (size_t i = 0; i < wasm_vec_size(&module->function_types); i++) {
+    const wasm_function_type *type = &module->function_types.start[i];
+    char *p = wasm_text_reserve(out, 96 + type->param_count * 5);
+    p = wasm_put_lit(p, "\n  (type");
+    p = wasm_put_index_comment(p, i);
+    p = wasm_put_lit(p, " (func");
+    if (type->param_count) {
+      p = wasm_put_lit(p, " (param");
+      for (uint32_t j = 0; j < type->param_count; j++) {
+        *p++ = ' ';
+        p = wasm_put_valtype(p, type->params[j]);
+      }
+      *p++ = ')';
+    }
+    if (type->result_count) {
+      p = wasm_put_lit(p, " (result ");
+      p = wasm_put_valtype(p, type->result_type);
+      *p++ = ')';
+    }
+    p = wasm_put_lit(p, "))");
+    wasm_text_commit(out, p);
+  }
+}
+
+static void wasm_text_imports(wasm_text_out *out, const wasm_module *module) {
+  // Every kind has its own index space.
+  uint32_t counts[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < wasm_vec_size(&module->imports); i++) {
+    const wasm_import *import = &module->imports.start[i];
+    size_t room = 96 + wasm_name_room(module, import->module_name) +
+                  wasm_name_room(module, import->name);
+    char *p = wasm_text_reserve(out, room);
+    p = wasm_put_lit(p, "\n  (import ");
+    p = wasm_put_name(p, module, import->module_name);
+    *p++ = ' ';
+    p = wasm_put_name(p, module, import->name);
+    uint32_t index = counts[import->type]++;
+    switch (import->type) {
+    case wasm_import_func:
+      p = wasm_put_lit(p, " (func");
+      p = wasm_put_index_comment(p, index);
+      p = wasm_put_lit(p, " (type ");
+      p = wasm_put_u64(p, import->desc.func);
+      *p++ = ')';
+      break;
+    case wasm_import_table:
+      p = wasm_put_lit(p, " (table");
+      p = wasm_put_index_comment(p, index);
+      *p++ = ' ';
+      p = wasm_put_limits(p, &import->desc.table);
+      p = wasm_put_lit(p, " funcref");
+      break;
+    case wasm_import_mem:
+      p = wasm_put_lit(p, " (memory");
+      p = wasm_put_index_comment(p, index);
+      *p++ = ' ';
+      p = wasm_put_limits(p, &import->desc.mem);
+      break;
+    case wasm_import_global:
+      p = wasm_put_lit(p, " (global");
+      p = wasm_put_index_comment(p, index);
+      *p++ = ' ';
+      if (import->desc.global.is_mutable) {
+        p = wasm_put_lit(p, "(mut ");
+        p = wasm_put_valtype(p, import->desc.global.type);
+        *p++ = ')';
+      } else {
+        p = wasm_put_valtype(p, import->desc.global.type);
+      }
+      break;
+    }
+    p = wasm_put_lit(p, "))");
+    wasm_text_commit(out, p);
+  }
+}
+
+static bool wasm_text_globals(wasm_text_out *out, const wasm_module *module) {
+  for (size_t i = 0; i < wasm_vec_size(&module->globals); i++) {
+    const wasm_global *global = &module->globals.start[i];
+    char *p = wasm_text_reserve(out, 64);
+    p = wasm_put_lit(p, "\n  (global");
+    p = wasm_put_index_comment(p, module->import_global_count + i);
+    *p++ = ' ';
+    if (global->is_mutable) {
+      p = wasm_put_lit(p, "(mut ");
+      p = wasm_put_valtype(p, global->type);
+      *p++ = ')';
+    } else {
+      p = wasm_put_valtype(p, global->type);
+    }
+    wasm_text_commit(out, p);
+    if (!wasm_text_const_expr(out, &global->initializer)) {
+      return false;
+    }
+    wasm_text_append(out, ")", 1);
+  }
+  return true;
+}
+
+static void wasm_text_exports(wasm_text_out *out, const wasm_module *module) {
+  static const char *const kinds[4] = {" (func ", " (table ", " (memory ",
+                                       " (global "};
+  for (size_t i = 0; i < wasm_vec_size(&module->exports); i++) {
+    const wasm_export *export = &module->exports.start[i];
+    char *p = wasm_text_reserve(out, 48 + wasm_name_room(module, export->name));
+    p = wasm_put_lit(p, "\n  (export ");
+    p = wasm_put_name(p, module, export->name);
+    p = wasm_put(p, kinds[export->type], strlen(kinds[export->type]));
+    p = wasm_put_u64(p, export->idx);
+    p = wasm_put_lit(p, "))");
+    wasm_text_commit(out, p);
+  }
+}
+
+static bool wasm_text_elems(wasm_text_out *out, const wasm_module *module) {
+  for (size_t i = 0; i < wasm_vec_size(&module->elems); i++) {
+    const wasm_elem *elem = &module->elems.start[i];
+    char *p = wasm_text_reserve(out, 64);
+    p = wasm_put_lit(p, "\n  (elem");
+    p = wasm_put_index_comment(p, i);
+    if (elem->tableidx) {
+      p = wasm_put_lit(p, " (table ");
+      p = wasm_put_u64(p, elem->tableidx);
+      *p++ = ')';
+    }
+    wasm_text_commit(out, p);
+    if (!wasm_text_const_expr(out, &elem->offset)) {
+      return false;
+    }
+
+    size_t count = wasm_vec_size(&elem->init);
+    p = wasm_text_reserve(out, 8 + count * 11);
+    p = wasm_put_lit(p, " func");
+    for (size_t j = 0; j < count; j++) {
+      *p++ = ' ';
+      p = wasm_put_u64(p, elem->init.start[j]);
+    }
+    *p++ = ')';
+    wasm_text_commit(out, p);
+  }
+  return true;
+}
+
+static bool wasm_text_datas(wasm_text_out *out, const wasm_module *module) {
+  for (size_t i = 0; i < wasm_vec_size(&module->datas); i++) {
+    const wasm_data *data = &module->datas.start[i];
+    char *p = wasm_text_reserve(out, 64);
+    p = wasm_put_lit(p, "\n  (data");
+    p = wasm_put_index_comment(p, i);
+    if (data->memidx) {
+      p = wasm_put_lit(p, " (memory ");
+      p = wasm_put_u64(p, data->memidx);
+      *p++ = ')';
+    }
+    wasm_text_commit(out, p);
+    if (!data->is_passive && !wasm_text_const_expr(out, &data->offset)) {
+      return false;
+    }
+
+    size_t size = wasm_vec_size(&data->init);
+    p = wasm_text_reserve(out, 4 + 3 * size);
+    *p++ = ' ';
+    p = wasm_put_string(p, data->init.start, size);
+    *p++ = ')';
+    wasm_text_commit(out, p);
+  }
+  return true;
+}
+
+bool wasm_print_wat(wasm_text_out *out, const wasm_module *module,
+                    uint32_t thread_count) {
+  wasm_text_append(out, "(module", 7);
+  wasm_text_types(out, module);
+  wasm_text_imports(out, module);
+  if (!wasm_text_funcs(out, module, thread_count)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < wasm_vec_size(&module->tables); i++) {
+    char *p = wasm_text_reserve(out, 64);
+    p = wasm_put_lit(p, "\n  (table");
+    p = wasm_put_index_comment(p, module->import_table_count + i);
+    *p++ = ' ';
+    p = wasm_put_limits(p, &module->tables.start[i]);
+    p = wasm_put_lit(p, " funcref)");
+    wasm_text_commit(out, p);
+  }
+  for (size_t i = 0; i < wasm_vec_size(&module->mems); i++) {
+    char *p = wasm_text_reserve(out, 64);
+    p = wasm_put_lit(p, "\n  (memory");
+    p = wasm_put_index_comment(p, module->import_mem_count + i);
+    *p++ = ' ';
+    p = wasm_put_limits(p, &module->mems.start[i]);
+    *p++ = ')';
+    wasm_text_commit(out, p);
+  }
+  if (!wasm_text_globals(out, module)) {
+    return false;
+  }
+  wasm_text_exports(out, module);
+  if (module->has_start) {
+    char *p = wasm_text_reserve(out, 32);
+    p = wasm_put_lit(p, "\n  (start ");
+    p = wasm_put_u64(p, module->start);
+    *p++ = ')';
+    wasm_text_commit(out, p);
+  }
+  if (!wasm_text_elems(out, module) || !wasm_text_datas(out, module)) {
+    return false;
+  }
+
+  wasm_text_append(out, ")\n", 2);
+  return !out->failed;
+}
+
+void wasm_print_module(const wasm_module *module) {
+  fflush(stdout);
+  wasm_text_out out;
+  wasm_init_text_out(&out, STDOUT_FILENO);
+  if (!wasm_print_wat(&out, module, 1)) {
+    wasm_flush_text_out(&out);
+    fprintf(stderr, "\nFailed to print the module.\n");
+  }
+  wasm_flush_text_out(&out);
+  wasm_deinit_text_out(&out);
+}
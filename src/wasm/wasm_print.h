@@ -0,0 +1,34 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Output of the text printer. The text is collected in a large buffer that is
+// written to `fd` whenever it fills up, so even large modules take a few big
+// writes. The buffer can be reused for several modules.
+typedef struct {
+  // -1 keeps the whole text in `data`.
+  int fd;
+  char *data;
+  size_t size;
+  size_t capacity;
+  // Bytes written to `fd` so far.
+  uint64_t written;
+  bool failed;
+} wasm_text_out;
+
+void wasm_init_text_out(wasm_text_out *out, int fd);
+void wasm_deinit_text_out(wasm_text_out *out);
+// Writes the buffered text to `fd`. Returns false if a write failed.
+bool wasm_flush_text_out(wasm_text_out *out);
+
+// Prints `module` in the text format as wasm2wat does, with every section the
+// loader keeps and the decoded function bodies. Floats are printed as exact
+// hex floats. The bodies are printed in chunks on `thread_count` threads and
+// written in order. Returns false if a body can't be decoded.
+bool wasm_print_wat(wasm_text_out *out, const wasm_module *module,
+                    uint32_t thread_count);
+
+// Prints `module` to stdout.
+void wasm_print_module(const wasm_module *module);
@@ -1,6 +1,7 @@
 #include "wasm/wasm_reader.h"
 
 #include "wasm/wasm_common.h"
+#include "wasm/wasm_utf8.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -8,9 +9,16 @@
 #include <string.h>
 
 bool wasm_file_reader_read(wasm_reader *reader, void *buffer, size_t amount) {
+  if (amount > reader->size) {
+    return false;
+  }
+  if (reader->size != SIZE_MAX) {
+    reader->size -= amount;
+  }
+
   if (buffer) {
     // Read.
-    return 1 == fread(buffer, amount, 1, (FILE *)reader->device);
+    return amount == 0 || 1 == fread(buffer, amount, 1, (FILE *)reader->device);
   } else {
     // Seek.
     if (amount > INT_MAX) {
@@ -37,7 +45,17 @@ bool wasm_memory_reader_read(wasm_reader *reader, void *buffer, size_t amount) {
 
 void wasm_init_file_reader(wasm_reader *reader, FILE *file) {
   reader->device = file;
-  reader->size = 0; // Size is ignored in file reader.
+  // Like for memory the size is what's left to read, so sizes in the module
+  // can be checked before anything is allocated for them. Streams that can't
+  // seek have no known size.
+  reader->size = SIZE_MAX;
+  long start = ftell(file);
+  if (start >= 0 && fseek(file, 0, SEEK_END) == 0) {
+    long end = ftell(file);
+    if (fseek(file, start, SEEK_SET) == 0 && end >= start) {
+      reader->size = (size_t)(end - start);
+    }
+  }
   reader->read = &wasm_file_reader_read;
 }
 
@@ -61,7 +79,7 @@ _Bool wasm_seek(wasm_reader *reader, size_t amount) {
 // XXX: handle max
 // XXX: check if unsigned char is required in other places
 uint32_t wasm_read_leb_u32(wasm_reader *reader) {
-  uint32_t out;
+  uint32_t out = 0;
   wasm_read_leb_u32_2(reader, &out);
   return out;
 }
@@ -101,6 +119,52 @@ bool wasm_read_leb_u32_2(wasm_reader *reader, uint32_t *out) {
   return *out = result, true;
 }
 
+// Signed numbers are sign extended from the last byte that was read. `bits` is
+// the width of the result which limits the amount of bytes.
+static bool wasm_read_leb_signed(wasm_reader *reader, int64_t *out, int bits) {
+  uint64_t result = 0;
+  int shift = 0;
+  unsigned char c;
+
+  do {
+    if (shift >= bits || !wasm_read_obj(reader, &c)) {
+      return false;
+    }
+
+    result |= (uint64_t)(c & 127) << shift;
+    shift += 7;
+  } while (c & 128);
+
+  // Sign extend if the sign bit of the last byte is set.
+  if (shift < 64 && (c & 64)) {
+    result |= ~(uint64_t)0 << shift;
+  }
+
+  // Unused bits of the last byte must match the sign.
+  if (shift > bits) {
+    int64_t value = (int64_t)result;
+    int64_t min = -((int64_t)1 << (bits - 1));
+    int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+    if (bits < 64 && (value < min || value > max)) {
+      return false;
+    }
+  }
+
+  return *out = (int64_t)result, true;
+}
+
+bool wasm_read_leb_s32(wasm_reader *reader, int32_t *out) {
+  int64_t result;
+  if (!wasm_read_leb_signed(reader, &result, 32)) {
+    return false;
+  }
+  return *out = (int32_t)result, true;
+}
+
+bool wasm_read_leb_s64(wasm_reader *reader, int64_t *out) {
+  return wasm_read_leb_signed(reader, out, 64);
+}
+
 bool wasm_read_f32(wasm_reader *reader, float *out) {
   char data[4];
 
@@ -125,7 +189,7 @@ bool wasm_read_f32(wasm_reader *reader, float *out) {
 bool wasm_read_f64(wasm_reader *reader, double *out) {
   char data[8];
 
-  if (!wasm_read(reader, data, 4)) {
+  if (!wasm_read(reader, data, 8)) {
     return false;
   }
 
@@ -147,75 +211,22 @@ bool wasm_read_f64(wasm_reader *reader, double *out) {
   return true;
 }
 
-// XXX: This code has never been tested and is just assumed to be working.
-bool wasm_validate_utf8(char *str) {
-  while (*str) {
-    if ((*str & (1 << 7)) == 0) {
-      // 1 byte
-      str++;
-    } else if ((*str & (1 << 7 | 1 << 6 | 1 << 5)) == (1 << 7 | 1 << 6)) {
-      // 2 bytes
-      if (str[1] == '\0') {
-        return false;
-      }
-
-      if ((str[1] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      str += 2;
-    } else if ((*str & (1 << 7 | 1 << 6 | 1 << 5 | 1 << 4)) ==
-               (1 << 7 | 1 << 6 | 1 << 5)) {
-      // 3 bytes
-      if (str[1] == '\0' || str[2] == '\0') {
-        return false;
-      }
-
-      if ((str[1] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      if ((str[2] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      str += 3;
-    } else if ((*str & (1 << 7 | 1 << 6 | 1 << 5 | 1 << 4 | 1 << 3)) ==
-               (1 << 7 | 1 << 6 | 1 << 5 | 1 << 4)) {
-      // 4 bytes
-      if (str[1] == '\0' || str[2] == '\0' || str[3] == '\0') {
-        return false;
-      }
-      if ((str[1] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      if ((str[2] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      if ((str[3] & (1 << 7 | 1 << 6)) != (1 << 7)) {
-        return false;
-      }
-      str += 4;
-    } else {
-      puts("uffka");
-      return false;
-    }
-  }
-
-  return true;
-}
-
 bool wasm_read_string(wasm_reader *reader, char **out) {
-  uint32_t length = wasm_read_leb_u32(reader);
+  uint32_t length;
+  if (!wasm_read_leb_u32_2(reader, &length) || length > reader->size) {
+    return false;
+  }
   char *str = wasm_alloc_array(char, length + 1);
 
-  if (!wasm_read(reader, str, length)) {
+  if (length > 0 && !wasm_read(reader, str, length)) {
     wasm_free(str);
     return false;
   }
 
   str[length] = '\0';
 
-  if (!wasm_validate_utf8(str)) {
-    fprintf(stderr,
-            "Looks like invalid utf8 but maybe the function is wrong.\n");
+  if (!wasm_validate_utf8(str, length)) {
+    fprintf(stderr, "Invalid UTF-8 in name.\n");
     wasm_free(str);
     return false;
   }
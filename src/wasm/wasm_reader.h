@@ -8,6 +8,7 @@
 // An abstract device that can read and seek.
 typedef struct _wasm_reader_t {
   void *device;
+  // Bytes left to read, SIZE_MAX if unknown.
   size_t size;
 
   // Returns true on success, false on failure.
@@ -30,6 +31,10 @@ uint32_t wasm_read_leb_u32(wasm_reader *reader);
 // Reads a leb128 encoded number.
 bool wasm_read_leb_u32_2(wasm_reader *reader, uint32_t *out);
 
+// Reads a signed leb128 encoded number. Used for constants and block types.
+bool wasm_read_leb_s32(wasm_reader *reader, int32_t *out);
+bool wasm_read_leb_s64(wasm_reader *reader, int64_t *out);
+
 // Little endian raw floats.
 bool wasm_read_f32(wasm_reader *reader, float *out);
 bool wasm_read_f64(wasm_reader *reader, double *out);
@@ -0,0 +1,590 @@
+#include "wasm/wasm_sched.h"
+
+#include "wasm/wasm_common.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// Native stack of a task. It is reserved and only the touched part takes up
+// physical memory, the lowest page is a guard page.
+#define wasm_task_stack_size (8 * 1024 * 1024)
+#define wasm_guard_size 4096
+// Stacks of finished tasks that a worker keeps for new tasks.
+#define wasm_max_free_stacks 16
+
+struct wasm_worker;
+
+// A pending host call moves from waiting to parked when its task is switched
+// out, and to completed when the operation finished. Whichever of the two
+// comes second puts the task back into a deque.
+enum {
+  wasm_task_running,
+  wasm_task_waiting,
+  wasm_task_parked,
+  wasm_task_completed,
+};
+
+struct wasm_task {
+  wasm_scheduler *scheduler;
+  wasm_instance *instance;
+  uint32_t funcidx;
+  wasm_value *args;
+  wasm_value result;
+  enum wasm_trap trap;
+  wasm_task_done done;
+  void *user;
+
+  ucontext_t context;
+  unsigned char *stack;
+  bool finished;
+  // Set by `wasm_task_await` before it switches to the worker.
+  bool awaiting;
+  atomic_int state;
+  // The worker that runs the task right now. Stolen tasks move to another
+  // worker.
+  struct wasm_worker *worker;
+};
+
+// A double ended queue of runnable tasks. The owner pushes and pops new tasks
+// at the bottom so that it keeps working on what it just spawned. Thieves,
+// preempted tasks and tasks spawned by other threads use the top.
+typedef struct {
+  pthread_mutex_t lock;
+  wasm_task **items;
+  // Capacity is a power of 2. `top` and `bottom` only wrap around.
+  size_t capacity;
+  size_t top;
+  size_t bottom;
+} wasm_deque;
+
+typedef struct wasm_worker {
+  wasm_scheduler *scheduler;
+  pthread_t thread;
+  wasm_deque deque;
+  // The context of the worker loop that tasks switch back to.
+  ucontext_t context;
+  unsigned char *free_stacks[wasm_max_free_stacks];
+  uint32_t free_stack_count;
+  uint32_t random;
+} wasm_worker;
+
+struct wasm_scheduler {
+  wasm_worker *workers;
+  uint32_t worker_count;
+  int64_t slice;
+  // Spawned tasks that are not done yet.
+  atomic_size_t pending;
+  // Tasks in all deques.
+  atomic_size_t queued;
+  atomic_uint next_worker;
+
+  // Workers sleep on `wake` when all deques are empty. `wait` sleeps on
+  // `idle` until no task is pending.
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t idle;
+  bool stopping;
+
+#ifdef __linux__
+  // The event loop thread completes tasks that wait for file descriptors.
+  // Writing to `stop_fd` ends it.
+  pthread_t event_thread;
+  int epoll_fd;
+  int stop_fd;
+#endif
+};
+
+static __thread wasm_worker *wasm_current_worker = NULL;
+
+static void wasm_init_deque(wasm_deque *deque) {
+  pthread_mutex_init(&deque->lock, NULL);
+  deque->capacity = 64;
+  deque->items = wasm_alloc_array(wasm_task *, deque->capacity);
+  deque->top = 0;
+  deque->bottom = 0;
+}
+
+static void wasm_deinit_deque(wasm_deque *deque) {
+  pthread_mutex_destroy(&deque->lock);
+  wasm_free(deque->items);
+}
+
+// Must be called with the lock held.
+static void wasm_deque_reserve(wasm_deque *deque) {
+  size_t size = deque->bottom - deque->top;
+  if (size < deque->capacity) {
+    return;
+  }
+
+  wasm_task **items = wasm_alloc_array(wasm_task *, deque->capacity * 2);
+  for (size_t i = 0; i < size; i++) {
+    items[i] = deque->items[(deque->top + i) & (deque->capacity - 1)];
+  }
+  wasm_free(deque->items);
+  deque->items = items;
+  deque->capacity *= 2;
+  deque->top = 0;
+  deque->bottom = size;
+}
+
+static void wasm_deque_push(wasm_deque *deque, wasm_task *task, bool bottom) {
+  pthread_mutex_lock(&deque->lock);
+  wasm_deque_reserve(deque);
+  size_t index = bottom ? deque->bottom++ : --deque->top;
+  deque->items[index & (deque->capacity - 1)] = task;
+  pthread_mutex_unlock(&deque->lock);
+}
+
+static wasm_task *wasm_deque_pop(wasm_deque *deque, bool bottom) {
+  wasm_task *task = NULL;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->top != deque->bottom) {
+    size_t index = bottom ? --deque->bottom : deque->top++;
+    task = deque->items[index & (deque->capacity - 1)];
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return task;
+}
+
+static void wasm_enqueue(wasm_scheduler *scheduler, wasm_worker *worker,
+                         wasm_task *task, bool bottom) {
+  wasm_deque_push(&worker->deque, task, bottom);
+  atomic_fetch_add(&scheduler->queued, 1);
+}
+
+// Takes a task from the own deque or steals one from another worker.
+static wasm_task *wasm_find_task(wasm_worker *worker) {
+  wasm_scheduler *scheduler = worker->scheduler;
+  wasm_task *task = wasm_deque_pop(&worker->deque, true);
+
+  if (task == NULL && scheduler->worker_count > 1) {
+    // Victims are visited from a random start so thieves don't all contend
+    // for the same deque.
+    worker->random ^= worker->random << 13;
+    worker->random ^= worker->random >> 17;
+    worker->random ^= worker->random << 5;
+    uint32_t start = worker->random % scheduler->worker_count;
+    for (uint32_t i = 0; task == NULL && i < scheduler->worker_count; i++) {
+      wasm_worker *victim =
+          &scheduler->workers[(start + i) % scheduler->worker_count];
+      if (victim != worker) {
+        task = wasm_deque_pop(&victim->deque, false);
+      }
+    }
+  }
+
+  if (task) {
+    atomic_fetch_sub(&scheduler->queued, 1);
+  }
+  return task;
+}
+
+static unsigned char *wasm_take_stack(wasm_worker *worker) {
+  if (worker->free_stack_count > 0) {
+    return worker->free_stacks[--worker->free_stack_count];
+  }
+
+  unsigned char *stack = wasm_reserve_n(wasm_task_stack_size);
+  if (stack != NULL) {
+    mprotect(stack, wasm_guard_size, PROT_NONE);
+  }
+  return stack;
+}
+
+static void wasm_give_stack(wasm_worker *worker, unsigned char *stack) {
+  if (worker->free_stack_count < wasm_max_free_stacks) {
+    worker->free_stacks[worker->free_stack_count++] = stack;
+  } else {
+    wasm_free_reserved(stack, wasm_task_stack_size);
+  }
+}
+
+// Switches from the task back to the loop of its worker.
+static void wasm_task_suspend(wasm_task *task) {
+  swapcontext(&task->context, &task->worker->context);
+}
+
+static bool wasm_task_checkpoint(wasm_instance *instance) {
+  wasm_task *task = instance->checkpoint_user;
+  instance->fuel = task->scheduler->slice;
+  wasm_task_suspend(task);
+  return true;
+}
+
+bool wasm_task_yield(wasm_instance *instance) {
+  if (instance->checkpoint != wasm_task_checkpoint) {
+    return false;
+  }
+  wasm_task_suspend(instance->checkpoint_user);
+  return true;
+}
+
+wasm_task *wasm_task_pending(wasm_instance *instance) {
+  if (instance->checkpoint != wasm_task_checkpoint) {
+    return NULL;
+  }
+  wasm_task *task = instance->checkpoint_user;
+  atomic_store(&task->state, wasm_task_waiting);
+  return task;
+}
+
+void wasm_task_await(wasm_task *task) {
+  if (atomic_load(&task->state) != wasm_task_completed) {
+    task->awaiting = true;
+    wasm_task_suspend(task);
+  }
+  atomic_store(&task->state, wasm_task_running);
+}
+
+void wasm_task_complete(wasm_task *task) {
+  if (atomic_exchange(&task->state, wasm_task_completed) !=
+      wasm_task_parked) {
+    return;
+  }
+
+  wasm_scheduler *scheduler = task->scheduler;
+  wasm_enqueue(scheduler, task->worker, task, false);
+  pthread_mutex_lock(&scheduler->lock);
+  pthread_cond_signal(&scheduler->wake);
+  pthread_mutex_unlock(&scheduler->lock);
+}
+
+// A task that waits for a file descriptor. It lives on the stack of the
+// suspended task.
+typedef struct {
+  wasm_task *task;
+  int fd;
+  uint32_t events;
+} wasm_fd_waiter;
+
+#ifdef __linux__
+static void *wasm_event_main(void *arg) {
+  wasm_scheduler *scheduler = arg;
+  struct epoll_event events[64];
+
+  for (;;) {
+    int count = epoll_wait(scheduler->epoll_fd, events, 64, -1);
+    if (count < 0 && errno != EINTR) {
+      fprintf(stderr, "epoll_wait failed: %s\n", strerror(errno));
+      break;
+    }
+    for (int i = 0; i < count; i++) {
+      wasm_fd_waiter *waiter = events[i].data.ptr;
+      if (waiter == NULL) {
+        return NULL;
+      }
+      // The registration is one shot, removing it allows to wait for the
+      // same descriptor again.
+      epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_DEL, waiter->fd, NULL);
+      waiter->events = events[i].events;
+      wasm_task_complete(waiter->task);
+    }
+  }
+  return NULL;
+}
+#endif
+
+int wasm_task_wait_fd(wasm_instance *instance, int fd, uint32_t events) {
+  wasm_task *task = wasm_task_pending(instance);
+#ifdef __linux__
+  if (task != NULL) {
+    wasm_fd_waiter waiter = {task, fd, 0};
+    struct epoll_event event = {events | EPOLLONESHOT, {.ptr = &waiter}};
+    if (epoll_ctl(task->scheduler->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      atomic_store(&task->state, wasm_task_running);
+      return -1;
+    }
+    wasm_task_await(task);
+    return (int)waiter.events;
+  }
+#else
+  if (task != NULL) {
+    atomic_store(&task->state, wasm_task_running);
+  }
+#endif
+
+  // Without an event loop the thread blocks.
+  struct pollfd pfd = {fd, (short)events, 0};
+  int result;
+  do {
+    result = poll(&pfd, 1, -1);
+  } while (result < 0 && errno == EINTR);
+  return result < 0 ? -1 : pfd.revents;
+}
+
+// Entry point of the native stack of a task. `makecontext` only passes int
+// arguments so the task pointer is split in two halves.
+static void wasm_task_main(uint32_t high, uint32_t low) {
+  wasm_task *task = (wasm_task *)(((uintptr_t)high << 32) | low);
+  task->trap = wasm_invoke(task->instance, task->funcidx, task->args,
+                           &task->result);
+  task->finished = true;
+  wasm_task_suspend(task);
+}
+
+static void wasm_finish_task(wasm_worker *worker, wasm_task *task) {
+  wasm_scheduler *scheduler = task->scheduler;
+  wasm_instance *instance = task->instance;
+  instance->fuel = INT64_MAX;
+  instance->checkpoint = NULL;
+  instance->checkpoint_user = NULL;
+
+  if (task->done) {
+    task->done(task->trap, &task->result, task->user);
+  }
+  if (task->stack) {
+    wasm_give_stack(worker, task->stack);
+  }
+  wasm_free(task->args);
+  wasm_free(task);
+
+  if (atomic_fetch_sub(&scheduler->pending, 1) == 1) {
+    pthread_mutex_lock(&scheduler->lock);
+    pthread_cond_broadcast(&scheduler->idle);
+    pthread_mutex_unlock(&scheduler->lock);
+  }
+}
+
+static void wasm_run_task(wasm_worker *worker, wasm_task *task) {
+  task->worker = worker;
+
+  if (task->stack == NULL) {
+    task->stack = wasm_take_stack(worker);
+    if (task->stack == NULL) {
+      fprintf(stderr, "Failed to reserve a task stack.\n");
+      task->trap = wasm_trap_call_stack_exhausted;
+      wasm_finish_task(worker, task);
+      return;
+    }
+
+    uintptr_t address = (uintptr_t)task;
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = wasm_task_stack_size;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, (void (*)(void))wasm_task_main, 2,
+                (uint32_t)(address >> 32), (uint32_t)address);
+  }
+
+  swapcontext(&worker->context, &task->context);
+
+  if (task->finished) {
+    wasm_finish_task(worker, task);
+  } else if (task->awaiting) {
+    // The task is parked until `wasm_task_complete` unless that already
+    // happened.
+    task->awaiting = false;
+    int waiting = wasm_task_waiting;
+    if (!atomic_compare_exchange_strong(&task->state, &waiting,
+                                        wasm_task_parked)) {
+      wasm_enqueue(worker->scheduler, worker, task, false);
+    }
+  } else {
+    // Preempted or yielded tasks run again after the ones that are waiting.
+    wasm_enqueue(worker->scheduler, worker, task, false);
+  }
+}
+
+static void *wasm_worker_main(void *arg) {
+  wasm_worker *worker = arg;
+  wasm_scheduler *scheduler = worker->scheduler;
+  wasm_current_worker = worker;
+
+  for (;;) {
+    wasm_task *task = wasm_find_task(worker);
+    if (task) {
+      wasm_run_task(worker, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&scheduler->lock);
+    while (atomic_load(&scheduler->queued) == 0 && !scheduler->stopping) {
+      pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+    }
+    bool stop = scheduler->stopping && atomic_load(&scheduler->queued) == 0;
+    pthread_mutex_unlock(&scheduler->lock);
+    if (stop) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+// Stops the first `started` workers and the event thread and frees the
+// scheduler. No task may be left.
+static void wasm_destroy_scheduler(wasm_scheduler *scheduler,
+                                   uint32_t started) {
+  pthread_mutex_lock(&scheduler->lock);
+  scheduler->stopping = true;
+  pthread_cond_broadcast(&scheduler->wake);
+  pthread_mutex_unlock(&scheduler->lock);
+
+  for (uint32_t i = 0; i < scheduler->worker_count; i++) {
+    wasm_worker *worker = &scheduler->workers[i];
+    if (i < started) {
+      pthread_join(worker->thread, NULL);
+    }
+    wasm_deinit_deque(&worker->deque);
+    for (uint32_t j = 0; j < worker->free_stack_count; j++) {
+      wasm_free_reserved(worker->free_stacks[j], wasm_task_stack_size);
+    }
+  }
+
+#ifdef __linux__
+  uint64_t one = 1;
+  while (write(scheduler->stop_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+  pthread_join(scheduler->event_thread, NULL);
+  close(scheduler->stop_fd);
+  close(scheduler->epoll_fd);
+#endif
+
+  pthread_mutex_destroy(&scheduler->lock);
+  pthread_cond_destroy(&scheduler->wake);
+  pthread_cond_destroy(&scheduler->idle);
+  wasm_free(scheduler->workers);
+  wasm_free(scheduler);
+}
+
+wasm_scheduler *wasm_create_scheduler(uint32_t worker_count, int64_t slice) {
+  if (worker_count == 0 || slice <= 0) {
+    fprintf(stderr, "Invalid scheduler configuration.\n");
+    return NULL;
+  }
+
+  wasm_scheduler *scheduler = wasm_alloc(wasm_scheduler);
+#ifdef __linux__
+  scheduler->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  scheduler->stop_fd = eventfd(0, EFD_CLOEXEC);
+  struct epoll_event stop = {EPOLLIN, {.ptr = NULL}};
+  int error = 0;
+  if (scheduler->epoll_fd < 0 || scheduler->stop_fd < 0 ||
+      epoll_ctl(scheduler->epoll_fd, EPOLL_CTL_ADD, scheduler->stop_fd,
+                &stop) < 0) {
+    error = errno;
+  } else {
+    error = pthread_create(&scheduler->event_thread, NULL, wasm_event_main,
+                           scheduler);
+  }
+  if (error) {
+    fprintf(stderr, "Failed to create the event loop: %s\n", strerror(error));
+    if (scheduler->epoll_fd >= 0) {
+      close(scheduler->epoll_fd);
+    }
+    if (scheduler->stop_fd >= 0) {
+      close(scheduler->stop_fd);
+    }
+    wasm_free(scheduler);
+    return NULL;
+  }
+#endif
+
+  scheduler->workers = wasm_alloc_array(wasm_worker, worker_count);
+  scheduler->worker_count = worker_count;
+  scheduler->slice = slice;
+  atomic_init(&scheduler->pending, 0);
+  atomic_init(&scheduler->queued, 0);
+  atomic_init(&scheduler->next_worker, 0);
+  pthread_mutex_init(&scheduler->lock, NULL);
+  pthread_cond_init(&scheduler->wake, NULL);
+  pthread_cond_init(&scheduler->idle, NULL);
+  scheduler->stopping = false;
+
+  for (uint32_t i = 0; i < worker_count; i++) {
+    wasm_worker *worker = &scheduler->workers[i];
+    worker->scheduler = scheduler;
+    wasm_init_deque(&worker->deque);
+    worker->free_stack_count = 0;
+    worker->random = 2463534242u + i;
+  }
+  for (uint32_t i = 0; i < worker_count; i++) {
+    wasm_worker *worker = &scheduler->workers[i];
+    if (pthread_create(&worker->thread, NULL, wasm_worker_main, worker)) {
+      fprintf(stderr, "Failed to start the scheduler threads.\n");
+      wasm_destroy_scheduler(scheduler, i);
+      return NULL;
+    }
+  }
+
+  return scheduler;
+}
+
+void wasm_free_scheduler(wasm_scheduler *scheduler) {
+  if (scheduler == NULL) {
+    return;
+  }
+
+  wasm_scheduler_wait(scheduler);
+  wasm_destroy_scheduler(scheduler, scheduler->worker_count);
+}
+
+bool wasm_scheduler_spawn(wasm_scheduler *scheduler, wasm_instance *instance,
+                          uint32_t funcidx, const wasm_value *args,
+                          wasm_task_done done, void *user) {
+  wasm_module *module = instance->module;
+  if (funcidx >=
+      module->import_func_count + (uint32_t)wasm_vec_size(&module->funcs)) {
+    fprintf(stderr, "Invalid function index %u.\n", funcidx);
+    return false;
+  }
+
+  size_t param_count = instance->funcs[funcidx].type->param_count;
+  wasm_task *task = wasm_alloc(wasm_task);
+  task->scheduler = scheduler;
+  task->instance = instance;
+  task->funcidx = funcidx;
+  task->args = wasm_alloc_array(wasm_value, param_count + 1);
+  if (param_count > 0) {
+    memcpy(task->args, args, param_count * sizeof(wasm_value));
+  }
+  memset(&task->result, 0, sizeof(task->result));
+  task->trap = wasm_trap_none;
+  task->done = done;
+  task->user = user;
+  task->stack = NULL;
+  task->finished = false;
+  task->awaiting = false;
+  atomic_init(&task->state, wasm_task_running);
+  task->worker = NULL;
+
+  instance->fuel = scheduler->slice;
+  instance->checkpoint = wasm_task_checkpoint;
+  instance->checkpoint_user = task;
+
+  atomic_fetch_add(&scheduler->pending, 1);
+
+  // Workers keep the tasks they spawn, other threads distribute them.
+  wasm_worker *worker = wasm_current_worker;
+  if (worker != NULL && worker->scheduler == scheduler) {
+    wasm_enqueue(scheduler, worker, task, true);
+  } else {
+    uint32_t index =
+        atomic_fetch_add(&scheduler->next_worker, 1) % scheduler->worker_count;
+    wasm_enqueue(scheduler, &scheduler->workers[index], task, false);
+  }
+
+  pthread_mutex_lock(&scheduler->lock);
+  pthread_cond_signal(&scheduler->wake);
+  pthread_mutex_unlock(&scheduler->lock);
+  return true;
+}
+
+void wasm_scheduler_wait(wasm_scheduler *scheduler) {
+  pthread_mutex_lock(&scheduler->lock);
+  while (atomic_load(&scheduler->pending) > 0) {
+    pthread_cond_wait(&scheduler->idle, &scheduler->lock);
+  }
+  pthread_mutex_unlock(&scheduler->lock);
+}
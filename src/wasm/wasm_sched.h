@@ -0,0 +1,57 @@
+#pragma once
+
+#include "wasm/wasm_exec.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// An M:N scheduler that runs guest calls as tasks on a fixed pool of worker
+// threads. Every task runs on its own small native stack so that it can be
+// suspended in the middle of a call: at a fuel checkpoint of the engine once
+// its time slice is used up, or when a host function calls `wasm_task_yield`.
+// Each worker has a deque of runnable tasks and idle workers steal from the
+// others. Host functions can suspend their task while they wait for I/O, an
+// event loop thread puts it back once the operation completed.
+typedef struct wasm_scheduler wasm_scheduler;
+typedef struct wasm_task wasm_task;
+
+// Called on a worker thread when a task finished. `result` holds the result of
+// the function if it has one and `trap` is none.
+typedef void (*wasm_task_done)(enum wasm_trap trap, const wasm_value *result,
+                               void *user);
+
+// Starts `worker_count` threads. A task is preempted after it used `slice`
+// fuel, i.e. after about that many calls and loop iterations.
+wasm_scheduler *wasm_create_scheduler(uint32_t worker_count, int64_t slice);
+// Waits for all tasks and stops the workers.
+void wasm_free_scheduler(wasm_scheduler *scheduler);
+
+// Calls `funcidx` of `instance` with `args` as a new task. The instance must
+// not run anything else until `done` was called. Can be called from any
+// thread, including host functions running on a worker.
+bool wasm_scheduler_spawn(wasm_scheduler *scheduler, wasm_instance *instance,
+                          uint32_t funcidx, const wasm_value *args,
+                          wasm_task_done done, void *user);
+
+// Blocks until every spawned task is done.
+void wasm_scheduler_wait(wasm_scheduler *scheduler);
+
+// Suspends the task that runs `instance` so that the worker can run other
+// tasks. Host functions call it while they wait for something. Returns false
+// if `instance` is not running as a task.
+bool wasm_task_yield(wasm_instance *instance);
+
+// Marks the host call that runs on the task of `instance` as pending. The host
+// function starts an operation that calls `wasm_task_complete` from any thread
+// when it is done and then calls `wasm_task_await`. The guest sees a normal
+// call that returns once the operation completed. Returns NULL if `instance` is
+// not running as a task, the host function has to block instead.
+wasm_task *wasm_task_pending(wasm_instance *instance);
+// Suspends the task until `wasm_task_complete` was called. The worker runs
+// other tasks in the meantime.
+void wasm_task_await(wasm_task *task);
+void wasm_task_complete(wasm_task *task);
+
+// Waits until `fd` is ready for `events` (`POLLIN`, `POLLOUT`, ...) and
+// returns the events that occurred or -1 on error. A task is suspended and
+// resumed by the event loop of its scheduler, other callers block.
+int wasm_task_wait_fd(wasm_instance *instance, int fd, uint32_t events);
@@ -0,0 +1,55 @@
+#include "wasm/wasm_simd.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+enum wasm_simd_level wasm_simd_level = wasm_simd_scalar;
+// Loader threads detect the level concurrently, `pthread_once` makes the
+// first detection visible to all of them.
+static pthread_once_t wasm_simd_once = PTHREAD_ONCE_INIT;
+
+static void wasm_simd_detect_once(void) {
+  wasm_simd_level = wasm_simd_detect_level();
+}
+
+void wasm_simd_init(void) {
+  pthread_once(&wasm_simd_once, wasm_simd_detect_once);
+}
+
+enum wasm_simd_level wasm_simd_detect_level(void) {
+#if WASM_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return wasm_simd_avx2;
+  }
+  if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3")) {
+    return wasm_simd_sse41;
+  }
+  return wasm_simd_sse2;
+#else
+  return wasm_simd_scalar;
+#endif
+}
+
+enum wasm_simd_level wasm_simd_set_level(enum wasm_simd_level level) {
+  // A later `wasm_simd_init` doesn't override the level.
+  wasm_simd_init();
+  enum wasm_simd_level supported = wasm_simd_detect_level();
+  wasm_simd_level = level < supported ? level : supported;
+  return wasm_simd_level;
+}
+
+const char *wasm_simd_level_to_str(enum wasm_simd_level level) {
+  switch (level) {
+  case wasm_simd_scalar:
+    return "scalar";
+  case wasm_simd_sse2:
+    return "sse2";
+  case wasm_simd_sse41:
+    return "sse4.1";
+  case wasm_simd_avx2:
+    return "avx2";
+  default:
+    return "invalid";
+  }
+}
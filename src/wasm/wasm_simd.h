@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define WASM_SIMD_X86 1
+#include <immintrin.h>
+
+// Functions that use intrinsics above SSE2 must be compiled for that target.
+#define WASM_SSE41 __attribute__((target("ssse3,sse4.1")))
+#define WASM_AVX2 __attribute__((target("avx2")))
+#else
+#define WASM_SIMD_X86 0
+#endif
+
+// A 128 bit vector. Lanes are stored in little endian order like in linear
+// memory.
+typedef union {
+  int8_t i8[16];
+  uint8_t u8[16];
+  int16_t i16[8];
+  uint16_t u16[8];
+  int32_t i32[4];
+  uint32_t u32[4];
+  int64_t i64[2];
+  uint64_t u64[2];
+  float f32[4];
+  double f64[2];
+#if WASM_SIMD_X86
+  __m128i m;
+  __m128 ps;
+  __m128d pd;
+#endif
+} wasm_v128;
+
+// Instruction sets that are used to execute SIMD instructions. Every level
+// includes the ones below it.
+enum wasm_simd_level {
+  // Portable C which works on every host.
+  wasm_simd_scalar,
+  wasm_simd_sse2,
+  // SSSE3 and SSE4.1.
+  wasm_simd_sse41,
+  wasm_simd_avx2,
+};
+
+// Level that is used by the interpreter and the loader. It is detected with
+// CPUID the first time it is needed.
+extern enum wasm_simd_level wasm_simd_level;
+
+// Selects the best supported level unless a level was already set. Can be
+// called from any thread.
+void wasm_simd_init(void);
+
+// Returns the best level that is supported by the host.
+enum wasm_simd_level wasm_simd_detect_level(void);
+// Selects a level, e.g. to compare against the scalar fallback. Levels that
+// are not supported by the host are clamped. Returns the selected level. Must
+// not be called while other threads load modules or run code.
+enum wasm_simd_level wasm_simd_set_level(enum wasm_simd_level level);
+const char *wasm_simd_level_to_str(enum wasm_simd_level level);
@@ -0,0 +1,1391 @@
+#pragma once
+
+// Implementations of the SIMD instructions for the interpreter. Every
+// instruction has a portable scalar implementation. Where the host has a
+// matching instruction it is used if `wasm_simd_level` allows it. The level is
+// checked on every execution, the branch is always predicted correctly.
+//
+// Intrinsics above SSE2 can only be used in functions that are compiled for
+// that target, so they are wrapped in small `wasm_sse41_*` and `wasm_avx2_*`
+// functions.
+//
+// Only included by wasm_exec.c. The scalar float helpers of the interpreter,
+// e.g. `wasm_f32_min`, are shared with the MVP instructions.
+
+#include "wasm/wasm_simd.h"
+#include <math.h>
+#include <stdint.h>
+
+// Computes every lane of the result with `expr`. `expr` can use the operands
+// and the lane index `i`.
+#define WASM_SIMD_LANES(field, expr)                                           \
+  wasm_v128 r;                                                                 \
+  for (int i = 0; i < (int)(sizeof(r.field) / sizeof(r.field[0])); i++) {     \
+    r.field[i] = (expr);                                                       \
+  }                                                                            \
+  return r
+
+#if WASM_SIMD_X86
+// Returns `expr` if the level is available. `field` is the member of
+// `wasm_v128` that has the type of `expr`.
+#define WASM_SIMD_USE(level, field, expr)                                      \
+  if (wasm_simd_level >= wasm_simd_##level) {                                  \
+    wasm_v128 r;                                                               \
+    r.field = (expr);                                                          \
+    return r;                                                                  \
+  }
+
+static inline __m128i wasm_sse2_not(__m128i a) {
+  return _mm_xor_si128(a, _mm_set1_epi32(-1));
+}
+
+// Unsigned comparisons are done as signed ones after flipping the sign bit.
+static inline __m128i wasm_sse2_flip8(__m128i a) {
+  return _mm_xor_si128(a, _mm_set1_epi8((char)0x80));
+}
+static inline __m128i wasm_sse2_flip16(__m128i a) {
+  return _mm_xor_si128(a, _mm_set1_epi16((short)0x8000));
+}
+static inline __m128i wasm_sse2_flip32(__m128i a) {
+  return _mm_xor_si128(a, _mm_set1_epi32((int)0x80000000));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_swizzle(__m128i a, __m128i s) {
+  // Indices >= 16 get the top bit set which makes pshufb return 0.
+  return _mm_shuffle_epi8(a, _mm_adds_epu8(s, _mm_set1_epi8(0x70)));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_shuffle(__m128i a, __m128i b,
+                                                    __m128i lanes) {
+  // Lanes of `a` are 0-15 and lanes of `b` 16-31. Indices of the other
+  // operand get the top bit set.
+  __m128i from_a =
+      _mm_or_si128(lanes, _mm_cmpgt_epi8(lanes, _mm_set1_epi8(15)));
+  __m128i from_b = _mm_sub_epi8(lanes, _mm_set1_epi8(16));
+  return _mm_or_si128(_mm_shuffle_epi8(a, from_a),
+                      _mm_shuffle_epi8(b, from_b));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_abs8(__m128i a) {
+  return _mm_abs_epi8(a);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_abs16(__m128i a) {
+  return _mm_abs_epi16(a);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_abs32(__m128i a) {
+  return _mm_abs_epi32(a);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_popcnt8(__m128i a) {
+  // Looks up the bit count of both nibbles.
+  const __m128i table =
+      _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  __m128i low = _mm_and_si128(a, nibble);
+  __m128i high = _mm_and_si128(_mm_srli_epi16(a, 4), nibble);
+  return _mm_add_epi8(_mm_shuffle_epi8(table, low),
+                      _mm_shuffle_epi8(table, high));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_min_s8(__m128i a, __m128i b) {
+  return _mm_min_epi8(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_max_s8(__m128i a, __m128i b) {
+  return _mm_max_epi8(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_min_u16(__m128i a, __m128i b) {
+  return _mm_min_epu16(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_max_u16(__m128i a, __m128i b) {
+  return _mm_max_epu16(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_min_s32(__m128i a, __m128i b) {
+  return _mm_min_epi32(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_max_s32(__m128i a, __m128i b) {
+  return _mm_max_epi32(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_min_u32(__m128i a, __m128i b) {
+  return _mm_min_epu32(a, b);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_max_u32(__m128i a, __m128i b) {
+  return _mm_max_epu32(a, b);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_mul32(__m128i a, __m128i b) {
+  return _mm_mullo_epi32(a, b);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_eq64(__m128i a, __m128i b) {
+  return _mm_cmpeq_epi64(a, b);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_narrow_u32(__m128i a, __m128i b) {
+  return _mm_packus_epi32(a, b);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_q15mulr(__m128i a, __m128i b) {
+  // pmulhrsw wraps 0x8000 * 0x8000 to 0x8000 instead of saturating.
+  __m128i r = _mm_mulhrs_epi16(a, b);
+  return _mm_xor_si128(r, _mm_cmpeq_epi16(r, _mm_set1_epi16((short)0x8000)));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_extadd_s8(__m128i a) {
+  return _mm_maddubs_epi16(_mm_set1_epi8(1), a);
+}
+WASM_SSE41 static inline __m128i wasm_sse41_extadd_u8(__m128i a) {
+  return _mm_maddubs_epi16(a, _mm_set1_epi8(1));
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_extend_s32(__m128i a) {
+  return _mm_cvtepi32_epi64(a);
+}
+
+// Signed 32 x 32 -> 64 bit multiplication of lanes 0 and 2.
+WASM_SSE41 static inline __m128i wasm_sse41_mul_s32(__m128i a, __m128i b) {
+  return _mm_mul_epi32(a, b);
+}
+
+WASM_SSE41 static inline __m128 wasm_sse41_round_ps(__m128 a, int mode) {
+  switch (mode) {
+  case 0:
+    return _mm_round_ps(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  case 1:
+    return _mm_round_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  case 2:
+    return _mm_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  default:
+    return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+}
+
+WASM_SSE41 static inline __m128d wasm_sse41_round_pd(__m128d a, int mode) {
+  switch (mode) {
+  case 0:
+    return _mm_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  case 1:
+    return _mm_round_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  case 2:
+    return _mm_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  default:
+    return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+}
+
+// AVX2 broadcasts a byte or a word with one instruction.
+WASM_AVX2 static inline __m128i wasm_avx2_splat8(int32_t x) {
+  return _mm_broadcastb_epi8(_mm_cvtsi32_si128(x));
+}
+WASM_AVX2 static inline __m128i wasm_avx2_splat16(int32_t x) {
+  return _mm_broadcastw_epi16(_mm_cvtsi32_si128(x));
+}
+#else
+#define WASM_SIMD_USE(level, field, expr)
+#endif
+
+// Saturating narrowing.
+
+static inline int8_t wasm_simd_sat_s8(int32_t x) {
+  return x < INT8_MIN ? INT8_MIN : x > INT8_MAX ? INT8_MAX : (int8_t)x;
+}
+static inline uint8_t wasm_simd_sat_u8(int32_t x) {
+  return x < 0 ? 0 : x > UINT8_MAX ? UINT8_MAX : (uint8_t)x;
+}
+static inline int16_t wasm_simd_sat_s16(int32_t x) {
+  return x < INT16_MIN ? INT16_MIN : x > INT16_MAX ? INT16_MAX : (int16_t)x;
+}
+static inline uint16_t wasm_simd_sat_u16(int32_t x) {
+  return x < 0 ? 0 : x > UINT16_MAX ? UINT16_MAX : (uint16_t)x;
+}
+
+// Comparison results are all ones or all zeros.
+#define WASM_SIMD_MASK(cond) (-(int)(cond))
+
+// Splats.
+
+static inline wasm_v128 wasm_simd_i8x16_splat(int32_t x) {
+  WASM_SIMD_USE(avx2, m, wasm_avx2_splat8(x));
+  WASM_SIMD_USE(sse2, m, _mm_set1_epi8((char)x));
+  WASM_SIMD_LANES(u8, (uint8_t)x);
+}
+static inline wasm_v128 wasm_simd_i16x8_splat(int32_t x) {
+  WASM_SIMD_USE(avx2, m, wasm_avx2_splat16(x));
+  WASM_SIMD_USE(sse2, m, _mm_set1_epi16((short)x));
+  WASM_SIMD_LANES(u16, (uint16_t)x);
+}
+static inline wasm_v128 wasm_simd_i32x4_splat(int32_t x) {
+  WASM_SIMD_USE(sse2, m, _mm_set1_epi32(x));
+  WASM_SIMD_LANES(i32, x);
+}
+static inline wasm_v128 wasm_simd_i64x2_splat(int64_t x) {
+  WASM_SIMD_USE(sse2, m, _mm_set1_epi64x(x));
+  WASM_SIMD_LANES(i64, x);
+}
+static inline wasm_v128 wasm_simd_f32x4_splat(float x) {
+  WASM_SIMD_USE(sse2, ps, _mm_set1_ps(x));
+  WASM_SIMD_LANES(f32, x);
+}
+static inline wasm_v128 wasm_simd_f64x2_splat(double x) {
+  WASM_SIMD_USE(sse2, pd, _mm_set1_pd(x));
+  WASM_SIMD_LANES(f64, x);
+}
+
+// Shuffles. `lanes` holds 16 lane indices below 32.
+
+static inline wasm_v128 wasm_simd_i8x16_shuffle(wasm_v128 a, wasm_v128 b,
+                                                wasm_v128 lanes) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_shuffle(a.m, b.m, lanes.m));
+  WASM_SIMD_LANES(u8, lanes.u8[i] < 16 ? a.u8[lanes.u8[i]]
+                                       : b.u8[lanes.u8[i] - 16]);
+}
+
+static inline wasm_v128 wasm_simd_i8x16_swizzle(wasm_v128 a, wasm_v128 s) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_swizzle(a.m, s.m));
+  WASM_SIMD_LANES(u8, s.u8[i] < 16 ? a.u8[s.u8[i]] : 0);
+}
+
+// Integer comparisons.
+
+static inline wasm_v128 wasm_simd_i8x16_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpeq_epi8(a.m, b.m));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] == b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpeq_epi8(a.m, b.m)));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] != b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_lt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmplt_epi8(a.m, b.m));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] < b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_lt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmplt_epi8(wasm_sse2_flip8(a.m), wasm_sse2_flip8(b.m)));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.u8[i] < b.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_gt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpgt_epi8(a.m, b.m));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] > b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_gt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmpgt_epi8(wasm_sse2_flip8(a.m), wasm_sse2_flip8(b.m)));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.u8[i] > b.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_le_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpgt_epi8(a.m, b.m)));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] <= b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_le_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpeq_epi8(_mm_min_epu8(a.m, b.m), a.m));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.u8[i] <= b.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_ge_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmplt_epi8(a.m, b.m)));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.i8[i] >= b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_ge_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpeq_epi8(_mm_max_epu8(a.m, b.m), a.m));
+  WASM_SIMD_LANES(i8, WASM_SIMD_MASK(a.u8[i] >= b.u8[i]));
+}
+
+static inline wasm_v128 wasm_simd_i16x8_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpeq_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] == b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpeq_epi16(a.m, b.m)));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] != b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_lt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmplt_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] < b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_lt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmplt_epi16(wasm_sse2_flip16(a.m), wasm_sse2_flip16(b.m)));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.u16[i] < b.u16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_gt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpgt_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] > b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_gt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmpgt_epi16(wasm_sse2_flip16(a.m), wasm_sse2_flip16(b.m)));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.u16[i] > b.u16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_le_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpgt_epi16(a.m, b.m)));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] <= b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_le_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                wasm_sse2_not(_mm_cmpgt_epi16(wasm_sse2_flip16(a.m),
+                                              wasm_sse2_flip16(b.m))));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.u16[i] <= b.u16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_ge_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmplt_epi16(a.m, b.m)));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.i16[i] >= b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_ge_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                wasm_sse2_not(_mm_cmplt_epi16(wasm_sse2_flip16(a.m),
+                                              wasm_sse2_flip16(b.m))));
+  WASM_SIMD_LANES(i16, WASM_SIMD_MASK(a.u16[i] >= b.u16[i]));
+}
+
+static inline wasm_v128 wasm_simd_i32x4_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpeq_epi32(a.m, b.m));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] == b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpeq_epi32(a.m, b.m)));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] != b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_lt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmplt_epi32(a.m, b.m));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] < b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_lt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmplt_epi32(wasm_sse2_flip32(a.m), wasm_sse2_flip32(b.m)));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.u32[i] < b.u32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_gt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_cmpgt_epi32(a.m, b.m));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] > b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_gt_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_cmpgt_epi32(wasm_sse2_flip32(a.m), wasm_sse2_flip32(b.m)));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.u32[i] > b.u32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_le_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmpgt_epi32(a.m, b.m)));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] <= b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_le_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                wasm_sse2_not(_mm_cmpgt_epi32(wasm_sse2_flip32(a.m),
+                                              wasm_sse2_flip32(b.m))));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.u32[i] <= b.u32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_ge_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(_mm_cmplt_epi32(a.m, b.m)));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.i32[i] >= b.i32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_ge_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                wasm_sse2_not(_mm_cmplt_epi32(wasm_sse2_flip32(a.m),
+                                              wasm_sse2_flip32(b.m))));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.u32[i] >= b.u32[i]));
+}
+
+static inline wasm_v128 wasm_simd_i64x2_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_eq64(a.m, b.m));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] == b.i64[i]));
+}
+static inline wasm_v128 wasm_simd_i64x2_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse2_not(wasm_sse41_eq64(a.m, b.m)));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] != b.i64[i]));
+}
+static inline wasm_v128 wasm_simd_i64x2_lt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] < b.i64[i]));
+}
+static inline wasm_v128 wasm_simd_i64x2_gt_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] > b.i64[i]));
+}
+static inline wasm_v128 wasm_simd_i64x2_le_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] <= b.i64[i]));
+}
+static inline wasm_v128 wasm_simd_i64x2_ge_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(i64, -(int64_t)(a.i64[i] >= b.i64[i]));
+}
+
+// Float comparisons. NaN compares unequal to everything.
+
+static inline wasm_v128 wasm_simd_f32x4_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmpeq_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] == b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmpneq_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] != b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_lt(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmplt_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] < b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_gt(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmpgt_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] > b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_le(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmple_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] <= b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_ge(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_cmpge_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(i32, WASM_SIMD_MASK(a.f32[i] >= b.f32[i]));
+}
+
+static inline wasm_v128 wasm_simd_f64x2_eq(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmpeq_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] == b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_ne(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmpneq_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] != b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_lt(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmplt_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] < b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_gt(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmpgt_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] > b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_le(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmple_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] <= b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_ge(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_cmpge_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(i64, -(int64_t)(a.f64[i] >= b.f64[i]));
+}
+
+// Bitwise operations.
+
+static inline wasm_v128 wasm_simd_v128_not(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_not(a.m));
+  WASM_SIMD_LANES(u64, ~a.u64[i]);
+}
+static inline wasm_v128 wasm_simd_v128_and(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_and_si128(a.m, b.m));
+  WASM_SIMD_LANES(u64, a.u64[i] & b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_v128_andnot(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_andnot_si128(b.m, a.m));
+  WASM_SIMD_LANES(u64, a.u64[i] & ~b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_v128_or(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_or_si128(a.m, b.m));
+  WASM_SIMD_LANES(u64, a.u64[i] | b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_v128_xor(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_xor_si128(a.m, b.m));
+  WASM_SIMD_LANES(u64, a.u64[i] ^ b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_v128_bitselect(wasm_v128 a, wasm_v128 b,
+                                                 wasm_v128 c) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_or_si128(_mm_and_si128(a.m, c.m),
+                             _mm_andnot_si128(c.m, b.m)));
+  WASM_SIMD_LANES(u64, (a.u64[i] & c.u64[i]) | (b.u64[i] & ~c.u64[i]));
+}
+
+// Reductions to a scalar.
+
+static inline int32_t wasm_simd_v128_any_true(wasm_v128 a) {
+  return (a.u64[0] | a.u64[1]) != 0;
+}
+
+static inline int32_t wasm_simd_i8x16_all_true(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a.m, _mm_setzero_si128())) == 0;
+  }
+#endif
+  for (int i = 0; i < 16; i++) {
+    if (a.u8[i] == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+static inline int32_t wasm_simd_i16x8_all_true(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(a.m, _mm_setzero_si128())) == 0;
+  }
+#endif
+  for (int i = 0; i < 8; i++) {
+    if (a.u16[i] == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+static inline int32_t wasm_simd_i32x4_all_true(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(a.m, _mm_setzero_si128())) == 0;
+  }
+#endif
+  for (int i = 0; i < 4; i++) {
+    if (a.u32[i] == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+static inline int32_t wasm_simd_i64x2_all_true(wasm_v128 a) {
+  return a.u64[0] != 0 && a.u64[1] != 0;
+}
+
+static inline int32_t wasm_simd_i8x16_bitmask(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_epi8(a.m);
+  }
+#endif
+  int32_t mask = 0;
+  for (int i = 0; i < 16; i++) {
+    mask |= (a.u8[i] >> 7) << i;
+  }
+  return mask;
+}
+static inline int32_t wasm_simd_i16x8_bitmask(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_epi8(_mm_packs_epi16(a.m, _mm_setzero_si128()));
+  }
+#endif
+  int32_t mask = 0;
+  for (int i = 0; i < 8; i++) {
+    mask |= (a.u16[i] >> 15) << i;
+  }
+  return mask;
+}
+static inline int32_t wasm_simd_i32x4_bitmask(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_ps(a.ps);
+  }
+#endif
+  int32_t mask = 0;
+  for (int i = 0; i < 4; i++) {
+    mask |= (int32_t)(a.u32[i] >> 31) << i;
+  }
+  return mask;
+}
+static inline int32_t wasm_simd_i64x2_bitmask(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    return _mm_movemask_pd(a.pd);
+  }
+#endif
+  return (int32_t)(a.u64[0] >> 63) | (int32_t)(a.u64[1] >> 63) << 1;
+}
+
+// i8x16 arithmetic.
+
+static inline wasm_v128 wasm_simd_i8x16_abs(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_abs8(a.m));
+  WASM_SIMD_LANES(u8, a.i8[i] < 0 ? -a.u8[i] : a.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi8(_mm_setzero_si128(), a.m));
+  WASM_SIMD_LANES(u8, -a.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_popcnt(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_popcnt8(a.m));
+  WASM_SIMD_LANES(u8, __builtin_popcount(a.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_narrow_i16x8_s(wasm_v128 a,
+                                                      wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_packs_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i8, wasm_simd_sat_s8(i < 8 ? a.i16[i] : b.i16[i - 8]));
+}
+static inline wasm_v128 wasm_simd_i8x16_narrow_i16x8_u(wasm_v128 a,
+                                                      wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_packus_epi16(a.m, b.m));
+  WASM_SIMD_LANES(u8, wasm_simd_sat_u8(i < 8 ? a.i16[i] : b.i16[i - 8]));
+}
+static inline wasm_v128 wasm_simd_i8x16_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_add_epi8(a.m, b.m));
+  WASM_SIMD_LANES(u8, a.u8[i] + b.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_add_sat_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_adds_epi8(a.m, b.m));
+  WASM_SIMD_LANES(i8, wasm_simd_sat_s8(a.i8[i] + b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_add_sat_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_adds_epu8(a.m, b.m));
+  WASM_SIMD_LANES(u8, wasm_simd_sat_u8(a.u8[i] + b.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi8(a.m, b.m));
+  WASM_SIMD_LANES(u8, a.u8[i] - b.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_sub_sat_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_subs_epi8(a.m, b.m));
+  WASM_SIMD_LANES(i8, wasm_simd_sat_s8(a.i8[i] - b.i8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_sub_sat_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_subs_epu8(a.m, b.m));
+  WASM_SIMD_LANES(u8, wasm_simd_sat_u8(a.u8[i] - b.u8[i]));
+}
+static inline wasm_v128 wasm_simd_i8x16_min_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_min_s8(a.m, b.m));
+  WASM_SIMD_LANES(i8, a.i8[i] < b.i8[i] ? a.i8[i] : b.i8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_min_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_min_epu8(a.m, b.m));
+  WASM_SIMD_LANES(u8, a.u8[i] < b.u8[i] ? a.u8[i] : b.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_max_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_max_s8(a.m, b.m));
+  WASM_SIMD_LANES(i8, a.i8[i] > b.i8[i] ? a.i8[i] : b.i8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_max_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_max_epu8(a.m, b.m));
+  WASM_SIMD_LANES(u8, a.u8[i] > b.u8[i] ? a.u8[i] : b.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i8x16_avgr_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_avg_epu8(a.m, b.m));
+  WASM_SIMD_LANES(u8, (a.u8[i] + b.u8[i] + 1) >> 1);
+}
+
+// Shifts use the count modulo the lane width.
+
+static inline wasm_v128 wasm_simd_i8x16_shl(wasm_v128 a, int32_t count) {
+  int c = count & 7;
+  WASM_SIMD_USE(sse2, m,
+                _mm_and_si128(_mm_sll_epi16(a.m, _mm_cvtsi32_si128(c)),
+                              _mm_set1_epi8((char)(0xFF << c))));
+  WASM_SIMD_LANES(u8, a.u8[i] << c);
+}
+static inline wasm_v128 wasm_simd_i8x16_shr_s(wasm_v128 a, int32_t count) {
+  int c = count & 7;
+  // Shifts the bytes in the high half of 16 bit lanes and packs them again.
+  WASM_SIMD_USE(
+      sse2, m,
+      _mm_packs_epi16(
+          _mm_sra_epi16(_mm_unpacklo_epi8(a.m, a.m), _mm_cvtsi32_si128(c + 8)),
+          _mm_sra_epi16(_mm_unpackhi_epi8(a.m, a.m),
+                        _mm_cvtsi32_si128(c + 8))));
+  WASM_SIMD_LANES(i8, a.i8[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i8x16_shr_u(wasm_v128 a, int32_t count) {
+  int c = count & 7;
+  WASM_SIMD_USE(sse2, m,
+                _mm_and_si128(_mm_srl_epi16(a.m, _mm_cvtsi32_si128(c)),
+                              _mm_set1_epi8((char)(0xFF >> c))));
+  WASM_SIMD_LANES(u8, a.u8[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i16x8_shl(wasm_v128 a, int32_t count) {
+  int c = count & 15;
+  WASM_SIMD_USE(sse2, m, _mm_sll_epi16(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u16, a.u16[i] << c);
+}
+static inline wasm_v128 wasm_simd_i16x8_shr_s(wasm_v128 a, int32_t count) {
+  int c = count & 15;
+  WASM_SIMD_USE(sse2, m, _mm_sra_epi16(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(i16, a.i16[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i16x8_shr_u(wasm_v128 a, int32_t count) {
+  int c = count & 15;
+  WASM_SIMD_USE(sse2, m, _mm_srl_epi16(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u16, a.u16[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i32x4_shl(wasm_v128 a, int32_t count) {
+  int c = count & 31;
+  WASM_SIMD_USE(sse2, m, _mm_sll_epi32(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u32, a.u32[i] << c);
+}
+static inline wasm_v128 wasm_simd_i32x4_shr_s(wasm_v128 a, int32_t count) {
+  int c = count & 31;
+  WASM_SIMD_USE(sse2, m, _mm_sra_epi32(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(i32, a.i32[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i32x4_shr_u(wasm_v128 a, int32_t count) {
+  int c = count & 31;
+  WASM_SIMD_USE(sse2, m, _mm_srl_epi32(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u32, a.u32[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i64x2_shl(wasm_v128 a, int32_t count) {
+  int c = count & 63;
+  WASM_SIMD_USE(sse2, m, _mm_sll_epi64(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u64, a.u64[i] << c);
+}
+static inline wasm_v128 wasm_simd_i64x2_shr_s(wasm_v128 a, int32_t count) {
+  int c = count & 63;
+  WASM_SIMD_LANES(i64, a.i64[i] >> c);
+}
+static inline wasm_v128 wasm_simd_i64x2_shr_u(wasm_v128 a, int32_t count) {
+  int c = count & 63;
+  WASM_SIMD_USE(sse2, m, _mm_srl_epi64(a.m, _mm_cvtsi32_si128(c)));
+  WASM_SIMD_LANES(u64, a.u64[i] >> c);
+}
+
+// i16x8 arithmetic.
+
+static inline wasm_v128 wasm_simd_i16x8_extadd_pairwise_i8x16_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_extadd_s8(a.m));
+  WASM_SIMD_LANES(i16, a.i8[2 * i] + a.i8[2 * i + 1]);
+}
+static inline wasm_v128 wasm_simd_i16x8_extadd_pairwise_i8x16_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_extadd_u8(a.m));
+  WASM_SIMD_LANES(u16, a.u8[2 * i] + a.u8[2 * i + 1]);
+}
+static inline wasm_v128 wasm_simd_i16x8_abs(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_abs16(a.m));
+  WASM_SIMD_LANES(u16, a.i16[i] < 0 ? -a.u16[i] : a.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi16(_mm_setzero_si128(), a.m));
+  WASM_SIMD_LANES(u16, -a.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_q15mulr_sat_s(wasm_v128 a,
+                                                     wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_q15mulr(a.m, b.m));
+  WASM_SIMD_LANES(i16,
+                  wasm_simd_sat_s16((a.i16[i] * b.i16[i] + 0x4000) >> 15));
+}
+static inline wasm_v128 wasm_simd_i16x8_narrow_i32x4_s(wasm_v128 a,
+                                                      wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_packs_epi32(a.m, b.m));
+  WASM_SIMD_LANES(i16, wasm_simd_sat_s16(i < 4 ? a.i32[i] : b.i32[i - 4]));
+}
+static inline wasm_v128 wasm_simd_i16x8_narrow_i32x4_u(wasm_v128 a,
+                                                      wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_narrow_u32(a.m, b.m));
+  WASM_SIMD_LANES(u16, wasm_simd_sat_u16(i < 4 ? a.i32[i] : b.i32[i - 4]));
+}
+static inline wasm_v128 wasm_simd_i16x8_extend_low_i8x16_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_srai_epi16(_mm_unpacklo_epi8(a.m, a.m), 8));
+  WASM_SIMD_LANES(i16, a.i8[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_extend_high_i8x16_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_srai_epi16(_mm_unpackhi_epi8(a.m, a.m), 8));
+  WASM_SIMD_LANES(i16, a.i8[i + 8]);
+}
+static inline wasm_v128 wasm_simd_i16x8_extend_low_i8x16_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpacklo_epi8(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u16, a.u8[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_extend_high_i8x16_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpackhi_epi8(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u16, a.u8[i + 8]);
+}
+static inline wasm_v128 wasm_simd_i16x8_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_add_epi16(a.m, b.m));
+  WASM_SIMD_LANES(u16, a.u16[i] + b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_add_sat_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_adds_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, wasm_simd_sat_s16(a.i16[i] + b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_add_sat_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_adds_epu16(a.m, b.m));
+  WASM_SIMD_LANES(u16, wasm_simd_sat_u16(a.u16[i] + b.u16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi16(a.m, b.m));
+  WASM_SIMD_LANES(u16, a.u16[i] - b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_sub_sat_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_subs_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, wasm_simd_sat_s16(a.i16[i] - b.i16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_sub_sat_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_subs_epu16(a.m, b.m));
+  WASM_SIMD_LANES(u16, wasm_simd_sat_u16(a.u16[i] - b.u16[i]));
+}
+static inline wasm_v128 wasm_simd_i16x8_mul(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_mullo_epi16(a.m, b.m));
+  WASM_SIMD_LANES(u16, (uint32_t)a.u16[i] * b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_min_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_min_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, a.i16[i] < b.i16[i] ? a.i16[i] : b.i16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_min_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_min_u16(a.m, b.m));
+  WASM_SIMD_LANES(u16, a.u16[i] < b.u16[i] ? a.u16[i] : b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_max_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_max_epi16(a.m, b.m));
+  WASM_SIMD_LANES(i16, a.i16[i] > b.i16[i] ? a.i16[i] : b.i16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_max_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_max_u16(a.m, b.m));
+  WASM_SIMD_LANES(u16, a.u16[i] > b.u16[i] ? a.u16[i] : b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i16x8_avgr_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_avg_epu16(a.m, b.m));
+  WASM_SIMD_LANES(u16, (a.u16[i] + b.u16[i] + 1) >> 1);
+}
+static inline wasm_v128 wasm_simd_i16x8_extmul_low_i8x16_s(wasm_v128 a,
+                                                          wasm_v128 b) {
+  return wasm_simd_i16x8_mul(wasm_simd_i16x8_extend_low_i8x16_s(a),
+                             wasm_simd_i16x8_extend_low_i8x16_s(b));
+}
+static inline wasm_v128 wasm_simd_i16x8_extmul_high_i8x16_s(wasm_v128 a,
+                                                           wasm_v128 b) {
+  return wasm_simd_i16x8_mul(wasm_simd_i16x8_extend_high_i8x16_s(a),
+                             wasm_simd_i16x8_extend_high_i8x16_s(b));
+}
+static inline wasm_v128 wasm_simd_i16x8_extmul_low_i8x16_u(wasm_v128 a,
+                                                          wasm_v128 b) {
+  return wasm_simd_i16x8_mul(wasm_simd_i16x8_extend_low_i8x16_u(a),
+                             wasm_simd_i16x8_extend_low_i8x16_u(b));
+}
+static inline wasm_v128 wasm_simd_i16x8_extmul_high_i8x16_u(wasm_v128 a,
+                                                           wasm_v128 b) {
+  return wasm_simd_i16x8_mul(wasm_simd_i16x8_extend_high_i8x16_u(a),
+                             wasm_simd_i16x8_extend_high_i8x16_u(b));
+}
+
+// i32x4 arithmetic.
+
+static inline wasm_v128 wasm_simd_i32x4_extadd_pairwise_i16x8_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_madd_epi16(a.m, _mm_set1_epi16(1)));
+  WASM_SIMD_LANES(i32, a.i16[2 * i] + a.i16[2 * i + 1]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extadd_pairwise_i16x8_u(wasm_v128 a) {
+  // Adds the pairs as signed values and corrects the bias afterwards.
+  WASM_SIMD_USE(sse2, m,
+                _mm_add_epi32(_mm_madd_epi16(wasm_sse2_flip16(a.m),
+                                             _mm_set1_epi16(1)),
+                              _mm_set1_epi32(0x10000)));
+  WASM_SIMD_LANES(u32, a.u16[2 * i] + a.u16[2 * i + 1]);
+}
+static inline wasm_v128 wasm_simd_i32x4_abs(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_abs32(a.m));
+  WASM_SIMD_LANES(u32, a.i32[i] < 0 ? -a.u32[i] : a.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi32(_mm_setzero_si128(), a.m));
+  WASM_SIMD_LANES(u32, -a.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extend_low_i16x8_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_srai_epi32(_mm_unpacklo_epi16(a.m, a.m), 16));
+  WASM_SIMD_LANES(i32, a.i16[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extend_high_i16x8_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_srai_epi32(_mm_unpackhi_epi16(a.m, a.m), 16));
+  WASM_SIMD_LANES(i32, a.i16[i + 4]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extend_low_i16x8_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpacklo_epi16(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u32, a.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extend_high_i16x8_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpackhi_epi16(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u32, a.u16[i + 4]);
+}
+static inline wasm_v128 wasm_simd_i32x4_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_add_epi32(a.m, b.m));
+  WASM_SIMD_LANES(u32, a.u32[i] + b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi32(a.m, b.m));
+  WASM_SIMD_LANES(u32, a.u32[i] - b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_mul(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_mul32(a.m, b.m));
+  WASM_SIMD_LANES(u32, a.u32[i] * b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_min_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_min_s32(a.m, b.m));
+  WASM_SIMD_LANES(i32, a.i32[i] < b.i32[i] ? a.i32[i] : b.i32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_min_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_min_u32(a.m, b.m));
+  WASM_SIMD_LANES(u32, a.u32[i] < b.u32[i] ? a.u32[i] : b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_max_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_max_s32(a.m, b.m));
+  WASM_SIMD_LANES(i32, a.i32[i] > b.i32[i] ? a.i32[i] : b.i32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_max_u(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_max_u32(a.m, b.m));
+  WASM_SIMD_LANES(u32, a.u32[i] > b.u32[i] ? a.u32[i] : b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_dot_i16x8_s(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_madd_epi16(a.m, b.m));
+  WASM_SIMD_LANES(u32, (uint32_t)(a.i16[2 * i] * b.i16[2 * i]) +
+                           (uint32_t)(a.i16[2 * i + 1] * b.i16[2 * i + 1]));
+}
+static inline wasm_v128 wasm_simd_i32x4_extmul_low_i16x8_s(wasm_v128 a,
+                                                          wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_unpacklo_epi16(_mm_mullo_epi16(a.m, b.m),
+                                   _mm_mulhi_epi16(a.m, b.m)));
+  WASM_SIMD_LANES(i32, a.i16[i] * b.i16[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extmul_high_i16x8_s(wasm_v128 a,
+                                                           wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_unpackhi_epi16(_mm_mullo_epi16(a.m, b.m),
+                                   _mm_mulhi_epi16(a.m, b.m)));
+  WASM_SIMD_LANES(i32, a.i16[i + 4] * b.i16[i + 4]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extmul_low_i16x8_u(wasm_v128 a,
+                                                          wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_unpacklo_epi16(_mm_mullo_epi16(a.m, b.m),
+                                   _mm_mulhi_epu16(a.m, b.m)));
+  WASM_SIMD_LANES(u32, (uint32_t)a.u16[i] * b.u16[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_extmul_high_i16x8_u(wasm_v128 a,
+                                                           wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_unpackhi_epi16(_mm_mullo_epi16(a.m, b.m),
+                                   _mm_mulhi_epu16(a.m, b.m)));
+  WASM_SIMD_LANES(u32, (uint32_t)a.u16[i + 4] * b.u16[i + 4]);
+}
+
+// i64x2 arithmetic.
+
+static inline wasm_v128 wasm_simd_i64x2_abs(wasm_v128 a) {
+  WASM_SIMD_LANES(u64, a.i64[i] < 0 ? -a.u64[i] : a.u64[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi64(_mm_setzero_si128(), a.m));
+  WASM_SIMD_LANES(u64, -a.u64[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extend_low_i32x4_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_extend_s32(a.m));
+  WASM_SIMD_LANES(i64, a.i32[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extend_high_i32x4_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, m, wasm_sse41_extend_s32(_mm_srli_si128(a.m, 8)));
+  WASM_SIMD_LANES(i64, a.i32[i + 2]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extend_low_i32x4_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpacklo_epi32(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u64, a.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extend_high_i32x4_u(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_unpackhi_epi32(a.m, _mm_setzero_si128()));
+  WASM_SIMD_LANES(u64, a.u32[i + 2]);
+}
+static inline wasm_v128 wasm_simd_i64x2_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_add_epi64(a.m, b.m));
+  WASM_SIMD_LANES(u64, a.u64[i] + b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m, _mm_sub_epi64(a.m, b.m));
+  WASM_SIMD_LANES(u64, a.u64[i] - b.u64[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_mul(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(u64, a.u64[i] * b.u64[i]);
+}
+// The 32 x 32 -> 64 bit multiplications use lanes 0 and 2, so the inputs are
+// spread over these lanes first.
+static inline wasm_v128 wasm_simd_i64x2_extmul_low_i32x4_s(wasm_v128 a,
+                                                          wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m,
+                wasm_sse41_mul_s32(_mm_shuffle_epi32(a.m, 0x50),
+                                   _mm_shuffle_epi32(b.m, 0x50)));
+  WASM_SIMD_LANES(i64, (int64_t)a.i32[i] * b.i32[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extmul_high_i32x4_s(wasm_v128 a,
+                                                           wasm_v128 b) {
+  WASM_SIMD_USE(sse41, m,
+                wasm_sse41_mul_s32(_mm_shuffle_epi32(a.m, 0xFA),
+                                   _mm_shuffle_epi32(b.m, 0xFA)));
+  WASM_SIMD_LANES(i64, (int64_t)a.i32[i + 2] * b.i32[i + 2]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extmul_low_i32x4_u(wasm_v128 a,
+                                                          wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_mul_epu32(_mm_shuffle_epi32(a.m, 0x50),
+                              _mm_shuffle_epi32(b.m, 0x50)));
+  WASM_SIMD_LANES(u64, (uint64_t)a.u32[i] * b.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i64x2_extmul_high_i32x4_u(wasm_v128 a,
+                                                           wasm_v128 b) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_mul_epu32(_mm_shuffle_epi32(a.m, 0xFA),
+                              _mm_shuffle_epi32(b.m, 0xFA)));
+  WASM_SIMD_LANES(u64, (uint64_t)a.u32[i + 2] * b.u32[i + 2]);
+}
+
+// f32x4 arithmetic.
+
+static inline wasm_v128 wasm_simd_f32x4_ceil(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, ps, wasm_sse41_round_ps(a.ps, 0));
+  WASM_SIMD_LANES(f32, ceilf(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_floor(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, ps, wasm_sse41_round_ps(a.ps, 1));
+  WASM_SIMD_LANES(f32, floorf(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_trunc(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, ps, wasm_sse41_round_ps(a.ps, 2));
+  WASM_SIMD_LANES(f32, truncf(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_nearest(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, ps, wasm_sse41_round_ps(a.ps, 3));
+  WASM_SIMD_LANES(f32, nearbyintf(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_abs(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, _mm_and_si128(a.m, _mm_set1_epi32(0x7FFFFFFF)));
+  WASM_SIMD_LANES(u32, a.u32[i] & 0x7FFFFFFF);
+}
+static inline wasm_v128 wasm_simd_f32x4_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m, wasm_sse2_flip32(a.m));
+  WASM_SIMD_LANES(u32, a.u32[i] ^ 0x80000000);
+}
+static inline wasm_v128 wasm_simd_f32x4_sqrt(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, ps, _mm_sqrt_ps(a.ps));
+  WASM_SIMD_LANES(f32, sqrtf(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_add_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(f32, a.f32[i] + b.f32[i]);
+}
+static inline wasm_v128 wasm_simd_f32x4_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_sub_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(f32, a.f32[i] - b.f32[i]);
+}
+static inline wasm_v128 wasm_simd_f32x4_mul(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_mul_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(f32, a.f32[i] * b.f32[i]);
+}
+static inline wasm_v128 wasm_simd_f32x4_div(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_div_ps(a.ps, b.ps));
+  WASM_SIMD_LANES(f32, a.f32[i] / b.f32[i]);
+}
+// minps/maxps don't propagate NaN and ignore the sign of zero, so min and max
+// stay scalar.
+static inline wasm_v128 wasm_simd_f32x4_min(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(f32, wasm_f32_min(a.f32[i], b.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_max(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(f32, wasm_f32_max(a.f32[i], b.f32[i]));
+}
+// The pseudo min/max are defined like minps/maxps with swapped operands.
+static inline wasm_v128 wasm_simd_f32x4_pmin(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_min_ps(b.ps, a.ps));
+  WASM_SIMD_LANES(f32, b.f32[i] < a.f32[i] ? b.f32[i] : a.f32[i]);
+}
+static inline wasm_v128 wasm_simd_f32x4_pmax(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, ps, _mm_max_ps(b.ps, a.ps));
+  WASM_SIMD_LANES(f32, a.f32[i] < b.f32[i] ? b.f32[i] : a.f32[i]);
+}
+
+// f64x2 arithmetic.
+
+static inline wasm_v128 wasm_simd_f64x2_ceil(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, pd, wasm_sse41_round_pd(a.pd, 0));
+  WASM_SIMD_LANES(f64, ceil(a.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_floor(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, pd, wasm_sse41_round_pd(a.pd, 1));
+  WASM_SIMD_LANES(f64, floor(a.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_trunc(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, pd, wasm_sse41_round_pd(a.pd, 2));
+  WASM_SIMD_LANES(f64, trunc(a.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_nearest(wasm_v128 a) {
+  WASM_SIMD_USE(sse41, pd, wasm_sse41_round_pd(a.pd, 3));
+  WASM_SIMD_LANES(f64, nearbyint(a.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_abs(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_and_si128(a.m, _mm_set1_epi64x(0x7FFFFFFFFFFFFFFF)));
+  WASM_SIMD_LANES(u64, a.u64[i] & 0x7FFFFFFFFFFFFFFF);
+}
+static inline wasm_v128 wasm_simd_f64x2_neg(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, m,
+                _mm_xor_si128(a.m, _mm_set1_epi64x(INT64_MIN)));
+  WASM_SIMD_LANES(u64, a.u64[i] ^ 0x8000000000000000);
+}
+static inline wasm_v128 wasm_simd_f64x2_sqrt(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, pd, _mm_sqrt_pd(a.pd));
+  WASM_SIMD_LANES(f64, sqrt(a.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_add(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_add_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(f64, a.f64[i] + b.f64[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_sub(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_sub_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(f64, a.f64[i] - b.f64[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_mul(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_mul_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(f64, a.f64[i] * b.f64[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_div(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_div_pd(a.pd, b.pd));
+  WASM_SIMD_LANES(f64, a.f64[i] / b.f64[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_min(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(f64, wasm_f64_min(a.f64[i], b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_max(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_LANES(f64, wasm_f64_max(a.f64[i], b.f64[i]));
+}
+static inline wasm_v128 wasm_simd_f64x2_pmin(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_min_pd(b.pd, a.pd));
+  WASM_SIMD_LANES(f64, b.f64[i] < a.f64[i] ? b.f64[i] : a.f64[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_pmax(wasm_v128 a, wasm_v128 b) {
+  WASM_SIMD_USE(sse2, pd, _mm_max_pd(b.pd, a.pd));
+  WASM_SIMD_LANES(f64, a.f64[i] < b.f64[i] ? b.f64[i] : a.f64[i]);
+}
+
+// Conversions.
+
+static inline wasm_v128 wasm_simd_f32x4_demote_f64x2_zero(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, ps, _mm_cvtpd_ps(a.pd));
+  WASM_SIMD_LANES(f32, i < 2 ? (float)a.f64[i] : 0.0f);
+}
+static inline wasm_v128 wasm_simd_f64x2_promote_low_f32x4(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, pd, _mm_cvtps_pd(a.ps));
+  WASM_SIMD_LANES(f64, a.f32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_trunc_sat_f32x4_s(wasm_v128 a) {
+#if WASM_SIMD_X86
+  if (wasm_simd_level >= wasm_simd_sse2) {
+    // cvttps2dq returns INT32_MIN for NaN and out of range values. NaN lanes
+    // are zeroed before and positive overflows are flipped to INT32_MAX.
+    __m128 ordered = _mm_cmpeq_ps(a.ps, a.ps);
+    __m128 value = _mm_and_ps(a.ps, ordered);
+    __m128i overflow =
+        _mm_castps_si128(_mm_cmpge_ps(value, _mm_set1_ps(2147483648.0f)));
+    wasm_v128 r;
+    r.m = _mm_xor_si128(_mm_cvttps_epi32(value), overflow);
+    return r;
+  }
+#endif
+  WASM_SIMD_LANES(i32, wasm_i32_trunc_sat_f32_s(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_i32x4_trunc_sat_f32x4_u(wasm_v128 a) {
+  WASM_SIMD_LANES(u32, wasm_i32_trunc_sat_f32_u(a.f32[i]));
+}
+static inline wasm_v128 wasm_simd_f32x4_convert_i32x4_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, ps, _mm_cvtepi32_ps(a.m));
+  WASM_SIMD_LANES(f32, (float)a.i32[i]);
+}
+static inline wasm_v128 wasm_simd_f32x4_convert_i32x4_u(wasm_v128 a) {
+  WASM_SIMD_LANES(f32, (float)a.u32[i]);
+}
+static inline wasm_v128 wasm_simd_i32x4_trunc_sat_f64x2_s_zero(wasm_v128 a) {
+  WASM_SIMD_LANES(i32, i < 2 ? wasm_i32_trunc_sat_f64_s(a.f64[i]) : 0);
+}
+static inline wasm_v128 wasm_simd_i32x4_trunc_sat_f64x2_u_zero(wasm_v128 a) {
+  WASM_SIMD_LANES(u32, i < 2 ? wasm_i32_trunc_sat_f64_u(a.f64[i]) : 0);
+}
+static inline wasm_v128 wasm_simd_f64x2_convert_low_i32x4_s(wasm_v128 a) {
+  WASM_SIMD_USE(sse2, pd, _mm_cvtepi32_pd(a.m));
+  WASM_SIMD_LANES(f64, a.i32[i]);
+}
+static inline wasm_v128 wasm_simd_f64x2_convert_low_i32x4_u(wasm_v128 a) {
+  WASM_SIMD_LANES(f64, a.u32[i]);
+}
+
+// Instructions grouped by their signature. The interpreter generates its
+// cases from these lists.
+
+// v128 -> v128
+#define WASM_SIMD_UNOPS(X)                                                     \
+  X(v128_not)                                                                  \
+  X(i8x16_abs)                                                                 \
+  X(i8x16_neg)                                                                 \
+  X(i8x16_popcnt)                                                              \
+  X(f32x4_ceil)                                                                \
+  X(f32x4_floor)                                                               \
+  X(f32x4_trunc)                                                               \
+  X(f32x4_nearest)                                                             \
+  X(f64x2_ceil)                                                                \
+  X(f64x2_floor)                                                               \
+  X(f64x2_trunc)                                                               \
+  X(f64x2_nearest)                                                             \
+  X(i16x8_extadd_pairwise_i8x16_s)                                             \
+  X(i16x8_extadd_pairwise_i8x16_u)                                             \
+  X(i32x4_extadd_pairwise_i16x8_s)                                             \
+  X(i32x4_extadd_pairwise_i16x8_u)                                             \
+  X(i16x8_abs)                                                                 \
+  X(i16x8_neg)                                                                 \
+  X(i16x8_extend_low_i8x16_s)                                                  \
+  X(i16x8_extend_high_i8x16_s)                                                 \
+  X(i16x8_extend_low_i8x16_u)                                                  \
+  X(i16x8_extend_high_i8x16_u)                                                 \
+  X(i32x4_abs)                                                                 \
+  X(i32x4_neg)                                                                 \
+  X(i32x4_extend_low_i16x8_s)                                                  \
+  X(i32x4_extend_high_i16x8_s)                                                 \
+  X(i32x4_extend_low_i16x8_u)                                                  \
+  X(i32x4_extend_high_i16x8_u)                                                 \
+  X(i64x2_abs)                                                                 \
+  X(i64x2_neg)                                                                 \
+  X(i64x2_extend_low_i32x4_s)                                                  \
+  X(i64x2_extend_high_i32x4_s)                                                 \
+  X(i64x2_extend_low_i32x4_u)                                                  \
+  X(i64x2_extend_high_i32x4_u)                                                 \
+  X(f32x4_abs)                                                                 \
+  X(f32x4_neg)                                                                 \
+  X(f32x4_sqrt)                                                                \
+  X(f64x2_abs)                                                                 \
+  X(f64x2_neg)                                                                 \
+  X(f64x2_sqrt)                                                                \
+  X(f32x4_demote_f64x2_zero)                                                   \
+  X(f64x2_promote_low_f32x4)                                                   \
+  X(i32x4_trunc_sat_f32x4_s)                                                   \
+  X(i32x4_trunc_sat_f32x4_u)                                                   \
+  X(f32x4_convert_i32x4_s)                                                     \
+  X(f32x4_convert_i32x4_u)                                                     \
+  X(i32x4_trunc_sat_f64x2_s_zero)                                              \
+  X(i32x4_trunc_sat_f64x2_u_zero)                                              \
+  X(f64x2_convert_low_i32x4_s)                                                 \
+  X(f64x2_convert_low_i32x4_u)
+
+// v128 v128 -> v128
+#define WASM_SIMD_BINOPS(X)                                                    \
+  X(i8x16_swizzle)                                                             \
+  X(i8x16_eq)                                                                  \
+  X(i8x16_ne)                                                                  \
+  X(i8x16_lt_s)                                                                \
+  X(i8x16_lt_u)                                                                \
+  X(i8x16_gt_s)                                                                \
+  X(i8x16_gt_u)                                                                \
+  X(i8x16_le_s)                                                                \
+  X(i8x16_le_u)                                                                \
+  X(i8x16_ge_s)                                                                \
+  X(i8x16_ge_u)                                                                \
+  X(i16x8_eq)                                                                  \
+  X(i16x8_ne)                                                                  \
+  X(i16x8_lt_s)                                                                \
+  X(i16x8_lt_u)                                                                \
+  X(i16x8_gt_s)                                                                \
+  X(i16x8_gt_u)                                                                \
+  X(i16x8_le_s)                                                                \
+  X(i16x8_le_u)                                                                \
+  X(i16x8_ge_s)                                                                \
+  X(i16x8_ge_u)                                                                \
+  X(i32x4_eq)                                                                  \
+  X(i32x4_ne)                                                                  \
+  X(i32x4_lt_s)                                                                \
+  X(i32x4_lt_u)                                                                \
+  X(i32x4_gt_s)                                                                \
+  X(i32x4_gt_u)                                                                \
+  X(i32x4_le_s)                                                                \
+  X(i32x4_le_u)                                                                \
+  X(i32x4_ge_s)                                                                \
+  X(i32x4_ge_u)                                                                \
+  X(i64x2_eq)                                                                  \
+  X(i64x2_ne)                                                                  \
+  X(i64x2_lt_s)                                                                \
+  X(i64x2_gt_s)                                                                \
+  X(i64x2_le_s)                                                                \
+  X(i64x2_ge_s)                                                                \
+  X(f32x4_eq)                                                                  \
+  X(f32x4_ne)                                                                  \
+  X(f32x4_lt)                                                                  \
+  X(f32x4_gt)                                                                  \
+  X(f32x4_le)                                                                  \
+  X(f32x4_ge)                                                                  \
+  X(f64x2_eq)                                                                  \
+  X(f64x2_ne)                                                                  \
+  X(f64x2_lt)                                                                  \
+  X(f64x2_gt)                                                                  \
+  X(f64x2_le)                                                                  \
+  X(f64x2_ge)                                                                  \
+  X(v128_and)                                                                  \
+  X(v128_andnot)                                                               \
+  X(v128_or)                                                                   \
+  X(v128_xor)                                                                  \
+  X(i8x16_narrow_i16x8_s)                                                      \
+  X(i8x16_narrow_i16x8_u)                                                      \
+  X(i8x16_add)                                                                 \
+  X(i8x16_add_sat_s)                                                           \
+  X(i8x16_add_sat_u)                                                           \
+  X(i8x16_sub)                                                                 \
+  X(i8x16_sub_sat_s)                                                           \
+  X(i8x16_sub_sat_u)                                                           \
+  X(i8x16_min_s)                                                               \
+  X(i8x16_min_u)                                                               \
+  X(i8x16_max_s)                                                               \
+  X(i8x16_max_u)                                                               \
+  X(i8x16_avgr_u)                                                              \
+  X(i16x8_q15mulr_sat_s)                                                       \
+  X(i16x8_narrow_i32x4_s)                                                      \
+  X(i16x8_narrow_i32x4_u)                                                      \
+  X(i16x8_add)                                                                 \
+  X(i16x8_add_sat_s)                                                           \
+  X(i16x8_add_sat_u)                                                           \
+  X(i16x8_sub)                                                                 \
+  X(i16x8_sub_sat_s)                                                           \
+  X(i16x8_sub_sat_u)                                                           \
+  X(i16x8_mul)                                                                 \
+  X(i16x8_min_s)                                                               \
+  X(i16x8_min_u)                                                               \
+  X(i16x8_max_s)                                                               \
+  X(i16x8_max_u)                                                               \
+  X(i16x8_avgr_u)                                                              \
+  X(i16x8_extmul_low_i8x16_s)                                                  \
+  X(i16x8_extmul_high_i8x16_s)                                                 \
+  X(i16x8_extmul_low_i8x16_u)                                                  \
+  X(i16x8_extmul_high_i8x16_u)                                                 \
+  X(i32x4_add)                                                                 \
+  X(i32x4_sub)                                                                 \
+  X(i32x4_mul)                                                                 \
+  X(i32x4_min_s)                                                               \
+  X(i32x4_min_u)                                                               \
+  X(i32x4_max_s)                                                               \
+  X(i32x4_max_u)                                                               \
+  X(i32x4_dot_i16x8_s)                                                         \
+  X(i32x4_extmul_low_i16x8_s)                                                  \
+  X(i32x4_extmul_high_i16x8_s)                                                 \
+  X(i32x4_extmul_low_i16x8_u)                                                  \
+  X(i32x4_extmul_high_i16x8_u)                                                 \
+  X(i64x2_add)                                                                 \
+  X(i64x2_sub)                                                                 \
+  X(i64x2_mul)                                                                 \
+  X(i64x2_extmul_low_i32x4_s)                                                  \
+  X(i64x2_extmul_high_i32x4_s)                                                 \
+  X(i64x2_extmul_low_i32x4_u)                                                  \
+  X(i64x2_extmul_high_i32x4_u)                                                 \
+  X(f32x4_add)                                                                 \
+  X(f32x4_sub)                                                                 \
+  X(f32x4_mul)                                                                 \
+  X(f32x4_div)                                                                 \
+  X(f32x4_min)                                                                 \
+  X(f32x4_max)                                                                 \
+  X(f32x4_pmin)                                                                \
+  X(f32x4_pmax)                                                                \
+  X(f64x2_add)                                                                 \
+  X(f64x2_sub)                                                                 \
+  X(f64x2_mul)                                                                 \
+  X(f64x2_div)                                                                 \
+  X(f64x2_min)                                                                 \
+  X(f64x2_max)                                                                 \
+  X(f64x2_pmin)                                                                \
+  X(f64x2_pmax)
+
+// v128 i32 -> v128
+#define WASM_SIMD_SHIFTS(X)                                                    \
+  X(i8x16_shl)                                                                 \
+  X(i8x16_shr_s)                                                               \
+  X(i8x16_shr_u)                                                               \
+  X(i16x8_shl)                                                                 \
+  X(i16x8_shr_s)                                                               \
+  X(i16x8_shr_u)                                                               \
+  X(i32x4_shl)                                                                 \
+  X(i32x4_shr_s)                                                               \
+  X(i32x4_shr_u)                                                               \
+  X(i64x2_shl)                                                                 \
+  X(i64x2_shr_s)                                                               \
+  X(i64x2_shr_u)
+
+// v128 -> i32
+#define WASM_SIMD_TESTS(X)                                                     \
+  X(v128_any_true)                                                             \
+  X(i8x16_all_true)                                                            \
+  X(i8x16_bitmask)                                                             \
+  X(i16x8_all_true)                                                            \
+  X(i16x8_bitmask)                                                             \
+  X(i32x4_all_true)                                                            \
+  X(i32x4_bitmask)                                                             \
+  X(i64x2_all_true)                                                            \
+  X(i64x2_bitmask)
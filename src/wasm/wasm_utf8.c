@@ -0,0 +1,302 @@
+#include "wasm/wasm_utf8.h"
+
+#include "wasm/wasm_simd.h"
+#include <stdint.h>
+#include <string.h>
+
+// Checks one character at a time, with a fast path for runs of 8 ASCII bytes.
+// The ranges of the second byte are the ones of table 3-7 of the Unicode
+// standard which exclude overlong encodings, surrogates and code points above
+// U+10FFFF.
+static bool wasm_validate_utf8_scalar(const unsigned char *str,
+                                      size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    if (length - i >= 8) {
+      uint64_t word;
+      memcpy(&word, str + i, 8);
+      if ((word & 0x8080808080808080u) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+
+    unsigned char c = str[i];
+    if (c < 0x80) {
+      i++;
+      continue;
+    }
+
+    size_t continuations;
+    unsigned char min = 0x80, max = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+      continuations = 1;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      continuations = 2;
+      min = c == 0xE0 ? 0xA0 : min;
+      max = c == 0xED ? 0x9F : max;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      continuations = 3;
+      min = c == 0xF0 ? 0x90 : min;
+      max = c == 0xF4 ? 0x8F : max;
+    } else {
+      return false;
+    }
+
+    if (length - i - 1 < continuations || str[i + 1] < min ||
+        str[i + 1] > max) {
+      return false;
+    }
+    for (size_t k = 2; k <= continuations; k++) {
+      if ((str[i + k] & 0xC0) != 0x80) {
+        return false;
+      }
+    }
+    i += continuations + 1;
+  }
+  return true;
+}
+
+#if WASM_SIMD_X86
+// The vectorized validators follow "Validating UTF-8 In Less Than One
+// Instruction Per Byte" by Keiser and Lemire. Every byte is classified
+// together with the byte before it by looking up the high and low nibble of
+// the previous byte and the high nibble of the current one in three tables.
+// Each bit of the lookups stands for an error, a pair is invalid if all three
+// lookups have a bit in common. Continuations of 3 and 4 byte sequences are
+// checked by looking 2 and 3 bytes back.
+#define WASM_UTF8_TOO_SHORT (1 << 0)
+#define WASM_UTF8_TOO_LONG (1 << 1)
+#define WASM_UTF8_OVERLONG_3 (1 << 2)
+#define WASM_UTF8_TOO_LARGE (1 << 3)
+#define WASM_UTF8_SURROGATE (1 << 4)
+#define WASM_UTF8_OVERLONG_2 (1 << 5)
+// Overlong 4 byte sequences and too large ones share a bit.
+#define WASM_UTF8_TOO_LARGE_1000 (1 << 6)
+#define WASM_UTF8_OVERLONG_4 (1 << 6)
+#define WASM_UTF8_TWO_CONTS (1 << 7)
+// Errors that only depend on the high nibble of the first byte.
+#define WASM_UTF8_CARRY                                                        \
+  (WASM_UTF8_TOO_SHORT | WASM_UTF8_TOO_LONG | WASM_UTF8_TWO_CONTS)
+#define WASM_UTF8_LARGE (WASM_UTF8_TOO_LARGE | WASM_UTF8_TOO_LARGE_1000)
+
+// Indexed by the high nibble of the first byte.
+static const uint8_t wasm_utf8_byte_1_high[16] = {
+    // 0xxx: ASCII
+    WASM_UTF8_TOO_LONG, WASM_UTF8_TOO_LONG, WASM_UTF8_TOO_LONG,
+    WASM_UTF8_TOO_LONG, WASM_UTF8_TOO_LONG, WASM_UTF8_TOO_LONG,
+    WASM_UTF8_TOO_LONG, WASM_UTF8_TOO_LONG,
+    // 10xx: continuation
+    WASM_UTF8_TWO_CONTS, WASM_UTF8_TWO_CONTS, WASM_UTF8_TWO_CONTS,
+    WASM_UTF8_TWO_CONTS,
+    // 1100, 1101: 2 byte lead
+    WASM_UTF8_TOO_SHORT | WASM_UTF8_OVERLONG_2, WASM_UTF8_TOO_SHORT,
+    // 1110: 3 byte lead
+    WASM_UTF8_TOO_SHORT | WASM_UTF8_OVERLONG_3 | WASM_UTF8_SURROGATE,
+    // 1111: 4 byte lead
+    WASM_UTF8_TOO_SHORT | WASM_UTF8_LARGE | WASM_UTF8_OVERLONG_4};
+
+// Indexed by the low nibble of the first byte.
+static const uint8_t wasm_utf8_byte_1_low[16] = {
+    WASM_UTF8_CARRY | WASM_UTF8_OVERLONG_3 | WASM_UTF8_OVERLONG_2 |
+        WASM_UTF8_OVERLONG_4,
+    WASM_UTF8_CARRY | WASM_UTF8_OVERLONG_2,
+    WASM_UTF8_CARRY,
+    WASM_UTF8_CARRY,
+    WASM_UTF8_CARRY | WASM_UTF8_TOO_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE | WASM_UTF8_SURROGATE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE,
+    WASM_UTF8_CARRY | WASM_UTF8_LARGE};
+
+// Indexed by the high nibble of the second byte.
+static const uint8_t wasm_utf8_byte_2_high[16] = {
+    // 0xxx: ASCII
+    WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT,
+    WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT,
+    WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT,
+    // 1000
+    WASM_UTF8_TOO_LONG | WASM_UTF8_OVERLONG_2 | WASM_UTF8_TWO_CONTS |
+        WASM_UTF8_OVERLONG_3 | WASM_UTF8_TOO_LARGE_1000 | WASM_UTF8_OVERLONG_4,
+    // 1001
+    WASM_UTF8_TOO_LONG | WASM_UTF8_OVERLONG_2 | WASM_UTF8_TWO_CONTS |
+        WASM_UTF8_OVERLONG_3 | WASM_UTF8_TOO_LARGE,
+    // 101x
+    WASM_UTF8_TOO_LONG | WASM_UTF8_OVERLONG_2 | WASM_UTF8_TWO_CONTS |
+        WASM_UTF8_SURROGATE | WASM_UTF8_TOO_LARGE,
+    WASM_UTF8_TOO_LONG | WASM_UTF8_OVERLONG_2 | WASM_UTF8_TWO_CONTS |
+        WASM_UTF8_SURROGATE | WASM_UTF8_TOO_LARGE,
+    // 11xx: lead
+    WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT, WASM_UTF8_TOO_SHORT,
+    WASM_UTF8_TOO_SHORT};
+
+// Subtracted from the last bytes of a block with saturation. Anything left
+// means a sequence starts that needs more bytes than the block has.
+static const uint8_t wasm_utf8_incomplete[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+// SSE2 has no byte shuffle, so it only skips ASCII 16 bytes at a time. The
+// first block with other bytes ends the prefix on a character boundary.
+static bool wasm_validate_utf8_sse2(const unsigned char *str, size_t length) {
+  size_t i = 0;
+  while (length - i >= 16 &&
+         _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(str + i))) == 0) {
+    i += 16;
+  }
+  return wasm_validate_utf8_scalar(str + i, length - i);
+}
+
+WASM_SSE41 static inline __m128i wasm_sse41_utf8_errors(__m128i input,
+                                                        __m128i prev_input) {
+  const __m128i low_nibble = _mm_set1_epi8(0x0F);
+  __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+  __m128i byte_1_high = _mm_shuffle_epi8(
+      _mm_loadu_si128((const __m128i *)wasm_utf8_byte_1_high),
+      _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+  __m128i byte_1_low =
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)wasm_utf8_byte_1_low),
+                       _mm_and_si128(prev1, low_nibble));
+  __m128i byte_2_high = _mm_shuffle_epi8(
+      _mm_loadu_si128((const __m128i *)wasm_utf8_byte_2_high),
+      _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+  __m128i special =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // Bytes 2 and 3 after a 3 or 4 byte lead must be continuations. Two
+  // continuations in a row set TWO_CONTS which is the same bit.
+  __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+  __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+  __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+  __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+  __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth),
+                                        _mm_set1_epi8((char)0x80));
+  return _mm_xor_si128(must_continue, special);
+}
+
+WASM_SSE41 static bool wasm_validate_utf8_sse41(const unsigned char *str,
+                                                size_t length) {
+  const __m128i incomplete =
+      _mm_loadu_si128((const __m128i *)(wasm_utf8_incomplete + 16));
+  __m128i error = _mm_setzero_si128();
+  __m128i prev_input = _mm_setzero_si128();
+  __m128i prev_incomplete = _mm_setzero_si128();
+
+  for (size_t i = 0; i < length; i += 16) {
+    __m128i input;
+    if (length - i >= 16) {
+      input = _mm_loadu_si128((const __m128i *)(str + i));
+    } else {
+      // The tail is padded with zeros, which are ASCII.
+      unsigned char tail[16] = {0};
+      memcpy(tail, str + i, length - i);
+      input = _mm_loadu_si128((const __m128i *)tail);
+    }
+
+    // An ASCII block is only invalid if a sequence was cut off before it.
+    if (_mm_movemask_epi8(input) == 0) {
+      error = _mm_or_si128(error, prev_incomplete);
+    } else {
+      error = _mm_or_si128(error, wasm_sse41_utf8_errors(input, prev_input));
+      prev_incomplete = _mm_subs_epu8(input, incomplete);
+    }
+    prev_input = input;
+  }
+
+  error = _mm_or_si128(error, prev_incomplete);
+  return _mm_testz_si128(error, error);
+}
+
+WASM_AVX2 static inline __m256i wasm_avx2_utf8_errors(__m256i input,
+                                                      __m256i prev_input) {
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  // The byte shifts work within 128 bit lanes, so the lane before each lane
+  // is put next to it first.
+  __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+  __m256i byte_1_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)wasm_utf8_byte_1_high)),
+      _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+  __m256i byte_1_low = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)wasm_utf8_byte_1_low)),
+      _mm256_and_si256(prev1, low_nibble));
+  __m256i byte_2_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)wasm_utf8_byte_2_high)),
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+  __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low),
+                                     byte_2_high);
+
+  __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+  __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+  __m256i third =
+      _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+  __m256i fourth =
+      _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+  __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                           _mm256_set1_epi8((char)0x80));
+  return _mm256_xor_si256(must_continue, special);
+}
+
+WASM_AVX2 static bool wasm_validate_utf8_avx2(const unsigned char *str,
+                                              size_t length) {
+  const __m256i incomplete =
+      _mm256_loadu_si256((const __m256i *)wasm_utf8_incomplete);
+  __m256i error = _mm256_setzero_si256();
+  __m256i prev_input = _mm256_setzero_si256();
+  __m256i prev_incomplete = _mm256_setzero_si256();
+
+  for (size_t i = 0; i < length; i += 32) {
+    __m256i input;
+    if (length - i >= 32) {
+      input = _mm256_loadu_si256((const __m256i *)(str + i));
+    } else {
+      unsigned char tail[32] = {0};
+      memcpy(tail, str + i, length - i);
+      input = _mm256_loadu_si256((const __m256i *)tail);
+    }
+
+    if (_mm256_movemask_epi8(input) == 0) {
+      error = _mm256_or_si256(error, prev_incomplete);
+    } else {
+      error = _mm256_or_si256(error, wasm_avx2_utf8_errors(input, prev_input));
+      prev_incomplete = _mm256_subs_epu8(input, incomplete);
+    }
+    prev_input = input;
+  }
+
+  error = _mm256_or_si256(error, prev_incomplete);
+  return _mm256_testz_si256(error, error);
+}
+#endif
+
+bool wasm_validate_utf8(const char *str, size_t length) {
+  const unsigned char *bytes = (const unsigned char *)str;
+#if WASM_SIMD_X86
+  // Most names are short, copying them into a padded block isn't worth it.
+  if (length >= 16) {
+    wasm_simd_init();
+    switch (wasm_simd_level) {
+    case wasm_simd_avx2:
+      return wasm_validate_utf8_avx2(bytes, length);
+    case wasm_simd_sse41:
+      return wasm_validate_utf8_sse41(bytes, length);
+    case wasm_simd_sse2:
+      return wasm_validate_utf8_sse2(bytes, length);
+    default:
+      break;
+    }
+  }
+#endif
+  return wasm_validate_utf8_scalar(bytes, length);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Returns whether `length` bytes are well formed UTF-8. Overlong encodings,
+// surrogates and code points above U+10FFFF are rejected, NUL bytes are
+// allowed like in wasm names. Uses the instruction set selected by
+// `wasm_simd_level`.
+bool wasm_validate_utf8(const char *str, size_t length);
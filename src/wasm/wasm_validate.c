@@ -0,0 +1,786 @@
+#include "wasm/wasm_validate.h"
+
+#include "wasm/wasm_common.h"
+#include "wasm/wasm_opcodes.h"
+#include "wasm/wasm_reader.h"
+#include <stdio.h>
+#include <string.h>
+
+// Same limit as the compiler.
+#define wasm_validate_max_locals 50000
+
+static const uint8_t wasm_validate_imms[0x500] = {
+#define WASM_VALIDATE_IMM(code, ident, text, imm, pops, pushes)                \
+  [code] = wasm_imm_##imm,
+    WASM_OPCODES(WASM_VALIDATE_IMM)
+#undef WASM_VALIDATE_IMM
+};
+
+static const int8_t wasm_validate_pops[0x500] = {
+#define WASM_VALIDATE_POPS(code, ident, text, imm, pops, pushes) [code] = pops,
+    WASM_OPCODES(WASM_VALIDATE_POPS)
+#undef WASM_VALIDATE_POPS
+};
+
+// The 7 access sizes of a group of atomic instructions that starts at `op`.
+#define WASM_ATOMIC_SIGNATURES(op, i32, i64)                                   \
+  [op] = i32, [op + 1] = i64, [op + 2 ... op + 3] = i32,                       \
+  [op + 4 ... op + 6] = i64
+
+// Operand and result types of the instructions with a fixed signature, e.g.
+// "ii:i" for `i32.add`, with i for i32, l for i64, f for f32, d for f64 and v
+// for v128. SIMD instructions that aren't listed only take and return v128.
+static const char *const wasm_signatures[0x500] = {
+    [wasm_op_i32_load] = "i:i",
+    [wasm_op_i64_load] = "i:l",
+    [wasm_op_f32_load] = "i:f",
+    [wasm_op_f64_load] = "i:d",
+    [wasm_op_i32_load8_s ... wasm_op_i32_load16_u] = "i:i",
+    [wasm_op_i64_load8_s ... wasm_op_i64_load32_u] = "i:l",
+    [wasm_op_i32_store] = "ii:",
+    [wasm_op_i64_store] = "il:",
+    [wasm_op_f32_store] = "if:",
+    [wasm_op_f64_store] = "id:",
+    [wasm_op_i32_store8 ... wasm_op_i32_store16] = "ii:",
+    [wasm_op_i64_store8 ... wasm_op_i64_store32] = "il:",
+    [wasm_op_memory_size] = ":i",
+    [wasm_op_memory_grow] = "i:i",
+    [wasm_op_i32_const] = ":i",
+    [wasm_op_i64_const] = ":l",
+    [wasm_op_f32_const] = ":f",
+    [wasm_op_f64_const] = ":d",
+
+    [wasm_op_i32_eqz] = "i:i",
+    [wasm_op_i32_eq ... wasm_op_i32_ge_u] = "ii:i",
+    [wasm_op_i64_eqz] = "l:i",
+    [wasm_op_i64_eq ... wasm_op_i64_ge_u] = "ll:i",
+    [wasm_op_f32_eq ... wasm_op_f32_ge] = "ff:i",
+    [wasm_op_f64_eq ... wasm_op_f64_ge] = "dd:i",
+    [wasm_op_i32_clz ... wasm_op_i32_popcnt] = "i:i",
+    [wasm_op_i32_add ... wasm_op_i32_rotr] = "ii:i",
+    [wasm_op_i64_clz ... wasm_op_i64_popcnt] = "l:l",
+    [wasm_op_i64_add ... wasm_op_i64_rotr] = "ll:l",
+    [wasm_op_f32_abs ... wasm_op_f32_sqrt] = "f:f",
+    [wasm_op_f32_add ... wasm_op_f32_copysign] = "ff:f",
+    [wasm_op_f64_abs ... wasm_op_f64_sqrt] = "d:d",
+    [wasm_op_f64_add ... wasm_op_f64_copysign] = "dd:d",
+
+    [wasm_op_i32_wrap_i64] = "l:i",
+    [wasm_op_i32_trunc_f32_s ... wasm_op_i32_trunc_f32_u] = "f:i",
+    [wasm_op_i32_trunc_f64_s ... wasm_op_i32_trunc_f64_u] = "d:i",
+    [wasm_op_i64_extend_i32_s ... wasm_op_i64_extend_i32_u] = "i:l",
+    [wasm_op_i64_trunc_f32_s ... wasm_op_i64_trunc_f32_u] = "f:l",
+    [wasm_op_i64_trunc_f64_s ... wasm_op_i64_trunc_f64_u] = "d:l",
+    [wasm_op_f32_convert_i32_s ... wasm_op_f32_convert_i32_u] = "i:f",
+    [wasm_op_f32_convert_i64_s ... wasm_op_f32_convert_i64_u] = "l:f",
+    [wasm_op_f32_demote_f64] = "d:f",
+    [wasm_op_f64_convert_i32_s ... wasm_op_f64_convert_i32_u] = "i:d",
+    [wasm_op_f64_convert_i64_s ... wasm_op_f64_convert_i64_u] = "l:d",
+    [wasm_op_f64_promote_f32] = "f:d",
+    [wasm_op_i32_reinterpret_f32] = "f:i",
+    [wasm_op_i64_reinterpret_f64] = "d:l",
+    [wasm_op_f32_reinterpret_i32] = "i:f",
+    [wasm_op_f64_reinterpret_i64] = "l:d",
+    [wasm_op_i32_extend8_s ... wasm_op_i32_extend16_s] = "i:i",
+    [wasm_op_i64_extend8_s ... wasm_op_i64_extend32_s] = "l:l",
+    [wasm_op_i32_trunc_sat_f32_s ... wasm_op_i32_trunc_sat_f32_u] = "f:i",
+    [wasm_op_i32_trunc_sat_f64_s ... wasm_op_i32_trunc_sat_f64_u] = "d:i",
+    [wasm_op_i64_trunc_sat_f32_s ... wasm_op_i64_trunc_sat_f32_u] = "f:l",
+    [wasm_op_i64_trunc_sat_f64_s ... wasm_op_i64_trunc_sat_f64_u] = "d:l",
+
+    [wasm_op_memory_init] = "iii:",
+    [wasm_op_data_drop] = ":",
+    [wasm_op_memory_copy] = "iii:",
+    [wasm_op_memory_fill] = "iii:",
+
+    [wasm_op_v128_load ... wasm_op_v128_load64_splat] = "i:v",
+    [wasm_op_v128_store] = "iv:",
+    [wasm_op_v128_const] = ":v",
+    [wasm_op_i8x16_splat ... wasm_op_i32x4_splat] = "i:v",
+    [wasm_op_i64x2_splat] = "l:v",
+    [wasm_op_f32x4_splat] = "f:v",
+    [wasm_op_f64x2_splat] = "d:v",
+    [wasm_op_i8x16_extract_lane_s ... wasm_op_i8x16_extract_lane_u] = "v:i",
+    [wasm_op_i8x16_replace_lane] = "vi:v",
+    [wasm_op_i16x8_extract_lane_s ... wasm_op_i16x8_extract_lane_u] = "v:i",
+    [wasm_op_i16x8_replace_lane] = "vi:v",
+    [wasm_op_i32x4_extract_lane] = "v:i",
+    [wasm_op_i32x4_replace_lane] = "vi:v",
+    [wasm_op_i64x2_extract_lane] = "v:l",
+    [wasm_op_i64x2_replace_lane] = "vl:v",
+    [wasm_op_f32x4_extract_lane] = "v:f",
+    [wasm_op_f32x4_replace_lane] = "vf:v",
+    [wasm_op_f64x2_extract_lane] = "v:d",
+    [wasm_op_f64x2_replace_lane] = "vd:v",
+    [wasm_op_v128_any_true] = "v:i",
+    [wasm_op_v128_load8_lane ... wasm_op_v128_load64_lane] = "iv:v",
+    [wasm_op_v128_store8_lane ... wasm_op_v128_store64_lane] = "iv:",
+    [wasm_op_v128_load32_zero ... wasm_op_v128_load64_zero] = "i:v",
+    [wasm_op_i8x16_all_true ... wasm_op_i8x16_bitmask] = "v:i",
+    [wasm_op_i16x8_all_true ... wasm_op_i16x8_bitmask] = "v:i",
+    [wasm_op_i32x4_all_true ... wasm_op_i32x4_bitmask] = "v:i",
+    [wasm_op_i64x2_all_true ... wasm_op_i64x2_bitmask] = "v:i",
+    [wasm_op_i8x16_shl ... wasm_op_i8x16_shr_u] = "vi:v",
+    [wasm_op_i16x8_shl ... wasm_op_i16x8_shr_u] = "vi:v",
+    [wasm_op_i32x4_shl ... wasm_op_i32x4_shr_u] = "vi:v",
+    [wasm_op_i64x2_shl ... wasm_op_i64x2_shr_u] = "vi:v",
+
+    [wasm_op_memory_atomic_notify] = "ii:i",
+    [wasm_op_memory_atomic_wait32] = "iil:i",
+    [wasm_op_memory_atomic_wait64] = "ill:i",
+    [wasm_op_atomic_fence] = ":",
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_load, "i:i", "i:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_store, "ii:", "il:"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_add, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_sub, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_and, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_or, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_xor, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_xchg, "ii:i", "il:l"),
+    WASM_ATOMIC_SIGNATURES(wasm_op_i32_atomic_rmw_cmpxchg, "iii:i", "ill:l"),
+};
+
+#undef WASM_ATOMIC_SIGNATURES
+
+// An entry of the control stack. Every block, loop and if creates one.
+typedef struct {
+  uint16_t op;
+  // Height of the operand stack when the block was entered.
+  uint32_t height;
+  // `wasm_valtype_error` if the block has no result.
+  uint8_t result;
+  // The rest of the block can't be reached. Its operand stack is polymorphic.
+  bool unreachable;
+} wasm_validate_control;
+
+typedef struct {
+  uint8_t type;
+  bool is_mutable;
+} wasm_validate_global;
+
+typedef struct {
+  wasm_module *module;
+  wasm_reader reader;
+  wasm_function_type *type;
+  // The type of every local including the parameters and of every global.
+  wasm_byte_vec locals;
+  wasm_vec_of(wasm_validate_global) globals;
+  // Operand types. Operands popped from the polymorphic stack of unreachable
+  // code have the type `wasm_valtype_error`, which matches every type.
+  wasm_byte_vec stack;
+  wasm_vec_of(wasm_validate_control) controls;
+} wasm_validator;
+
+static uint8_t wasm_signature_type(char c) {
+  switch (c) {
+  case 'i':
+    return wasm_valtype_i32;
+  case 'l':
+    return wasm_valtype_i64;
+  case 'f':
+    return wasm_valtype_f32;
+  case 'd':
+    return wasm_valtype_f64;
+  default:
+    return wasm_valtype_v128;
+  }
+}
+
+static wasm_validate_control *wasm_validate_top(wasm_validator *v) {
+  return v->controls.end - 1;
+}
+
+static void wasm_push_type(wasm_validator *v, uint8_t type) {
+  *wasm_vec_append(&v->stack) = type;
+}
+
+// Pops an operand of the type `expected` or of any type if it is
+// `wasm_valtype_error`. `actual` is set to the type of the operand.
+static bool wasm_pop_type(wasm_validator *v, uint8_t expected,
+                          uint8_t *actual) {
+  wasm_validate_control *control = wasm_validate_top(v);
+  uint8_t type = wasm_valtype_error;
+  if (wasm_vec_size(&v->stack) > control->height) {
+    type = *--v->stack.end;
+  } else if (!control->unreachable) {
+    fprintf(stderr, "Operand stack underflow.\n");
+    return false;
+  }
+
+  if (expected != wasm_valtype_error && type != wasm_valtype_error &&
+      type != expected) {
+    fprintf(stderr, "Expected an operand of type %s but found %s.\n",
+            wasm_valtype_to_str(expected), wasm_valtype_to_str(type));
+    return false;
+  }
+  if (actual) {
+    *actual = type;
+  }
+  return true;
+}
+
+static bool wasm_validate_signature(wasm_validator *v, const char *signature) {
+  const char *results = strchr(signature, ':');
+  for (const char *p = results; p != signature;) {
+    if (!wasm_pop_type(v, wasm_signature_type(*--p), NULL)) {
+      return false;
+    }
+  }
+  for (const char *p = results + 1; *p; p++) {
+    wasm_push_type(v, wasm_signature_type(*p));
+  }
+  return true;
+}
+
+// Pops the parameters of a call and pushes its result.
+static bool wasm_validate_call(wasm_validator *v, wasm_function_type *type,
+                               bool is_tail_call) {
+  for (uint32_t i = type->param_count; i > 0; i--) {
+    if (!wasm_pop_type(v, type->params[i - 1], NULL)) {
+      return false;
+    }
+  }
+  if (is_tail_call) {
+    wasm_function_type *caller = v->type;
+    if (type->result_count != caller->result_count ||
+        (type->result_count && type->result_type != caller->result_type)) {
+      fprintf(stderr, "Tail call to a function with another result type.\n");
+      return false;
+    }
+    return true;
+  }
+  if (type->result_count) {
+    wasm_push_type(v, type->result_type);
+  }
+  return true;
+}
+
+static void wasm_validate_unreachable(wasm_validator *v) {
+  wasm_validate_control *control = wasm_validate_top(v);
+  v->stack.end = v->stack.start + control->height;
+  control->unreachable = true;
+}
+
+static void wasm_validate_push_control(wasm_validator *v, uint16_t op,
+                                       uint8_t result) {
+  wasm_validate_control *control = wasm_vec_append(&v->controls);
+  control->op = op;
+  control->height = (uint32_t)wasm_vec_size(&v->stack);
+  control->result = result;
+  control->unreachable = false;
+}
+
+// Checks that the block on top of the control stack ends with its result and
+// nothing else on the operand stack.
+static bool wasm_validate_block_result(wasm_validator *v) {
+  wasm_validate_control *control = wasm_validate_top(v);
+  if (control->result != wasm_valtype_error &&
+      !wasm_pop_type(v, control->result, NULL)) {
+    return false;
+  }
+  if (wasm_vec_size(&v->stack) != control->height) {
+    fprintf(stderr, "Block leaves extra values on the stack.\n");
+    return false;
+  }
+  return true;
+}
+
+// Returns the label `depth` or NULL if there is none. Branches to a loop jump
+// to its start, which takes no values, everything else to the end of the
+// block.
+static wasm_validate_control *wasm_validate_label(wasm_validator *v,
+                                                  uint32_t depth,
+                                                  uint8_t *type) {
+  if (depth >= wasm_vec_size(&v->controls)) {
+    fprintf(stderr, "Invalid branch depth %u.\n", depth);
+    return NULL;
+  }
+  wasm_validate_control *control = wasm_validate_top(v) - depth;
+  *type = control->op == wasm_op_loop ? wasm_valtype_error : control->result;
+  return control;
+}
+
+static bool wasm_validate_block_type(wasm_validator *v, uint8_t *result) {
+  unsigned char c;
+  if (!wasm_read(&v->reader, &c, 1)) {
+    return false;
+  }
+
+  switch (c) {
+  case 0x40:
+    return *result = wasm_valtype_error, true;
+  case 0x7F:
+    return *result = wasm_valtype_i32, true;
+  case 0x7E:
+    return *result = wasm_valtype_i64, true;
+  case 0x7D:
+    return *result = wasm_valtype_f32, true;
+  case 0x7C:
+    return *result = wasm_valtype_f64, true;
+  case 0x7B:
+    return *result = wasm_valtype_v128, true;
+  default:
+    fprintf(stderr, "Block type 0x%02X is not supported.\n", c);
+    return false;
+  }
+}
+
+// Skips the immediates of instructions whose operands don't depend on them.
+static bool wasm_skip_immediates(wasm_validator *v, uint16_t op) {
+  wasm_reader *reader = &v->reader;
+  uint32_t u32;
+  int32_t s32;
+  int64_t s64;
+
+  switch (wasm_validate_imms[op]) {
+  case wasm_imm_none:
+    return true;
+  case wasm_imm_memarg:
+    return wasm_read_leb_u32_2(reader, &u32) &&
+           wasm_read_leb_u32_2(reader, &u32);
+  case wasm_imm_memarg_lane:
+    return wasm_read_leb_u32_2(reader, &u32) &&
+           wasm_read_leb_u32_2(reader, &u32) && wasm_seek(reader, 1);
+  case wasm_imm_memory_init:
+    return wasm_read_leb_u32_2(reader, &u32) && wasm_seek(reader, 1);
+  case wasm_imm_data:
+    return wasm_read_leb_u32_2(reader, &u32);
+  case wasm_imm_memory:
+  case wasm_imm_lane:
+  case wasm_imm_reserved:
+    return wasm_seek(reader, 1);
+  case wasm_imm_memory_copy:
+    return wasm_seek(reader, 2);
+  case wasm_imm_i32:
+    return wasm_read_leb_s32(reader, &s32);
+  case wasm_imm_i64:
+    return wasm_read_leb_s64(reader, &s64);
+  case wasm_imm_f32:
+    return wasm_seek(reader, 4);
+  case wasm_imm_f64:
+    return wasm_seek(reader, 8);
+  case wasm_imm_v128:
+  case wasm_imm_shuffle:
+    return wasm_seek(reader, 16);
+  default:
+    return false;
+  }
+}
+
+static bool wasm_validate_instr(wasm_validator *v, uint16_t op) {
+  wasm_reader *reader = &v->reader;
+
+  switch (op) {
+  case wasm_op_unreachable:
+    wasm_validate_unreachable(v);
+    return true;
+
+  case wasm_op_nop:
+    return true;
+
+  case wasm_op_block:
+  case wasm_op_loop:
+  case wasm_op_if: {
+    uint8_t result;
+    if (!wasm_validate_block_type(v, &result) ||
+        (op == wasm_op_if && !wasm_pop_type(v, wasm_valtype_i32, NULL))) {
+      return false;
+    }
+    wasm_validate_push_control(v, op, result);
+    return true;
+  }
+
+  case wasm_op_else: {
+    wasm_validate_control *control = wasm_validate_top(v);
+    if (control->op != wasm_op_if) {
+      fprintf(stderr, "Else without if.\n");
+      return false;
+    }
+    if (!wasm_validate_block_result(v)) {
+      return false;
+    }
+    control->op = wasm_op_else;
+    control->unreachable = false;
+    return true;
+  }
+
+  case wasm_op_end: {
+    // The end of the function itself is not part of `expr`.
+    if (wasm_vec_size(&v->controls) == 1) {
+      fprintf(stderr, "Unexpected end of function.\n");
+      return false;
+    }
+    wasm_validate_control *control = wasm_validate_top(v);
+    if (control->op == wasm_op_if && control->result != wasm_valtype_error) {
+      fprintf(stderr, "If with a result needs an else branch.\n");
+      return false;
+    }
+    if (!wasm_validate_block_result(v)) {
+      return false;
+    }
+    uint8_t result = control->result;
+    v->controls.end--;
+    if (result != wasm_valtype_error) {
+      wasm_push_type(v, result);
+    }
+    return true;
+  }
+
+  case wasm_op_br:
+  case wasm_op_br_if: {
+    uint32_t depth;
+    uint8_t type;
+    if (!wasm_read_leb_u32_2(reader, &depth) ||
+        (op == wasm_op_br_if && !wasm_pop_type(v, wasm_valtype_i32, NULL)) ||
+        !wasm_validate_label(v, depth, &type)) {
+      return false;
+    }
+    if (type != wasm_valtype_error && !wasm_pop_type(v, type, NULL)) {
+      return false;
+    }
+    if (op == wasm_op_br) {
+      wasm_validate_unreachable(v);
+    } else if (type != wasm_valtype_error) {
+      wasm_push_type(v, type);
+    }
+    return true;
+  }
+
+  case wasm_op_br_table: {
+    uint32_t count;
+    if (!wasm_read_leb_u32_2(reader, &count) ||
+        !wasm_pop_type(v, wasm_valtype_i32, NULL)) {
+      return false;
+    }
+
+    // Every label needs the operand, the default label is the last one.
+    for (uint32_t i = 0; i <= count; i++) {
+      uint32_t depth;
+      uint8_t type;
+      if (!wasm_read_leb_u32_2(reader, &depth) ||
+          !wasm_validate_label(v, depth, &type)) {
+        return false;
+      }
+      if (type == wasm_valtype_error) {
+        continue;
+      }
+      uint8_t actual;
+      if (!wasm_pop_type(v, type, &actual)) {
+        return false;
+      }
+      wasm_push_type(v, actual);
+    }
+    // The labels have to agree on the number of values.
+    wasm_validate_unreachable(v);
+    return true;
+  }
+
+  case wasm_op_return:
+    if (v->type->result_count &&
+        !wasm_pop_type(v, v->type->result_type, NULL)) {
+      return false;
+    }
+    wasm_validate_unreachable(v);
+    return true;
+
+  case wasm_op_call:
+  case wasm_op_return_call: {
+    uint32_t funcidx;
+    if (!wasm_read_leb_u32_2(reader, &funcidx)) {
+      return false;
+    }
+    wasm_function_type *type = wasm_module_func_type(v->module, funcidx);
+    if (type == NULL) {
+      fprintf(stderr, "Call to unknown function %u.\n", funcidx);
+      return false;
+    }
+    if (!wasm_validate_call(v, type, op == wasm_op_return_call)) {
+      return false;
+    }
+    if (op == wasm_op_return_call) {
+      wasm_validate_unreachable(v);
+    }
+    return true;
+  }
+
+  case wasm_op_call_indirect:
+  case wasm_op_return_call_indirect: {
+    uint32_t typeidx;
+    if (!wasm_read_leb_u32_2(reader, &typeidx) || !wasm_seek(reader, 1) ||
+        typeidx >= wasm_vec_size(&v->module->function_types)) {
+      fprintf(stderr, "Invalid call_indirect.\n");
+      return false;
+    }
+    wasm_function_type *type =
+        wasm_vec_get(&v->module->function_types, typeidx);
+    if (!wasm_pop_type(v, wasm_valtype_i32, NULL) ||
+        !wasm_validate_call(v, type, op == wasm_op_return_call_indirect)) {
+      return false;
+    }
+    if (op == wasm_op_return_call_indirect) {
+      wasm_validate_unreachable(v);
+    }
+    return true;
+  }
+
+  case wasm_op_drop:
+    return wasm_pop_type(v, wasm_valtype_error, NULL);
+
+  case wasm_op_select: {
+    uint8_t a, b;
+    if (!wasm_pop_type(v, wasm_valtype_i32, NULL) ||
+        !wasm_pop_type(v, wasm_valtype_error, &b) ||
+        !wasm_pop_type(v, b, &a)) {
+      return false;
+    }
+    wasm_push_type(v, a != wasm_valtype_error ? a : b);
+    return true;
+  }
+
+  case wasm_op_local_get:
+  case wasm_op_local_set:
+  case wasm_op_local_tee: {
+    uint32_t localidx;
+    if (!wasm_read_leb_u32_2(reader, &localidx) ||
+        localidx >= wasm_vec_size(&v->locals)) {
+      fprintf(stderr, "Invalid local index.\n");
+      return false;
+    }
+    uint8_t type = v->locals.start[localidx];
+    if (op != wasm_op_local_get && !wasm_pop_type(v, type, NULL)) {
+      return false;
+    }
+    if (op != wasm_op_local_set) {
+      wasm_push_type(v, type);
+    }
+    return true;
+  }
+
+  case wasm_op_global_get:
+  case wasm_op_global_set: {
+    uint32_t globalidx;
+    if (!wasm_read_leb_u32_2(reader, &globalidx) ||
+        globalidx >= wasm_vec_size(&v->globals)) {
+      fprintf(stderr, "Invalid global index.\n");
+      return false;
+    }
+    wasm_validate_global *global = &v->globals.start[globalidx];
+    if (op == wasm_op_global_get) {
+      wasm_push_type(v, global->type);
+      return true;
+    }
+    if (!global->is_mutable) {
+      fprintf(stderr, "Global %u is immutable.\n", globalidx);
+      return false;
+    }
+    return wasm_pop_type(v, global->type, NULL);
+  }
+
+  default:
+    break;
+  }
+
+  if (!wasm_skip_immediates(v, op)) {
+    fprintf(stderr, "Invalid immediate of instruction 0x%X.\n", op);
+    return false;
+  }
+
+  const char *signature = wasm_signatures[op];
+  if (signature == NULL && op >= wasm_opcode_prefix_fd &&
+      op < wasm_opcode_prefix_fe) {
+    static const char *const vector_signatures[] = {"v:v", "vv:v", "vvv:v"};
+    int8_t pops = wasm_validate_pops[op];
+    signature = pops >= 1 && pops <= 3 ? vector_signatures[pops - 1] : NULL;
+  }
+  if (signature == NULL) {
+    fprintf(stderr, "Unsupported instruction 0x%X.\n", op);
+    return false;
+  }
+  return wasm_validate_signature(v, signature);
+}
+
+static bool wasm_validate_code(wasm_validator *v, uint32_t funcidx,
+                               wasm_code *code) {
+  wasm_module *module = v->module;
+  v->type = wasm_module_func_type(module, funcidx);
+
+  // The locals are run-length encoded.
+  uint64_t local_count = v->type->param_count;
+  wasm_locals *locals = module->locals.start + code->locals_offset;
+  for (uint32_t i = 0; i < code->locals_count; i++) {
+    local_count += locals[i].n;
+  }
+  if (local_count > wasm_validate_max_locals) {
+    fprintf(stderr, "Too many locals.\n");
+    return false;
+  }
+  v->locals.end = v->locals.start;
+  unsigned char *types = wasm_vec_append_n(&v->locals, local_count);
+  if (v->type->param_count) {
+    memcpy(types, v->type->params, v->type->param_count);
+  }
+  types += v->type->param_count;
+  for (uint32_t i = 0; i < code->locals_count; i++) {
+    memset(types, locals[i].type, locals[i].n);
+    types += locals[i].n;
+  }
+
+  // The function body is the outermost block.
+  wasm_init_memory_reader(&v->reader, wasm_code_expr(module, code),
+                          code->expr_size);
+  v->stack.end = v->stack.start;
+  v->controls.end = v->controls.start;
+  wasm_validate_push_control(
+      v, wasm_op_block,
+      v->type->result_count ? v->type->result_type : wasm_valtype_error);
+
+  while (v->reader.size > 0) {
+    unsigned char byte;
+    if (!wasm_read(&v->reader, &byte, 1)) {
+      return false;
+    }
+
+    uint16_t op = byte;
+    if (byte == 0xFC || byte == 0xFD || byte == 0xFE) {
+      uint32_t sub;
+      if (!wasm_read_leb_u32_2(&v->reader, &sub) || sub >= 0x100) {
+        fprintf(stderr, "Invalid prefixed instruction.\n");
+        return false;
+      }
+      op = (byte == 0xFC   ? wasm_opcode_prefix_fc
+            : byte == 0xFD ? wasm_opcode_prefix_fd
+                           : wasm_opcode_prefix_fe) +
+           (uint16_t)sub;
+    }
+
+    if (!wasm_validate_instr(v, op)) {
+      return false;
+    }
+  }
+
+  if (wasm_vec_size(&v->controls) != 1) {
+    fprintf(stderr, "Function body has unclosed blocks.\n");
+    return false;
+  }
+  return wasm_validate_block_result(v);
+}
+
+// Constant expressions are a single instruction. `global.get` can only read
+// imported globals that are immutable.
+static bool wasm_validate_const_expr(wasm_validator *v, wasm_expr *expr,
+                                     uint8_t type) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, expr->start, wasm_vec_size(expr));
+  unsigned char op;
+  if (!wasm_read(&reader, &op, 1)) {
+    return false;
+  }
+
+  uint8_t actual;
+  switch (op) {
+  case wasm_op_i32_const:
+    actual = wasm_valtype_i32;
+    break;
+  case wasm_op_i64_const:
+    actual = wasm_valtype_i64;
+    break;
+  case wasm_op_f32_const:
+    actual = wasm_valtype_f32;
+    break;
+  case wasm_op_f64_const:
+    actual = wasm_valtype_f64;
+    break;
+  case 0xFD:
+    actual = wasm_valtype_v128;
+    break;
+  case wasm_op_global_get: {
+    uint32_t globalidx;
+    if (!wasm_read_leb_u32_2(&reader, &globalidx) ||
+        globalidx >= v->module->import_global_count ||
+        v->globals.start[globalidx].is_mutable) {
+      fprintf(stderr, "Constant expression reads an invalid global.\n");
+      return false;
+    }
+    actual = v->globals.start[globalidx].type;
+  } break;
+  default:
+    return false;
+  }
+
+  if (actual != type) {
+    fprintf(stderr, "Constant expression has type %s instead of %s.\n",
+            wasm_valtype_to_str(actual), wasm_valtype_to_str(type));
+    return false;
+  }
+  return true;
+}
+
+static bool wasm_validate_globals(wasm_validator *v) {
+  wasm_module *module = v->module;
+  for (wasm_import *import = module->imports.start;
+       import != module->imports.end; import++) {
+    if (import->type == wasm_import_global) {
+      *wasm_vec_append(&v->globals) = (wasm_validate_global){
+          import->desc.global.type, import->desc.global.is_mutable};
+    }
+  }
+  for (wasm_global *global = module->globals.start;
+       global != module->globals.end; global++) {
+    if (!wasm_validate_const_expr(v, &global->initializer, global->type)) {
+      return false;
+    }
+    *wasm_vec_append(&v->globals) =
+        (wasm_validate_global){global->type, global->is_mutable};
+  }
+  return true;
+}
+
+static bool wasm_validate_segments(wasm_validator *v) {
+  wasm_module *module = v->module;
+  for (wasm_elem *elem = module->elems.start; elem != module->elems.end;
+       elem++) {
+    if (!wasm_validate_const_expr(v, &elem->offset, wasm_valtype_i32)) {
+      return false;
+    }
+  }
+  for (wasm_data *data = module->datas.start; data != module->datas.end;
+       data++) {
+    if (!data->is_passive &&
+        !wasm_validate_const_expr(v, &data->offset, wasm_valtype_i32)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool wasm_validate_module(wasm_module *module) {
+  wasm_validator v;
+  v.module = module;
+  wasm_vec_init(&v.locals);
+  wasm_vec_init(&v.globals);
+  wasm_vec_init(&v.stack);
+  wasm_vec_init(&v.controls);
+
+  bool ok = wasm_validate_globals(&v) && wasm_validate_segments(&v);
+  if (ok && module->has_start) {
+    wasm_function_type *type = wasm_module_func_type(module, module->start);
+    if (type == NULL || type->param_count || type->result_count) {
+      fprintf(stderr, "Invalid start function %u.\n", module->start);
+      ok = false;
+    }
+  }
+
+  for (size_t i = 0; ok && i < wasm_vec_size(&module->codes); i++) {
+    uint32_t funcidx = module->import_func_count + (uint32_t)i;
+    if (!wasm_validate_code(&v, funcidx, wasm_vec_get(&module->codes, i))) {
+      fprintf(stderr, "Error validating function %u.\n", funcidx);
+      ok = false;
+    }
+  }
+
+  wasm_vec_deinit(&v.locals);
+  wasm_vec_deinit(&v.globals);
+  wasm_vec_deinit(&v.stack);
+  wasm_vec_deinit(&v.controls);
+  return ok;
+}
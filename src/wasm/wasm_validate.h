@@ -0,0 +1,13 @@
+#pragma once
+
+#include "wasm/wasm.h"
+#include <stdbool.h>
+
+// Checks what compiling a module leaves out: the types of the operands of
+// every instruction, that `global.set` only writes mutable globals, that
+// global initializers and segment offsets have the right type, and that the
+// start function exists and takes no parameters and returns nothing.
+// `wasm_compile_module` has to succeed first, it checks the structure of the
+// function bodies and their immediates. Export indices are checked by the
+// loader. Returns false and prints the reason if the module is invalid.
+bool wasm_validate_module(wasm_module *module);
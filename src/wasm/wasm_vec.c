@@ -1,62 +1,51 @@
 #include "wasm/wasm_vec.h"
 #include "wasm/wasm_common.h"
-#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #define wasm_vec_first_capacity 8
 
-void _wasm_vec_init(wasm_vec *vec, size_t item_size) {
-  // We set start and end to NULL so you can still iterate.
-  vec->start = NULL;
-  vec->end = NULL;
-  vec->capacity = NULL;
-  vec->item_size = item_size;
-}
+// Every typed vector has the layout of three pointers. They are copied in and
+// out as bytes so this works for any element type.
+bool _wasm_vec_try_grow(void *vec, size_t item_size, size_t count) {
+  unsigned char *fields[3];
+  memcpy(fields, vec, sizeof(fields));
+  unsigned char *start = fields[0], *end = fields[1], *capacity = fields[2];
 
-void wasm_vec_deinit(wasm_vec *vec) {
-  if (vec->start) {
-    wasm_free(vec->start);
+  size_t size = (size_t)(end - start);
+  if (count > (SIZE_MAX - size) / item_size) {
+    return false;
   }
+  size_t needed = size + count * item_size;
 
-  vec->start = NULL;
-  vec->end = NULL;
-  vec->capacity = NULL;
-}
-
-void *wasm_vec_append(wasm_vec *vec) {
-  if (vec->start == NULL) {
-    // Empty vec.
-    size_t n = vec->item_size * wasm_vec_first_capacity;
-    // XXX: Not handling alloc failure here.
-    vec->start = wasm_alloc_n(n);
-    vec->end = vec->start + vec->item_size;
-    vec->capacity = vec->start + n;
-    return vec->start;
-  } else if (vec->end == vec->capacity) {
-    // No space in buffer.
-    size_t n = vec->end - vec->start;
-    vec->start = wasm_realloc_n(vec->start, n * 2);
-    vec->end = vec->start + n;
-    vec->capacity = vec->start + n * 2;
-    return vec->end - 1;
-  } else {
-    // There is space in buffer.
-    vec->end += vec->item_size;
-    return vec->end - vec->item_size;
+  // Appends double the capacity, larger reservations are allocated exactly.
+  size_t n = start ? (size_t)(capacity - start) * 2
+                   : item_size * wasm_vec_first_capacity;
+  if (n < needed) {
+    n = needed;
   }
-}
 
-void *wasm_vec_get(wasm_vec *vec, size_t index) {
-  assert(vec->start + (index * vec->item_size) < vec->end);
-  return vec->start + (index * vec->item_size);
+  start = wasm_realloc_n(start, n);
+  if (start == NULL) {
+    return false;
+  }
+  fields[0] = start;
+  fields[1] = start + size;
+  fields[2] = start + n;
+  memcpy(vec, fields, sizeof(fields));
+  return true;
 }
 
-void wasm_vec_for_each(wasm_vec *vec, void (*func)(void *)) {
-  for (void *it = vec->start; it != vec->end; it += vec->item_size) {
-    func(it);
+void _wasm_vec_grow(void *vec, size_t item_size, size_t count) {
+  if (!_wasm_vec_try_grow(vec, item_size, count)) {
+    fprintf(stderr, "Out of memory.\n");
+    abort();
   }
 }
 
-size_t wasm_vec_size(wasm_vec *vec) {
-  return (vec->end - vec->start) / vec->item_size;
+void _wasm_vec_for_each(void *start, size_t count, size_t item_size,
+                        void (*func)(void *)) {
+  for (size_t i = 0; i < count; i++) {
+    func((unsigned char *)start + i * item_size);
+  }
 }
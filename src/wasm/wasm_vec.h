@@ -1,22 +1,49 @@
+#pragma once
+
+#include "wasm/wasm_common.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
-// XXX: in the future we have the ability to store sizeof(void*)/item_size
-// elements in the capacity if that is required for performance. This could e.g.
-// be 8 valtypes if they are size 1 on 64-Bit.
-typedef struct {
-  // The start points to the first element or NULL if the vec is empty.
-  void *start;
-  // The end points to one after the last element or NULL if the vec is empty.
-  void *end;
-  void *capacity;
-  size_t item_size;
-} wasm_vec;
+// A growable array of `type`. Every element type gets its own vector type,
+// e.g. `typedef wasm_vec_of(wasm_export) wasm_export_vec;`, so the element size
+// is known at compile time and accessing an element is a plain indexed load.
+//
+// `start` points to the first element and `end` to one after the last one.
+// Both are NULL if nothing was allocated yet, so empty vectors can still be
+// iterated.
+#define wasm_vec_of(type)                                                      \
+  struct {                                                                     \
+    type *start;                                                               \
+    type *end;                                                                 \
+    type *capacity;                                                            \
+  }
+
+// The vector arguments of the macros below are evaluated more than once.
+#define wasm_vec_init(vec) ((vec)->start = (vec)->end = (vec)->capacity = NULL)
+#define wasm_vec_deinit(vec) (wasm_free((vec)->start), wasm_vec_init(vec))
+#define wasm_vec_size(vec) ((size_t)((vec)->end - (vec)->start))
+#define wasm_vec_get(vec, index)                                               \
+  (assert((size_t)(index) < wasm_vec_size(vec)), &(vec)->start[index])
+
+// Makes room for `count` more elements. Vectors in wasm modules are prefixed
+// with their length, reserving it up front allocates them exactly once.
+#define wasm_vec_reserve(vec, count)                                           \
+  ((size_t)((vec)->capacity - (vec)->end) >= (size_t)(count)                   \
+       ? (void)0                                                               \
+       : _wasm_vec_grow((vec), sizeof(*(vec)->start), (count)))
+
+// Appends `count` uninitialized elements and returns the first one.
+#define wasm_vec_append_n(vec, count)                                          \
+  (wasm_vec_reserve(vec, count), ((vec)->end += (count)) - (count))
+#define wasm_vec_append(vec) wasm_vec_append_n(vec, 1)
 
-void _wasm_vec_init(wasm_vec *vec, size_t item_size);
-#define wasm_vec_init(vec_ptr, type) _wasm_vec_init(vec_ptr, sizeof(type))
-void *wasm_vec_append(wasm_vec *vec);
-void *wasm_vec_get(wasm_vec *vec, size_t index);
-void wasm_vec_deinit(wasm_vec *vec);
+#define wasm_vec_for_each(vec, func)                                           \
+  _wasm_vec_for_each((vec)->start, wasm_vec_size(vec), sizeof(*(vec)->start),  \
+                     func)
 
-void wasm_vec_for_each(wasm_vec *vec, void (*func)(void *));
-size_t wasm_vec_size(wasm_vec *vec);
\ No newline at end of file
+void _wasm_vec_grow(void *vec, size_t item_size, size_t count);
+bool _wasm_vec_try_grow(void *vec, size_t item_size, size_t count);
+void _wasm_vec_for_each(void *start, size_t count, size_t item_size,
+                        void (*func)(void *));
@@ -0,0 +1,431 @@
+#include "wasm/wasm_wasi.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// Error codes of wasi. They differ from the ones of the host.
+enum wasm_wasi_errno {
+  wasm_wasi_success = 0,
+  wasm_wasi_eacces = 2,
+  wasm_wasi_eagain = 6,
+  wasm_wasi_ebadf = 8,
+  wasm_wasi_efault = 21,
+  wasm_wasi_efbig = 22,
+  wasm_wasi_eintr = 27,
+  wasm_wasi_einval = 28,
+  wasm_wasi_eio = 29,
+  wasm_wasi_eisdir = 31,
+  wasm_wasi_enospc = 51,
+  wasm_wasi_enosys = 52,
+  wasm_wasi_epipe = 64,
+  wasm_wasi_espipe = 70,
+};
+
+enum wasm_wasi_filetype {
+  wasm_wasi_filetype_unknown = 0,
+  wasm_wasi_filetype_block_device = 1,
+  wasm_wasi_filetype_character_device = 2,
+  wasm_wasi_filetype_directory = 3,
+  wasm_wasi_filetype_regular_file = 4,
+  wasm_wasi_filetype_socket_stream = 6,
+  wasm_wasi_filetype_symbolic_link = 7,
+};
+
+// Number of iovecs that are passed to one readv/writev. Longer lists result in
+// a short read or write which the module has to handle anyway.
+#define wasm_wasi_max_iovs 64
+
+static int32_t wasm_wasi_errno(int error) {
+  switch (error) {
+  case EACCES:
+    return wasm_wasi_eacces;
+  case EAGAIN:
+    return wasm_wasi_eagain;
+  case EBADF:
+    return wasm_wasi_ebadf;
+  case EFAULT:
+    return wasm_wasi_efault;
+  case EFBIG:
+    return wasm_wasi_efbig;
+  case EINTR:
+    return wasm_wasi_eintr;
+  case EINVAL:
+    return wasm_wasi_einval;
+  case EISDIR:
+    return wasm_wasi_eisdir;
+  case ENOSPC:
+    return wasm_wasi_enospc;
+  case ENOSYS:
+    return wasm_wasi_enosys;
+  case EPIPE:
+    return wasm_wasi_epipe;
+  case ESPIPE:
+    return wasm_wasi_espipe;
+  default:
+    return wasm_wasi_eio;
+  }
+}
+
+// Returns a pointer to `size` bytes of linear memory or NULL if they are out
+// of bounds.
+static unsigned char *wasm_wasi_memory(wasm_instance *instance, uint32_t ptr,
+                                       uint64_t size) {
+  if ((uint64_t)ptr + size > instance->memory_size) {
+    return NULL;
+  }
+  return instance->memory + ptr;
+}
+
+static bool wasm_wasi_store_u32(wasm_instance *instance, uint32_t ptr,
+                                uint32_t value) {
+  unsigned char *memory = wasm_wasi_memory(instance, ptr, sizeof(value));
+  if (memory == NULL) {
+    return false;
+  }
+  memcpy(memory, &value, sizeof(value));
+  return true;
+}
+
+static bool wasm_wasi_store_u64(wasm_instance *instance, uint32_t ptr,
+                                uint64_t value) {
+  unsigned char *memory = wasm_wasi_memory(instance, ptr, sizeof(value));
+  if (memory == NULL) {
+    return false;
+  }
+  memcpy(memory, &value, sizeof(value));
+  return true;
+}
+
+static int wasm_wasi_host_fd(wasm_wasi *wasi, int32_t fd) {
+  if (fd < 0 || fd >= wasm_wasi_fd_count) {
+    return -1;
+  }
+  return wasi->fds[fd];
+}
+
+// Points the host iovecs directly into linear memory so readv/writev transfer
+// the data without a copy. Returns the number of iovecs or -1 if a buffer is
+// out of bounds.
+static int wasm_wasi_map_iovs(wasm_instance *instance, uint32_t iovs_ptr,
+                              uint32_t iovs_len, struct iovec *iovs) {
+  if (iovs_len > wasm_wasi_max_iovs) {
+    iovs_len = wasm_wasi_max_iovs;
+  }
+
+  // Guest iovecs are pairs of u32 pointer and length.
+  unsigned char *guest = wasm_wasi_memory(instance, iovs_ptr, iovs_len * 8);
+  if (guest == NULL) {
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < iovs_len; i++) {
+    uint32_t buf, len;
+    memcpy(&buf, guest + i * 8, sizeof(buf));
+    memcpy(&len, guest + i * 8 + 4, sizeof(len));
+
+    unsigned char *memory = wasm_wasi_memory(instance, buf, len);
+    if (memory == NULL) {
+      return -1;
+    }
+    iovs[i].iov_base = memory;
+    iovs[i].iov_len = len;
+  }
+  return (int)iovs_len;
+}
+
+// Shared by fd_read and fd_write: (fd, iovs, iovs_len, nbytes_ptr) -> errno.
+static enum wasm_trap wasm_wasi_fd_io(const wasm_host_func *func,
+                                      wasm_instance *instance,
+                                      wasm_value *args, bool write) {
+  int fd = wasm_wasi_host_fd(func->user, args[0].i32);
+  if (fd < 0) {
+    args[0].i32 = wasm_wasi_ebadf;
+    return wasm_trap_none;
+  }
+
+  struct iovec iovs[wasm_wasi_max_iovs];
+  int count = wasm_wasi_map_iovs(instance, (uint32_t)args[1].i32,
+                                 (uint32_t)args[2].i32, iovs);
+  if (count < 0) {
+    args[0].i32 = wasm_wasi_efault;
+    return wasm_trap_none;
+  }
+
+  ssize_t result = write ? writev(fd, iovs, count) : readv(fd, iovs, count);
+  if (result < 0) {
+    args[0].i32 = wasm_wasi_errno(errno);
+    return wasm_trap_none;
+  }
+
+  args[0].i32 = wasm_wasi_store_u32(instance, (uint32_t)args[3].i32,
+                                    (uint32_t)result)
+                    ? wasm_wasi_success
+                    : wasm_wasi_efault;
+  return wasm_trap_none;
+}
+
+static enum wasm_trap wasm_wasi_fd_read(const wasm_host_func *func,
+                                        wasm_instance *instance,
+                                        wasm_value *args) {
+  return wasm_wasi_fd_io(func, instance, args, false);
+}
+
+static enum wasm_trap wasm_wasi_fd_write(const wasm_host_func *func,
+                                         wasm_instance *instance,
+                                         wasm_value *args) {
+  return wasm_wasi_fd_io(func, instance, args, true);
+}
+
+// (fd, offset, whence, newoffset_ptr) -> errno
+static enum wasm_trap wasm_wasi_fd_seek(const wasm_host_func *func,
+                                        wasm_instance *instance,
+                                        wasm_value *args) {
+  int fd = wasm_wasi_host_fd(func->user, args[0].i32);
+  int whence;
+  switch (args[2].i32) {
+  case 0:
+    whence = SEEK_SET;
+    break;
+  case 1:
+    whence = SEEK_CUR;
+    break;
+  case 2:
+    whence = SEEK_END;
+    break;
+  default:
+    args[0].i32 = wasm_wasi_einval;
+    return wasm_trap_none;
+  }
+
+  if (fd < 0) {
+    args[0].i32 = wasm_wasi_ebadf;
+    return wasm_trap_none;
+  }
+
+  off_t offset = lseek(fd, (off_t)args[1].i64, whence);
+  if (offset < 0) {
+    args[0].i32 = wasm_wasi_errno(errno);
+    return wasm_trap_none;
+  }
+
+  args[0].i32 =
+      wasm_wasi_store_u64(instance, (uint32_t)args[3].i32, (uint64_t)offset)
+          ? wasm_wasi_success
+          : wasm_wasi_efault;
+  return wasm_trap_none;
+}
+
+// (fd) -> errno. The host fd stays open since it is owned by the embedder.
+static enum wasm_trap wasm_wasi_fd_close(const wasm_host_func *func,
+                                         wasm_instance *instance,
+                                         wasm_value *args) {
+  (void)instance;
+  wasm_wasi *wasi = func->user;
+  if (wasm_wasi_host_fd(wasi, args[0].i32) < 0) {
+    args[0].i32 = wasm_wasi_ebadf;
+    return wasm_trap_none;
+  }
+  wasi->fds[args[0].i32] = -1;
+  args[0].i32 = wasm_wasi_success;
+  return wasm_trap_none;
+}
+
+// (fd, stat_ptr) -> errno. wasi-libc queries this for every stdio stream.
+static enum wasm_trap wasm_wasi_fd_fdstat_get(const wasm_host_func *func,
+                                              wasm_instance *instance,
+                                              wasm_value *args) {
+  int fd = wasm_wasi_host_fd(func->user, args[0].i32);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    args[0].i32 = wasm_wasi_ebadf;
+    return wasm_trap_none;
+  }
+
+  // struct fdstat { u8 filetype; u16 flags; u64 rights_base;
+  //                 u64 rights_inheriting; }
+  unsigned char *stat = wasm_wasi_memory(instance, (uint32_t)args[1].i32, 24);
+  if (stat == NULL) {
+    args[0].i32 = wasm_wasi_efault;
+    return wasm_trap_none;
+  }
+
+  uint8_t filetype = wasm_wasi_filetype_unknown;
+  if (S_ISREG(st.st_mode)) {
+    filetype = wasm_wasi_filetype_regular_file;
+  } else if (S_ISDIR(st.st_mode)) {
+    filetype = wasm_wasi_filetype_directory;
+  } else if (S_ISCHR(st.st_mode)) {
+    filetype = wasm_wasi_filetype_character_device;
+  } else if (S_ISBLK(st.st_mode)) {
+    filetype = wasm_wasi_filetype_block_device;
+  } else if (S_ISSOCK(st.st_mode)) {
+    filetype = wasm_wasi_filetype_socket_stream;
+  } else if (S_ISLNK(st.st_mode)) {
+    filetype = wasm_wasi_filetype_symbolic_link;
+  }
+
+  uint64_t rights = UINT64_MAX;
+  memset(stat, 0, 24);
+  stat[0] = filetype;
+  memcpy(stat + 8, &rights, sizeof(rights));
+  memcpy(stat + 16, &rights, sizeof(rights));
+  args[0].i32 = wasm_wasi_success;
+  return wasm_trap_none;
+}
+
+// (clock_id, precision, time_ptr) -> errno
+static enum wasm_trap wasm_wasi_clock_time_get(const wasm_host_func *func,
+                                               wasm_instance *instance,
+                                               wasm_value *args) {
+  (void)func;
+  static const clockid_t clocks[] = {CLOCK_REALTIME, CLOCK_MONOTONIC,
+                                     CLOCK_PROCESS_CPUTIME_ID,
+                                     CLOCK_THREAD_CPUTIME_ID};
+  uint32_t id = (uint32_t)args[0].i32;
+  struct timespec ts;
+  if (id >= sizeof(clocks) / sizeof(clocks[0]) ||
+      clock_gettime(clocks[id], &ts) != 0) {
+    args[0].i32 = wasm_wasi_einval;
+    return wasm_trap_none;
+  }
+
+  uint64_t time = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+  args[0].i32 = wasm_wasi_store_u64(instance, (uint32_t)args[2].i32, time)
+                    ? wasm_wasi_success
+                    : wasm_wasi_efault;
+  return wasm_trap_none;
+}
+
+// Implements `args_sizes_get` and `environ_sizes_get`: (count_ptr,
+// buf_size_ptr) -> errno. The buffer holds all NUL terminated strings.
+static int32_t wasm_wasi_strings_sizes_get(wasm_instance *instance,
+                                           char **strings, size_t count,
+                                           wasm_value *args) {
+  size_t buf_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    buf_size += strlen(strings[i]) + 1;
+  }
+
+  if (!wasm_wasi_store_u32(instance, (uint32_t)args[0].i32, (uint32_t)count) ||
+      !wasm_wasi_store_u32(instance, (uint32_t)args[1].i32,
+                           (uint32_t)buf_size)) {
+    return wasm_wasi_efault;
+  }
+  return wasm_wasi_success;
+}
+
+// Implements `args_get` and `environ_get`: (ptrs_ptr, buf_ptr) -> errno.
+static int32_t wasm_wasi_strings_get(wasm_instance *instance, char **strings,
+                                     size_t count, wasm_value *args) {
+  uint32_t ptrs = (uint32_t)args[0].i32;
+  uint32_t buf = (uint32_t)args[1].i32;
+
+  for (size_t i = 0; i < count; i++) {
+    size_t size = strlen(strings[i]) + 1;
+    unsigned char *memory = wasm_wasi_memory(instance, buf, size);
+    if (memory == NULL || !wasm_wasi_store_u32(instance, ptrs, buf)) {
+      return wasm_wasi_efault;
+    }
+    memcpy(memory, strings[i], size);
+    ptrs += 4;
+    buf += (uint32_t)size;
+  }
+  return wasm_wasi_success;
+}
+
+static size_t wasm_wasi_environ_count(wasm_wasi *wasi) {
+  size_t count = 0;
+  while (wasi->environ && wasi->environ[count]) {
+    count++;
+  }
+  return count;
+}
+
+static enum wasm_trap wasm_wasi_args_sizes_get(const wasm_host_func *func,
+                                               wasm_instance *instance,
+                                               wasm_value *args) {
+  wasm_wasi *wasi = func->user;
+  args[0].i32 = wasm_wasi_strings_sizes_get(instance, wasi->argv,
+                                            (size_t)wasi->argc, args);
+  return wasm_trap_none;
+}
+
+static enum wasm_trap wasm_wasi_args_get(const wasm_host_func *func,
+                                         wasm_instance *instance,
+                                         wasm_value *args) {
+  wasm_wasi *wasi = func->user;
+  args[0].i32 =
+      wasm_wasi_strings_get(instance, wasi->argv, (size_t)wasi->argc, args);
+  return wasm_trap_none;
+}
+
+static enum wasm_trap wasm_wasi_environ_sizes_get(const wasm_host_func *func,
+                                                  wasm_instance *instance,
+                                                  wasm_value *args) {
+  wasm_wasi *wasi = func->user;
+  args[0].i32 = wasm_wasi_strings_sizes_get(
+      instance, wasi->environ, wasm_wasi_environ_count(wasi), args);
+  return wasm_trap_none;
+}
+
+static enum wasm_trap wasm_wasi_environ_get(const wasm_host_func *func,
+                                            wasm_instance *instance,
+                                            wasm_value *args) {
+  wasm_wasi *wasi = func->user;
+  args[0].i32 = wasm_wasi_strings_get(instance, wasi->environ,
+                                      wasm_wasi_environ_count(wasi), args);
+  return wasm_trap_none;
+}
+
+// (code) -> noreturn
+static enum wasm_trap wasm_wasi_proc_exit(const wasm_host_func *func,
+                                          wasm_instance *instance,
+                                          wasm_value *args) {
+  (void)instance;
+  wasm_wasi *wasi = func->user;
+  wasi->exit_code = args[0].i32;
+  return wasm_trap_exit;
+}
+
+void wasm_init_wasi(wasm_wasi *wasi, int argc, char **argv, char **environ) {
+  wasi->argc = argc;
+  wasi->argv = argv;
+  wasi->environ = environ;
+  for (int i = 0; i < wasm_wasi_fd_count; i++) {
+    wasi->fds[i] = i;
+  }
+  wasi->exit_code = 0;
+}
+
+bool wasm_wasi_add_imports(wasm_wasi *wasi, wasm_host_imports *imports) {
+  static const struct {
+    const char *name;
+    const char *signature;
+    wasm_host_trampoline trampoline;
+  } funcs[] = {
+      {"fd_read", "(iiii)i", &wasm_wasi_fd_read},
+      {"fd_write", "(iiii)i", &wasm_wasi_fd_write},
+      {"fd_seek", "(iIii)i", &wasm_wasi_fd_seek},
+      {"fd_close", "(i)i", &wasm_wasi_fd_close},
+      {"fd_fdstat_get", "(ii)i", &wasm_wasi_fd_fdstat_get},
+      {"clock_time_get", "(iIi)i", &wasm_wasi_clock_time_get},
+      {"args_sizes_get", "(ii)i", &wasm_wasi_args_sizes_get},
+      {"args_get", "(ii)i", &wasm_wasi_args_get},
+      {"environ_sizes_get", "(ii)i", &wasm_wasi_environ_sizes_get},
+      {"environ_get", "(ii)i", &wasm_wasi_environ_get},
+      {"proc_exit", "(i)", &wasm_wasi_proc_exit},
+  };
+
+  for (size_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+    if (!wasm_host_imports_add_raw(imports, wasm_wasi_module_name,
+                                   funcs[i].name, funcs[i].signature,
+                                   funcs[i].trampoline, wasi)) {
+      return false;
+    }
+  }
+  return true;
+}
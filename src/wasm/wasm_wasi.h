@@ -0,0 +1,32 @@
+#pragma once
+
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include <stdint.h>
+
+// Module name of the wasi functions.
+#define wasm_wasi_module_name "wasi_snapshot_preview1"
+
+// Number of file descriptors that are visible to the module (stdin, stdout and
+// stderr).
+#define wasm_wasi_fd_count 3
+
+// Host state of the wasi preview1 subset. The module only sees the arguments,
+// the environment and the file descriptors that are stored here.
+typedef struct {
+  int argc;
+  char **argv;
+  // NULL terminated like `environ`. May be NULL.
+  char **environ;
+  // Host file descriptors for the wasi fds. -1 if the fd is closed.
+  int fds[wasm_wasi_fd_count];
+  // Set by `proc_exit`.
+  int32_t exit_code;
+} wasm_wasi;
+
+// Starts with the standard streams of the host.
+void wasm_init_wasi(wasm_wasi *wasi, int argc, char **argv, char **environ);
+
+// Adds the wasi functions to `imports`. `wasi` must outlive the instances
+// that use them. `proc_exit` aborts the execution with `wasm_trap_exit`.
+bool wasm_wasi_add_imports(wasm_wasi *wasi, wasm_host_imports *imports);
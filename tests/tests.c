@@ -1,7 +1,23 @@
 #include "test.h"
 #include "wasm/wasm.h"
+#include "wasm/wasm_check.h"
 #include "wasm/wasm_common.h"
+#include "wasm/wasm_compile.h"
+#include "wasm/wasm_exec.h"
+#include "wasm/wasm_host.h"
+#include "wasm/wasm_perf.h"
+#include "wasm/wasm_print.h"
 #include "wasm/wasm_reader.h"
+#include "wasm/wasm_sched.h"
+#include "wasm/wasm_utf8.h"
+#include "wasm/wasm_validate.h"
+#include "wasm/wasm_wasi.h"
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
 
 char abcd[] = {'a', 'b', 'c', 'd'};
 
@@ -79,7 +95,30 @@ void test_skip_custom_section() {
 }
 
 void test_vec() {
-  // Add tests for wasm_vec here :(
+  wasm_vec_of(uint64_t) vec;
+  wasm_vec_init(&vec);
+  MUST_EQUAL(wasm_vec_size(&vec), 0);
+
+  // Reserving allocates exactly once, appends within it don't move the
+  // elements.
+  wasm_vec_reserve(&vec, 100);
+  uint64_t *start = vec.start;
+  MUST_EQUAL(vec.capacity - vec.start, 100);
+  for (uint64_t i = 0; i < 100; i++) {
+    *wasm_vec_append(&vec) = i * 3;
+  }
+  MUST_EQUAL(vec.start, start);
+  MUST_EQUAL(wasm_vec_size(&vec), 100);
+  MUST_EQUAL(*wasm_vec_get(&vec, 42), 126);
+
+  // Growing past the reservation keeps the elements.
+  uint64_t *more = wasm_vec_append_n(&vec, 5);
+  more[4] = 7;
+  MUST_EQUAL(wasm_vec_size(&vec), 105);
+  MUST_EQUAL(vec.start[99], 297);
+  MUST_EQUAL(vec.start[104], 7);
+  wasm_vec_deinit(&vec);
+  MUST_EQUAL(vec.start, NULL);
 }
 
 void test_emscripten_file_1() {
@@ -96,6 +135,1389 @@ void test_emscripten_file_1() {
   wasm_free_module(module);
 }
 
+void test_emscripten_file_1_exec() {
+  wasm_module *module =
+      wasm_load_module_from_file("../tests/files/emscripten_1/a.out.wasm");
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    wasm_value args[2] = {{.i32 = 5}, {.i32 = 7}};
+    wasm_value result;
+
+    // a(argc, argv) = argc + 2
+    MUST_EQUAL(wasm_invoke(instance, 0, args, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 7);
+
+    // b(size) allocates on the stack and returns the old stack pointer.
+    args[0].i32 = 20;
+    MUST_EQUAL(wasm_invoke(instance, 1, args, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 2768);
+    MUST_EQUAL(instance->globals[0].i32, 2800);
+  }
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
+
+// (func $fac (export "fac") (param i32) (result i32)
+//   local.get 0
+//   i32.eqz
+//   if (result i32)
+//     i32.const 1
+//   else
+//     local.get 0
+//     local.get 0
+//     i32.const 1
+//     i32.sub
+//     call $fac
+//     i32.mul
+//   end)
+const unsigned char fac_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x07, 0x07, 0x01, 0x03,
+    0x66, 0x61, 0x63, 0x00, 0x00, 0x0A, 0x17, 0x01, 0x15, 0x00, 0x20, 0x00,
+    0x45, 0x04, 0x7F, 0x41, 0x01, 0x05, 0x20, 0x00, 0x20, 0x00, 0x41, 0x01,
+    0x6B, 0x10, 0x00, 0x6C, 0x0B, 0x0B};
+
+void test_exec_control_flow() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, fac_module, sizeof(fac_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    wasm_value arg = {.i32 = 5};
+    wasm_value result;
+    MUST_EQUAL(wasm_invoke(instance, 0, &arg, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 120);
+
+    // Unbounded recursion traps instead of crashing.
+    arg.i32 = -1;
+    MUST_EQUAL(wasm_invoke(instance, 0, &arg, &result),
+               wasm_trap_call_stack_exhausted);
+
+    MUST_EQUAL(wasm_invoke(instance, 99, &arg, &result),
+               wasm_trap_undefined_function);
+  }
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+
+  // Export indices are checked when the module is loaded.
+  unsigned char bad_export[sizeof(fac_module)];
+  memcpy(bad_export, fac_module, sizeof(fac_module));
+  bad_export[28] = 99;
+  wasm_init_memory_reader(&reader, bad_export, sizeof(bad_export));
+  MUST_EQUAL(wasm_load_module(&reader), NULL);
+}
+
+// (import "env" "add" (func $add (param i32 i32) (result i32)))
+// (func (export "run") (param i32 i32) (result i32)
+//   local.get 0
+//   local.get 1
+//   call $add
+//   i32.const 1
+//   i32.add)
+const unsigned char import_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01,
+    0x60, 0x02, 0x7F, 0x7F, 0x01, 0x7F, 0x02, 0x0B, 0x01, 0x03, 0x65,
+    0x6E, 0x76, 0x03, 0x61, 0x64, 0x64, 0x00, 0x00, 0x03, 0x02, 0x01,
+    0x00, 0x07, 0x07, 0x01, 0x03, 0x72, 0x75, 0x6E, 0x00, 0x01, 0x0A,
+    0x0D, 0x01, 0x0B, 0x00, 0x20, 0x00, 0x20, 0x01, 0x10, 0x00, 0x41,
+    0x01, 0x6A, 0x0B};
+
+int32_t host_add(wasm_instance *instance, void *user, int32_t a, int32_t b) {
+  (void)instance;
+  ++*(int *)user;
+  return a + b;
+}
+
+void test_imports() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, import_module, sizeof(import_module));
+  wasm_module *module = wasm_load_module(&reader);
+
+  MUST_NOT_EQUAL(module, NULL);
+  if (module == NULL) {
+    return;
+  }
+
+  MUST_EQUAL(wasm_vec_size(&module->imports), 1);
+  MUST_EQUAL(module->import_func_count, 1);
+
+  // Missing imports fail the instantiation.
+  MUST_EQUAL(wasm_instantiate(module, NULL), NULL);
+
+  int calls = 0;
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+
+  // The signature has to match.
+  wasm_host_imports_add(&imports, "env", "add", "(iI)i", &host_add, &calls);
+  MUST_EQUAL(wasm_instantiate(module, &imports), NULL);
+  wasm_deinit_host_imports(&imports);
+
+  wasm_init_host_imports(&imports);
+  wasm_host_imports_add(&imports, "env", "add", "(ii)i", &host_add, &calls);
+  wasm_instance *instance = wasm_instantiate(module, &imports);
+  MUST_NOT_EQUAL(instance, NULL);
+
+  if (instance) {
+    wasm_value args[2] = {{.i32 = 40}, {.i32 = 1}};
+    wasm_value result;
+    MUST_EQUAL(wasm_invoke(instance, 1, args, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 42);
+    MUST_EQUAL(calls, 1);
+  }
+
+  wasm_free_instance(instance);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+}
+
+// (type $a (func (param i32) (result i32)))
+// (type $b (func (param i32) (result i32)))
+// (table 4 funcref)
+// (elem (i32.const 0) $double $inc $seven)
+// (func $double (type $a) local.get 0 i32.const 2 i32.mul)
+// (func $inc (type $b) local.get 0 i32.const 1 i32.add)
+// (func $seven (result i32) i32.const 7)
+// (func $dispatch (param i32 i32) (result i32)
+//   local.get 0
+//   local.get 1
+//   call_indirect (type $b))
+const unsigned char indirect_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x15, 0x04, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x60, 0x01, 0x7F, 0x01, 0x7F, 0x60, 0x00, 0x01,
+    0x7F, 0x60, 0x02, 0x7F, 0x7F, 0x01, 0x7F, 0x03, 0x05, 0x04, 0x00, 0x01,
+    0x02, 0x03, 0x04, 0x04, 0x01, 0x70, 0x00, 0x04, 0x09, 0x09, 0x01, 0x00,
+    0x41, 0x00, 0x0B, 0x03, 0x00, 0x01, 0x02, 0x0A, 0x20, 0x04, 0x07, 0x00,
+    0x20, 0x00, 0x41, 0x02, 0x6C, 0x0B, 0x07, 0x00, 0x20, 0x00, 0x41, 0x01,
+    0x6A, 0x0B, 0x04, 0x00, 0x41, 0x07, 0x0B, 0x09, 0x00, 0x20, 0x00, 0x20,
+    0x01, 0x11, 0x01, 0x00, 0x0B};
+
+static enum wasm_trap dispatch(wasm_instance *instance, int32_t value,
+                               int32_t index, int32_t *result) {
+  wasm_value args[2] = {{.i32 = value}, {.i32 = index}};
+  wasm_value out = {.i32 = 0};
+  enum wasm_trap trap = wasm_invoke(instance, 3, args, &out);
+  *result = out.i32;
+  return trap;
+}
+
+void test_call_indirect() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, indirect_module, sizeof(indirect_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    // Structurally equal types share the canonical id.
+    MUST_EQUAL(wasm_module_type_id(module, 0), wasm_module_type_id(module, 1));
+    MUST_NOT_EQUAL(wasm_module_type_id(module, 0),
+                   wasm_module_type_id(module, 2));
+
+    int32_t result;
+    MUST_EQUAL(dispatch(instance, 5, 0, &result), wasm_trap_none);
+    MUST_EQUAL(result, 10);
+    MUST_EQUAL(dispatch(instance, 5, 1, &result), wasm_trap_none);
+    MUST_EQUAL(result, 6);
+    MUST_EQUAL(dispatch(instance, 5, 2, &result),
+               wasm_trap_indirect_call_type_mismatch);
+    MUST_EQUAL(dispatch(instance, 5, 3, &result),
+               wasm_trap_uninitialized_element);
+    MUST_EQUAL(dispatch(instance, 5, 4, &result), wasm_trap_undefined_element);
+
+    // The inline cache must not return a stale target.
+    MUST_EQUAL(dispatch(instance, 5, 0, &result), wasm_trap_none);
+    MUST_EQUAL(result, 10);
+  }
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
+
+// (memory 1)
+// (data (i32.const 0) "\10\00\00\00\06\00\00\00")
+// (data (i32.const 16) "hello\n")
+// (func (export "_start")
+//   (drop (call $fd_write (i32.const 1) (i32.const 0) (i32.const 1)
+//                         (i32.const 8)))
+//   (drop (call $args_sizes_get (i32.const 32) (i32.const 36)))
+//   (call $proc_exit (i32.load (i32.const 32))))
+const unsigned char wasi_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x16, 0x04, 0x60,
+    0x04, 0x7F, 0x7F, 0x7F, 0x7F, 0x01, 0x7F, 0x60, 0x01, 0x7F, 0x00, 0x60,
+    0x02, 0x7F, 0x7F, 0x01, 0x7F, 0x60, 0x00, 0x00, 0x02, 0x6E, 0x03, 0x16,
+    0x77, 0x61, 0x73, 0x69, 0x5F, 0x73, 0x6E, 0x61, 0x70, 0x73, 0x68, 0x6F,
+    0x74, 0x5F, 0x70, 0x72, 0x65, 0x76, 0x69, 0x65, 0x77, 0x31, 0x08, 0x66,
+    0x64, 0x5F, 0x77, 0x72, 0x69, 0x74, 0x65, 0x00, 0x00, 0x16, 0x77, 0x61,
+    0x73, 0x69, 0x5F, 0x73, 0x6E, 0x61, 0x70, 0x73, 0x68, 0x6F, 0x74, 0x5F,
+    0x70, 0x72, 0x65, 0x76, 0x69, 0x65, 0x77, 0x31, 0x09, 0x70, 0x72, 0x6F,
+    0x63, 0x5F, 0x65, 0x78, 0x69, 0x74, 0x00, 0x01, 0x16, 0x77, 0x61, 0x73,
+    0x69, 0x5F, 0x73, 0x6E, 0x61, 0x70, 0x73, 0x68, 0x6F, 0x74, 0x5F, 0x70,
+    0x72, 0x65, 0x76, 0x69, 0x65, 0x77, 0x31, 0x0E, 0x61, 0x72, 0x67, 0x73,
+    0x5F, 0x73, 0x69, 0x7A, 0x65, 0x73, 0x5F, 0x67, 0x65, 0x74, 0x00, 0x02,
+    0x03, 0x02, 0x01, 0x03, 0x05, 0x03, 0x01, 0x00, 0x01, 0x07, 0x0A, 0x01,
+    0x06, 0x5F, 0x73, 0x74, 0x61, 0x72, 0x74, 0x00, 0x03, 0x0A, 0x1D, 0x01,
+    0x1B, 0x00, 0x41, 0x01, 0x41, 0x00, 0x41, 0x01, 0x41, 0x08, 0x10, 0x00,
+    0x1A, 0x41, 0x20, 0x41, 0x24, 0x10, 0x02, 0x1A, 0x41, 0x20, 0x28, 0x02,
+    0x00, 0x10, 0x01, 0x0B, 0x0B, 0x19, 0x02, 0x00, 0x41, 0x00, 0x0B, 0x08,
+    0x10, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x41, 0x10, 0x0B,
+    0x06, 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x0A};
+
+void test_wasi() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, wasi_module, sizeof(wasi_module));
+  wasm_module *module = wasm_load_module(&reader);
+  MUST_NOT_EQUAL(module, NULL);
+  if (module == NULL) {
+    return;
+  }
+
+  int pipe_fds[2];
+  MUST_EQUAL(pipe(pipe_fds), 0);
+
+  char *argv[] = {"test", "a", "b"};
+  wasm_wasi wasi;
+  wasm_init_wasi(&wasi, 3, argv, NULL);
+  wasi.fds[1] = pipe_fds[1];
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  MUST_EQUAL(wasm_wasi_add_imports(&wasi, &imports), true);
+  wasm_instance *instance = wasm_instantiate(module, &imports);
+  MUST_NOT_EQUAL(instance, NULL);
+
+  if (instance) {
+    // proc_exit stops the execution with the number of arguments.
+    MUST_EQUAL(wasm_invoke(instance, 3, NULL, NULL), wasm_trap_exit);
+    MUST_EQUAL(wasi.exit_code, 3);
+
+    uint32_t written;
+    memcpy(&written, instance->memory + 8, sizeof(written));
+    MUST_EQUAL(written, 6);
+
+    char buf[8] = {0};
+    MUST_EQUAL(read(pipe_fds[0], buf, sizeof(buf)), 6);
+    MUST_EQUAL(strcmp(buf, "hello\n"), 0);
+  }
+
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+  wasm_free_instance(instance);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+}
+
+// (memory 1)
+// (data "hello")
+// (func $init (param i32 i32 i32)
+//   (memory.init 0 (local.get 0) (local.get 1) (local.get 2)))
+// (func $drop (data.drop 0))
+// (func $copy (param i32 i32 i32)
+//   (memory.copy (local.get 0) (local.get 1) (local.get 2)))
+// (func $fill (param i32 i32 i32)
+//   (memory.fill (local.get 0) (local.get 1) (local.get 2)))
+const unsigned char bulk_memory_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0F, 0x03, 0x60,
+    0x03, 0x7F, 0x7F, 0x7F, 0x00, 0x60, 0x00, 0x00, 0x60, 0x01, 0x7F, 0x01,
+    0x7F, 0x03, 0x06, 0x05, 0x00, 0x01, 0x00, 0x00, 0x02, 0x05, 0x03, 0x01,
+    0x00, 0x01, 0x0C, 0x01, 0x01, 0x0A, 0x35, 0x05, 0x0C, 0x00, 0x20, 0x00,
+    0x20, 0x01, 0x20, 0x02, 0xFC, 0x08, 0x00, 0x00, 0x0B, 0x05, 0x00, 0xFC,
+    0x09, 0x00, 0x0B, 0x0C, 0x00, 0x20, 0x00, 0x20, 0x01, 0x20, 0x02, 0xFC,
+    0x0A, 0x00, 0x00, 0x0B, 0x0B, 0x00, 0x20, 0x00, 0x20, 0x01, 0x20, 0x02,
+    0xFC, 0x0B, 0x00, 0x0B, 0x07, 0x00, 0x20, 0x00, 0x2D, 0x00, 0x00, 0x0B,
+    0x0B, 0x08, 0x01, 0x01, 0x05, 0x68, 0x65, 0x6C, 0x6C, 0x6F};
+
+static enum wasm_trap bulk_memory_op(wasm_instance *instance, uint32_t funcidx,
+                                     int32_t a, int32_t b, int32_t c) {
+  wasm_value args[3] = {{.i32 = a}, {.i32 = b}, {.i32 = c}};
+  return wasm_invoke(instance, funcidx, args, NULL);
+}
+
+void test_bulk_memory() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, bulk_memory_module,
+                          sizeof(bulk_memory_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    // Passive segments are not copied on instantiation.
+    MUST_EQUAL(instance->memory[0], 0);
+
+    MUST_EQUAL(bulk_memory_op(instance, 0, 10, 1, 4), wasm_trap_none);
+    MUST_EQUAL_MEM(instance->memory + 10, "ello", 4);
+
+    // Overlapping copies behave like memmove.
+    MUST_EQUAL(bulk_memory_op(instance, 2, 11, 10, 4), wasm_trap_none);
+    MUST_EQUAL_MEM(instance->memory + 10, "eello", 5);
+
+    MUST_EQUAL(bulk_memory_op(instance, 3, 0, 'x', 3), wasm_trap_none);
+    MUST_EQUAL_MEM(instance->memory, "xxx", 3);
+
+    // Out of bounds accesses trap without writing anything.
+    MUST_EQUAL(bulk_memory_op(instance, 0, 0, 3, 3),
+               wasm_trap_memory_out_of_bounds);
+    MUST_EQUAL(bulk_memory_op(instance, 0, 65535, 0, 2),
+               wasm_trap_memory_out_of_bounds);
+    MUST_EQUAL(bulk_memory_op(instance, 2, 65535, 0, 2),
+               wasm_trap_memory_out_of_bounds);
+    MUST_EQUAL(bulk_memory_op(instance, 3, 65535, 0, 2),
+               wasm_trap_memory_out_of_bounds);
+    MUST_EQUAL(instance->memory[65535], 0);
+    MUST_EQUAL(bulk_memory_op(instance, 3, 65536, 0, 0), wasm_trap_none);
+
+    // Dropped segments are empty.
+    MUST_EQUAL(wasm_invoke(instance, 1, NULL, NULL), wasm_trap_none);
+    MUST_EQUAL(bulk_memory_op(instance, 0, 0, 0, 1),
+               wasm_trap_memory_out_of_bounds);
+    MUST_EQUAL(bulk_memory_op(instance, 0, 0, 0, 0), wasm_trap_none);
+  }
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
+
+// (memory 1)
+// (func (v128.store (i32.const 32)
+//   (i8x16.shuffle 0 17 2 19 4 21 6 23 8 25 10 27 12 29 14 31
+//     (v128.load (i32.const 0)) (v128.load (i32.const 16)))))
+// (func (v128.store (i32.const 48) (i8x16.add_sat_u (v128.load (i32.const 0))
+//   (v128.load (i32.const 16)))))
+// (func (v128.store (i32.const 64) (i16x8.q15mulr_sat_s
+//   (v128.load (i32.const 0)) (v128.load (i32.const 16)))))
+// (func (v128.store (i32.const 80) (f32x4.min (v128.load (i32.const 96))
+//   (v128.load (i32.const 112)))))
+// (func (result i32) (i8x16.bitmask (v128.load (i32.const 0))))
+// (func (result i32) (i32x4.extract_lane 1 (i32x4.mul
+//   (v128.load32_splat (i32.const 0)) (v128.const i32x4 1 2 3 4))))
+// (func (v128.store (i32.const 128) (i8x16.swizzle (v128.load (i32.const 0))
+//   (v128.load (i32.const 16)))))
+// (func (v128.store (i32.const 144) (i8x16.shr_s (v128.load (i32.const 0))
+//   (i32.const 9))))
+const unsigned char simd_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02, 0x60,
+    0x00, 0x00, 0x60, 0x00, 0x01, 0x7F, 0x03, 0x09, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x01, 0x00, 0x00, 0x05, 0x03, 0x01, 0x00, 0x01, 0x0A, 0xC9,
+    0x01, 0x08, 0x26, 0x00, 0x41, 0x20, 0x41, 0x00, 0xFD, 0x00, 0x04, 0x00,
+    0x41, 0x00, 0xFD, 0x00, 0x04, 0x10, 0xFD, 0x0D, 0x00, 0x11, 0x02, 0x13,
+    0x04, 0x15, 0x06, 0x17, 0x08, 0x19, 0x0A, 0x1B, 0x0C, 0x1D, 0x0E, 0x1F,
+    0xFD, 0x0B, 0x04, 0x00, 0x0B, 0x16, 0x00, 0x41, 0x30, 0x41, 0x00, 0xFD,
+    0x00, 0x04, 0x00, 0x41, 0x00, 0xFD, 0x00, 0x04, 0x10, 0xFD, 0x70, 0xFD,
+    0x0B, 0x04, 0x00, 0x0B, 0x18, 0x00, 0x41, 0xC0, 0x00, 0x41, 0x00, 0xFD,
+    0x00, 0x04, 0x00, 0x41, 0x00, 0xFD, 0x00, 0x04, 0x10, 0xFD, 0x82, 0x01,
+    0xFD, 0x0B, 0x04, 0x00, 0x0B, 0x18, 0x00, 0x41, 0xD0, 0x00, 0x41, 0x00,
+    0xFD, 0x00, 0x04, 0x60, 0x41, 0x00, 0xFD, 0x00, 0x04, 0x70, 0xFD, 0xE8,
+    0x01, 0xFD, 0x0B, 0x04, 0x00, 0x0B, 0x0A, 0x00, 0x41, 0x00, 0xFD, 0x00,
+    0x04, 0x00, 0xFD, 0x64, 0x0B, 0x20, 0x00, 0x41, 0x00, 0xFD, 0x09, 0x02,
+    0x00, 0xFD, 0x0C, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFD, 0xB5, 0x01, 0xFD, 0x1B,
+    0x01, 0x0B, 0x17, 0x00, 0x41, 0x80, 0x01, 0x41, 0x00, 0xFD, 0x00, 0x04,
+    0x00, 0x41, 0x00, 0xFD, 0x00, 0x04, 0x10, 0xFD, 0x0E, 0xFD, 0x0B, 0x04,
+    0x00, 0x0B, 0x13, 0x00, 0x41, 0x90, 0x01, 0x41, 0x00, 0xFD, 0x00, 0x04,
+    0x00, 0x41, 0x09, 0xFD, 0x6C, 0xFD, 0x0B, 0x04, 0x00, 0x0B};
+
+// Runs the SIMD instructions with `level` and stores their results in `out`.
+static void run_simd(wasm_instance *instance, enum wasm_simd_level level,
+                     unsigned char out[128], int32_t results[2]) {
+  const unsigned char a[16] = {0x00, 0x80, 0xFF, 0x7F, 0x10, 0xF0, 0x01, 0x02,
+                               0x80, 0x81, 0x90, 0x07, 0xFE, 0x33, 0x44, 0x55};
+  const unsigned char b[16] = {0x00, 0x80, 0x03, 0x40, 0x13, 0xF1, 0x20, 0x0F,
+                               0x05, 0x1F, 0x99, 0x11, 0xFF, 0x02, 0x0A, 0x0C};
+  const float floats[8] = {NAN, -0.0f, 1.0f, -5.0f, 1.0f, 0.0f, 2.0f, -6.0f};
+
+  memset(instance->memory, 0, 160);
+  memcpy(instance->memory, a, 16);
+  memcpy(instance->memory + 16, b, 16);
+  memcpy(instance->memory + 96, floats, sizeof(floats));
+
+  wasm_simd_set_level(level);
+  for (uint32_t i = 0; i < 8; i++) {
+    wasm_value result;
+    MUST_EQUAL(wasm_invoke(instance, i, NULL, &result), wasm_trap_none);
+    if (i == 4 || i == 5) {
+      results[i - 4] = result.i32;
+    }
+  }
+  memcpy(out, instance->memory + 32, 128);
+}
+
+void test_simd() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, simd_module, sizeof(simd_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    enum wasm_simd_level best = wasm_simd_detect_level();
+    unsigned char scalar_out[128], best_out[128];
+    int32_t scalar_results[2], best_results[2];
+    run_simd(instance, wasm_simd_scalar, scalar_out, scalar_results);
+    run_simd(instance, best, best_out, best_results);
+
+    // The accelerated paths must match the scalar fallback exactly.
+    MUST_EQUAL_MEM(scalar_out, best_out, 128);
+    MUST_EQUAL(scalar_results[0], best_results[0]);
+    MUST_EQUAL(scalar_results[1], best_results[1]);
+
+    MUST_EQUAL_MEM(best_out, "\x00\x80\xFF\x40\x10\xF1\x01\x0F", 8);
+    uint16_t q15;
+    memcpy(&q15, best_out + 32, 2);
+    MUST_EQUAL(q15, 0x7FFF);
+    float min[4];
+    memcpy(min, best_out + 48, sizeof(min));
+    MUST_NOT_EQUAL(isnan(min[0]), 0);
+    MUST_NOT_EQUAL(signbit(min[1]), 0);
+    MUST_EQUAL(min[3], -6.0f);
+    MUST_EQUAL(best_results[0], 5926);
+    MUST_EQUAL(best_results[1], -65536);
+    // Swizzle indices above 15 select zero.
+    MUST_EQUAL_MEM(best_out + 96, "\x00\x00\x7F\x00\x00\x00\x00\x55", 8);
+
+    wasm_simd_set_level(best);
+  }
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
+
+// (import "env" "memory" (memory 1 2 shared))
+// (func $add (param i32 i32) (result i32)
+//   (i32.atomic.rmw.add (local.get 0) (local.get 1)))
+// (func $cmpxchg8 (param i32 i32 i32) (result i32)
+//   (i32.atomic.rmw8.cmpxchg_u (local.get 0) (local.get 1) (local.get 2)))
+// (func $load64 (param i32) (result i64) (i64.atomic.load (local.get 0)))
+// (func $wait (param i32 i32 i64) (result i32)
+//   (memory.atomic.wait32 (local.get 0) (local.get 1) (local.get 2)))
+// (func $notify (param i32 i32) (result i32)
+//   (memory.atomic.notify (local.get 0) (local.get 1)))
+// (func $grow (param i32) (result i32) (memory.grow (local.get 0)))
+// (func $size (result i32) (atomic.fence) (memory.size))
+const unsigned char atomics_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x23, 0x06, 0x60,
+    0x02, 0x7F, 0x7F, 0x01, 0x7F, 0x60, 0x03, 0x7F, 0x7F, 0x7F, 0x01, 0x7F,
+    0x60, 0x01, 0x7F, 0x01, 0x7E, 0x60, 0x03, 0x7F, 0x7F, 0x7E, 0x01, 0x7F,
+    0x60, 0x01, 0x7F, 0x01, 0x7F, 0x60, 0x00, 0x01, 0x7F, 0x02, 0x10, 0x01,
+    0x03, 0x65, 0x6E, 0x76, 0x06, 0x6D, 0x65, 0x6D, 0x6F, 0x72, 0x79, 0x02,
+    0x03, 0x01, 0x02, 0x03, 0x08, 0x07, 0x00, 0x01, 0x02, 0x03, 0x00, 0x04,
+    0x05, 0x0A, 0x49, 0x07, 0x0A, 0x00, 0x20, 0x00, 0x20, 0x01, 0xFE, 0x1E,
+    0x02, 0x00, 0x0B, 0x0C, 0x00, 0x20, 0x00, 0x20, 0x01, 0x20, 0x02, 0xFE,
+    0x4A, 0x00, 0x00, 0x0B, 0x08, 0x00, 0x20, 0x00, 0xFE, 0x11, 0x03, 0x00,
+    0x0B, 0x0C, 0x00, 0x20, 0x00, 0x20, 0x01, 0x20, 0x02, 0xFE, 0x01, 0x02,
+    0x00, 0x0B, 0x0A, 0x00, 0x20, 0x00, 0x20, 0x01, 0xFE, 0x00, 0x02, 0x00,
+    0x0B, 0x06, 0x00, 0x20, 0x00, 0x40, 0x00, 0x0B, 0x07, 0x00, 0xFE, 0x03,
+    0x00, 0x3F, 0x00, 0x0B};
+
+static int32_t atomics_call(wasm_instance *instance, uint32_t funcidx,
+                            int32_t a, int32_t b, int64_t c,
+                            enum wasm_trap expected_trap) {
+  wasm_value args[3] = {{.i32 = a}, {.i32 = b}, {.i64 = c}};
+  wasm_value result = {.i32 = -100};
+  MUST_EQUAL(wasm_invoke(instance, funcidx, args, &result), expected_trap);
+  return result.i32;
+}
+
+typedef struct {
+  wasm_instance *instance;
+  int32_t result;
+} atomics_waiter;
+
+static void *atomics_wait_thread(void *arg) {
+  atomics_waiter *waiter = arg;
+  waiter->result = atomics_call(waiter->instance, 3, 16, 0, -1, wasm_trap_none);
+  return NULL;
+}
+
+void test_atomics() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, atomics_module, sizeof(atomics_module));
+  wasm_module *module = wasm_load_module(&reader);
+
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_shared_memory *memory = wasm_create_shared_memory(1, 2);
+  MUST_NOT_EQUAL(memory, NULL);
+  wasm_host_imports_add_memory(&imports, "env", "memory", memory);
+  wasm_release_shared_memory(memory);
+
+  // Both instances use the same memory.
+  wasm_instance *a = module ? wasm_instantiate(module, &imports) : NULL;
+  wasm_instance *b = module ? wasm_instantiate(module, &imports) : NULL;
+  MUST_NOT_EQUAL(a, NULL);
+  MUST_NOT_EQUAL(b, NULL);
+  if (a && b) {
+    MUST_EQUAL(a->memory, b->memory);
+
+    // Read-modify-write instructions return the old value.
+    MUST_EQUAL(atomics_call(a, 0, 0, 5, 0, wasm_trap_none), 0);
+    MUST_EQUAL(atomics_call(b, 0, 0, 3, 0, wasm_trap_none), 5);
+    MUST_EQUAL(atomics_call(a, 2, 0, 0, 0, wasm_trap_none), 8);
+    atomics_call(a, 0, 2, 1, 0, wasm_trap_unaligned_atomic);
+    atomics_call(a, 0, 65536, 1, 0, wasm_trap_memory_out_of_bounds);
+
+    // The expected value is wrapped to the access size.
+    MUST_EQUAL(atomics_call(a, 1, 4, 0x100, 7, wasm_trap_none), 0);
+    MUST_EQUAL(atomics_call(a, 1, 4, 1, 9, wasm_trap_none), 7);
+    MUST_EQUAL(memory->data[4], 7);
+
+    MUST_EQUAL(atomics_call(a, 3, 0, 99, -1, wasm_trap_none),
+               wasm_wait_not_equal);
+    MUST_EQUAL(atomics_call(a, 3, 0, 8, 1000000, wasm_trap_none),
+               wasm_wait_timed_out);
+    MUST_EQUAL(atomics_call(a, 4, 16, 1, 0, wasm_trap_none), 0);
+
+    // Growing the memory in one instance is visible in the other.
+    MUST_EQUAL(atomics_call(b, 5, 1, 0, 0, wasm_trap_none), 1);
+    MUST_EQUAL(atomics_call(a, 0, 65536, 1, 0, wasm_trap_none), 0);
+    MUST_EQUAL(atomics_call(a, 6, 0, 0, 0, wasm_trap_none), 2);
+    MUST_EQUAL(atomics_call(a, 5, 1, 0, 0, wasm_trap_none), -1);
+
+    // A thread that waits is woken by a notify from another instance.
+    atomics_waiter waiter = {b, -1};
+    pthread_t thread;
+    MUST_EQUAL(pthread_create(&thread, NULL, atomics_wait_thread, &waiter), 0);
+    while (atomics_call(a, 4, 16, 1, 0, wasm_trap_none) == 0) {
+      sched_yield();
+    }
+    pthread_join(thread, NULL);
+    MUST_EQUAL(waiter.result, wasm_wait_ok);
+  }
+  wasm_free_instance(a);
+  wasm_free_instance(b);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+}
+
+// (func $spin (param $n i32) (result i32)
+//   loop
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end
+//   (local.get $n))
+static const unsigned char spin_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x0A, 0x12, 0x01, 0x10,
+    0x00, 0x03, 0x40, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00,
+    0x0B, 0x20, 0x00, 0x0B};
+
+#define scheduler_task_count 16
+
+static _Atomic int scheduler_done_count;
+
+static void scheduler_task_done(enum wasm_trap trap, const wasm_value *result,
+                                void *user) {
+  int32_t *out = user;
+  *out = trap ? -1 : result->i32;
+  atomic_fetch_add(&scheduler_done_count, 1);
+}
+
+static bool interrupt_checkpoint(wasm_instance *instance) {
+  (void)instance;
+  return false;
+}
+
+void test_scheduler() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, spin_module, sizeof(spin_module));
+  wasm_module *module = wasm_load_module(&reader);
+  MUST_NOT_EQUAL(module, NULL);
+  if (module == NULL) {
+    return;
+  }
+
+  wasm_instance *instances[scheduler_task_count] = {NULL};
+  for (int i = 0; i < scheduler_task_count; i++) {
+    instances[i] = wasm_instantiate(module, NULL);
+    MUST_NOT_EQUAL(instances[i], NULL);
+  }
+
+  // The small slice preempts every task many times.
+  wasm_scheduler *scheduler = wasm_create_scheduler(2, 100);
+  MUST_NOT_EQUAL(scheduler, NULL);
+  if (scheduler && instances[scheduler_task_count - 1]) {
+    int32_t results[scheduler_task_count];
+    atomic_store(&scheduler_done_count, 0);
+    for (int i = 0; i < scheduler_task_count; i++) {
+      wasm_value arg = {.i32 = 1000 * (i + 1)};
+      results[i] = -100;
+      wasm_scheduler_spawn(scheduler, instances[i], 0, &arg,
+                           scheduler_task_done, &results[i]);
+    }
+    wasm_scheduler_wait(scheduler);
+    MUST_EQUAL(atomic_load(&scheduler_done_count), scheduler_task_count);
+    int finished = 0;
+    for (int i = 0; i < scheduler_task_count; i++) {
+      finished += results[i] == 0;
+    }
+    MUST_EQUAL(finished, scheduler_task_count);
+
+    // The instances can be called directly again once their task is done.
+    wasm_value arg = {.i32 = 10};
+    wasm_value result = {.i32 = -100};
+    MUST_EQUAL(wasm_invoke(instances[0], 0, &arg, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 0);
+    MUST(!wasm_task_yield(instances[0]), "must not be a task");
+  }
+  wasm_free_scheduler(scheduler);
+
+  // A checkpoint hook that returns false stops the execution.
+  if (instances[0]) {
+    instances[0]->fuel = 50;
+    instances[0]->checkpoint = interrupt_checkpoint;
+    wasm_value arg = {.i32 = 1000};
+    MUST_EQUAL(wasm_invoke(instances[0], 0, &arg, NULL), wasm_trap_interrupted);
+  }
+
+  for (int i = 0; i < scheduler_task_count; i++) {
+    wasm_free_instance(instances[i]);
+  }
+  wasm_free_module(module);
+}
+
+// (import "env" "io" (func $io (param i32) (result i32)))
+// (func $run (param $n i32)
+//   loop
+//     (drop (call $io (local.get $n)))
+//     (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))
+//   end)
+static const unsigned char io_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0A, 0x02, 0x60,
+    0x01, 0x7F, 0x01, 0x7F, 0x60, 0x01, 0x7F, 0x00, 0x02, 0x0A, 0x01, 0x03,
+    0x65, 0x6E, 0x76, 0x02, 0x69, 0x6F, 0x00, 0x00, 0x03, 0x02, 0x01, 0x01,
+    0x0A, 0x15, 0x01, 0x13, 0x00, 0x03, 0x40, 0x20, 0x00, 0x10, 0x00, 0x1A,
+    0x20, 0x00, 0x41, 0x01, 0x6B, 0x22, 0x00, 0x0D, 0x00, 0x0B, 0x0B};
+
+// Reads one byte from the pipe in `user` for every call.
+static int32_t io_read_pipe(wasm_instance *instance, void *user, int32_t n) {
+  int fd = *(int *)user;
+  if (wasm_task_wait_fd(instance, fd, POLLIN) < 0) {
+    return -1;
+  }
+  char byte;
+  return read(fd, &byte, 1) == 1 ? n : -1;
+}
+
+static void io_task_done(enum wasm_trap trap, const wasm_value *result,
+                         void *user) {
+  (void)result;
+  atomic_store((_Atomic int *)user, trap == wasm_trap_none ? 1 : -1);
+}
+
+void test_async_host_call() {
+  int fds[2];
+  MUST_EQUAL(pipe(fds), 0);
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, io_module, sizeof(io_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_host_imports imports;
+  wasm_init_host_imports(&imports);
+  wasm_host_imports_add(&imports, "env", "io", "(i)i", io_read_pipe, &fds[0]);
+  wasm_reader spin_reader;
+  wasm_init_memory_reader(&spin_reader, spin_module, sizeof(spin_module));
+  wasm_module *spin = wasm_load_module(&spin_reader);
+
+  wasm_instance *reader_instance =
+      module ? wasm_instantiate(module, &imports) : NULL;
+  wasm_instance *spin_instance = spin ? wasm_instantiate(spin, NULL) : NULL;
+  MUST_NOT_EQUAL(reader_instance, NULL);
+  MUST_NOT_EQUAL(spin_instance, NULL);
+
+  // With a single worker the spinning task can only finish while the reading
+  // task is suspended.
+  wasm_scheduler *scheduler = wasm_create_scheduler(1, INT64_MAX);
+  if (scheduler && reader_instance && spin_instance) {
+    _Atomic int reader_done = 0;
+    _Atomic int spin_done = 0;
+    wasm_value reads = {.i32 = 3};
+    wasm_value spins = {.i32 = 1000};
+    wasm_scheduler_spawn(scheduler, reader_instance, 1, &reads, io_task_done,
+                         (void *)&reader_done);
+    wasm_scheduler_spawn(scheduler, spin_instance, 0, &spins, io_task_done,
+                         (void *)&spin_done);
+    while (atomic_load(&spin_done) == 0) {
+      sched_yield();
+    }
+    MUST_EQUAL(atomic_load(&reader_done), 0);
+
+    MUST_EQUAL(write(fds[1], "abc", 3), 3);
+    wasm_scheduler_wait(scheduler);
+    MUST_EQUAL(atomic_load(&reader_done), 1);
+    MUST_EQUAL(atomic_load(&spin_done), 1);
+
+    // Outside of a task the host function blocks.
+    MUST_EQUAL(write(fds[1], "d", 1), 1);
+    wasm_value once = {.i32 = 1};
+    MUST_EQUAL(wasm_invoke(reader_instance, 1, &once, NULL), wasm_trap_none);
+  }
+  wasm_free_scheduler(scheduler);
+
+  wasm_free_instance(reader_instance);
+  wasm_free_instance(spin_instance);
+  wasm_deinit_host_imports(&imports);
+  wasm_free_module(module);
+  wasm_free_module(spin);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void test_section_directory() {
+  FILE *file = fopen("../tests/files/emscripten_1/a.out.wasm", "rb");
+  MUST_NOT_EQUAL(file, NULL);
+  if (file == NULL) {
+    return;
+  }
+  unsigned char data[4096];
+  size_t size = fread(data, 1, sizeof(data), file);
+  fclose(file);
+
+  wasm_section_directory directory;
+  MUST(wasm_read_section_directory(&directory, data, size),
+       "must read directory");
+  const wasm_section_entry *exports =
+      wasm_section_directory_find(&directory, 7, NULL);
+  MUST_NOT_EQUAL(exports, NULL);
+
+  // The exports bring in the index spaces they refer to but not the code.
+  wasm_module *module = wasm_decode_sections(&directory, wasm_section_bit(7));
+  MUST_NOT_EQUAL(module, NULL);
+  if (module) {
+    MUST_EQUAL(wasm_vec_size(&module->exports), 2);
+    MUST_EQUAL(wasm_vec_size(&module->funcs), 2);
+    MUST_EQUAL(wasm_vec_size(&module->codes), 0);
+    MUST_NOT_EQUAL(wasm_module_find_export(module, "a", wasm_export_func),
+                   NULL);
+  }
+  wasm_free_module(module);
+
+  // The code section brings in the functions and types it depends on.
+  module = wasm_decode_sections(&directory, wasm_section_bit(10));
+  MUST_NOT_EQUAL(module, NULL);
+  if (module) {
+    MUST_EQUAL(wasm_vec_size(&module->function_types), 2);
+    MUST_EQUAL(wasm_vec_size(&module->codes), 2);
+    MUST_EQUAL(wasm_vec_size(&module->exports), 0);
+  }
+  wasm_free_module(module);
+  wasm_deinit_section_directory(&directory);
+
+  // A named custom section after the code.
+  unsigned char custom[sizeof(spin_module) + 9];
+  memcpy(custom, spin_module, sizeof(spin_module));
+  memcpy(custom + sizeof(spin_module), "\x00\x07\x04notehi", 9);
+  MUST(wasm_read_section_directory(&directory, custom, sizeof(custom)),
+       "must read directory");
+  const wasm_section_entry *note =
+      wasm_section_directory_find(&directory, 0, "note");
+  MUST_NOT_EQUAL(note, NULL);
+  MUST_EQUAL(wasm_section_directory_find(&directory, 0, "other"), NULL);
+  if (note) {
+    MUST_EQUAL(note->length, 2);
+    MUST_EQUAL_MEM(custom + note->offset, "hi", 2);
+  }
+  wasm_deinit_section_directory(&directory);
+
+  // The length of the last section is past the end.
+  MUST(!wasm_read_section_directory(&directory, custom, sizeof(custom) - 1),
+       "must fail");
+  wasm_deinit_section_directory(&directory);
+}
+
+void test_check_modules() {
+  const char *paths[3] = {"../tests/files/emscripten_1/a.out.wasm",
+                          "../tests/files/custom_section.wasm",
+                          "../tests/files/missing.wasm"};
+  wasm_check_result results[3];
+  wasm_check_modules(paths, 3, 2, 0, results);
+
+  MUST(results[0].ok, "must be valid");
+  MUST_EQUAL(results[0].func_count, 2);
+  MUST_NOT_EQUAL(results[0].stats.section_bytes[10], 0);
+  MUST_NOT_EQUAL(results[0].allocations, 0);
+  MUST(results[0].peak_bytes > 0, "must count bytes");
+  MUST(results[1].ok, "must be valid");
+  MUST(!results[2].ok, "must fail");
+
+  char *json = NULL;
+  size_t json_size = 0;
+  FILE *out = open_memstream(&json, &json_size);
+  wasm_print_check_json(out, &results[0]);
+  fclose(out);
+  const char *prefix = "{\"file\":\"../tests/files/emscripten_1";
+  MUST_EQUAL(strncmp(json, prefix, strlen(prefix)), 0);
+  MUST_NOT_EQUAL(strstr(json, "\"code\":{"), NULL);
+  free(json);
+}
+
+// (func (result i32) f32.const 0 f32.const 0 i32.add)
+static const unsigned char mistyped_add_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01,
+    0x60, 0x00, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x0A, 0x0F, 0x01,
+    0x0D, 0x00, 0x43, 0x00, 0x00, 0x00, 0x00, 0x43, 0x00, 0x00, 0x00,
+    0x00, 0x6A, 0x0B};
+
+// (global i32 (i32.const 0))
+// (func i32.const 1 global.set 0)
+static const unsigned char immutable_global_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01,
+    0x60, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x06, 0x06, 0x01, 0x7F,
+    0x00, 0x41, 0x00, 0x0B, 0x0A, 0x08, 0x01, 0x06, 0x00, 0x41, 0x01,
+    0x24, 0x00, 0x0B};
+
+// (func) (start 5)
+static const unsigned char bad_start_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04,
+    0x01, 0x60, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x08, 0x01,
+    0x05, 0x0A, 0x04, 0x01, 0x02, 0x00, 0x0B};
+
+// Loads, compiles and validates a module.
+static bool validate_bytes(const unsigned char *data, size_t size) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, data, size);
+  wasm_module *module = wasm_load_module(&reader);
+  bool ok = module && wasm_compile_module(module) &&
+            wasm_validate_module(module);
+  wasm_free_module(module);
+  return ok;
+}
+
+void test_validate() {
+  MUST(validate_bytes(fac_module, sizeof(fac_module)), "must be valid");
+  MUST(validate_bytes(spin_module, sizeof(spin_module)), "must be valid");
+
+  // These compile but are invalid.
+  MUST(!validate_bytes(mistyped_add_module, sizeof(mistyped_add_module)),
+       "must reject operands of the wrong type");
+  MUST(!validate_bytes(immutable_global_module,
+                       sizeof(immutable_global_module)),
+       "must reject writes to immutable globals");
+  MUST(!validate_bytes(bad_start_module, sizeof(bad_start_module)),
+       "must reject an unknown start function");
+}
+
+static void *alloc_on_thread(void *arg) {
+  (void)arg;
+  return wasm_alloc(uint64_t);
+}
+
+// Loads `size` bytes of `data` and returns whether it worked.
+static bool load_bytes(const unsigned char *data, size_t size) {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, data, size);
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_free_module(module);
+  return module != NULL;
+}
+
+// Same as `load_bytes` but reads the module from a pipe, whose size isn't
+// known up front.
+static bool load_piped(const unsigned char *data, size_t size) {
+  int fds[2];
+  MUST_EQUAL(pipe(fds), 0);
+  MUST_EQUAL(write(fds[1], data, size), (ssize_t)size);
+  close(fds[1]);
+  FILE *file = fdopen(fds[0], "rb");
+  wasm_reader reader;
+  wasm_init_file_reader(&reader, file);
+  MUST_EQUAL(reader.size, SIZE_MAX);
+  wasm_module *module = wasm_load_module(&reader);
+  fclose(file);
+  wasm_free_module(module);
+  return module != NULL;
+}
+
+void test_alloc_accounting() {
+  // Objects allocated on a thread that exited are still counted.
+  size_t count = wasm_alloc_count();
+  pthread_t thread;
+  void *object = NULL;
+  MUST_EQUAL(pthread_create(&thread, NULL, alloc_on_thread, NULL), 0);
+  pthread_join(thread, &object);
+  MUST_EQUAL(wasm_alloc_count(), count + 1);
+  wasm_free(object);
+  MUST_EQUAL(wasm_alloc_count(), count);
+
+  // Sizes from the module that are larger than the module itself fail before
+  // anything is allocated for them.
+  static const unsigned char huge_type_count[] = {
+      0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00,
+      0x01, 0x05, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F};
+  static const unsigned char huge_name[] = {
+      0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00,
+      0x07, 0x06, 0x01, 0xF0, 0xFF, 0xFF, 0xFF, 0x0F};
+  static const unsigned char huge_data[] = {
+      0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x0B, 0x0A,
+      0x01, 0x00, 0x41, 0x00, 0x0B, 0xFF, 0xFF, 0xFF, 0xFF, 0x07};
+  wasm_reset_thread_allocs();
+  MUST(!load_bytes(huge_type_count, sizeof(huge_type_count)), "must fail");
+  MUST(!load_bytes(huge_name, sizeof(huge_name)), "must fail");
+  MUST(!load_bytes(huge_data, sizeof(huge_data)), "must fail");
+  MUST(wasm_get_thread_allocs().peak_bytes < 64 * 1024,
+       "must not allocate the declared sizes");
+
+  // Without the size of the input the sizes are bounded by their section.
+  MUST(!load_piped(huge_type_count, sizeof(huge_type_count)), "must fail");
+  MUST(!load_piped(huge_name, sizeof(huge_name)), "must fail");
+  MUST(wasm_get_thread_allocs().peak_bytes < 64 * 1024,
+       "must not allocate the declared sizes");
+
+  // A segment that fits its section is checked against the limit before it
+  // is allocated.
+  static const unsigned char large_data[] = {
+      0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x0B, 0x88,
+      0x80, 0x40, 0x01, 0x00, 0x41, 0x00, 0x0B, 0x80, 0x80, 0x40};
+  wasm_set_module_memory_limit(64 * 1024);
+  MUST(!load_piped(large_data, sizeof(large_data)), "must fail");
+  wasm_set_module_memory_limit(0);
+  MUST(wasm_get_thread_allocs().peak_bytes < 128 * 1024,
+       "must not allocate the declared sizes");
+
+  // Loads fail once they allocated more than the limit.
+  wasm_set_module_memory_limit(64);
+  MUST(!load_bytes(spin_module, sizeof(spin_module)), "must fail");
+  wasm_set_module_memory_limit(1024 * 1024);
+  MUST(load_bytes(spin_module, sizeof(spin_module)), "must load");
+  wasm_set_module_memory_limit(0);
+  MUST(!wasm_alloc_limit_exceeded(), "must clear the limit");
+
+  const char *path = "../tests/files/emscripten_1/a.out.wasm";
+  wasm_check_result result;
+  wasm_check_modules(&path, 1, 1, 64, &result);
+  MUST(!result.ok, "must fail");
+}
+
+// Validates `str` at every level. Sets `agree` to false if the levels give
+// different results.
+static bool validate_utf8_levels(const char *str, size_t length,
+                                 bool *agree) {
+  enum wasm_simd_level best = wasm_simd_detect_level();
+  wasm_simd_set_level(wasm_simd_scalar);
+  bool valid = wasm_validate_utf8(str, length);
+  for (enum wasm_simd_level level = wasm_simd_sse2; level <= best; level++) {
+    wasm_simd_set_level(level);
+    *agree = *agree && wasm_validate_utf8(str, length) == valid;
+  }
+  wasm_simd_set_level(best);
+  return valid;
+}
+
+void test_utf8() {
+  static const struct {
+    const char *str;
+    bool valid;
+  } cases[] = {
+      {"abc", true},
+      {"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", true},
+      {"\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF", true},
+      {"\xC0\x80", false},         // overlong NUL
+      {"\xC1\xBF", false},         // overlong 2 bytes
+      {"\xE0\x9F\xBF", false},     // overlong 3 bytes
+      {"\xF0\x8F\xBF\xBF", false}, // overlong 4 bytes
+      {"\xED\xA0\x80", false},     // surrogate
+      {"\xF4\x90\x80\x80", false}, // above U+10FFFF
+      {"\xF5\x80\x80\x80", false},
+      {"\xFF", false},
+      {"\x80", false},              // lone continuation
+      {"\xC3", false},              // truncated
+      {"\xE2\x82", false},
+      {"\xE2\x82\x41", false},
+      {"\xF0\x9F\x98", false},
+  };
+
+  // Every case is checked on its own and at every offset in a longer buffer
+  // so it ends up in all positions of a SIMD block and across blocks.
+  bool agree = true;
+  bool expected = true;
+  char buffer[96];
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    size_t length = strlen(cases[i].str);
+    bool valid = cases[i].valid;
+    expected = expected &&
+               validate_utf8_levels(cases[i].str, length, &agree) == valid;
+    for (size_t offset = 0; offset + length <= sizeof(buffer); offset++) {
+      memset(buffer, 'a', sizeof(buffer));
+      memcpy(buffer + offset, cases[i].str, length);
+      expected =
+          expected &&
+          validate_utf8_levels(buffer, sizeof(buffer), &agree) == valid &&
+          validate_utf8_levels(buffer, offset + length, &agree) == valid;
+    }
+  }
+  MUST(expected, "must classify every case");
+
+  // NUL bytes are allowed in names.
+  MUST(validate_utf8_levels("a\0b", 3, &agree), "must be valid");
+  MUST(validate_utf8_levels("", 0, &agree), "must be valid");
+
+  // Random bytes, most of them valid sequences.
+  static const char *pieces[] = {"x", "\xC3\xA9", "\xE2\x82\xAC",
+                                 "\xF0\x9F\x98\x80"};
+  uint32_t random = 1;
+  for (int round = 0; round < 2000; round++) {
+    size_t length = 0;
+    while (length < sizeof(buffer) - 4) {
+      random ^= random << 13;
+      random ^= random >> 17;
+      random ^= random << 5;
+      if (random % 64 == 0) {
+        buffer[length++] = (char)(random >> 8);
+      } else {
+        const char *piece = pieces[(random >> 8) % 4];
+        memcpy(buffer + length, piece, strlen(piece));
+        length += strlen(piece);
+      }
+    }
+    validate_utf8_levels(buffer, length, &agree);
+  }
+  MUST(agree, "levels must agree");
+}
+
+// (func (param i32) (result i32) (local i32)
+//   i32.const 2
+//   i32.const 3
+//   i32.mul
+//   local.get 0
+//   i32.add
+//   local.tee 1
+//   local.get 1
+//   local.get 0
+//   local.set 1
+//   i32.sub
+//   local.get 1
+//   i32.add)
+static const unsigned char register_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01,
+    0x60, 0x01, 0x7F, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x0A, 0x1A,
+    0x01, 0x18, 0x01, 0x01, 0x7F, 0x41, 0x02, 0x41, 0x03, 0x6C, 0x20,
+    0x00, 0x6A, 0x22, 0x01, 0x20, 0x01, 0x20, 0x00, 0x21, 0x01, 0x6B,
+    0x20, 0x01, 0x6A, 0x0B};
+
+// Runs `funcidx` of a module compiled with and without register forms. Both
+// must compute the same, the register forms with fewer dispatches. Returns the
+// result.
+static int32_t check_register_ir(const unsigned char *data, size_t size,
+                                 uint32_t funcidx, wasm_value *args) {
+  wasm_value results[2] = {{.i32 = 0}, {.i32 = 0}};
+  uint64_t dispatches[2] = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    wasm_set_register_ir(i == 1);
+    wasm_reader reader;
+    wasm_init_memory_reader(&reader, data, size);
+    wasm_module *module = wasm_load_module(&reader);
+    wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+    MUST_NOT_EQUAL(instance, NULL);
+    if (instance) {
+      MUST_EQUAL(wasm_invoke(instance, funcidx, args, &results[i]),
+                 wasm_trap_none);
+      dispatches[i] = instance->dispatch_count;
+    }
+    wasm_free_instance(instance);
+    wasm_free_module(module);
+  }
+  wasm_set_register_ir(true);
+
+  MUST_EQUAL(results[0].i32, results[1].i32);
+  MUST(dispatches[1] < dispatches[0], "register forms must dispatch less");
+  return results[1].i32;
+}
+
+void test_register_ir() {
+  // The product is folded, `local.tee` stores the sum directly and the read
+  // of local 1 happens before it is overwritten.
+  wasm_value arg = {.i32 = 10};
+  MUST_EQUAL(
+      check_register_ir(register_module, sizeof(register_module), 0, &arg),
+      10);
+
+  arg.i32 = 10;
+  MUST_EQUAL(check_register_ir(fac_module, sizeof(fac_module), 0, &arg),
+             3628800);
+}
+
+// (table 2 funcref)
+// (elem (i32.const 0) $count $count_indirect)
+// (func $count (param i32 i32) (result i32)
+//   local.get 0
+//   i32.eqz
+//   if
+//     local.get 1
+//     return
+//   end
+//   local.get 0
+//   i32.const 1
+//   i32.sub
+//   local.get 1
+//   i32.const 1
+//   i32.add
+//   return_call $count)
+// (func $count_indirect (param i32 i32) (result i32)
+//   ;; same as $count but with `i32.const 1 return_call_indirect (type 0)`)
+// (func $depth (param i32 i32) (result i32)
+//   ;; returns 0 if local 0 is 0, else `$depth(local 0 - 1, local 1) + 1`)
+static const unsigned char tail_call_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01, 0x60,
+    0x02, 0x7F, 0x7F, 0x01, 0x7F, 0x03, 0x04, 0x03, 0x00, 0x00, 0x00, 0x04,
+    0x04, 0x01, 0x70, 0x00, 0x02, 0x09, 0x08, 0x01, 0x00, 0x41, 0x00, 0x0B,
+    0x02, 0x00, 0x01, 0x0A, 0x4C, 0x03, 0x17, 0x00, 0x20, 0x00, 0x45, 0x04,
+    0x40, 0x20, 0x01, 0x0F, 0x0B, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x20, 0x01,
+    0x41, 0x01, 0x6A, 0x12, 0x00, 0x0B, 0x1A, 0x00, 0x20, 0x00, 0x45, 0x04,
+    0x40, 0x20, 0x01, 0x0F, 0x0B, 0x20, 0x00, 0x41, 0x01, 0x6B, 0x20, 0x01,
+    0x41, 0x01, 0x6A, 0x41, 0x01, 0x13, 0x00, 0x00, 0x0B, 0x17, 0x00, 0x20,
+    0x00, 0x45, 0x04, 0x40, 0x41, 0x00, 0x0F, 0x0B, 0x20, 0x00, 0x41, 0x01,
+    0x6B, 0x20, 0x01, 0x10, 0x02, 0x41, 0x01, 0x6A, 0x0B};
+
+void test_call_stack() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, tail_call_module, sizeof(tail_call_module));
+  wasm_module *module = wasm_load_module(&reader);
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance == NULL) {
+    wasm_free_module(module);
+    return;
+  }
+
+  // Tail calls reuse the frame so they can go far deeper than the call
+  // depth.
+  wasm_value args[2] = {{.i32 = 1000000}, {.i32 = 0}};
+  wasm_value result;
+  MUST_EQUAL(wasm_invoke(instance, 0, args, &result), wasm_trap_none);
+  MUST_EQUAL(result.i32, 1000000);
+  MUST_EQUAL(wasm_invoke(instance, 1, args, &result), wasm_trap_none);
+  MUST_EQUAL(result.i32, 1000000);
+
+  // Plain recursion is limited by the configured depth, not the native
+  // stack.
+  args[0].i32 = 50000;
+  MUST_EQUAL(wasm_invoke(instance, 2, args, &result),
+             wasm_trap_call_stack_exhausted);
+  MUST_EQUAL(instance->call_depth, 0);
+  MUST(wasm_instance_set_max_call_depth(instance, 100000), "must reserve");
+  MUST_EQUAL(wasm_invoke(instance, 2, args, &result), wasm_trap_none);
+  MUST_EQUAL(result.i32, 50000);
+
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+}
+
+void test_load_modules() {
+  const char *paths[4] = {"../tests/files/emscripten_1/a.out.wasm",
+                          "../tests/files/custom_section.wasm",
+                          "../tests/files/emscripten_1/a.out.wasm",
+                          "../tests/files/missing.wasm"};
+  wasm_module_set *set = wasm_load_modules(paths, 4, 3);
+  MUST_NOT_EQUAL(set, NULL);
+  if (set == NULL) {
+    return;
+  }
+
+  wasm_module *a = set->modules[0], *b = set->modules[2];
+  MUST_NOT_EQUAL(a, NULL);
+  MUST_NOT_EQUAL(set->modules[1], NULL);
+  MUST_NOT_EQUAL(b, NULL);
+  MUST_EQUAL(set->modules[3], NULL);
+  if (a && b) {
+    // Equal names and types of different modules are stored once.
+    wasm_export *export_a = a->exports.start, *export_b = b->exports.start;
+    MUST_EQUAL(export_a->name, export_b->name);
+    MUST(strcmp(wasm_module_name(a, export_a->name),
+                wasm_module_name(b, export_b->name)) == 0,
+         "wrong name");
+    MUST_EQUAL(wasm_module_type_id(a, 1), wasm_module_type_id(b, 1));
+    MUST_NOT_EQUAL(wasm_module_type_id(a, 0), wasm_module_type_id(a, 1));
+    MUST_EQUAL(a->function_types.start[1].params,
+               b->function_types.start[1].params);
+    MUST_EQUAL(wasm_vec_size(&a->names), 0);
+
+    wasm_instance *instance = wasm_instantiate(b, NULL);
+    MUST_NOT_EQUAL(instance, NULL);
+    if (instance) {
+      wasm_value arg = {.i32 = 20}, result;
+      MUST_EQUAL(wasm_invoke(instance, 1, &arg, &result), wasm_trap_none);
+      MUST_EQUAL(result.i32, 2768);
+    }
+    wasm_free_instance(instance);
+  }
+  wasm_free_module_set(set);
+}
+
+void test_perf_stats() {
+  wasm_perf_stats stats;
+  wasm_init_perf_stats(&stats);
+  wasm_set_perf_stats(&stats);
+  MUST_EQUAL(wasm_get_perf_stats(), &stats);
+
+  wasm_module *module =
+      wasm_load_module_from_file("../tests/files/emscripten_1/a.out.wasm");
+  wasm_instance *instance = module ? wasm_instantiate(module, NULL) : NULL;
+  MUST_NOT_EQUAL(instance, NULL);
+  if (instance) {
+    wasm_value arg = {.i32 = 20}, result;
+    MUST_EQUAL(wasm_invoke(instance, 1, &arg, &result), wasm_trap_none);
+    MUST_EQUAL(result.i32, 2768);
+  }
+  wasm_set_perf_stats(NULL);
+  MUST_EQUAL(wasm_get_perf_stats(), NULL);
+
+  // Counters may be missing here, the time is always measured.
+  MUST(stats.header.ns > 0, "must measure the header");
+  MUST(stats.sections[1].ns > 0, "must measure the type section");
+  MUST(stats.sections[10].ns > 0, "must measure the code section");
+  MUST_EQUAL(wasm_vec_size(&stats.funcs), 2);
+  MUST_EQUAL(stats.funcs.start[1].funcidx, 1);
+  MUST(stats.funcs.start[1].sample.ns > 0, "must measure the body");
+  MUST(stats.compile.ns > 0, "must measure the compilation");
+  MUST(stats.instantiate.ns >= stats.compile.ns, "must include compile");
+  MUST_EQUAL(stats.invoke_count, 1);
+  if (stats.events & (1u << wasm_perf_instructions)) {
+    MUST(stats.invoke.events[wasm_perf_instructions] > 0,
+         "must count instructions");
+  }
+
+  char *text = NULL;
+  size_t text_size = 0;
+  FILE *out = open_memstream(&text, &text_size);
+  wasm_print_perf_stats(out, &stats, 10);
+  fclose(out);
+  MUST_NOT_EQUAL(strstr(text, "section code"), NULL);
+  MUST_NOT_EQUAL(strstr(text, "invoke (1 calls)"), NULL);
+  free(text);
+
+  // Loads after stopping are not recorded.
+  wasm_free_instance(instance);
+  wasm_free_module(module);
+  module = wasm_load_module_from_file("../tests/files/emscripten_1/a.out.wasm");
+  MUST_EQUAL(wasm_vec_size(&stats.funcs), 2);
+  wasm_free_module(module);
+  wasm_deinit_perf_stats(&stats);
+}
+
+// (memory 1)
+// (func (result f64)
+//   f32.const 1.5 drop  f32.const nan drop  f32.const -inf drop
+//   f32.const nan:0x1 drop  f64.const -0 drop  f64.const 0x1p-1074 drop
+//   i64.const -1 drop
+//   i32.const 0 i32.load offset=8 align=1 drop
+//   block (result f64) f64.const 3 br 0 end)
+static const unsigned char float_module[] = {
+    0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01, 0x60,
+    0x00, 0x01, 0x7C, 0x03, 0x02, 0x01, 0x00, 0x05, 0x03, 0x01, 0x00, 0x01,
+    0x0A, 0x47, 0x01, 0x45, 0x00, 0x43, 0x00, 0x00, 0xC0, 0x3F, 0x1A, 0x43,
+    0x00, 0x00, 0xC0, 0x7F, 0x1A, 0x43, 0x00, 0x00, 0x80, 0xFF, 0x1A, 0x43,
+    0x01, 0x00, 0x80, 0x7F, 0x1A, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x80, 0x1A, 0x44, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x1A, 0x42, 0x7F, 0x1A, 0x41, 0x00, 0x28, 0x00, 0x08, 0x1A, 0x02, 0x7C,
+    0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x40, 0x0C, 0x00, 0x0B,
+    0x0B};
+
+static char *print_wat(const wasm_module *module, uint32_t thread_count) {
+  wasm_text_out out;
+  wasm_init_text_out(&out, -1);
+  bool ok = wasm_print_wat(&out, module, thread_count);
+  MUST(ok, "must print the module");
+  char *text = strndup(out.data, out.size);
+  wasm_deinit_text_out(&out);
+  return text;
+}
+
+void test_print_wat() {
+  FILE *file = fopen("../tests/files/emscripten_1/a.out.wat", "rb");
+  MUST_NOT_EQUAL(file, NULL);
+  char expected[2048] = {0};
+  if (file) {
+    MUST(fread(expected, 1, sizeof(expected) - 1, file) > 0,
+         "must read the text");
+    fclose(file);
+  }
+
+  wasm_module *module =
+      wasm_load_module_from_file("../tests/files/emscripten_1/a.out.wasm");
+  MUST_NOT_EQUAL(module, NULL);
+  if (module) {
+    // The chunks printed on several threads are joined in order.
+    for (uint32_t threads = 1; threads <= 2; threads++) {
+      char *text = print_wat(module, threads);
+      MUST_EQUAL(strcmp(text, expected), 0);
+      free(text);
+    }
+    wasm_free_module(module);
+  }
+
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, float_module, sizeof(float_module));
+  module = wasm_load_module(&reader);
+  MUST_NOT_EQUAL(module, NULL);
+  if (module) {
+    char *text = print_wat(module, 1);
+    MUST_EQUAL(strcmp(text, "(module\n"
+                            "  (type (;0;) (func (result f64)))\n"
+                            "  (func (;0;) (type 0) (result f64)\n"
+                            "    f32.const 0x1.8p+0\n"
+                            "    drop\n"
+                            "    f32.const nan\n"
+                            "    drop\n"
+                            "    f32.const -inf\n"
+                            "    drop\n"
+                            "    f32.const nan:0x1\n"
+                            "    drop\n"
+                            "    f64.const -0x0p+0\n"
+                            "    drop\n"
+                            "    f64.const 0x1p-1074\n"
+                            "    drop\n"
+                            "    i64.const -1\n"
+                            "    drop\n"
+                            "    i32.const 0\n"
+                            "    i32.load offset=8 align=1\n"
+                            "    drop\n"
+                            "    block (result f64)  ;; label = @1\n"
+                            "      f64.const 0x1.8p+1\n"
+                            "      br 0 (;@1;)\n"
+                            "    end)\n"
+                            "  (memory (;0;) 1))\n"),
+               0);
+    free(text);
+    wasm_free_module(module);
+  }
+}
+
+void test_compact_module() {
+  wasm_reader reader;
+  wasm_init_memory_reader(&reader, io_module, sizeof(io_module));
+  wasm_module *module = wasm_load_module(&reader);
+  MUST_NOT_EQUAL(module, NULL);
+  if (module) {
+    // The parameters of both types are packed into one array.
+    wasm_function_type *types = module->function_types.start;
+    MUST_EQUAL(types[0].param_count, 1);
+    MUST_EQUAL(types[0].params, module->valtypes.start);
+    MUST_EQUAL(types[1].params, module->valtypes.start + 1);
+    MUST_EQUAL(types[1].params[0], wasm_valtype_i32);
+    MUST_EQUAL(types[1].result_count, 0);
+
+    wasm_import *import = module->imports.start;
+    MUST(strcmp(wasm_module_name(module, import->module_name), "env") == 0,
+         "wrong module name");
+    MUST(strcmp(wasm_module_name(module, import->name), "io") == 0,
+         "wrong name");
+
+    // Bodies are stored without their locals and the final 0x0B.
+    wasm_code *code = module->codes.start;
+    MUST_EQUAL(code->locals_count, 0);
+    MUST_EQUAL(code->expr_size, 17);
+    MUST_EQUAL(wasm_vec_size(&module->code_bytes), 17);
+    MUST_EQUAL_MEM(wasm_code_expr(module, code), io_module + 41, 17);
+  }
+  wasm_free_module(module);
+
+  // Every section appears at most once.
+  static const unsigned char two_type_sections[] = {
+      0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01,
+      0x60, 0x00, 0x00, 0x01, 0x04, 0x01, 0x60, 0x00, 0x00};
+  MUST(!load_bytes(two_type_sections, sizeof(two_type_sections)),
+       "must fail");
+}
+
 // Ad hoc main for tests.
 int main(void) {
   puts("Tests started");
@@ -110,6 +1532,27 @@ int main(void) {
   TEST(test_skip_custom_section);
   TEST(test_vec);
   TEST(test_emscripten_file_1);
+  TEST(test_emscripten_file_1_exec);
+  TEST(test_exec_control_flow);
+  TEST(test_imports);
+  TEST(test_call_indirect);
+  TEST(test_wasi);
+  TEST(test_bulk_memory);
+  TEST(test_simd);
+  TEST(test_atomics);
+  TEST(test_scheduler);
+  TEST(test_async_host_call);
+  TEST(test_section_directory);
+  TEST(test_check_modules);
+  TEST(test_validate);
+  TEST(test_alloc_accounting);
+  TEST(test_utf8);
+  TEST(test_compact_module);
+  TEST(test_register_ir);
+  TEST(test_call_stack);
+  TEST(test_load_modules);
+  TEST(test_perf_stats);
+  TEST(test_print_wat);
 
   if (all_success) {
     puts("\nAll tests passed PogChamp");